@@ -53,20 +53,6 @@ extern "C" {
  */
 #define PRE_APP_INIT_HOOK Number1_PreAppHook
 
-/**
- * @}
- *
- * @name Coarse Timer
- * Settings for the @ref timer. These are used to initialize
- * CoarseTimer_Settings.
- * @{
- */
-
-/**
- * @brief The timer to use for the coarse timer.
- */
-#define COARSE_TIMER_ID 2
-
 /**
  * @}
  *
@@ -151,8 +137,8 @@ extern "C" {
  * @}
  *
  * @name SPI DMX
- * Settings for the @ref spi_dmx. These are used to initialize
- * SPIRGBConfiguration.
+ * Settings for the @ref spi and @ref spi_dmx. These are used to initialize
+ * SPIConfiguration and SPIRGBConfiguration.
  * @{
  */
 
@@ -171,6 +157,71 @@ extern "C" {
  */
 #define SPI_USE_ENHANCED_BUFFERING true
 
+/**
+ * @brief Use DMA for SPI transfers, rather than the SPI interrupt.
+ */
+#define SPI_USE_DMA true
+
+/**
+ * @brief The DMA channel to use for SPI transmit.
+ */
+#define SPI_TX_DMA_CHANNEL DMA_CHANNEL_0
+
+/**
+ * @brief The DMA channel to use for SPI receive.
+ */
+#define SPI_RX_DMA_CHANNEL DMA_CHANNEL_1
+
+/**
+ * @}
+ *
+ * @name Dimmer
+ * Settings for the dimmer model, see dimmer_model.h.
+ * @{
+ */
+
+/**
+ * @brief The number of sub devices the dimmer model provides, up to 512.
+ *
+ * Each sub device uses 25 bytes of RAM: 12 for the settings, 3 for the scene
+ * levels, 6 for the DMX input & output levels and 4 for the preset playback.
+ * The budget for 512 sub devices is 12.5KB, about 16KB for the whole dimmer
+ * model.
+ */
+#define DIMMER_SUB_DEVICE_COUNT 512
+
+/**
+ * @brief The number of custom labels the dimmer's sub devices can use.
+ *
+ * Sub devices with the same label share an entry. Each entry uses 34 bytes of
+ * RAM.
+ */
+#define DIMMER_CUSTOM_LABEL_COUNT 8
+
+/**
+ * @}
+ *
+ * @name Profiling
+ * Settings for the @ref isr_profiler and the @ref scheduler.
+ * @{
+ */
+
+/**
+ * @brief Record the execution time of the interrupt handlers.
+ *
+ * This adds around 1us to each ISR. If undefined, the profiler is compiled
+ * out.
+ */
+// #define ISR_PROFILING
+
+/**
+ * @brief Record the calls & cycles for each scheduler task.
+ *
+ * This reads the core timer twice for every task on every pass of the main
+ * loop. If undefined, only the wakeable tasks are timed, for the load.
+ */
+// #define SCHEDULER_TASK_STATS
+
 /**
  * @}
  * @}
@@ -28,19 +28,26 @@
 #ifndef BOARDCFG_TEMPLATE_APP_PIPELINE_H_
 #define BOARDCFG_TEMPLATE_APP_PIPELINE_H_
 
+#include "pipeline_latency.h"
+
+// The latency is only recorded if the response was queued.
 #define PIPELINE_TRANSPORT_TX(token, command, rc, iov, iov_count) \
-  USBTransport_SendResponse(token, command, rc, iov, iov_count);
+  (USBTransport_SendResponse(token, command, rc, iov, iov_count) ? \
+   (PipelineLatency_ResponseSent(token), true) : false);
 
 #define PIPELINE_TRANSPORT_RX(data, size) \
+  PipelineLatency_TransferReceived(); \
   StreamDecoder_Process(data, size);
 
 #define PIPELINE_HANDLE_MESSAGE(message) \
+  PipelineLatency_MessageReceived((message)->token); \
   MessageHandler_HandleMessage(message);
 
 #define PIPELINE_LOG_WRITE(message) \
   USBConsole_Log(message);
 
 #define PIPELINE_TRANSCEIVER_TX_EVENT(event) \
+  PipelineLatency_TransceiverEvent((event)->token, (event)->timestamp); \
   MessageHandler_TransceiverEvent(event);
 
 #define PIPELINE_TRANSCEIVER_RX_EVENT(event) \
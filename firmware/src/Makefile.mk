@@ -1,10 +1,14 @@
 noinst_LTLIBRARIES += firmware/src/libcoarsetimer.la \
                       firmware/src/libdimmermodel.la \
+                      firmware/src/libdimmermodel512.la \
                       firmware/src/libflags.la \
+                      firmware/src/libisrprofiler.la \
                       firmware/src/libledmodel.la \
                       firmware/src/libmessagehandler.la \
+                      firmware/src/libmetrics.la \
                       firmware/src/libmovinglightmodel.la \
                       firmware/src/libnetworkmodel.la \
+                      firmware/src/libpipelinelatency.la \
                       firmware/src/libproxymodel.la \
                       firmware/src/librandom.la \
                       firmware/src/librdmbuffer.la \
@@ -13,11 +17,15 @@ noinst_LTLIBRARIES += firmware/src/libcoarsetimer.la \
                       firmware/src/librdmutil.la \
                       firmware/src/libreceivercounters.la \
                       firmware/src/libresponder.la \
+                      firmware/src/libscheduler.la \
                       firmware/src/libsensormodel.la \
                       firmware/src/libspi.la \
                       firmware/src/libspirgb.la \
                       firmware/src/libstreamdecoder.la \
+                      firmware/src/libtimerwheel.la \
+                      firmware/src/libtimestamp.la \
                       firmware/src/libtransceiver.la \
+                      firmware/src/libtransceivertrace.la \
                       firmware/src/libusbtransport.la
 
 firmware_src_libcoarsetimer_la_SOURCES = firmware/src/coarse_timer.c
@@ -26,18 +34,34 @@ firmware_src_libcoarsetimer_la_CFLAGS = $(BUILD_FLAGS)
 firmware_src_libdimmermodel_la_SOURCES = firmware/src/dimmer_model.c
 firmware_src_libdimmermodel_la_CFLAGS = $(BUILD_FLAGS)
 
+# The dimmer with the full set of sub devices, as used by the boards.
+firmware_src_libdimmermodel512_la_SOURCES = firmware/src/dimmer_model.c
+firmware_src_libdimmermodel512_la_CFLAGS = $(BUILD_FLAGS) \
+                                           -DDIMMER_SUB_DEVICE_COUNT=512
+
 firmware_src_libflags_la_SOURCES = firmware/src/flags.c
 firmware_src_libflags_la_CFLAGS = $(BUILD_FLAGS)
 
+firmware_src_libisrprofiler_la_SOURCES = firmware/src/isr_profiler.c
+firmware_src_libisrprofiler_la_CFLAGS = $(BUILD_FLAGS)
+
 firmware_src_libledmodel_la_SOURCES = firmware/src/led_model.c
 firmware_src_libledmodel_la_CFLAGS = $(BUILD_FLAGS)
 
 firmware_src_libmessagehandler_la_SOURCES = firmware/src/message_handler.c
 firmware_src_libmessagehandler_la_CFLAGS = $(BUILD_FLAGS)
 
+firmware_src_libmetrics_la_SOURCES = firmware/src/metrics.c
+firmware_src_libmetrics_la_CFLAGS = $(BUILD_FLAGS)
+
 firmware_src_libnetworkmodel_la_SOURCES = firmware/src/network_model.c
 firmware_src_libnetworkmodel_la_CFLAGS = $(BUILD_FLAGS)
 
+firmware_src_libpipelinelatency_la_SOURCES = \
+    firmware/src/pipeline_latency.c
+firmware_src_libpipelinelatency_la_CFLAGS = $(BUILD_FLAGS)
+firmware_src_libpipelinelatency_la_LIBADD = firmware/src/libtimestamp.la
+
 firmware_src_libproxymodel_la_SOURCES = firmware/src/proxy_model.c
 firmware_src_libproxymodel_la_CFLAGS = $(BUILD_FLAGS)
 
@@ -65,6 +89,9 @@ firmware_src_libreceivercounters_la_CFLAGS = $(BUILD_FLAGS)
 firmware_src_libresponder_la_SOURCES = firmware/src/responder.c
 firmware_src_libresponder_la_CFLAGS = $(BUILD_FLAGS)
 
+firmware_src_libscheduler_la_SOURCES = firmware/src/scheduler.c
+firmware_src_libscheduler_la_CFLAGS = $(BUILD_FLAGS)
+
 firmware_src_libsensormodel_la_SOURCES = firmware/src/sensor_model.c
 firmware_src_libsensormodel_la_CFLAGS = $(BUILD_FLAGS)
 
@@ -77,9 +104,20 @@ firmware_src_libspi_la_CFLAGS = $(BUILD_FLAGS)
 firmware_src_libstreamdecoder_la_SOURCES = firmware/src/stream_decoder.c
 firmware_src_libstreamdecoder_la_CFLAGS = $(BUILD_FLAGS)
 
+firmware_src_libtimerwheel_la_SOURCES = firmware/src/timer_wheel.c
+firmware_src_libtimerwheel_la_CFLAGS = $(BUILD_FLAGS)
+
+firmware_src_libtimestamp_la_SOURCES = firmware/src/timestamp.c
+firmware_src_libtimestamp_la_CFLAGS = $(BUILD_FLAGS)
+
 firmware_src_libtransceiver_la_SOURCES = firmware/src/transceiver.c
 firmware_src_libtransceiver_la_CFLAGS = $(BUILD_FLAGS)
-firmware_src_libtransceiver_la_LIBADD = firmware/src/librandom.la
+firmware_src_libtransceiver_la_LIBADD = firmware/src/librandom.la \
+                                        firmware/src/libtransceivertrace.la
+
+firmware_src_libtransceivertrace_la_SOURCES = \
+    firmware/src/transceiver_trace.c
+firmware_src_libtransceivertrace_la_CFLAGS = $(BUILD_FLAGS)
 
 firmware_src_libusbtransport_la_SOURCES = firmware/src/usb_transport.c
 firmware_src_libusbtransport_la_CFLAGS = $(BUILD_FLAGS)
@@ -23,22 +23,29 @@
 
 #include "coarse_timer.h"
 #include "dimmer_model.h"
+#include "isr_profiler.h"
 #include "led_model.h"
 #include "message_handler.h"
+#include "metrics.h"
 #include "moving_light.h"
 #include "network_model.h"
+#include "pipeline_latency.h"
 #include "proxy_model.h"
 #include "rdm.h"
 #include "rdm_handler.h"
 #include "rdm_responder.h"
 #include "receiver_counters.h"
+#include "scheduler.h"
 #include "sensor_model.h"
 #include "setting_macros.h"
+#include "spi.h"
 #include "spi_rgb.h"
 #include "stream_decoder.h"
 #include "syslog.h"
 #include "system_definitions.h"
 #include "temperature.h"
+#include "timer_wheel.h"
+#include "timestamp.h"
 #include "transceiver.h"
 #include "uid_store.h"
 #include "usb_descriptors.h"
@@ -47,8 +54,40 @@
 
 #include "app_settings.h"
 
-void __ISR(AS_TIMER_ISR_VECTOR(COARSE_TIMER_ID), ipl6AUTO) TimerEvent() {
+/*
+ * @brief True if the responder tasks are enabled.
+ */
+static bool g_responder_tasks_enabled;
+
+/*
+ * @brief Updates the gauges once a second.
+ */
+static TimerWheel_Timer g_metrics_timer;
+
+static void UpdateMetrics() {
+  Metrics_Set(METRIC_UPTIME,
+              Timestamp_Now() / (TIMESTAMP_TICKS_PER_MICROSECOND * 1000000u));
+  Metrics_Set(METRIC_SCHEDULER_LOAD, Scheduler_SampleLoad());
+}
+
+/*
+ * @brief Enable the tasks that only run in responder mode.
+ */
+static void EnableResponderTasks(bool enabled) {
+  Scheduler_SetEnabled(RDMResponder_Tasks, enabled);
+  Scheduler_SetEnabled(RDMHandler_Tasks, enabled);
+  Scheduler_SetEnabled(SPIRGB_Tasks, enabled);
+  Scheduler_SetEnabled(Temperature_Tasks, enabled);
+  g_responder_tasks_enabled = enabled;
+}
+
+void __ISR(_CORE_TIMER_VECTOR, ipl6AUTO) CoreTimerEvent() {
+  ISR_PROFILER_ENTER();
+  ISR_PROFILER_LATENCY(ISR_PROFILER_CORE_TIMER,
+                       isr_profiler_start - CoreTimer_GetCompare());
+  Timestamp_Update();
   CoarseTimer_TimerEvent();
+  ISR_PROFILER_EXIT(ISR_PROFILER_CORE_TIMER);
 }
 
 void APP_Initialize(void) {
@@ -62,12 +101,30 @@ void APP_Initialize(void) {
   UIDStore_AsUnicodeString(USBDescriptor_UnicodeUID());
 
   CoarseTimer_Settings timer_settings = {
-    .timer_id = AS_TIMER_ID(COARSE_TIMER_ID),
-    .interrupt_source = AS_TIMER_INTERRUPT_SOURCE(COARSE_TIMER_ID)
+    .interrupt_source = INT_SOURCE_TIMER_CORE
   };
-  SYS_INT_VectorPrioritySet(AS_TIMER_INTERRUPT_VECTOR(COARSE_TIMER_ID),
-                            INT_PRIORITY_LEVEL6);
+  SYS_INT_VectorPrioritySet(INT_VECTOR_CT, INT_PRIORITY_LEVEL6);
+  Timestamp_Initialize();
   CoarseTimer_Initialize(&timer_settings);
+  TimerWheel_Initialize();
+
+  Metrics_Initialize();
+  PipelineLatency_Initialize();
+  TimerWheel_SchedulePeriodic(&g_metrics_timer, 10000u, UpdateMetrics);
+
+  // The transceiver runs first, since it's the most sensitive to latency. The
+  // SPI tasks only run when there is a transfer in progress.
+  Scheduler_Initialize();
+  Scheduler_AddTask(Transceiver_Tasks, SCHEDULER_POLLED);
+  Scheduler_AddTask(USBTransport_Tasks, SCHEDULER_POLLED);
+  Scheduler_AddTask(USBConsole_Tasks, SCHEDULER_POLLED);
+  Scheduler_AddTask(SPI_Tasks, SCHEDULER_WAKEABLE);
+  Scheduler_AddTask(TimerWheel_Tasks, SCHEDULER_POLLED);
+  Scheduler_AddTask(RDMResponder_Tasks, SCHEDULER_POLLED);
+  Scheduler_AddTask(RDMHandler_Tasks, SCHEDULER_POLLED);
+  Scheduler_AddTask(SPIRGB_Tasks, SCHEDULER_WAKEABLE);
+  Scheduler_AddTask(Temperature_Tasks, SCHEDULER_POLLED);
+  g_responder_tasks_enabled = true;
 
   // Initialize the Logging system, bottom up
   USBTransport_Initialize(NULL);
@@ -140,12 +197,20 @@ void APP_Initialize(void) {
 
   Flags_Initialize();
 
-  // SPI DMX Output
-  SPIRGBConfiguration spi_config;
+  // SPI bus
+  SPIConfiguration spi_config;
   spi_config.module_id = SPI_MODULE_ID;
   spi_config.baud_rate = SPI_BAUD_RATE;
   spi_config.use_enhanced_buffering = SPI_USE_ENHANCED_BUFFERING;
-  SPIRGB_Init(&spi_config);
+  spi_config.use_dma = SPI_USE_DMA;
+  spi_config.tx_dma_channel = SPI_TX_DMA_CHANNEL;
+  spi_config.rx_dma_channel = SPI_RX_DMA_CHANNEL;
+  SPI_Initialize(&spi_config);
+
+  // SPI DMX Output
+  SPIRGBConfiguration spi_rgb_config;
+  spi_rgb_config.module_id = SPI_MODULE_ID;
+  SPIRGB_Init(&spi_rgb_config);
 
   // Send a frame with all pixels set to 0.
   SPIRGB_BeginUpdate();
@@ -153,16 +218,11 @@ void APP_Initialize(void) {
 }
 
 void APP_Tasks(void) {
-  USBTransport_Tasks();
-  Transceiver_Tasks();
-  USBConsole_Tasks();
-
-  if (Transceiver_GetMode() == T_MODE_RESPONDER) {
-    RDMResponder_Tasks();
-    RDMHandler_Tasks();
-    SPIRGB_Tasks();
-    Temperature_Tasks();
+  const bool responder_mode = Transceiver_GetMode() == T_MODE_RESPONDER;
+  if (responder_mode != g_responder_tasks_enabled) {
+    EnableResponderTasks(responder_mode);
   }
+  Scheduler_Run();
 }
 
 void APP_Reset() {
@@ -19,47 +19,72 @@
 
 #include "coarse_timer.h"
 
+#include "core_timer.h"
+
+/*
+ * @brief The number of core timer counts in 0.1ms.
+ */
+static const uint32_t COUNTS_PER_TICK = SYS_CLK_FREQ / 2u / 10000u;
+
+/*
+ * @brief How often to move the time base forward, in core timer counts.
+ *
+ * This must be less than 2^32 counts, after allowing for interrupt latency.
+ */
+static const uint32_t REBASE_INTERVAL = 1u << 30;
+
 typedef struct {
   CoarseTimer_Settings settings;
-  volatile uint32_t timer_count;
+  volatile CoarseTimer_Value base_time;  //!< The time at base_count.
+  volatile uint32_t base_count;  //!< The core timer count at base_time.
+  volatile uint32_t sequence;  //!< Incremented each time the base changes.
 } CoarseTimer_Data;
 
 CoarseTimer_Data g_coarse_timer;
 
+/*
+ * @brief Move the time base forward to the last whole tick.
+ */
+static void Rebase() {
+  const uint32_t ticks =
+      (CoreTimer_GetCount() - g_coarse_timer.base_count) / COUNTS_PER_TICK;
+  g_coarse_timer.base_count += ticks * COUNTS_PER_TICK;
+  g_coarse_timer.base_time += ticks;
+  g_coarse_timer.sequence++;
+}
+
 void CoarseTimer_TimerEvent() {
-  g_coarse_timer.timer_count++;
+  Rebase();
+  CoreTimer_SetCompare(g_coarse_timer.base_count + REBASE_INTERVAL);
   SYS_INT_SourceStatusClear(g_coarse_timer.settings.interrupt_source);
 }
 
 void CoarseTimer_Initialize(const CoarseTimer_Settings *settings) {
-  g_coarse_timer.timer_count = 0u;
   g_coarse_timer.settings = *settings;
+  g_coarse_timer.base_time = 0u;
+  g_coarse_timer.base_count = CoreTimer_GetCount();
+  g_coarse_timer.sequence = 0u;
 
-  PLIB_TMR_Stop(settings->timer_id);
-  PLIB_TMR_ClockSourceSelect(settings->timer_id,
-                             TMR_CLOCK_SOURCE_PERIPHERAL_CLOCK);
-  PLIB_TMR_PrescaleSelect(settings->timer_id, TMR_PRESCALE_VALUE_1);
-  PLIB_TMR_Mode16BitEnable(settings->timer_id);
-  PLIB_TMR_CounterAsyncWriteDisable(settings->timer_id);
-
-  PLIB_TMR_Counter16BitClear(settings->timer_id);
-  PLIB_TMR_Period16BitSet(settings->timer_id, 100u * (SYS_CLK_FREQ / 1000000u));
-  PLIB_TMR_Start(settings->timer_id);
-
+  CoreTimer_SetCompare(g_coarse_timer.base_count + REBASE_INTERVAL);
   SYS_INT_SourceStatusClear(settings->interrupt_source);
   SYS_INT_SourceEnable(settings->interrupt_source);
 }
 
 CoarseTimer_Value CoarseTimer_GetTime() {
-  SYS_INT_SourceDisable(g_coarse_timer.settings.interrupt_source);
-  CoarseTimer_Value value = g_coarse_timer.timer_count;
-  SYS_INT_SourceEnable(g_coarse_timer.settings.interrupt_source);
+  // If the ISR moves the time base while we're reading it, try again.
+  uint32_t sequence;
+  CoarseTimer_Value value;
+  do {
+    sequence = g_coarse_timer.sequence;
+    value = g_coarse_timer.base_time +
+        (CoreTimer_GetCount() - g_coarse_timer.base_count) / COUNTS_PER_TICK;
+  } while (sequence != g_coarse_timer.sequence);
   return value;
 }
 
 uint32_t CoarseTimer_ElapsedTime(CoarseTimer_Value start_time) {
   // This works because of unsigned int math.
-  return g_coarse_timer.timer_count - start_time;
+  return CoarseTimer_GetTime() - start_time;
 }
 
 uint32_t CoarseTimer_Delta(CoarseTimer_Value start_time,
@@ -72,7 +97,7 @@ bool CoarseTimer_HasElapsed(uint32_t start_time, uint32_t duration) {
     return true;
   }
   // This works because of unsigned int math.
-  uint32_t diff = g_coarse_timer.timer_count - start_time;
+  uint32_t diff = CoarseTimer_GetTime() - start_time;
   // The diff needs to be more than duration, since we don't want to fire an
   // event too early. If we use >=, consider:
   //   - start at 1.99ms (counter = 19)
@@ -83,5 +108,7 @@ bool CoarseTimer_HasElapsed(uint32_t start_time, uint32_t duration) {
 }
 
 void CoarseTimer_SetCounter(uint32_t count) {
-  g_coarse_timer.timer_count = count;
+  g_coarse_timer.base_time = count;
+  g_coarse_timer.base_count = CoreTimer_GetCount();
+  g_coarse_timer.sequence++;
 }
@@ -23,6 +23,10 @@
  *
  * The timer is accurate to 10ths of a millisecond.
  *
+ * The time is derived from the free running core timer, so there is no
+ * periodic tick interrupt. The core timer wraps every 107s, so the compare
+ * interrupt is used to move the time base forward every 26s.
+ *
  * @addtogroup timer
  * @{
  * @file coarse_timer.h
@@ -37,7 +41,6 @@
 #include <stdint.h>
 
 #include "system_config.h"
-#include "peripheral/tmr/plib_tmr.h"
 #include "system/int/sys_int.h"
 
 #ifdef __cplusplus
@@ -48,8 +51,7 @@ extern "C" {
  * @brief Settings for the CoarseTimer module.
  */
 typedef struct {
-  TMR_MODULE_ID timer_id;  //!< The timer module to use.
-  INT_SOURCE interrupt_source;  //!< The interrupt source to use.
+  INT_SOURCE interrupt_source;  //!< The core timer interrupt source.
 } CoarseTimer_Settings;
 
 /**
@@ -67,8 +69,7 @@ typedef uint32_t CoarseTimer_Value;
  * @examplepara
  * ~~~~~~~~~~~~~~~~~~~~~
  * CoarseTimer_Settings timer_settings = {
- *   .timer_id = TMR_ID_2,
- *   .interrupt_source = INT_SOURCE_TIMER_2
+ *   .interrupt_source = INT_SOURCE_TIMER_CORE
  * };
  *
  * CoarseTimer_Initialize(&timer_settings);
@@ -77,13 +78,14 @@ typedef uint32_t CoarseTimer_Value;
 void CoarseTimer_Initialize(const CoarseTimer_Settings *settings);
 
 /**
- * @brief Update the timer.
+ * @brief Move the time base forward.
  *
- * This should be called from within an ISR.
+ * This should be called from within the core timer ISR. The ISR must have
+ * the same, or higher, priority than any ISR that uses the timer.
  *
  * @examplepara
  * ~~~~~~~~~~~~~~~~~~~~~
- * void __ISR(_TIMER_2_VECTOR, ipl6) TimerEvent() {
+ * void __ISR(_CORE_TIMER_VECTOR, ipl6) CoreTimerEvent() {
  *  CoarseTimer_TimerEvent();
  * }
  * ~~~~~~~~~~~~~~~~~~~~~
@@ -136,8 +138,8 @@ uint32_t CoarseTimer_Delta(CoarseTimer_Value start_time,
 bool CoarseTimer_HasElapsed(CoarseTimer_Value start_time, uint32_t interval);
 
 /**
- * @brief Manually set the internal counter.
- * @param count the new value of the internal counter.
+ * @brief Manually set the current time.
+ * @param count the new value of the timer.
  * @note This function should be used for testing only.
  */
 void CoarseTimer_SetCounter(uint32_t count);
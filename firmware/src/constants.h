@@ -110,6 +110,30 @@ typedef enum {
    */
   COMMAND_RUN_SELF_TEST = 0x03,
 
+  /**
+   * @brief Get the values of the metrics.
+   * @sa @ref message-commands-getmetrics.
+   */
+  COMMAND_GET_METRICS = 0x04,
+
+  /**
+   * @brief Get the ISR execution time profiles.
+   * @sa @ref message-commands-getisrstats.
+   */
+  COMMAND_GET_ISR_STATS = 0x05,
+
+  /**
+   * @brief Read the transceiver trace.
+   * @sa @ref message-commands-gettrace.
+   */
+  COMMAND_GET_TRACE = 0x06,
+
+  /**
+   * @brief Get the message latency distributions.
+   * @sa @ref message-commands-getlatencystats.
+   */
+  COMMAND_GET_LATENCY_STATS = 0x07,
+
   // User Configuration
   /**
    * @brief Set the break time of the transceiver.
@@ -0,0 +1,34 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * core_timer.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "core_timer.h"
+
+#include <xc.h>
+
+uint32_t CoreTimer_GetCount() {
+  return _CP0_GET_COUNT();
+}
+
+void CoreTimer_SetCompare(uint32_t value) {
+  _CP0_SET_COMPARE(value);
+}
+
+uint32_t CoreTimer_GetCompare() {
+  return _CP0_GET_COMPARE();
+}
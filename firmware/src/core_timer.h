@@ -0,0 +1,72 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * core_timer.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup core_timer Core Timer
+ * @brief Access to the MIPS core timer.
+ *
+ * The core timer is a free running 32-bit counter that increments every
+ * second system clock cycle. It drives the coarse timer, and is used to
+ * measure short intervals, such as how long a task runs for.
+ *
+ * @addtogroup core_timer
+ * @{
+ * @file core_timer.h
+ * @brief Access to the MIPS core timer.
+ */
+
+#ifndef FIRMWARE_SRC_CORE_TIMER_H_
+#define FIRMWARE_SRC_CORE_TIMER_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Get the current value of the core timer.
+ * @returns The core timer count. This wraps every 2^32 counts, use unsigned
+ *   subtraction to compute intervals.
+ */
+uint32_t CoreTimer_GetCount();
+
+/**
+ * @brief Set the core timer compare register.
+ * @param value The count at which to raise the core timer interrupt.
+ *
+ * This also clears a pending core timer interrupt.
+ */
+void CoreTimer_SetCompare(uint32_t value);
+
+/**
+ * @brief Get the core timer compare register.
+ * @returns The count at which the core timer interrupt is raised.
+ */
+uint32_t CoreTimer_GetCompare();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FIRMWARE_SRC_CORE_TIMER_H_
+
+/**
+ * @}
+ */
@@ -19,22 +19,33 @@
 #include "dimmer_model.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "coarse_timer.h"
 #include "constants.h"
+#include "dmx_spec.h"
 #include "macros.h"
 #include "rdm_frame.h"
 #include "rdm_buffer.h"
 #include "rdm_responder.h"
 #include "rdm_util.h"
+#include "timer_wheel.h"
 #include "utils.h"
 
 #include <syslog.h>
 
 #include <system_config.h>
+#include "app_settings.h"
+
+#if DIMMER_SUB_DEVICE_COUNT < 1 || DIMMER_SUB_DEVICE_COUNT > 512
+#error "DIMMER_SUB_DEVICE_COUNT must be between 1 and 512"
+#endif
 
 // Various constants
-enum { NUMBER_OF_SUB_DEVICES = 4 };
+enum { NUMBER_OF_SUB_DEVICES = DIMMER_SUB_DEVICE_COUNT };
+enum { SUB_DEVICE_FOOTPRINT = 1 };
+enum { NUMBER_OF_CUSTOM_LABELS = DIMMER_CUSTOM_LABEL_COUNT };
+enum { SUB_DEVICE_STATUS_MESSAGE_POOL_SIZE = 8 };
 enum { NUMBER_OF_SCENES = 3 };
 enum { NUMBER_OF_LOCK_STATES = 3 };
 enum { NUMBER_OF_CURVES = 4 };
@@ -51,6 +62,12 @@ static const char PERSONALITY_DESCRIPTION[] = "Dimmer";
 static const uint8_t STATUS_TYPE_MASK = 0xf;
 static const uint16_t INITIAL_START_ADDRESS = 1u;
 static const uint32_t STATUS_MESSAGE_TRIGGER_INTERVAL = 300000;  // 30s
+static const uint32_t OUTPUT_TICK_INTERVAL = 100;  // 10ms
+static const uint16_t DEFAULT_MAXIMUM_LEVEL = 0xfffe;
+static const uint32_t PRESET_TIME_UNIT = 1000;  // 100ms
+static const uint32_t FADE_COMPLETE = 0x10000;
+static const uint32_t DMX_LOSS_TIMEOUT = 10000;  // 1s, the max break to break
+static const uint16_t INFINITE_TIME = 0xffff;
 
 static const char LOCK_STATE_DESCRIPTION_UNLOCKED[] = "Unlocked";
 static const char LOCK_STATE_DESCRIPTION_SUBDEVICES_LOCKED[] =
@@ -88,12 +105,27 @@ typedef struct {
 } ModulationFrequency;
 
 typedef struct {
+  uint8_t levels[NUMBER_OF_SUB_DEVICES];  //!< The captured levels, by slot.
   uint16_t up_fade_time;
   uint16_t down_fade_time;
   uint16_t wait_time;
   uint8_t programmed_state;
 } Scene;
 
+typedef enum {
+  PLAYBACK_STATE_OFF,  //!< The outputs follow the DMX data.
+  PLAYBACK_STATE_FADING,  //!< Fading to a scene.
+  PLAYBACK_STATE_WAITING,  //!< Waiting before moving to the next scene.
+  PLAYBACK_STATE_HOLDING  //!< Holding a single scene.
+} PlaybackState;
+
+typedef enum {
+  MONITOR_STARTUP_DELAY,  //!< Waiting to play the startup scene.
+  MONITOR_SIGNAL_PRESENT,  //!< DMX is being received.
+  MONITOR_HOLDING,  //!< Holding the startup or fail scene.
+  MONITOR_IDLE  //!< Nothing to do until DMX is received.
+} MonitorState;
+
 typedef struct {
   uint16_t sub_device;
   uint16_t message_id;
@@ -115,8 +147,8 @@ typedef struct {
    * Remember this when using the array.
    */
   Scene scenes[NUMBER_OF_SCENES];
-  CoarseTimer_Value status_message_timer;
-  CoarseTimer_Value self_test_timer;
+  TimerWheel_Timer status_message_timer;
+  TimerWheel_Timer self_test_timer;
   StatusMessage status_message;
 
   uint16_t playback_mode;
@@ -138,29 +170,147 @@ typedef struct {
   uint8_t running_self_test;
 } RootDevice;
 
+/*
+ * @brief The enumerated settings for a sub device, packed into 16 bits.
+ */
 typedef struct {
-  RDMResponder responder;
-  StatusMessage status_message;
+  uint16_t curve : 3;
+  uint16_t output_response_time : 2;
+  uint16_t modulation_frequency : 3;
+  uint16_t sd_report_threshold : 3;
+  uint16_t on_below_min : 1;
+  uint16_t identify_on : 1;
+  uint16_t identify_loud : 1;
+} SubDeviceSettings;
 
-  uint16_t index;
-  uint16_t min_level_increasing;
-  uint16_t min_level_decreasing;
-  uint16_t max_level;
-  uint8_t on_below_min;
-  uint8_t identify_mode;
-  uint8_t burn_in;
-  uint8_t curve;
-  uint8_t output_response_time;
-  uint8_t modulation_frequency;
-  RDMStatusType sd_report_threshold;
-} DimmerSubDevice;
+/*
+ * @brief The state of all the sub devices, indexed by slot.
+ *
+ * The state that is the same for all sub devices lives in the shared
+ * RDMResponder, g_subdevice_responder.
+ */
+typedef struct {
+  uint16_t start_address[NUMBER_OF_SUB_DEVICES];
+  uint16_t min_level_increasing[NUMBER_OF_SUB_DEVICES];
+  uint16_t min_level_decreasing[NUMBER_OF_SUB_DEVICES];
+  uint16_t max_level[NUMBER_OF_SUB_DEVICES];
+  SubDeviceSettings settings[NUMBER_OF_SUB_DEVICES];
+  uint8_t burn_in[NUMBER_OF_SUB_DEVICES];
+
+  /*
+   * @brief The custom label for each sub device.
+   *
+   * 0 means the sub device uses DEFAULT_DEVICE_LABEL, otherwise this is the
+   * index + 1 in g_custom_labels.
+   */
+  uint8_t label[NUMBER_OF_SUB_DEVICES];
+
+  /*
+   * @brief The number of sub devices that don't follow on from the first sub
+   * device. If this is 0, the sub devices form a contiguous block.
+   */
+  uint16_t out_of_block_count;
+} SubDevices;
+
+/*
+ * @brief A custom label, which may be shared by many sub devices.
+ */
+typedef struct {
+  char label[RDM_DEFAULT_STRING_SIZE];
+  uint16_t ref_count;
+} CustomLabel;
 
 typedef struct {
   StatusMessage last[STATUS_MESSAGE_QUEUE_SIZE];
   uint8_t count;
 } StatusMessages;
 
-static DimmerSubDevice g_subdevices[NUMBER_OF_SUB_DEVICES];
+static SubDevices g_subdevices;
+static RDMResponder g_subdevice_responder;
+static CustomLabel g_custom_labels[NUMBER_OF_CUSTOM_LABELS];
+
+/*
+ * @brief Status messages queued by the sub devices.
+ *
+ * Each sub device has at most one active message. Only a handful of sub
+ * devices generate messages so these are pooled, rather than reserving space
+ * for every sub device.
+ */
+static StatusMessage
+    g_subdevice_status_messages[SUB_DEVICE_STATUS_MESSAGE_POOL_SIZE];
+
+/*
+ * @brief The dimming engine.
+ */
+typedef struct {
+  uint8_t universe[DMX_FRAME_SIZE];  //!< The last received DMX data.
+  uint8_t last_dmx[NUMBER_OF_SUB_DEVICES];  //!< The DMX levels, by slot.
+  /*
+   * @brief For LTP merging, true if the DMX level changed after the last
+   * preset was started.
+   */
+  bool dmx_is_latest[NUMBER_OF_SUB_DEVICES];
+  uint16_t input[NUMBER_OF_SUB_DEVICES];  //!< The merged 8.8 levels, by slot.
+  uint16_t output[NUMBER_OF_SUB_DEVICES];  //!< The output levels, by slot.
+  TimerWheel_Timer tick_timer;  //!< Runs the engine every OUTPUT_TICK_INTERVAL.
+} DimmerEngine;
+
+static DimmerEngine g_engine;
+
+/*
+ * @brief The preset playback engine.
+ *
+ * Levels are 8.8 fixed point DMX levels, which are fed into the dimming
+ * engine in place of the received DMX data.
+ */
+typedef struct {
+  uint16_t level[NUMBER_OF_SUB_DEVICES];  //!< The current levels, by slot.
+  uint16_t from[NUMBER_OF_SUB_DEVICES];  //!< The levels when the fade started.
+  CoarseTimer_Value fade_start;  //!< When the current fade started.
+  TimerWheel_Timer wait_timer;  //!< Moves on to the next scene in a sequence.
+  uint16_t scene;  //!< The scene we're fading to or holding, indexed from 1.
+  uint8_t playback_level;  //!< The level to play the scene at.
+  bool sequence;  //!< True if we're cycling through all the scenes.
+  PlaybackState state;
+} Playback;
+
+static Playback g_playback;
+
+/*
+ * @brief Tracks the presence of the DMX signal.
+ *
+ * This triggers the startup & fail scenes. It only looks at when the last
+ * frame arrived, not the data itself. The return of the signal is handled as
+ * soon as a frame arrives. While the signal is present, a frame only updates
+ * last_frame; the loss of signal timer checks it when it expires and is
+ * rescheduled if a frame arrived since.
+ */
+typedef struct {
+  CoarseTimer_Value last_frame;  //!< When DMX data was last received.
+  CoarseTimer_Value start;  //!< When the startup delay or hold time started.
+  TimerWheel_Timer timer;  //!< Expires at the deadline for the current state.
+  uint16_t hold_time;  //!< The hold time for the current scene.
+  MonitorState state;
+} SignalMonitor;
+
+static SignalMonitor g_signal_monitor;
+
+/*
+ * @brief The curve lookup tables, these map a DMX level to a 16-bit level.
+ *
+ * These are built by DimmerModel_Initialize().
+ */
+static uint16_t g_curves[NUMBER_OF_CURVES][UINT8_MAX + 1u];
+
+static const SubDeviceSettings DEFAULT_SUB_DEVICE_SETTINGS = {
+  .curve = 1u,
+  .output_response_time = 1u,
+  .modulation_frequency = 1u,
+  .sd_report_threshold = STATUS_ADVISORY,
+  .on_below_min = false,
+  .identify_on = false,
+  .identify_loud = false
+};
 
 static const char* LOCK_STATES[NUMBER_OF_LOCK_STATES] = {
   LOCK_STATE_DESCRIPTION_UNLOCKED,
@@ -180,6 +330,15 @@ static const char* OUTPUT_RESPONSE_TIMES[NUMBER_OF_OUTPUT_RESPONSE_TIMES] = {
   OUTPUT_RESPONSE_DESCRIPTION2,
 };
 
+/*
+ * @brief The maximum change in the output level per tick, for each output
+ * response time. Fast goes from 0 to full in 100ms, slow takes 1s.
+ */
+static const uint16_t OUTPUT_RESPONSE_STEP[NUMBER_OF_OUTPUT_RESPONSE_TIMES] = {
+  6554u,
+  656u,
+};
+
 static const ModulationFrequency
 MODULATION_FREQUENCY[NUMBER_OF_MODULATION_FREQUENCIES] = {
   {
@@ -214,15 +373,82 @@ static const SelfTest SELF_TESTS[NUMBER_OF_SELF_TESTS] = {
 static const ResponderDefinition ROOT_RESPONDER_DEFINITION;
 static const ResponderDefinition SUBDEVICE_RESPONDER_DEFINITION;
 
+static const ResponderDefinition *const RESPONDER_DEFINITIONS[] = {
+  &ROOT_RESPONDER_DEFINITION,
+  &SUBDEVICE_RESPONDER_DEFINITION
+};
+
 static StatusMessages g_status_messages;
 
 
 static RootDevice g_root_device;
-static DimmerSubDevice *g_active_device = NULL;
+
+/*
+ * @brief The slot of the sub device that is handling the current request.
+ */
+static unsigned int g_active_slot = 0u;
 
 // Helper functions
 // ----------------------------------------------------------------------------
 
+/*
+ * @brief Get the sub device index for a slot.
+ *
+ * If there are fewer than 512 sub devices, we leave a gap at index 2, since
+ * sub devices aren't required to be contiguous.
+ */
+static inline uint16_t SubDeviceIndex(unsigned int slot) {
+  return slot + 1u + (NUMBER_OF_SUB_DEVICES < SUBDEVICE_MAX && slot ? 1u : 0u);
+}
+
+/*
+ * @brief Check if a start address follows on from the first sub device.
+ */
+static inline bool IsInBlock(unsigned int slot, uint16_t start_address) {
+  return start_address ==
+      g_subdevices.start_address[0] + slot * SUB_DEVICE_FOOTPRINT;
+}
+
+/*
+ * @brief Recount the sub devices that aren't part of the block.
+ */
+static void CountOutOfBlock() {
+  g_subdevices.out_of_block_count = 0u;
+  unsigned int slot = 1u;
+  for (; slot < NUMBER_OF_SUB_DEVICES; slot++) {
+    if (!IsInBlock(slot, g_subdevices.start_address[slot])) {
+      g_subdevices.out_of_block_count++;
+    }
+  }
+}
+
+/*
+ * @brief Set the start address of a single sub device.
+ *
+ * This keeps g_subdevices.out_of_block_count up to date. Changing the first
+ * sub device moves the whole block, so that requires a recount.
+ */
+static void SetSubDeviceStartAddress(unsigned int slot,
+                                     uint16_t start_address) {
+  if (g_subdevices.start_address[slot] == start_address) {
+    return;
+  }
+
+  if (slot == 0u) {
+    g_subdevices.start_address[0] = start_address;
+    CountOutOfBlock();
+    return;
+  }
+
+  if (IsInBlock(slot, g_subdevices.start_address[slot])) {
+    g_subdevices.out_of_block_count++;
+  }
+  g_subdevices.start_address[slot] = start_address;
+  if (IsInBlock(slot, start_address)) {
+    g_subdevices.out_of_block_count--;
+  }
+}
+
 /*
  * @brief Set a block address for all the sub devices.
  * @param start_address the new start address
@@ -230,27 +456,75 @@ static DimmerSubDevice *g_active_device = NULL;
  *   footprint of the sub devices would exceed the last slot (512).
  */
 bool ResetToBlockAddress(uint16_t start_address) {
-  unsigned int footprint = 0u;
+  const unsigned int footprint = NUMBER_OF_SUB_DEVICES * SUB_DEVICE_FOOTPRINT;
+  if ((uint16_t) (MAX_DMX_START_ADDRESS - start_address + 1u) < footprint) {
+    return false;
+  }
+
   unsigned int i = 0u;
   for (; i < NUMBER_OF_SUB_DEVICES; i++) {
-    RDMResponder *responder = &g_subdevices[i].responder;
-    footprint +=
-        responder->def->personalities[responder->current_personality - 1u]
-            .slot_count;
+    g_subdevices.start_address[i] = start_address;
+    start_address += SUB_DEVICE_FOOTPRINT;
   }
+  g_subdevices.out_of_block_count = 0u;
+  return true;
+}
 
-  if ((uint16_t) (MAX_DMX_START_ADDRESS - start_address + 1u) < footprint) {
-    return false;
+/*
+ * @brief Find the active status message for a sub device.
+ * @returns The status message, or NULL if the sub device doesn't have one.
+ */
+static StatusMessage *FindSubDeviceStatusMessage(uint16_t sub_device_index) {
+  unsigned int i = 0u;
+  for (; i < SUB_DEVICE_STATUS_MESSAGE_POOL_SIZE; i++) {
+    StatusMessage *message = &g_subdevice_status_messages[i];
+    if (message->is_active && message->sub_device == sub_device_index) {
+      return message;
+    }
   }
+  return NULL;
+}
 
-  for (i = 0u; i < NUMBER_OF_SUB_DEVICES; i++) {
-    RDMResponder *responder = &g_subdevices[i].responder;
-    responder->dmx_start_address = start_address;
-    const PersonalityDefinition *personality =
-        &responder->def->personalities[responder->current_personality - 1u];
-    start_address += personality->slot_count;
+/*
+ * @brief Find the custom label for the active sub device.
+ * @returns The label or DEFAULT_DEVICE_LABEL.
+ */
+static const char *ActiveSubDeviceLabel() {
+  const uint8_t label = g_subdevices.label[g_active_slot];
+  return label ? g_custom_labels[label - 1u].label : DEFAULT_DEVICE_LABEL;
+}
+
+/*
+ * @brief Find an in-use custom label that matches.
+ * @returns The index + 1 of the custom label, or 0 if there wasn't a match.
+ */
+static uint8_t FindCustomLabel(const char *label, unsigned int length) {
+  unsigned int i = 0u;
+  for (; i < NUMBER_OF_CUSTOM_LABELS; i++) {
+    const CustomLabel *custom_label = &g_custom_labels[i];
+    if (custom_label->ref_count &&
+        RDMUtil_SafeStringLength(custom_label->label,
+                                 RDM_DEFAULT_STRING_SIZE) == length &&
+        memcmp(custom_label->label, label, length) == 0) {
+      return i + 1u;
+    }
   }
-  return true;
+  return 0u;
+}
+
+/*
+ * @brief Set the custom label for the active sub device.
+ * @param label The index + 1 of the custom label, or 0 for the default label.
+ */
+static void SetActiveSubDeviceLabel(uint8_t label) {
+  const uint8_t old_label = g_subdevices.label[g_active_slot];
+  if (old_label) {
+    g_custom_labels[old_label - 1u].ref_count--;
+  }
+  if (label) {
+    g_custom_labels[label - 1u].ref_count++;
+  }
+  g_subdevices.label[g_active_slot] = label;
 }
 
 uint8_t *AddStatusMessageToResponse(uint8_t *ptr,
@@ -277,18 +551,30 @@ void QueueStatusMessage(StatusMessage *message,
   message->data_value2 = data_value2;
 }
 
-void QueueSubDeviceStatusMessage(DimmerSubDevice *device,
+void QueueSubDeviceStatusMessage(unsigned int slot,
                                  RDMStatusType status_type,
                                  RDMStatusMessageId status_id,
                                  uint16_t data_value1,
                                  uint16_t data_value2) {
-  if (device->sd_report_threshold == STATUS_NONE ||
-      (status_type & STATUS_TYPE_MASK) < device->sd_report_threshold) {
+  const uint8_t threshold = g_subdevices.settings[slot].sd_report_threshold;
+  if (threshold == STATUS_NONE ||
+      (status_type & STATUS_TYPE_MASK) < threshold) {
     return;
   }
 
-  QueueStatusMessage(&device->status_message, device->index,
-                     status_type, status_id, data_value1, data_value2);
+  const uint16_t sub_device_index = SubDeviceIndex(slot);
+  StatusMessage *message = FindSubDeviceStatusMessage(sub_device_index);
+  unsigned int i = 0u;
+  for (; message == NULL && i < SUB_DEVICE_STATUS_MESSAGE_POOL_SIZE; i++) {
+    if (!g_subdevice_status_messages[i].is_active) {
+      message = &g_subdevice_status_messages[i];
+    }
+  }
+
+  if (message) {
+    QueueStatusMessage(message, sub_device_index, status_type, status_id,
+                       data_value1, data_value2);
+  }
 }
 
 /*
@@ -307,6 +593,392 @@ bool MaybeDequeueStatusMessage(StatusMessage *message, uint8_t threshold) {
   return true;
 }
 
+/*
+ * @brief Build the curve lookup tables.
+ *
+ * The curves are:
+ *  - Linear.
+ *  - Modified Linear, the mean of the linear and square curves.
+ *  - Square.
+ *  - Modified Square, a cubic curve.
+ */
+static void BuildCurves() {
+  // Each curve is first computed in the range 0 - 65025 (255 * 255).
+  const uint32_t full_scale = UINT8_MAX * UINT8_MAX;
+  uint32_t level = 0u;
+  for (; level <= UINT8_MAX; level++) {
+    const uint32_t linear = level * UINT8_MAX;
+    const uint32_t square = level * level;
+    const uint32_t cube = square * level / UINT8_MAX;
+    g_curves[0][level] = linear * UINT16_MAX / full_scale;
+    g_curves[1][level] = (linear + square) / 2u * UINT16_MAX / full_scale;
+    g_curves[2][level] = square * UINT16_MAX / full_scale;
+    g_curves[3][level] = cube * UINT16_MAX / full_scale;
+  }
+}
+
+/*
+ * @brief Scale a 16-bit level to the range [min_level, max_level].
+ */
+static inline uint16_t ScaleLevel(uint32_t level, uint16_t min_level,
+                                  uint16_t max_level) {
+  if (max_level <= min_level) {
+    return min_level;
+  }
+  // Adding the top bit maps 0xffff to 0x10000, so full scale is max_level.
+  return min_level +
+      (((level + (level >> 15)) * (uint32_t) (max_level - min_level)) >> 16);
+}
+
+/*
+ * @brief Look up an 8.8 fixed point level in a curve, interpolating between
+ * the entries.
+ */
+static inline uint32_t CurveLevel(const uint16_t *curve, uint16_t level) {
+  const uint8_t index = level >> 8;
+  const uint8_t fraction = level & 0xff;
+  if (fraction == 0u || index == UINT8_MAX) {
+    return curve[index];
+  }
+  // The curves are increasing, so the difference is always positive.
+  return curve[index] +
+      (((uint32_t) (curve[index + 1u] - curve[index]) * fraction) >> 8);
+}
+
+/*
+ * @brief Merge the DMX data and the preset playback levels into
+ * g_engine.input.
+ *
+ * The merge mode is checked once, so each loop is a load, a compare and a
+ * select for each slot.
+ */
+static void MergeInputs() {
+  uint16_t *input = g_engine.input;
+  const uint16_t *preset = g_playback.level;
+  unsigned int slot = 0u;
+  for (; slot < NUMBER_OF_SUB_DEVICES; slot++) {
+    const uint8_t dmx =
+        g_engine.universe[g_subdevices.start_address[slot] - 1u];
+    if (dmx != g_engine.last_dmx[slot]) {
+      g_engine.last_dmx[slot] = dmx;
+      g_engine.dmx_is_latest[slot] = true;
+    }
+    input[slot] = dmx << 8;
+  }
+
+  if (g_playback.state == PLAYBACK_STATE_OFF) {
+    return;
+  }
+
+  switch (g_root_device.merge_mode) {
+    case MERGE_MODE_HTP:
+      for (slot = 0u; slot < NUMBER_OF_SUB_DEVICES; slot++) {
+        input[slot] = preset[slot] > input[slot] ? preset[slot] : input[slot];
+      }
+      break;
+    case MERGE_MODE_LTP:
+      for (slot = 0u; slot < NUMBER_OF_SUB_DEVICES; slot++) {
+        input[slot] = g_engine.dmx_is_latest[slot] ? input[slot] : preset[slot];
+      }
+      break;
+    case MERGE_MODE_DMX_ONLY:
+      // Presets are only used when there is no DMX.
+      if (g_signal_monitor.state != MONITOR_SIGNAL_PRESENT) {
+        memcpy(input, preset, sizeof(g_engine.input));
+      }
+      break;
+    case MERGE_MODE_DEFAULT:
+    default:
+      // The preset overrides DMX.
+      memcpy(input, preset, sizeof(g_engine.input));
+  }
+}
+
+/*
+ * @brief Find the next programmed scene, wrapping around at the end.
+ */
+static uint16_t NextProgrammedScene(uint16_t scene_index) {
+  unsigned int i = 0u;
+  for (; i < NUMBER_OF_SCENES; i++) {
+    scene_index = scene_index % NUMBER_OF_SCENES + 1u;
+    if (g_root_device.scenes[scene_index - 1u].programmed_state !=
+        PRESET_NOT_PROGRAMMED) {
+      return scene_index;
+    }
+  }
+  return PRESET_PLAYBACK_OFF;
+}
+
+/*
+ * @brief Start a fade from the current levels to a scene.
+ */
+static void StartFade(uint16_t scene_index) {
+  MergeInputs();
+  memcpy(g_playback.from, g_engine.input, sizeof(g_playback.from));
+  memcpy(g_playback.level, g_engine.input, sizeof(g_playback.level));
+  memset(g_engine.dmx_is_latest, 0, sizeof(g_engine.dmx_is_latest));
+  g_playback.scene = scene_index;
+  g_playback.fade_start = CoarseTimer_GetTime();
+  g_playback.state = PLAYBACK_STATE_FADING;
+  TimerWheel_Cancel(&g_playback.wait_timer);
+}
+
+/*
+ * @brief Called when the wait time for a scene in a sequence expires.
+ */
+static void PlayNextScene() {
+  StartFade(NextProgrammedScene(g_playback.scene));
+}
+
+/*
+ * @brief Start or stop playback.
+ * @param scene_index The scene to play, PRESET_PLAYBACK_OFF or
+ *   PRESET_PLAYBACK_ALL.
+ * @param level The playback level.
+ */
+static void StartPlayback(uint16_t scene_index, uint8_t level) {
+  g_playback.playback_level = level;
+  g_playback.sequence = scene_index == PRESET_PLAYBACK_ALL;
+  if (scene_index == PRESET_PLAYBACK_OFF) {
+    g_playback.state = PLAYBACK_STATE_OFF;
+    TimerWheel_Cancel(&g_playback.wait_timer);
+  } else if (scene_index == PRESET_PLAYBACK_ALL) {
+    StartFade(NextProgrammedScene(NUMBER_OF_SCENES));
+  } else {
+    StartFade(scene_index);
+  }
+}
+
+/*
+ * @brief Play the startup or fail scene, if one is configured.
+ */
+static void StartSignalScene(uint16_t scene_index, uint8_t level,
+                             uint16_t hold_time) {
+  // Playback set with PRESET_PLAYBACK takes priority.
+  if (scene_index == PRESET_PLAYBACK_OFF ||
+      g_root_device.playback_mode != PRESET_PLAYBACK_OFF) {
+    g_signal_monitor.state = MONITOR_IDLE;
+    return;
+  }
+  StartPlayback(scene_index, level);
+  g_signal_monitor.hold_time = hold_time;
+  g_signal_monitor.start = CoarseTimer_GetTime();
+  g_signal_monitor.state = MONITOR_HOLDING;
+}
+
+/*
+ * @brief Get the time until the deadline for the signal monitor's state.
+ * @param remaining Set to the time remaining, in 10ths of a millisecond.
+ * @returns false if the state doesn't have a deadline.
+ */
+static bool SignalMonitorDeadline(uint32_t *remaining) {
+  CoarseTimer_Value start = g_signal_monitor.start;
+  uint32_t delay = 0u;
+  switch (g_signal_monitor.state) {
+    case MONITOR_STARTUP_DELAY:
+      if (g_root_device.startup_delay == INFINITE_TIME) {
+        return false;
+      }
+      delay = g_root_device.startup_delay * PRESET_TIME_UNIT;
+      break;
+    case MONITOR_SIGNAL_PRESENT:
+      if (g_root_device.fail_loss_of_signal_delay == INFINITE_TIME) {
+        return false;
+      }
+      delay = g_root_device.fail_loss_of_signal_delay * PRESET_TIME_UNIT;
+      if (delay < DMX_LOSS_TIMEOUT) {
+        delay = DMX_LOSS_TIMEOUT;
+      }
+      start = g_signal_monitor.last_frame;
+      break;
+    case MONITOR_HOLDING:
+      if (g_signal_monitor.hold_time == INFINITE_TIME) {
+        return false;
+      }
+      delay = g_signal_monitor.hold_time * PRESET_TIME_UNIT;
+      break;
+    case MONITOR_IDLE:
+    default:
+      return false;
+  }
+
+  const uint32_t elapsed = CoarseTimer_ElapsedTime(start);
+  *remaining = elapsed < delay ? delay - elapsed : 0u;
+  return true;
+}
+
+/*
+ * @brief Called when the deadline for the signal monitor's state expires.
+ */
+static void SignalMonitorTimeout() {
+  uint32_t remaining = 0u;
+  switch (g_signal_monitor.state) {
+    case MONITOR_STARTUP_DELAY:
+      StartSignalScene(g_root_device.startup_scene,
+                       g_root_device.startup_level,
+                       g_root_device.startup_hold);
+      break;
+    case MONITOR_SIGNAL_PRESENT:
+      // A frame may have arrived since the deadline was last set.
+      if (SignalMonitorDeadline(&remaining) && remaining == 0u) {
+        StartSignalScene(g_root_device.fail_scene,
+                         g_root_device.fail_level,
+                         g_root_device.fail_hold_time);
+      }
+      break;
+    case MONITOR_HOLDING:
+      // Fade the scene out.
+      if (g_root_device.playback_mode == PRESET_PLAYBACK_OFF) {
+        g_playback.playback_level = 0u;
+        g_playback.sequence = false;
+        StartFade(g_playback.scene);
+      }
+      g_signal_monitor.state = MONITOR_IDLE;
+      break;
+    case MONITOR_IDLE:
+      break;
+  }
+
+  if (SignalMonitorDeadline(&remaining)) {
+    TimerWheel_Schedule(&g_signal_monitor.timer, remaining,
+                        SignalMonitorTimeout);
+  }
+}
+
+/*
+ * @brief Set the signal monitor's timer after the state or the startup / fail
+ * settings change.
+ */
+static void UpdateSignalMonitorTimer() {
+  uint32_t remaining;
+  if (SignalMonitorDeadline(&remaining)) {
+    TimerWheel_Schedule(&g_signal_monitor.timer, remaining,
+                        SignalMonitorTimeout);
+  } else {
+    TimerWheel_Cancel(&g_signal_monitor.timer);
+  }
+}
+
+/*
+ * @brief Called when a DMX frame arrives while the signal isn't present.
+ */
+static void SignalReturned() {
+  if (g_root_device.playback_mode == PRESET_PLAYBACK_OFF) {
+    StartPlayback(PRESET_PLAYBACK_OFF, 0u);
+  }
+  g_signal_monitor.state = MONITOR_SIGNAL_PRESENT;
+  UpdateSignalMonitorTimer();
+}
+
+/*
+ * @brief Get the fraction of a fade that is complete.
+ * @param elapsed The time since the fade started.
+ * @param fade_time The fade time, in units of 100ms.
+ * @returns The fraction, with FADE_COMPLETE representing 1.
+ */
+static uint32_t FadeFraction(uint32_t elapsed, uint16_t fade_time) {
+  const uint32_t duration = fade_time * PRESET_TIME_UNIT;
+  if (elapsed >= duration) {
+    return FADE_COMPLETE;
+  }
+  return ((uint64_t) elapsed << 16) / duration;
+}
+
+/*
+ * @brief Run one tick of the preset playback engine.
+ *
+ * The fade fractions are computed once per tick, which leaves a multiply and
+ * a shift for each slot.
+ */
+static void RunPlayback() {
+  if (g_playback.state != PLAYBACK_STATE_FADING) {
+    return;
+  }
+
+  const Scene *scene = &g_root_device.scenes[g_playback.scene - 1u];
+  const uint32_t elapsed = CoarseTimer_ElapsedTime(g_playback.fade_start);
+
+  const uint32_t up_fraction = FadeFraction(elapsed, scene->up_fade_time);
+  const uint32_t down_fraction = FadeFraction(elapsed, scene->down_fade_time);
+  // The playback level is a 0.16 multiplier, see ScaleLevel().
+  const uint32_t playback_scale = g_playback.playback_level * 257u;
+  const uint32_t scale = playback_scale + (playback_scale >> 15);
+
+  unsigned int slot = 0u;
+  for (; slot < NUMBER_OF_SUB_DEVICES; slot++) {
+    const uint16_t from = g_playback.from[slot];
+    const uint16_t target = ((scene->levels[slot] << 8) * scale) >> 16;
+    if (target >= from) {
+      g_playback.level[slot] =
+          from + (((uint32_t) (target - from) * up_fraction) >> 16);
+    } else {
+      g_playback.level[slot] =
+          from - (((uint32_t) (from - target) * down_fraction) >> 16);
+    }
+  }
+
+  if (up_fraction == FADE_COMPLETE && down_fraction == FADE_COMPLETE) {
+    if (g_playback.sequence) {
+      g_playback.state = PLAYBACK_STATE_WAITING;
+      TimerWheel_Schedule(&g_playback.wait_timer,
+                          scene->wait_time * PRESET_TIME_UNIT, PlayNextScene);
+    } else {
+      g_playback.state = PLAYBACK_STATE_HOLDING;
+    }
+  }
+}
+
+/*
+ * @brief Run one tick of the dimming engine.
+ */
+static void RunEngine() {
+  unsigned int slot = 0u;
+  for (; slot < NUMBER_OF_SUB_DEVICES; slot++) {
+    const SubDeviceSettings settings = g_subdevices.settings[slot];
+    const uint16_t level = g_engine.input[slot];
+    const uint16_t max_level = g_subdevices.max_level[slot];
+    uint16_t output = g_engine.output[slot];
+    uint16_t target = 0u;
+
+    if (level == 0u) {
+      if (settings.on_below_min) {
+        target = g_subdevices.min_level_decreasing[slot];
+      }
+    } else {
+      // The minimum level depends on which way the output is moving.
+      const uint32_t curve_level =
+          CurveLevel(g_curves[settings.curve - 1u], level);
+      target = ScaleLevel(curve_level,
+                          g_subdevices.min_level_increasing[slot], max_level);
+      if (target < output) {
+        target = ScaleLevel(curve_level,
+                            g_subdevices.min_level_decreasing[slot],
+                            max_level);
+      }
+    }
+
+    const uint16_t step =
+        OUTPUT_RESPONSE_STEP[settings.output_response_time - 1u];
+    if (target > output) {
+      output = target - output > step ? output + step : target;
+    } else {
+      output = output - target > step ? output - step : target;
+    }
+    g_engine.output[slot] = output;
+  }
+}
+
+/*
+ * @brief Run the playback & dimming engines.
+ *
+ * This is called every OUTPUT_TICK_INTERVAL by the timer wheel.
+ */
+static void RunOutputTick() {
+  RunPlayback();
+  MergeInputs();
+  RunEngine();
+}
+
 // Root PID Handlers
 // ----------------------------------------------------------------------------
 int DimmerModel_GetStatusMessages(const RDMHeader *header,
@@ -339,11 +1011,10 @@ int DimmerModel_GetStatusMessages(const RDMHeader *header,
 
     // Check the sub devices.
     unsigned int i = 0u;
-    for (; i < NUMBER_OF_SUB_DEVICES &&
+    for (; i < SUB_DEVICE_STATUS_MESSAGE_POOL_SIZE &&
            g_status_messages.count < STATUS_MESSAGE_QUEUE_SIZE; i++) {
-      DimmerSubDevice *subdevice = &g_subdevices[i];
-
-      if (MaybeDequeueStatusMessage(&subdevice->status_message, threshold)) {
+      if (MaybeDequeueStatusMessage(&g_subdevice_status_messages[i],
+                                    threshold)) {
         ptr = AddStatusMessageToResponse(
                   ptr, &g_status_messages.last[g_status_messages.count]);
         g_status_messages.count++;
@@ -375,6 +1046,20 @@ int DimmerModel_GetSelfTest(const RDMHeader *header,
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
 
+/*
+ * @brief Called when the running self test completes.
+ */
+static void SelfTestComplete() {
+  // Queue a status message for the root.
+  QueueStatusMessage(
+      &g_root_device.status_message, SUBDEVICE_ROOT, STATUS_ADVISORY,
+      (uint16_t) (g_root_device.running_self_test == 1u ?
+          STS_OLP_SELFTEST_PASSED : STS_OLP_SELFTEST_FAILED),
+      g_root_device.running_self_test, 0u);
+
+  g_root_device.running_self_test = SELF_TEST_OFF;
+}
+
 int DimmerModel_PerformSelfTest(const RDMHeader *header,
                                 const uint8_t *param_data) {
   if (header->param_data_length != sizeof(uint8_t)) {
@@ -389,13 +1074,16 @@ int DimmerModel_PerformSelfTest(const RDMHeader *header,
 
   if (self_test_id == SELF_TEST_OFF) {
     g_root_device.running_self_test = SELF_TEST_OFF;
+    TimerWheel_Cancel(&g_root_device.self_test_timer);
   } else {
     if (g_root_device.running_self_test) {
       return RDMResponder_BuildNack(header, NR_ACTION_NOT_SUPPORTED);
     }
 
     g_root_device.running_self_test = self_test_id;
-    g_root_device.self_test_timer = CoarseTimer_GetTime();
+    TimerWheel_Schedule(&g_root_device.self_test_timer,
+                        SELF_TESTS[self_test_id - 1].duration,
+                        SelfTestComplete);
   }
   return RDMResponder_BuildSetAck(header);
 }
@@ -436,6 +1124,11 @@ int DimmerModel_CapturePreset(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_WRITE_PROTECT);
   }
 
+  MergeInputs();
+  unsigned int slot = 0u;
+  for (; slot < NUMBER_OF_SUB_DEVICES; slot++) {
+    scene->levels[slot] = g_engine.input[slot] >> 8;
+  }
   scene->up_fade_time = up_fade_time;
   scene->down_fade_time = down_fade_time;
   scene->wait_time = wait_time;
@@ -465,38 +1158,19 @@ int DimmerModel_SetPresetPlayback(const RDMHeader *header,
 
   g_root_device.playback_mode = playback_mode;
   g_root_device.playback_level = param_data[2];
+  StartPlayback(playback_mode, g_root_device.playback_level);
 
   return RDMResponder_BuildSetAck(header);
 }
 
 int DimmerModel_GetDMXBlockAddress(const RDMHeader *header,
                                    UNUSED const uint8_t *param_data) {
-  uint16_t total_footprint = 0u;
-  uint16_t expected_start_address = 0u;
-  bool is_contiguous = true;
-  unsigned int i = 0u;
-  for (; i < NUMBER_OF_SUB_DEVICES; i++) {
-    RDMResponder *responder = &g_subdevices[i].responder;
-    uint16_t sub_device_footprint = responder->def
-        ->personalities[responder->current_personality - 1u].slot_count;
-    total_footprint += sub_device_footprint;
-    if (expected_start_address &&
-        expected_start_address != responder->dmx_start_address) {
-      is_contiguous = false;
-    } else if (expected_start_address) {
-      expected_start_address += sub_device_footprint;
-    } else {
-      expected_start_address = responder->dmx_start_address +
-                               sub_device_footprint;
-    }
-  }
-
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  ptr = PushUInt16(ptr, total_footprint);
+  ptr = PushUInt16(ptr, NUMBER_OF_SUB_DEVICES * SUB_DEVICE_FOOTPRINT);
   ptr = PushUInt16(
       ptr,
-      is_contiguous ? g_subdevices[0].responder.dmx_start_address :
-          INVALID_DMX_START_ADDRESS);
+      g_subdevices.out_of_block_count ? INVALID_DMX_START_ADDRESS :
+          g_subdevices.start_address[0]);
   return RDMResponder_AddHeaderAndChecksum(header, ACK,
                                            ptr - g_rdm_buffer);
 }
@@ -547,6 +1221,7 @@ int DimmerModel_SetDMXFailMode(const RDMHeader *header,
   g_root_device.fail_loss_of_signal_delay = loss_of_signal_delay;
   g_root_device.fail_hold_time = hold_time;
   g_root_device.fail_level = param_data[6];
+  UpdateSignalMonitorTimer();
 
   return RDMResponder_BuildSetAck(header);
 }
@@ -578,6 +1253,7 @@ int DimmerModel_SetDMXStartupMode(const RDMHeader *header,
   g_root_device.startup_delay = loss_of_signal_delay;
   g_root_device.startup_hold = hold_time;
   g_root_device.startup_level = param_data[6];
+  UpdateSignalMonitorTimer();
 
   return RDMResponder_BuildSetAck(header);
 }
@@ -729,6 +1405,7 @@ int DimmerModel_SetPresetStatus(const RDMHeader *header,
   }
 
   if (clear_preset == 1u) {
+    memset(scene->levels, 0, NUMBER_OF_SUB_DEVICES);
     scene->up_fade_time = 0u;
     scene->down_fade_time = 0u;
     scene->wait_time = 0u;
@@ -767,7 +1444,65 @@ int DimmerModel_SetPresetMergeMode(const RDMHeader *header,
 // ----------------------------------------------------------------------------
 int DimmerModel_ClearStatusId(const RDMHeader *header,
                               UNUSED const uint8_t *param_data) {
-  g_active_device->status_message.is_active = false;
+  StatusMessage *message = FindSubDeviceStatusMessage(
+      SubDeviceIndex(g_active_slot));
+  if (message) {
+    message->is_active = false;
+  }
+  return RDMResponder_BuildSetAck(header);
+}
+
+int DimmerModel_GetSubDeviceLabel(const RDMHeader *header,
+                                  UNUSED const uint8_t *param_data) {
+  return RDMResponder_GenericReturnString(header, ActiveSubDeviceLabel(),
+                                          RDM_DEFAULT_STRING_SIZE);
+}
+
+int DimmerModel_SetSubDeviceLabel(const RDMHeader *header,
+                                  const uint8_t *param_data) {
+  if (header->param_data_length > RDM_DEFAULT_STRING_SIZE) {
+    return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+  }
+
+  const char *new_label = (const char*) param_data;
+  const unsigned int length = header->param_data_length;
+
+  // Labels are shared between sub devices, so first check if the default or
+  // an existing custom label matches.
+  if (length == sizeof(DEFAULT_DEVICE_LABEL) - 1u &&
+      memcmp(new_label, DEFAULT_DEVICE_LABEL, length) == 0) {
+    SetActiveSubDeviceLabel(0u);
+    return RDMResponder_BuildSetAck(header);
+  }
+
+  uint8_t label = FindCustomLabel(new_label, length);
+  if (label) {
+    SetActiveSubDeviceLabel(label);
+    return RDMResponder_BuildSetAck(header);
+  }
+
+  // Copy on write: if no one else is using our label we can modify it in
+  // place, otherwise we need a free one.
+  label = g_subdevices.label[g_active_slot];
+  if (label == 0u || g_custom_labels[label - 1u].ref_count > 1u) {
+    label = 0u;
+    unsigned int i = 0u;
+    for (; label == 0u && i < NUMBER_OF_CUSTOM_LABELS; i++) {
+      if (g_custom_labels[i].ref_count == 0u) {
+        label = i + 1u;
+      }
+    }
+  }
+
+  if (label == 0u) {
+    return RDMResponder_BuildNack(header, NR_ACTION_NOT_SUPPORTED);
+  }
+
+  RDMUtil_StringCopy(g_custom_labels[label - 1u].label,
+                     RDM_DEFAULT_STRING_SIZE, new_label, length);
+  if (label != g_subdevices.label[g_active_slot]) {
+    SetActiveSubDeviceLabel(label);
+  }
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -775,7 +1510,7 @@ int DimmerModel_GetSubDeviceReportingThreshold(
     const RDMHeader *header,
     UNUSED const uint8_t *param_data) {
   return RDMResponder_GenericGetUInt8(
-      header, g_active_device->sd_report_threshold);
+      header, g_subdevices.settings[g_active_slot].sd_report_threshold);
 }
 
 int DimmerModel_SetSubDeviceReportingThreshold(const RDMHeader *header,
@@ -790,13 +1525,16 @@ int DimmerModel_SetSubDeviceReportingThreshold(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->sd_report_threshold = threshold;
+  g_subdevices.settings[g_active_slot].sd_report_threshold = threshold;
   return RDMResponder_BuildSetAck(header);
 }
 
 int DimmerModel_GetIdentifyMode(const RDMHeader *header,
                                 UNUSED const uint8_t *param_data) {
-  return RDMResponder_GenericGetUInt8(header, g_active_device->identify_mode);
+  return RDMResponder_GenericGetUInt8(
+      header,
+      g_subdevices.settings[g_active_slot].identify_loud ?
+          IDENTIFY_MODE_LOUD : IDENTIFY_MODE_QUIET);
 }
 
 int DimmerModel_SetIdentifyMode(const RDMHeader *header,
@@ -810,20 +1548,22 @@ int DimmerModel_SetIdentifyMode(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->identify_mode = mode;
+  g_subdevices.settings[g_active_slot].identify_loud =
+      mode == IDENTIFY_MODE_LOUD;
   return RDMResponder_BuildSetAck(header);
 }
 
 int DimmerModel_GetBurnIn(const RDMHeader *header,
                           UNUSED const uint8_t *param_data) {
-  return RDMResponder_GenericGetUInt8(header, g_active_device->burn_in);
+  return RDMResponder_GenericGetUInt8(header,
+                                      g_subdevices.burn_in[g_active_slot]);
 }
 
 int DimmerModel_SetBurnIn(const RDMHeader *header,
                           const uint8_t *param_data) {
   // TODO(simon): it would be nice to decrement this once an hour.
   return RDMResponder_GenericSetUInt8(header, param_data,
-                                      &g_active_device->burn_in);
+                                      &g_subdevices.burn_in[g_active_slot]);
 }
 
 int DimmerModel_GetDimmerInfo(const RDMHeader *header,
@@ -842,9 +1582,9 @@ int DimmerModel_GetDimmerInfo(const RDMHeader *header,
 int DimmerModel_GetMinimumLevel(const RDMHeader *header,
                                 UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  ptr = PushUInt16(ptr, g_active_device->min_level_increasing);
-  ptr = PushUInt16(ptr, g_active_device->min_level_decreasing);
-  *ptr++ = g_active_device->on_below_min;
+  ptr = PushUInt16(ptr, g_subdevices.min_level_increasing[g_active_slot]);
+  ptr = PushUInt16(ptr, g_subdevices.min_level_decreasing[g_active_slot]);
+  *ptr++ = g_subdevices.settings[g_active_slot].on_below_min;
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
 
@@ -862,27 +1602,28 @@ int DimmerModel_SetMinimumLevel(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->min_level_increasing = min_level_increasing;
-  g_active_device->min_level_decreasing = min_level_decreasing;
-  g_active_device->on_below_min = on_below_min;
+  g_subdevices.min_level_increasing[g_active_slot] = min_level_increasing;
+  g_subdevices.min_level_decreasing[g_active_slot] = min_level_decreasing;
+  g_subdevices.settings[g_active_slot].on_below_min = on_below_min;
   return RDMResponder_BuildSetAck(header);
 }
 
 int DimmerModel_GetMaximumLevel(const RDMHeader *header,
                                 UNUSED const uint8_t *param_data) {
-  return RDMResponder_GenericGetUInt16(header, g_active_device->max_level);
+  return RDMResponder_GenericGetUInt16(header,
+                                       g_subdevices.max_level[g_active_slot]);
 }
 
 int DimmerModel_SetMaximumLevel(const RDMHeader *header,
                                 const uint8_t *param_data) {
   return RDMResponder_GenericSetUInt16(header, param_data,
-                                       &g_active_device->max_level);
+                                       &g_subdevices.max_level[g_active_slot]);
 }
 
 int DimmerModel_GetCurve(const RDMHeader *header,
                          UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  *ptr++ = g_active_device->curve;
+  *ptr++ = g_subdevices.settings[g_active_slot].curve;
   *ptr++ = NUMBER_OF_CURVES;
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
@@ -899,11 +1640,11 @@ int DimmerModel_SetCurve(const RDMHeader *header,
   }
 
   // To make it interesting, not every sub-device supports each curve type.
-  if (curve % 2 && g_active_device->index % 2 == 0) {
+  if (curve % 2 && SubDeviceIndex(g_active_slot) % 2 == 0) {
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->curve = curve;
+  g_subdevices.settings[g_active_slot].curve = curve;
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -925,7 +1666,7 @@ int DimmerModel_GetCurveDescription(const RDMHeader *header,
 int DimmerModel_GetOutputResponseTime(const RDMHeader *header,
                                       UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  *ptr++ = g_active_device->output_response_time;
+  *ptr++ = g_subdevices.settings[g_active_slot].output_response_time;
   *ptr++ = NUMBER_OF_OUTPUT_RESPONSE_TIMES;
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
@@ -941,7 +1682,7 @@ int DimmerModel_SetOutputResponseTime(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->output_response_time = setting;
+  g_subdevices.settings[g_active_slot].output_response_time = setting;
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -963,7 +1704,7 @@ int DimmerModel_GetOutputResponseDescription(const RDMHeader *header,
 int DimmerModel_GetModulationFrequency(const RDMHeader *header,
                                        UNUSED const uint8_t *param_data) {
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  *ptr++ = g_active_device->modulation_frequency;
+  *ptr++ = g_subdevices.settings[g_active_slot].modulation_frequency;
   *ptr++ = NUMBER_OF_MODULATION_FREQUENCIES;
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
@@ -979,7 +1720,7 @@ int DimmerModel_SetModulationFrequency(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
 
-  g_active_device->modulation_frequency = setting;
+  g_subdevices.settings[g_active_slot].modulation_frequency = setting;
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -1001,12 +1742,62 @@ int DimmerModel_GetModulationFrequencyDescription(
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
 
+/*
+ * @brief We generate status messages for each device, based on a periodic
+ * timer. This makes it easier to reproduce problems (and test!).
+ */
+static void GenerateStatusMessages() {
+  // The cycle counter is used to generate status messages for each sub device.
+  static uint8_t cycle = 0u;
+  static uint16_t complete_cycles = 0u;
+
+  int slot = RDMResponder_SubDeviceSlot(1u);
+  if (slot >= 0) {
+    // The cycle for the first device is:
+    //  - 0, NOOP
+    //  - 1, Queue breaker trip warning
+    //  - 2, NOOP
+    //  - 3, Clear breaker trip warning
+    //  - 4, NOOP
+    if (cycle == 1) {
+      // Queue a message
+      QueueSubDeviceStatusMessage(slot, STATUS_WARNING, STS_BREAKER_TRIP, 0u,
+                                  0u);
+    } else if (cycle == 3u) {
+      StatusMessage *message = FindSubDeviceStatusMessage(1u);
+      if (message) {
+        // The previous message is still in the queue, cancel it.
+        message->is_active = false;
+      } else {
+        // Queue a 'cleared' message
+        QueueSubDeviceStatusMessage(slot, STATUS_WARNING_CLEARED,
+                                    STS_BREAKER_TRIP, 0u, 0u);
+      }
+    }
+  }
+
+  slot = RDMResponder_SubDeviceSlot(3u);
+  if (slot >= 0) {
+    // This subdevice just queues a manufacturer-defined advisory message
+    // each cycle.
+    QueueSubDeviceStatusMessage(slot, STATUS_ADVISORY,
+                                (uint16_t) STS_OLP_TESTING,
+                                complete_cycles, cycle);
+  }
+  cycle++;
+  cycle %= 5u;
+  if (cycle == 0u) {
+    complete_cycles++;
+  }
+}
+
 // Public Functions
 // ----------------------------------------------------------------------------
 void DimmerModel_Initialize() {
   // Initialize the root
   unsigned int i = 0u;
   for (; i != NUMBER_OF_SCENES; i++) {
+    memset(g_root_device.scenes[i].levels, 0, NUMBER_OF_SUB_DEVICES);
     g_root_device.scenes[i].up_fade_time = 0u;
     g_root_device.scenes[i].down_fade_time = 0u;
     g_root_device.scenes[i].wait_time = 0u;
@@ -1029,64 +1820,115 @@ void DimmerModel_Initialize() {
   g_root_device.merge_mode = MERGE_MODE_DEFAULT;
   g_root_device.power_on_self_test = false;
   g_root_device.running_self_test = SELF_TEST_OFF;
+  TimerWheel_Cancel(&g_root_device.self_test_timer);
 
-  // Initialize the subdevices.
+  // Initialize the shared sub device responder.
   uint8_t parent_uid[UID_LENGTH];
   RDMResponder_GetUID(parent_uid);
 
-  uint16_t sub_device_index = 1u;
+  RDMResponder_SwitchResponder(&g_subdevice_responder);
+  g_responder->def = &SUBDEVICE_RESPONDER_DEFINITION;
+  memcpy(g_responder->uid, parent_uid, UID_LENGTH);
+  RDMResponder_InitResponder();
+  g_responder->is_subdevice = true;
+  g_responder->sub_device_count = NUMBER_OF_SUB_DEVICES;
+  RDMResponder_InvalidateCache();
+  RDMResponder_RestoreResponder();
+
+  // Initialize the subdevices.
+  memset(&g_subdevices, 0, sizeof(g_subdevices));
   for (i = 0u; i < NUMBER_OF_SUB_DEVICES; i++) {
-    if (i == 1) {
-      // Leave a gap at sub-device 2, since sub devices aren't required to be
-      // contiguous.
-      sub_device_index++;
-    }
+    g_subdevices.settings[i] = DEFAULT_SUB_DEVICE_SETTINGS;
+    g_subdevices.max_level[i] = DEFAULT_MAXIMUM_LEVEL;
+  }
+  memset(g_custom_labels, 0, sizeof(g_custom_labels));
+  memset(g_subdevice_status_messages, 0, sizeof(g_subdevice_status_messages));
 
-    DimmerSubDevice *subdevice = &g_subdevices[i];
-    subdevice->responder.def = &SUBDEVICE_RESPONDER_DEFINITION;
-
-    subdevice->index = sub_device_index++;
-    subdevice->min_level_increasing = 0u;
-    subdevice->min_level_decreasing = 0u;
-    subdevice->max_level = 0u;
-    subdevice->on_below_min = 0u;
-    subdevice->identify_mode = IDENTIFY_MODE_QUIET;
-    subdevice->burn_in = 0u;
-    subdevice->curve = 1u;
-    subdevice->output_response_time = 1u;
-    subdevice->modulation_frequency = 1u;
-    subdevice->sd_report_threshold = STATUS_ADVISORY;
-    subdevice->status_message.is_active = false;
-
-    RDMResponder_SwitchResponder(&subdevice->responder);
-    memcpy(g_responder->uid, parent_uid, UID_LENGTH);
-    RDMResponder_InitResponder();
-    g_responder->is_subdevice = true;
-    g_responder->sub_device_count = NUMBER_OF_SUB_DEVICES;
-  }
-
-  // restore
-  RDMResponder_RestoreResponder();
   if (!ResetToBlockAddress(INITIAL_START_ADDRESS)) {
     // Set them all to 1
     for (i = 0u; i < NUMBER_OF_SUB_DEVICES; i++) {
-      RDMResponder *responder = &g_subdevices[i].responder;
-      responder->dmx_start_address = INITIAL_START_ADDRESS;
+      g_subdevices.start_address[i] = INITIAL_START_ADDRESS;
     }
+    CountOutOfBlock();
   }
 
   // init status messages
   g_status_messages.count = 0u;
+
+  // Initialize the dimming engine.
+  TimerWheel_Cancel(&g_engine.tick_timer);
+  TimerWheel_Cancel(&g_playback.wait_timer);
+  TimerWheel_Cancel(&g_signal_monitor.timer);
+  memset(&g_engine, 0, sizeof(g_engine));
+  memset(&g_playback, 0, sizeof(g_playback));
+  g_playback.state = PLAYBACK_STATE_OFF;
+  memset(&g_signal_monitor, 0, sizeof(g_signal_monitor));
+  g_signal_monitor.state = MONITOR_STARTUP_DELAY;
+  BuildCurves();
+}
+
+uint16_t DimmerModel_GetOutputLevel(uint16_t sub_device) {
+  int slot = RDMResponder_SubDeviceSlot(sub_device);
+  return slot < 0 ? 0u : g_engine.output[slot];
+}
+
+/*
+ * @brief Load a sub device into the shared responder, called by the sub
+ * device registry.
+ */
+static void SelectSubDevice(unsigned int slot) {
+  g_active_slot = slot;
+  RDMResponder_SwitchResponder(&g_subdevice_responder);
+
+  // The start address is the only per-sub-device field in the cached
+  // responses.
+  if (g_responder->dmx_start_address != g_subdevices.start_address[slot]) {
+    g_responder->dmx_start_address = g_subdevices.start_address[slot];
+    RDMResponder_InvalidateCache();
+  }
+  g_responder->identify_on = g_subdevices.settings[slot].identify_on;
+}
+
+/*
+ * @brief Store any changes to the shared responder, called by the sub device
+ * registry.
+ */
+static void ReleaseSubDevice(unsigned int slot) {
+  SetSubDeviceStartAddress(slot, g_responder->dmx_start_address);
+  g_subdevices.settings[slot].identify_on = g_responder->identify_on;
 }
 
 static void DimmerModel_Activate() {
   g_responder->def = &ROOT_RESPONDER_DEFINITION;
   RDMResponder_InitResponder();
-  g_responder->sub_device_count = NUMBER_OF_SUB_DEVICES;
-  g_root_device.status_message_timer = CoarseTimer_GetTime();
+
+  RDMResponder_ResetSubDevices(SelectSubDevice, ReleaseSubDevice);
+  unsigned int i = 0u;
+  for (; i < NUMBER_OF_SUB_DEVICES; i++) {
+    RDMResponder_AddSubDevice(SubDeviceIndex(i));
+  }
+  g_responder->sub_device_count = RDMResponder_SubDeviceCount();
+  RDMResponder_InvalidateCache();
+  TimerWheel_SchedulePeriodic(&g_root_device.status_message_timer,
+                              STATUS_MESSAGE_TRIGGER_INTERVAL,
+                              GenerateStatusMessages);
+  TimerWheel_SchedulePeriodic(&g_engine.tick_timer, OUTPUT_TICK_INTERVAL,
+                              RunOutputTick);
+
+  // Activating the model is treated as a power on.
+  g_signal_monitor.start = CoarseTimer_GetTime();
+  g_signal_monitor.state = MONITOR_STARTUP_DELAY;
+  UpdateSignalMonitorTimer();
 }
 
-static void DimmerModel_Deactivate() {}
+static void DimmerModel_Deactivate() {
+  TimerWheel_Cancel(&g_root_device.status_message_timer);
+  TimerWheel_Cancel(&g_root_device.self_test_timer);
+  TimerWheel_Cancel(&g_engine.tick_timer);
+  TimerWheel_Cancel(&g_playback.wait_timer);
+  TimerWheel_Cancel(&g_signal_monitor.timer);
+  RDMResponder_ResetSubDevices(NULL, NULL);
+}
 
 static int DimmerModel_HandleRequest(const RDMHeader *header,
                                      const uint8_t *param_data) {
@@ -1126,102 +1968,30 @@ static int DimmerModel_HandleRequest(const RDMHeader *header,
     }
   }
 
-  unsigned int i = 0u;
-  bool handled = false;
-  int response_size = RDM_RESPONDER_NO_RESPONSE;
-  for (; i < NUMBER_OF_SUB_DEVICES; i++) {
-    if (sub_device == g_subdevices[i].index || sub_device == SUBDEVICE_ALL) {
-      if (!locked) {
-        g_active_device = &g_subdevices[i];
-        RDMResponder_SwitchResponder(&g_subdevices[i].responder);
-        response_size = RDMResponder_DispatchPID(header, param_data);
-      }
-      handled = true;
-    }
-  }
-
-  RDMResponder_RestoreResponder();
-
-  if (!handled) {
-    return RDMResponder_BuildNack(header, NR_SUB_DEVICE_OUT_OF_RANGE);
-  }
-
-  if (locked) {
+  if (locked && (sub_device == SUBDEVICE_ALL ||
+                 RDMResponder_SubDeviceSlot(sub_device) >= 0)) {
     return RDMResponder_BuildNack(header, NR_WRITE_PROTECT);
   }
 
   // If it was an all-subdevices call, it's not really clear how to handle the
   // response, in this case we return the last one.
-  return response_size;
+  return RDMResponder_DispatchSubDevice(header, param_data);
 }
 
-/*
- * @brief We generate status messages for each device, based on a periodic
- * timer. This makes it easier to reproduce problems (and test!).
- */
-static void DimmerModel_Tasks() {
-  // The cycle counter is used to generate status messages for each sub device.
-  static uint8_t cycle = 0u;
-  static uint16_t complete_cycles = 0u;
+static void DimmerModel_Tasks() {}
 
-  if (g_root_device.running_self_test &&
-      CoarseTimer_HasElapsed(
-          g_root_device.self_test_timer,
-          SELF_TESTS[g_root_device.running_self_test - 1].duration)) {
-    // Queue a status message for the root.
-    QueueStatusMessage(
-        &g_root_device.status_message, SUBDEVICE_ROOT, STATUS_ADVISORY,
-        (uint16_t) (g_root_device.running_self_test == 1u ?
-            STS_OLP_SELFTEST_PASSED : STS_OLP_SELFTEST_FAILED),
-        g_root_device.running_self_test, 0u);
-
-    g_root_device.running_self_test = 0u;
-  }
-
-  if (!CoarseTimer_HasElapsed(g_root_device.status_message_timer,
-                             STATUS_MESSAGE_TRIGGER_INTERVAL)) {
+static void DimmerModel_ReceiveDMX(unsigned int offset, const uint8_t *data,
+                                   unsigned int length) {
+  if (offset >= DMX_FRAME_SIZE) {
     return;
   }
-
-  g_root_device.status_message_timer = CoarseTimer_GetTime();
-
-  unsigned int subdevice_index = 0u;
-  for (; subdevice_index < NUMBER_OF_SUB_DEVICES; subdevice_index++) {
-    DimmerSubDevice *subdevice = &g_subdevices[subdevice_index];
-
-    if (subdevice->index == 1u) {
-      // The cycle for the first device is:
-      //  - 0, NOOP
-      //  - 1, Queue breaker trip warning
-      //  - 2, NOOP
-      //  - 3, Clear breaker trip warning
-      //  - 4, NOOP
-      if (cycle == 1) {
-        // Queue a message
-        QueueSubDeviceStatusMessage(subdevice, STATUS_WARNING,
-                                    STS_BREAKER_TRIP, 0u, 0u);
-      } else if (cycle == 3u) {
-        if (subdevice->status_message.is_active) {
-          // The previous message is still in the queue, cancel it.
-          subdevice->status_message.is_active = false;
-        } else {
-          // Queue a 'cleared' message
-          QueueSubDeviceStatusMessage(subdevice, STATUS_WARNING_CLEARED,
-                                      STS_BREAKER_TRIP, 0u, 0u);
-        }
-      }
-    } else if (subdevice->index == 3u) {
-      // This subdevice just queues a manufacturer-defined advisory message
-      // each cycle.
-      QueueSubDeviceStatusMessage(subdevice, STATUS_ADVISORY,
-                                  (uint16_t) STS_OLP_TESTING,
-                                  complete_cycles, cycle);
-    }
+  if (length > DMX_FRAME_SIZE - offset) {
+    length = DMX_FRAME_SIZE - offset;
   }
-  cycle++;
-  cycle %= 5u;
-  if (cycle == 0u) {
-    complete_cycles++;
+  memcpy(&g_engine.universe[offset], data, length);
+  g_signal_monitor.last_frame = CoarseTimer_GetTime();
+  if (g_signal_monitor.state != MONITOR_SIGNAL_PRESENT) {
+    SignalReturned();
   }
 }
 
@@ -1231,7 +2001,11 @@ const ModelEntry DIMMER_MODEL_ENTRY = {
   .deactivate_fn = DimmerModel_Deactivate,
   .ioctl_fn = RDMResponder_Ioctl,
   .request_fn = DimmerModel_HandleRequest,
-  .tasks_fn = DimmerModel_Tasks
+  .tasks_fn = DimmerModel_Tasks,
+  .dmx_fn = DimmerModel_ReceiveDMX,
+  .definitions = RESPONDER_DEFINITIONS,
+  .definition_count = sizeof(RESPONDER_DEFINITIONS) /
+                      sizeof(RESPONDER_DEFINITIONS[0])
 };
 
 // Root device definition
@@ -1255,16 +2029,6 @@ static const PIDDescriptor ROOT_PID_DESCRIPTORS[] = {
     RDMResponder_SetDeviceLabel},
   {PID_SOFTWARE_VERSION_LABEL, RDMResponder_GetSoftwareVersionLabel, 0u,
     (PIDCommandHandler) NULL},
-  {PID_IDENTIFY_DEVICE, RDMResponder_GetIdentifyDevice, 0u,
-    RDMResponder_SetIdentifyDevice},
-  {PID_PERFORM_SELFTEST, DimmerModel_GetSelfTest, 0u,
-    DimmerModel_PerformSelfTest},
-  {PID_SELF_TEST_DESCRIPTION, DimmerModel_GetSelfTestDescription, 1u,
-    (PIDCommandHandler) NULL},
-  {PID_CAPTURE_PRESET, (PIDCommandHandler) NULL, 0,
-    DimmerModel_CapturePreset},
-  {PID_PRESET_PLAYBACK, DimmerModel_GetPresetPlayback, 0,
-    DimmerModel_SetPresetPlayback},
   {PID_DMX_BLOCK_ADDRESS, DimmerModel_GetDMXBlockAddress, 0u,
     DimmerModel_SetDMXBlockAddress},
   {PID_DMX_FAIL_MODE, DimmerModel_GetDMXFailMode, 0u,
@@ -1275,6 +2039,16 @@ static const PIDDescriptor ROOT_PID_DESCRIPTORS[] = {
   {PID_LOCK_STATE, DimmerModel_GetLockState, 0u, DimmerModel_SetLockState},
   {PID_LOCK_STATE_DESCRIPTION, DimmerModel_GetLockStateDescription, 1u,
     (PIDCommandHandler) NULL},
+  {PID_IDENTIFY_DEVICE, RDMResponder_GetIdentifyDevice, 0u,
+    RDMResponder_SetIdentifyDevice},
+  {PID_PERFORM_SELFTEST, DimmerModel_GetSelfTest, 0u,
+    DimmerModel_PerformSelfTest},
+  {PID_SELF_TEST_DESCRIPTION, DimmerModel_GetSelfTestDescription, 1u,
+    (PIDCommandHandler) NULL},
+  {PID_CAPTURE_PRESET, (PIDCommandHandler) NULL, 0,
+    DimmerModel_CapturePreset},
+  {PID_PRESET_PLAYBACK, DimmerModel_GetPresetPlayback, 0,
+    DimmerModel_SetPresetPlayback},
   {PID_PRESET_INFO, DimmerModel_GetPresetInfo, 0u,
     (PIDCommandHandler) NULL},
   {PID_PRESET_STATUS, DimmerModel_GetPresetStatus, 2u,
@@ -1326,15 +2100,12 @@ static const PIDDescriptor SUBDEVICE_PID_DESCRIPTORS[] = {
     (PIDCommandHandler) NULL},
   {PID_MANUFACTURER_LABEL, RDMResponder_GetManufacturerLabel, 0u,
     (PIDCommandHandler) NULL},
-  {PID_DMX_START_ADDRESS, RDMResponder_GetDMXStartAddress, 0u,
-    RDMResponder_SetDMXStartAddress},
+  {PID_DEVICE_LABEL, DimmerModel_GetSubDeviceLabel, 0u,
+    DimmerModel_SetSubDeviceLabel},
   {PID_SOFTWARE_VERSION_LABEL, RDMResponder_GetSoftwareVersionLabel, 0u,
     (PIDCommandHandler) NULL},
-  {PID_IDENTIFY_DEVICE, RDMResponder_GetIdentifyDevice, 0u,
-    RDMResponder_SetIdentifyDevice},
-  {PID_BURN_IN, DimmerModel_GetBurnIn, 0u, DimmerModel_SetBurnIn},
-  {PID_IDENTIFY_MODE, DimmerModel_GetIdentifyMode, 0u,
-    DimmerModel_SetIdentifyMode},
+  {PID_DMX_START_ADDRESS, RDMResponder_GetDMXStartAddress, 0u,
+    RDMResponder_SetDMXStartAddress},
   {PID_DIMMER_INFO, DimmerModel_GetDimmerInfo, 0u,
     (PIDCommandHandler) NULL},
   {PID_MINIMUM_LEVEL, DimmerModel_GetMinimumLevel, 0u,
@@ -1353,6 +2124,11 @@ static const PIDDescriptor SUBDEVICE_PID_DESCRIPTORS[] = {
   {PID_MODULATION_FREQUENCY_DESCRIPTION,
     DimmerModel_GetModulationFrequencyDescription, 1u,
     (PIDCommandHandler) NULL},
+  {PID_BURN_IN, DimmerModel_GetBurnIn, 0u, DimmerModel_SetBurnIn},
+  {PID_IDENTIFY_DEVICE, RDMResponder_GetIdentifyDevice, 0u,
+    RDMResponder_SetIdentifyDevice},
+  {PID_IDENTIFY_MODE, DimmerModel_GetIdentifyMode, 0u,
+    DimmerModel_SetIdentifyMode},
 };
 
 static const ProductDetailIds SUBDEVICE_PRODUCT_DETAIL_ID_LIST = {
@@ -1373,7 +2149,7 @@ static const SlotDefinition PERSONALITY_SLOTS[] = {
 
 static const PersonalityDefinition PERSONALITIES[PERSONALITY_COUNT] = {
   {
-    .dmx_footprint = 1u,
+    .dmx_footprint = SUB_DEVICE_FOOTPRINT,
     .description = PERSONALITY_DESCRIPTION,
     .slots = PERSONALITY_SLOTS,
     .slot_count = 1u
@@ -28,26 +28,56 @@
  *
  * ### Sub-devices
  *
- * The model has multiple sub-devices, that each take a single slot of DMX
- * data. The sub-devices are not contiguous.
+ * The model has DIMMER_SUB_DEVICE_COUNT sub-devices (up to 512), that each
+ * take a single slot of DMX data. Unless all 512 sub-devices are in use, the
+ * sub-device indices are not contiguous, there is a gap at index 2.
  *
  * DMX_BLOCK_ADDRESS can be used to set the start address of all sub-devices in
  * a single operation.
  *
+ * To keep the RAM usage down, the sub-device state is held in packed arrays
+ * and the sub-devices share a single RDMResponder. Sub-device labels are
+ * stored only once they differ from the default label, and there are a
+ * limited number of custom labels available.
+ *
  * ### Dimmer Settings
  *
  * Each sub-device implements the PIDs from Section 4 of E1.37-1. To make
  * things interesting, not all sub-devices support all the dimmer curves /
  * modulation frequencies.
  *
+ * ### Output
+ *
+ * Every 10ms the dimming engine reads each sub-device's level from the
+ * received DMX universe, and converts it to a 16-bit output level. The level
+ * passes through the sub-device's curve, is scaled between the minimum and
+ * maximum levels and then slew limited according to the output response time.
+ * The curves are stored as 256 entry lookup tables, and all the math is fixed
+ * point.
+ *
  * ### Presets & Scenes.
  *
  * The root device provides 3 scenes. The first scene (index 1) is a factory
  * programed scene, which can't be modified. The 2nd and 3rd scenes can be
- * 'updated' with capture preset.
+ * 'updated' with capture preset, which records the current level of each
+ * sub-device.
+ *
+ * PRESET_PLAYBACK replaces the DMX data with a scene, scaled by the playback
+ * level. Channels fade to the scene using the scene's up & down fade times.
+ * When playing back all scenes, each programmed scene is held for its wait
+ * time before fading to the next one.
+ *
+ * PRESET_MERGEMODE controls how the DMX data and the preset are combined:
+ * the preset can override DMX (the default), the higher of the two can win
+ * (HTP), the one that changed last can win (LTP), or the preset can be
+ * limited to when there is no DMX signal.
  *
  * DMX_FAIL_MODE and DMX_STARTUP_MODE can be used to change the on-failure and
- * on-startup scenes.
+ * on-startup scenes. The fail scene is played once no DMX has been received
+ * for the loss of signal delay (minimum 1s), the startup scene is played if
+ * no DMX is received within the startup delay of the model being activated.
+ * Either scene fades out once the hold time expires, and DMX data always
+ * takes over from them.
  *
  * ### Status Messages
  *
@@ -76,6 +106,8 @@
 #ifndef FIRMWARE_SRC_DIMMER_MODEL_H_
 #define FIRMWARE_SRC_DIMMER_MODEL_H_
 
+#include <stdint.h>
+
 #include "rdm_model.h"
 
 #ifdef __cplusplus
@@ -92,6 +124,13 @@ extern const ModelEntry DIMMER_MODEL_ENTRY;
  */
 void DimmerModel_Initialize();
 
+/**
+ * @brief Get the output level of a sub-device.
+ * @param sub_device The sub-device index.
+ * @returns The 16-bit output level, or 0 if the sub-device doesn't exist.
+ */
+uint16_t DimmerModel_GetOutputLevel(uint16_t sub_device);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,64 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * isr_profiler.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "isr_profiler.h"
+
+#include <string.h>
+
+/*
+ * @brief The upper bound of the first histogram bucket, as a power of 2.
+ */
+enum { FIRST_BUCKET_SHIFT = 6 };
+
+static ISRProfiler_Stats g_isr_stats[ISR_PROFILER_COUNT];
+
+void ISRProfiler_Reset() {
+  memset(g_isr_stats, 0, sizeof(g_isr_stats));
+}
+
+void ISRProfiler_Exit(ISRProfilerId id, uint32_t start) {
+  const uint32_t cycles = CoreTimer_GetCount() - start;
+  ISRProfiler_Stats *stats = &g_isr_stats[id];
+  stats->calls++;
+  stats->total_cycles += cycles;
+  if (stats->calls == 1u || cycles < stats->min_cycles) {
+    stats->min_cycles = cycles;
+  }
+  if (cycles > stats->max_cycles) {
+    stats->max_cycles = cycles;
+  }
+
+  unsigned int bucket = 0u;
+  uint32_t limit = cycles >> FIRST_BUCKET_SHIFT;
+  while (limit && bucket < ISR_PROFILER_BUCKETS - 1u) {
+    limit >>= 1;
+    bucket++;
+  }
+  stats->histogram[bucket]++;
+}
+
+void ISRProfiler_RecordLatency(ISRProfilerId id, uint32_t cycles) {
+  if (cycles > g_isr_stats[id].max_latency) {
+    g_isr_stats[id].max_latency = cycles;
+  }
+}
+
+const ISRProfiler_Stats *ISRProfiler_GetStats() {
+  return g_isr_stats;
+}
@@ -0,0 +1,163 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * isr_profiler.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup isr_profiler ISR Profiler
+ * @brief Measure how long the interrupt handlers run for.
+ *
+ * Each instrumented ISR records the core timer count on entry and exit. The
+ * profiler keeps the number of calls, the minimum, maximum and total cycles
+ * and a histogram of run times for each ISR. Where the time the interrupt was
+ * raised is known, the ISR also records how late it started.
+ *
+ * Profiling is opt-in, define ISR_PROFILING in app_settings.h to enable it.
+ * Otherwise ISR_PROFILER_ENTER() and ISR_PROFILER_EXIT() compile to nothing.
+ *
+ * Times include any higher priority ISRs that preempt the profiled ISR.
+ *
+ * The host reads the results with the @ref message-commands-getisrstats
+ * command.
+ *
+ * @addtogroup isr_profiler
+ * @{
+ * @file isr_profiler.h
+ * @brief Measure how long the interrupt handlers run for.
+ */
+
+#ifndef FIRMWARE_SRC_ISR_PROFILER_H_
+#define FIRMWARE_SRC_ISR_PROFILER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_settings.h"
+#include "core_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The profiled ISRs.
+ *
+ * The values are part of the host protocol, new ISRs must be added at the
+ * end.
+ */
+typedef enum {
+  ISR_PROFILER_TRANSCEIVER_UART,  //!< Transceiver_UARTEvent()
+  ISR_PROFILER_TRANSCEIVER_IC,  //!< The transceiver input capture ISR.
+  ISR_PROFILER_TRANSCEIVER_TIMER,  //!< Transceiver_TimerEvent()
+  ISR_PROFILER_CORE_TIMER,  //!< The core timer ISR.
+  ISR_PROFILER_USB,  //!< The USB ISR.
+  ISR_PROFILER_COUNT  //!< The number of ISRs, not a valid ISR.
+} ISRProfilerId;
+
+/**
+ * @brief The number of histogram buckets.
+ *
+ * Bucket 0 counts runs shorter than 64 cycles (1.6us at 80MHz), each
+ * following bucket covers twice the range of the previous one and the last
+ * bucket counts everything longer.
+ */
+#define ISR_PROFILER_BUCKETS 8u
+
+/**
+ * @brief The profile of an ISR.
+ *
+ * All times are in core timer cycles.
+ */
+typedef struct {
+  uint32_t calls;  //!< The number of times the ISR has run.
+  uint32_t min_cycles;  //!< The shortest run, 0 if it hasn't run.
+  uint32_t max_cycles;  //!< The longest run.
+  uint32_t max_latency;  //!< The longest delay from the interrupt to entry.
+  uint64_t total_cycles;  //!< The total time spent in the ISR.
+  uint32_t histogram[ISR_PROFILER_BUCKETS];  //!< The run time histogram.
+} ISRProfiler_Stats;
+
+/**
+ * @brief Clear the profile of every ISR.
+ *
+ * The profiles start out zeroed, so this doesn't need to be called at
+ * startup. That way the ISRs that run during system initialization are
+ * recorded as well.
+ */
+void ISRProfiler_Reset();
+
+/**
+ * @brief Record a run of an ISR.
+ * @param id The ISR.
+ * @param start The core timer count when the ISR was entered.
+ */
+void ISRProfiler_Exit(ISRProfilerId id, uint32_t start);
+
+/**
+ * @brief Record how late an ISR started.
+ * @param id The ISR.
+ * @param cycles The number of cycles between the interrupt being raised and
+ *   the ISR starting.
+ */
+void ISRProfiler_RecordLatency(ISRProfilerId id, uint32_t cycles);
+
+/**
+ * @brief Get the profile of every ISR.
+ * @returns An array of ISR_PROFILER_COUNT profiles, indexed by ISRProfilerId.
+ */
+const ISRProfiler_Stats *ISRProfiler_GetStats();
+
+#ifdef ISR_PROFILING
+
+/**
+ * @brief Call at the start of an ISR.
+ */
+#define ISR_PROFILER_ENTER() \
+  const uint32_t isr_profiler_start = CoreTimer_GetCount()
+
+/**
+ * @brief Call at the end of an ISR.
+ * @param id The ISRProfilerId of the ISR.
+ */
+#define ISR_PROFILER_EXIT(id) \
+  ISRProfiler_Exit(id, isr_profiler_start)
+
+/**
+ * @brief Record the latency of an ISR.
+ * @param id The ISRProfilerId of the ISR.
+ * @param cycles The number of cycles between the interrupt and ISR entry.
+ */
+#define ISR_PROFILER_LATENCY(id, cycles) \
+  ISRProfiler_RecordLatency(id, cycles)
+
+#else
+
+#define ISR_PROFILER_ENTER()
+#define ISR_PROFILER_EXIT(id)
+#define ISR_PROFILER_LATENCY(id, cycles)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FIRMWARE_SRC_ISR_PROFILER_H_
+
+/**
+ * @}
+ */
@@ -19,12 +19,15 @@
 #include "led_model.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "constants.h"
 #include "macros.h"
+#include "rdm_buffer.h"
 #include "rdm_frame.h"
 #include "rdm_responder.h"
 #include "rdm_util.h"
+#include "spi_rgb.h"
 #include "utils.h"
 
 // Various constants
@@ -33,19 +36,17 @@ enum {SOFTWARE_VERSION = 0x00000000 };
 static const char DEVICE_MODEL_DESCRIPTION[] = "Ja Rule LED Driver";
 static const char SOFTWARE_LABEL[] = "Alpha";
 static const char DEFAULT_DEVICE_LABEL[] = "Ja Rule";
-enum { MAX_PIXEL_COUNT = 170u };
+enum { MAX_PIXEL_COUNT = SPIRGB_MAX_PIXELS };
 enum { DEFAULT_PIXEL_COUNT = 2u };
+enum { MIN_GAMMA = 10u };
+enum { MAX_GAMMA = 28u };
+enum { DEFAULT_GAMMA = 10u };
 
 static const ResponderDefinition RESPONDER_DEFINITION;
 
-typedef enum {
-  PIXEL_TYPE_LPD8806 = 0x0001,
-  /*
-  PIXEL_TYPE_WS2801 = 0x0002,
-  PIXEL_TYPE_P9813 = 0x0003,
-  PIXEL_TYPE_APA102 = 0x0004,
-  */
-} PixelType;
+static const ResponderDefinition *const RESPONDER_DEFINITIONS[] = {
+  &RESPONDER_DEFINITION
+};
 
 typedef struct {
   PixelType pixel_type;
@@ -57,11 +58,20 @@ typedef struct {
    * case we could have up to 512 of them.
    */
   uint16_t pixel_count;
+
+  uint8_t gamma;  //!< In tenths.
+  uint8_t white_balance[3];  //!< Red, green, blue.
+  bool dithering;
+  uint8_t brightness;  //!< The APA102 global brightness.
 } LEDModel;
 
 
 static const char PIXEL_TYPE_STRING[] = "Pixel Type";
 static const char PIXEL_COUNT_STRING[] = "Pixel Count";
+static const char PIXEL_GAMMA_STRING[] = "Pixel Gamma";
+static const char PIXEL_WHITE_BALANCE_STRING[] = "Pixel White Balance";
+static const char PIXEL_DITHERING_STRING[] = "Pixel Dithering";
+static const char PIXEL_BRIGHTNESS_STRING[] = "Pixel Brightness";
 
 static const ParameterDescription PIXEL_TYPE_DESCRIPTION = {
   .pdl_size = 2u,
@@ -70,7 +80,7 @@ static const ParameterDescription PIXEL_TYPE_DESCRIPTION = {
   .unit = UNITS_NONE,
   .prefix = PREFIX_NONE,
   .min_valid_value = PIXEL_TYPE_LPD8806,
-  .max_valid_value = PIXEL_TYPE_LPD8806,
+  .max_valid_value = PIXEL_TYPE_APA102,
   .default_value = PIXEL_TYPE_LPD8806,
   .description = PIXEL_TYPE_STRING,
 };
@@ -87,6 +97,54 @@ static const ParameterDescription PIXEL_COUNT_DESCRIPTION = {
   .description = PIXEL_COUNT_STRING,
 };
 
+static const ParameterDescription PIXEL_GAMMA_DESCRIPTION = {
+  .pdl_size = 1u,
+  .data_type = DS_UNSIGNED_BYTE,
+  .command_class = CC_GET_SET,
+  .unit = UNITS_NONE,
+  .prefix = PREFIX_DECI,
+  .min_valid_value = MIN_GAMMA,
+  .max_valid_value = MAX_GAMMA,
+  .default_value = DEFAULT_GAMMA,
+  .description = PIXEL_GAMMA_STRING,
+};
+
+static const ParameterDescription PIXEL_WHITE_BALANCE_DESCRIPTION = {
+  .pdl_size = 3u,
+  .data_type = DS_NOT_DEFINED,
+  .command_class = CC_GET_SET,
+  .unit = UNITS_NONE,
+  .prefix = PREFIX_NONE,
+  .min_valid_value = 0u,
+  .max_valid_value = 0u,
+  .default_value = 0u,
+  .description = PIXEL_WHITE_BALANCE_STRING,
+};
+
+static const ParameterDescription PIXEL_DITHERING_DESCRIPTION = {
+  .pdl_size = 1u,
+  .data_type = DS_UNSIGNED_BYTE,
+  .command_class = CC_GET_SET,
+  .unit = UNITS_NONE,
+  .prefix = PREFIX_NONE,
+  .min_valid_value = 0u,
+  .max_valid_value = 1u,
+  .default_value = 0u,
+  .description = PIXEL_DITHERING_STRING,
+};
+
+static const ParameterDescription PIXEL_BRIGHTNESS_DESCRIPTION = {
+  .pdl_size = 1u,
+  .data_type = DS_UNSIGNED_BYTE,
+  .command_class = CC_GET_SET,
+  .unit = UNITS_NONE,
+  .prefix = PREFIX_NONE,
+  .min_valid_value = 0u,
+  .max_valid_value = SPIRGB_MAX_BRIGHTNESS,
+  .default_value = SPIRGB_MAX_BRIGHTNESS,
+  .description = PIXEL_BRIGHTNESS_STRING,
+};
+
 static LEDModel g_model;
 
 // PID Handlers
@@ -102,6 +160,18 @@ int LEDModel_GetParameterDescription(const RDMHeader *header,
     case PID_PIXEL_COUNT:
       description = &PIXEL_COUNT_DESCRIPTION;
       break;
+    case PID_PIXEL_GAMMA:
+      description = &PIXEL_GAMMA_DESCRIPTION;
+      break;
+    case PID_PIXEL_WHITE_BALANCE:
+      description = &PIXEL_WHITE_BALANCE_DESCRIPTION;
+      break;
+    case PID_PIXEL_DITHERING:
+      description = &PIXEL_DITHERING_DESCRIPTION;
+      break;
+    case PID_PIXEL_BRIGHTNESS:
+      description = &PIXEL_BRIGHTNESS_DESCRIPTION;
+      break;
     default:
       {}
   }
@@ -123,10 +193,11 @@ int LEDModel_SetPixelType(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
   }
   const uint16_t type = ExtractUInt16(param_data);
-  if (type != PIXEL_TYPE_LPD8806) {
+  if (type < PIXEL_TYPE_LPD8806 || type > PIXEL_TYPE_APA102) {
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
   g_model.pixel_type = type;
+  SPIRGB_SetPixelType(g_model.pixel_type);
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -146,6 +217,75 @@ int LEDModel_SetPixelCount(const RDMHeader *header,
     return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
   }
   g_model.pixel_count = count;
+  SPIRGB_SetPixelCount(count);
+  return RDMResponder_BuildSetAck(header);
+}
+
+int LEDModel_GetPixelGamma(const RDMHeader *header,
+                           UNUSED const uint8_t *param_data) {
+  return RDMResponder_GenericGetUInt8(header, g_model.gamma);
+}
+
+int LEDModel_SetPixelGamma(const RDMHeader *header,
+                           const uint8_t *param_data) {
+  if (header->param_data_length != sizeof(uint8_t)) {
+    return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+  }
+  // Only some of the values in the range have curves.
+  if (!SPIRGB_SetGamma(param_data[0])) {
+    return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
+  }
+  g_model.gamma = param_data[0];
+  return RDMResponder_BuildSetAck(header);
+}
+
+int LEDModel_GetPixelWhiteBalance(const RDMHeader *header,
+                                  UNUSED const uint8_t *param_data) {
+  uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
+  memcpy(ptr, g_model.white_balance, sizeof(g_model.white_balance));
+  ptr += sizeof(g_model.white_balance);
+  return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
+}
+
+int LEDModel_SetPixelWhiteBalance(const RDMHeader *header,
+                                  const uint8_t *param_data) {
+  if (header->param_data_length != sizeof(g_model.white_balance)) {
+    return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+  }
+  memcpy(g_model.white_balance, param_data, sizeof(g_model.white_balance));
+  SPIRGB_SetWhiteBalance(g_model.white_balance[RED],
+                         g_model.white_balance[GREEN],
+                         g_model.white_balance[BLUE]);
+  return RDMResponder_BuildSetAck(header);
+}
+
+int LEDModel_GetPixelDithering(const RDMHeader *header,
+                               UNUSED const uint8_t *param_data) {
+  return RDMResponder_GenericGetBool(header, g_model.dithering);
+}
+
+int LEDModel_SetPixelDithering(const RDMHeader *header,
+                               const uint8_t *param_data) {
+  int r = RDMResponder_GenericSetBool(header, param_data, &g_model.dithering);
+  SPIRGB_SetDithering(g_model.dithering);
+  return r;
+}
+
+int LEDModel_GetPixelBrightness(const RDMHeader *header,
+                                UNUSED const uint8_t *param_data) {
+  return RDMResponder_GenericGetUInt8(header, g_model.brightness);
+}
+
+int LEDModel_SetPixelBrightness(const RDMHeader *header,
+                                const uint8_t *param_data) {
+  if (header->param_data_length != sizeof(uint8_t)) {
+    return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+  }
+  if (param_data[0] > SPIRGB_MAX_BRIGHTNESS) {
+    return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
+  }
+  g_model.brightness = param_data[0];
+  SPIRGB_SetBrightness(g_model.brightness);
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -158,6 +298,18 @@ static void LEDModel_Activate() {
   RDMResponder_InitResponder();
   g_model.pixel_type = PIXEL_TYPE_LPD8806;
   g_model.pixel_count = DEFAULT_PIXEL_COUNT;
+  g_model.gamma = DEFAULT_GAMMA;
+  memset(g_model.white_balance, UINT8_MAX, sizeof(g_model.white_balance));
+  g_model.dithering = false;
+  g_model.brightness = SPIRGB_MAX_BRIGHTNESS;
+  SPIRGB_SetPixelType(g_model.pixel_type);
+  SPIRGB_SetPixelCount(g_model.pixel_count);
+  SPIRGB_SetGamma(g_model.gamma);
+  SPIRGB_SetWhiteBalance(g_model.white_balance[RED],
+                         g_model.white_balance[GREEN],
+                         g_model.white_balance[BLUE]);
+  SPIRGB_SetDithering(g_model.dithering);
+  SPIRGB_SetBrightness(g_model.brightness);
 }
 
 static void LEDModel_Deactivate() {}
@@ -195,7 +347,10 @@ const ModelEntry LED_MODEL_ENTRY = {
   .deactivate_fn = LEDModel_Deactivate,
   .ioctl_fn = RDMResponder_Ioctl,
   .request_fn = LEDModel_HandleRequest,
-  .tasks_fn = LEDModel_Tasks
+  .tasks_fn = LEDModel_Tasks,
+  .definitions = RESPONDER_DEFINITIONS,
+  .definition_count = sizeof(RESPONDER_DEFINITIONS) /
+                      sizeof(RESPONDER_DEFINITIONS[0])
 };
 
 static const PIDDescriptor PID_DESCRIPTORS[] = {
@@ -217,7 +372,14 @@ static const PIDDescriptor PID_DESCRIPTORS[] = {
   {PID_IDENTIFY_DEVICE, RDMResponder_GetIdentifyDevice, 0u,
     RDMResponder_SetIdentifyDevice},
   {PID_PIXEL_TYPE, LEDModel_GetPixelType, 0u, LEDModel_SetPixelType},
-  {PID_PIXEL_COUNT, LEDModel_GetPixelCount, 0u, LEDModel_SetPixelCount}
+  {PID_PIXEL_COUNT, LEDModel_GetPixelCount, 0u, LEDModel_SetPixelCount},
+  {PID_PIXEL_GAMMA, LEDModel_GetPixelGamma, 0u, LEDModel_SetPixelGamma},
+  {PID_PIXEL_WHITE_BALANCE, LEDModel_GetPixelWhiteBalance, 0u,
+    LEDModel_SetPixelWhiteBalance},
+  {PID_PIXEL_DITHERING, LEDModel_GetPixelDithering, 0u,
+    LEDModel_SetPixelDithering},
+  {PID_PIXEL_BRIGHTNESS, LEDModel_GetPixelBrightness, 0u,
+    LEDModel_SetPixelBrightness}
 };
 
 static const ProductDetailIds PRODUCT_DETAIL_ID_LIST = {
@@ -27,11 +27,15 @@
 #include "app_pipeline.h"
 #include "constants.h"
 #include "flags.h"
+#include "isr_profiler.h"
+#include "metrics.h"
 #include "peripheral/eth/plib_eth.h"
+#include "pipeline_latency.h"
 #include "rdm_frame.h"
 #include "rdm_handler.h"
 #include "syslog.h"
 #include "transceiver.h"
+#include "transceiver_trace.h"
 
 #include "app_settings.h"
 
@@ -314,6 +318,81 @@ static void ReturnRDMResponderJitter(uint8_t token, unsigned int length) {
   SendMessage(token, COMMAND_GET_RDM_RESPONDER_JITTER, RC_OK, &iovec, 1u);
 }
 
+static void GetMetrics(uint8_t token, unsigned int length) {
+  if (length) {
+    SendMessage(token, COMMAND_GET_METRICS, RC_BAD_PARAM, NULL, 0u);
+    return;
+  }
+
+  IOVec iovec;
+  iovec.base = g_metrics;
+  iovec.length = sizeof(g_metrics);
+  SendMessage(token, COMMAND_GET_METRICS, RC_OK, &iovec, 1u);
+}
+
+static void GetISRStats(uint8_t token, const uint8_t *payload,
+                        unsigned int length) {
+  if (length > 1u) {
+    SendMessage(token, COMMAND_GET_ISR_STATS, RC_BAD_PARAM, NULL, 0u);
+    return;
+  }
+
+  IOVec iovec;
+  iovec.base = ISRProfiler_GetStats();
+  iovec.length = ISR_PROFILER_COUNT * sizeof(ISRProfiler_Stats);
+  SendMessage(token, COMMAND_GET_ISR_STATS, RC_OK, &iovec, 1u);
+
+  if (length && payload[0]) {
+    ISRProfiler_Reset();
+  }
+}
+
+static void GetLatencyStats(uint8_t token, const uint8_t *payload,
+                            unsigned int length) {
+  if (length > 1u) {
+    SendMessage(token, COMMAND_GET_LATENCY_STATS, RC_BAD_PARAM, NULL, 0u);
+    return;
+  }
+
+  IOVec iovec;
+  iovec.base = PipelineLatency_GetStats();
+  iovec.length = PIPELINE_STAGE_COUNT * sizeof(PipelineLatency_Stats);
+  SendMessage(token, COMMAND_GET_LATENCY_STATS, RC_OK, &iovec, 1u);
+
+  if (length && payload[0]) {
+    PipelineLatency_ResetStats();
+  }
+}
+
+static void GetTrace(uint8_t token, unsigned int length) {
+  if (length) {
+    SendMessage(token, COMMAND_GET_TRACE, RC_BAD_PARAM, NULL, 0u);
+    return;
+  }
+
+  const unsigned int max_events =
+      (PAYLOAD_SIZE - sizeof(uint32_t)) / sizeof(TransceiverTraceEvent);
+  const TransceiverTraceEvent *events;
+  uint32_t dropped;
+  unsigned int count = TransceiverTrace_Peek(&events, &dropped);
+  if (count > max_events) {
+    count = max_events;
+  }
+
+  IOVec iovecs[2];
+  iovecs[0].base = &dropped;
+  iovecs[0].length = sizeof(dropped);
+  iovecs[1].base = events;
+  iovecs[1].length = count * sizeof(TransceiverTraceEvent);
+  SendMessage(token, COMMAND_GET_TRACE, RC_OK, iovecs, 2u);
+  TransceiverTrace_Consume(count);
+}
+
+static void SendBufferFull(const Message *message) {
+  Metrics_Increment(METRIC_BUFFER_FULL);
+  SendMessage(message->token, message->command, RC_BUFFER_FULL, NULL, 0u);
+}
+
 static bool CheckForTXMode(const Message *message) {
   if (Transceiver_GetMode() == T_MODE_CONTROLLER) {
     return true;
@@ -339,7 +418,7 @@ void MessageHandler_HandleMessage(const Message *message) {
       if (CheckForTXMode(message) &&
           !Transceiver_QueueDMX(message->token, message->payload,
                                 message->length)) {
-        SendMessage(message->token, message->command, RC_BUFFER_FULL, NULL, 0u);
+        SendBufferFull(message);
       }
       break;
     case GET_FLAGS:
@@ -358,18 +437,30 @@ void MessageHandler_HandleMessage(const Message *message) {
     case COMMAND_RUN_SELF_TEST:
       RunSelfTest(message->token, message->length);
       break;
+    case COMMAND_GET_METRICS:
+      GetMetrics(message->token, message->length);
+      break;
+    case COMMAND_GET_ISR_STATS:
+      GetISRStats(message->token, message->payload, message->length);
+      break;
+    case COMMAND_GET_TRACE:
+      GetTrace(message->token, message->length);
+      break;
+    case COMMAND_GET_LATENCY_STATS:
+      GetLatencyStats(message->token, message->payload, message->length);
+      break;
     case COMMAND_RDM_DUB_REQUEST:
       if (CheckForTXMode(message) &&
           !Transceiver_QueueRDMDUB(message->token, message->payload,
                                    message->length)) {
-        SendMessage(message->token, message->command, RC_BUFFER_FULL, NULL, 0u);
+        SendBufferFull(message);
       }
       break;
     case COMMAND_RDM_REQUEST:
       if (CheckForTXMode(message) &&
           !Transceiver_QueueRDMRequest(message->token, message->payload,
                                        message->length, false)) {
-        SendMessage(message->token, message->command, RC_BUFFER_FULL, NULL, 0u);
+        SendBufferFull(message);
       }
       break;
     case COMMAND_SET_BREAK_TIME:
@@ -419,7 +510,7 @@ void MessageHandler_HandleMessage(const Message *message) {
       if (CheckForTXMode(message) &&
           !Transceiver_QueueRDMRequest(message->token, message->payload,
                                        message->length, true)) {
-        SendMessage(message->token, message->command, RC_BUFFER_FULL, NULL, 0u);
+        SendBufferFull(message);
       }
       break;
 
@@ -0,0 +1,64 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * metrics.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "metrics.h"
+
+#include <string.h>
+
+typedef struct {
+  const char *name;
+  MetricType type;
+} MetricDefinition;
+
+// This must be kept in the same order as MetricId.
+static const MetricDefinition METRIC_DEFINITIONS[METRIC_COUNT] = {
+  {"uptime", METRIC_TYPE_GAUGE},
+  {"scheduler_load", METRIC_TYPE_GAUGE},
+  {"tx_frames", METRIC_TYPE_COUNTER},
+  {"rdm_timeouts", METRIC_TYPE_COUNTER},
+  {"rdm_invalid_responses", METRIC_TYPE_COUNTER},
+  {"usb_rx_transfers", METRIC_TYPE_COUNTER},
+  {"usb_tx_messages", METRIC_TYPE_COUNTER},
+  {"usb_tx_drops", METRIC_TYPE_COUNTER},
+  {"usb_tx_errors", METRIC_TYPE_COUNTER},
+  {"host_messages", METRIC_TYPE_COUNTER},
+  {"host_framing_errors", METRIC_TYPE_COUNTER},
+  {"buffer_full", METRIC_TYPE_COUNTER},
+  {"rdm_responses_sent", METRIC_TYPE_COUNTER},
+};
+
+uint32_t g_metrics[METRIC_COUNT];
+
+void Metrics_Initialize() {
+  memset(g_metrics, 0, sizeof(g_metrics));
+}
+
+const char *Metrics_Name(MetricId id) {
+  if (id >= METRIC_COUNT) {
+    return NULL;
+  }
+  return METRIC_DEFINITIONS[id].name;
+}
+
+MetricType Metrics_Type(MetricId id) {
+  if (id >= METRIC_COUNT) {
+    return METRIC_TYPE_COUNTER;
+  }
+  return METRIC_DEFINITIONS[id].type;
+}
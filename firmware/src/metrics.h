@@ -0,0 +1,140 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * metrics.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup metrics Metrics
+ * @brief Counters and gauges for monitoring the device.
+ *
+ * Each metric is a uint32_t, identified by a MetricId. Counters are
+ * incremented when an event occurs and wrap at 2^32. Gauges are set to the
+ * current value of some quantity.
+ *
+ * Updating a metric is a single increment or store, so it's cheap enough to
+ * do from an ISR. Each metric must only be updated from one context, since the
+ * increment isn't atomic. If an event can occur in more than one context, it
+ * gets a metric for each.
+ *
+ * The host reads the metrics with the @ref message-commands-getmetrics
+ * command, and RDM controllers with the PID_DEVICE_METRICS manufacturer PID.
+ * Both return the metrics in MetricId order.
+ *
+ * @addtogroup metrics
+ * @{
+ * @file metrics.h
+ * @brief Counters and gauges for monitoring the device.
+ */
+
+#ifndef FIRMWARE_SRC_METRICS_H_
+#define FIRMWARE_SRC_METRICS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The metrics.
+ *
+ * The values are part of the host protocol and PID_DEVICE_METRICS, new
+ * metrics must be added at the end.
+ */
+typedef enum {
+  METRIC_UPTIME,  //!< Gauge, the number of seconds since the device started.
+  METRIC_SCHEDULER_LOAD,  //!< Gauge, the main loop load in 10ths of a percent.
+  METRIC_TX_FRAMES,  //!< The number of frames sent in controller mode.
+  METRIC_RDM_TIMEOUTS,  //!< The number of RDM requests without a response.
+  METRIC_RDM_INVALID_RESPONSES,  //!< The number of malformed RDM responses.
+  METRIC_USB_RX_TRANSFERS,  //!< The number of USB transfers from the host.
+  METRIC_USB_TX_MESSAGES,  //!< The number of messages sent to the host.
+  METRIC_USB_TX_DROPS,  //!< Messages dropped since a write was in progress.
+  METRIC_USB_TX_ERRORS,  //!< Messages dropped since the USB write failed.
+  METRIC_HOST_MESSAGES,  //!< The number of messages decoded from the host.
+  METRIC_HOST_FRAMING_ERRORS,  //!< Host messages without an end of message.
+  METRIC_BUFFER_FULL,  //!< Requests rejected with RC_BUFFER_FULL.
+  METRIC_RDM_RESPONSES_SENT,  //!< The number of responses sent as a responder.
+  METRIC_COUNT  //!< The number of metrics, not a valid metric.
+} MetricId;
+
+/**
+ * @brief The type of a metric.
+ */
+typedef enum {
+  METRIC_TYPE_COUNTER,  //!< Incremented when an event occurs.
+  METRIC_TYPE_GAUGE  //!< Set to the current value.
+} MetricType;
+
+/// @cond INTERNAL
+extern uint32_t g_metrics[METRIC_COUNT];
+/// @endcond
+
+/**
+ * @brief Reset all metrics to 0.
+ */
+void Metrics_Initialize();
+
+/**
+ * @brief Increment a counter.
+ * @param id The counter to increment.
+ */
+static inline void Metrics_Increment(MetricId id) {
+  g_metrics[id]++;
+}
+
+/**
+ * @brief Set the value of a gauge.
+ * @param id The gauge to set.
+ * @param value The new value.
+ */
+static inline void Metrics_Set(MetricId id, uint32_t value) {
+  g_metrics[id] = value;
+}
+
+/**
+ * @brief Get the value of a metric.
+ * @param id The metric to get.
+ * @returns The value of the metric.
+ */
+static inline uint32_t Metrics_Get(MetricId id) {
+  return g_metrics[id];
+}
+
+/**
+ * @brief Get the name of a metric.
+ * @param id The metric.
+ * @returns The name of the metric, or NULL if the id is out of range.
+ */
+const char *Metrics_Name(MetricId id);
+
+/**
+ * @brief Get the type of a metric.
+ * @param id The metric.
+ * @returns The type of the metric.
+ */
+MetricType Metrics_Type(MetricId id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FIRMWARE_SRC_METRICS_H_
+
+/**
+ * @}
+ */
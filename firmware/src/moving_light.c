@@ -20,13 +20,13 @@
 
 #include <stdlib.h>
 
-#include "coarse_timer.h"
 #include "constants.h"
 #include "macros.h"
 #include "rdm_buffer.h"
 #include "rdm_frame.h"
 #include "rdm_responder.h"
 #include "rdm_util.h"
+#include "timer_wheel.h"
 #include "utils.h"
 
 // Various constants
@@ -47,6 +47,10 @@ static const char LANGUAGE_FRENCH[] = "fr";
 
 static const ResponderDefinition RESPONDER_DEFINITION;
 
+static const ResponderDefinition *const RESPONDER_DEFINITIONS[] = {
+  &RESPONDER_DEFINITION
+};
+
 /*
  * @brief The simple model state.
  */
@@ -55,8 +59,8 @@ typedef struct {
   uint32_t lamp_hours;
   uint32_t lamp_strikes;
   uint32_t device_power_cycles;
-  CoarseTimer_Value lamp_strike_time;
-  CoarseTimer_Value clock_timer;
+  TimerWheel_Timer lamp_strike_timer;
+  TimerWheel_Timer clock_timer;
   uint8_t lamp_state;
   uint8_t lamp_on_mode;
   uint8_t display_level;
@@ -132,6 +136,44 @@ uint8_t DaysInMonth(uint16_t year, uint8_t month) {
   }
 }
 
+/*
+ * @brief Called once the lamp has finished striking.
+ */
+static void LampStruck() {
+  if (g_moving_light.lamp_state == LAMP_STRIKE) {
+    g_moving_light.lamp_state = LAMP_ON;
+    g_moving_light.lamp_strikes++;
+  }
+}
+
+/*
+ * @brief Advance the real time clock by a second.
+ */
+static void ClockTick() {
+  g_moving_light.second++;
+  if (g_moving_light.second >= 60u) {
+    g_moving_light.second = 0u;
+    g_moving_light.minute++;
+  }
+  if (g_moving_light.minute >= 60u) {
+    g_moving_light.minute = 0u;
+    g_moving_light.hour++;
+  }
+  if (g_moving_light.hour >= 24u) {
+    g_moving_light.hour = 0u;
+    g_moving_light.day++;
+  }
+  if (g_moving_light.day >
+      DaysInMonth(g_moving_light.year, g_moving_light.month)) {
+    g_moving_light.day = 1u;
+    g_moving_light.month++;
+  }
+  if (g_moving_light.month > 12u) {
+    g_moving_light.month = 1u;
+    g_moving_light.year++;
+  }
+}
+
 // PID Handlers
 // ----------------------------------------------------------------------------
 int MovingLightModel_GetLanguageCapabilities(const RDMHeader *header,
@@ -321,7 +363,10 @@ int MovingLightModel_SetLampState(const RDMHeader *header,
   }
   g_moving_light.lamp_state = param_data[0];
   if (g_moving_light.lamp_state == LAMP_STRIKE) {
-    g_moving_light.lamp_strike_time = CoarseTimer_GetTime();
+    TimerWheel_Schedule(&g_moving_light.lamp_strike_timer, LAMP_STRIKE_DELAY,
+                        LampStruck);
+  } else {
+    TimerWheel_Cancel(&g_moving_light.lamp_strike_timer);
   }
   return RDMResponder_BuildSetAck(header);
 }
@@ -459,10 +504,17 @@ void MovingLightModel_Initialize() {
 static void MovingLightModel_Activate() {
   g_responder->def = &RESPONDER_DEFINITION;
   RDMResponder_InitResponder();
-  g_moving_light.clock_timer = CoarseTimer_GetTime();
+  TimerWheel_SchedulePeriodic(&g_moving_light.clock_timer, ONE_SECOND,
+                              ClockTick);
+  if (g_moving_light.lamp_state == LAMP_STRIKE) {
+    TimerWheel_Schedule(&g_moving_light.lamp_strike_timer, LAMP_STRIKE_DELAY,
+                        LampStruck);
+  }
 }
 
 static void MovingLightModel_Deactivate() {
+  TimerWheel_Cancel(&g_moving_light.lamp_strike_timer);
+  TimerWheel_Cancel(&g_moving_light.clock_timer);
 }
 
 static int MovingLightModel_HandleRequest(const RDMHeader *header,
@@ -490,40 +542,7 @@ static int MovingLightModel_HandleRequest(const RDMHeader *header,
   return RDMResponder_DispatchPID(header, param_data);
 }
 
-static void MovingLightModel_Tasks() {
-  if (g_moving_light.lamp_state == LAMP_STRIKE &&
-      CoarseTimer_HasElapsed(g_moving_light.lamp_strike_time,
-                             LAMP_STRIKE_DELAY)) {
-    g_moving_light.lamp_state = LAMP_ON;
-    g_moving_light.lamp_strikes++;
-  }
-
-  if (CoarseTimer_HasElapsed(g_moving_light.clock_timer, ONE_SECOND)) {
-    g_moving_light.clock_timer = CoarseTimer_GetTime();
-    g_moving_light.second++;
-    if (g_moving_light.second >= 60u) {
-      g_moving_light.second = 0u;
-      g_moving_light.minute++;
-    }
-    if (g_moving_light.minute >= 60u) {
-      g_moving_light.minute = 0u;
-      g_moving_light.hour++;
-    }
-    if (g_moving_light.hour >= 24u) {
-      g_moving_light.hour = 0u;
-      g_moving_light.day++;
-    }
-    if (g_moving_light.day >
-        DaysInMonth(g_moving_light.year, g_moving_light.month)) {
-      g_moving_light.day = 1u;
-      g_moving_light.month++;
-    }
-    if (g_moving_light.month > 12u) {
-      g_moving_light.month = 1u;
-      g_moving_light.year++;
-    }
-  }
-}
+static void MovingLightModel_Tasks() {}
 
 const ModelEntry MOVING_LIGHT_MODEL_ENTRY = {
   .model_id = MOVING_LIGHT_MODEL_ID,
@@ -531,7 +550,10 @@ const ModelEntry MOVING_LIGHT_MODEL_ENTRY = {
   .deactivate_fn = MovingLightModel_Deactivate,
   .ioctl_fn = RDMResponder_Ioctl,
   .request_fn = MovingLightModel_HandleRequest,
-  .tasks_fn = MovingLightModel_Tasks
+  .tasks_fn = MovingLightModel_Tasks,
+  .definitions = RESPONDER_DEFINITIONS,
+  .definition_count = sizeof(RESPONDER_DEFINITIONS) /
+                      sizeof(RESPONDER_DEFINITIONS[0])
 };
 
 static const PIDDescriptor PID_DESCRIPTORS[] = {
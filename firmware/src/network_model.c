@@ -57,6 +57,10 @@ static const uint32_t DHCP_FAILURE_RATIO = 3u;  // Fail 1 / n DHCP requests.
 
 static const ResponderDefinition RESPONDER_DEFINITION;
 
+static const ResponderDefinition *const RESPONDER_DEFINITIONS[] = {
+  &RESPONDER_DEFINITION
+};
+
 /*
  * @brief The read only state for a network Interface.
  */
@@ -639,7 +643,10 @@ const ModelEntry NETWORK_MODEL_ENTRY = {
   .deactivate_fn = NetworkModel_Deactivate,
   .ioctl_fn = RDMResponder_Ioctl,
   .request_fn = NetworkModel_HandleRequest,
-  .tasks_fn = NetworkModel_Tasks
+  .tasks_fn = NetworkModel_Tasks,
+  .definitions = RESPONDER_DEFINITIONS,
+  .definition_count = sizeof(RESPONDER_DEFINITIONS) /
+                      sizeof(RESPONDER_DEFINITIONS[0])
 };
 
 static const PIDDescriptor PID_DESCRIPTORS[] = {
@@ -656,8 +663,6 @@ static const PIDDescriptor PID_DESCRIPTORS[] = {
     RDMResponder_SetDeviceLabel},
   {PID_SOFTWARE_VERSION_LABEL, RDMResponder_GetSoftwareVersionLabel, 0u,
     (PIDCommandHandler) NULL},
-  {PID_IDENTIFY_DEVICE, RDMResponder_GetIdentifyDevice, 0u,
-    RDMResponder_SetIdentifyDevice},
   {PID_LIST_INTERFACES, NetworkModel_GetListInterfaces, 0u,
     (PIDCommandHandler) NULL},
   {PID_INTERFACE_LABEL, NetworkModel_GetInterfaceLabel, 4u,
@@ -684,6 +689,8 @@ static const PIDDescriptor PID_DESCRIPTORS[] = {
   {PID_DNS_HOSTNAME, NetworkModel_GetHostname, 0u, NetworkModel_SetHostname},
   {PID_DNS_DOMAIN_NAME, NetworkModel_GetDomainName, 0u,
     NetworkModel_SetDomainName},
+  {PID_IDENTIFY_DEVICE, RDMResponder_GetIdentifyDevice, 0u,
+    RDMResponder_SetIdentifyDevice},
 };
 
 static const ProductDetailIds PRODUCT_DETAIL_ID_LIST = {
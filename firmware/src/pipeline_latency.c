@@ -0,0 +1,161 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * pipeline_latency.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "pipeline_latency.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+/*
+ * @brief The upper bound of the first histogram bucket, as a power of 2.
+ */
+enum { FIRST_BUCKET_SHIFT = 5 };
+
+/*
+ * @brief A message in flight.
+ */
+typedef struct {
+  Timestamp received;  //!< When the USB transfer arrived.
+  Timestamp handled;  //!< When the message was passed to the handler.
+  Timestamp frame_start;  //!< The start of the break, or 0.
+  Timestamp event;  //!< When the transceiver event occurred, or 0.
+  uint8_t token;
+  bool in_use;
+} InFlightMessage;
+
+typedef struct {
+  Timestamp last_transfer;
+  uint8_t next_slot;  //!< The slot to use if all slots are in use.
+  InFlightMessage messages[PIPELINE_LATENCY_MAX_MESSAGES];
+  PipelineLatency_Stats stats[PIPELINE_STAGE_COUNT];
+} PipelineLatencyData;
+
+static PipelineLatencyData g_latency;
+
+static InFlightMessage *FindMessage(uint8_t token) {
+  unsigned int i = 0u;
+  for (; i < PIPELINE_LATENCY_MAX_MESSAGES; i++) {
+    if (g_latency.messages[i].in_use && g_latency.messages[i].token == token) {
+      return &g_latency.messages[i];
+    }
+  }
+  return NULL;
+}
+
+static InFlightMessage *AllocateMessage(uint8_t token) {
+  // If the host re-uses a token, the earlier message is forgotten.
+  InFlightMessage *message = FindMessage(token);
+  if (message) {
+    return message;
+  }
+
+  unsigned int i = 0u;
+  for (; i < PIPELINE_LATENCY_MAX_MESSAGES; i++) {
+    if (!g_latency.messages[i].in_use) {
+      return &g_latency.messages[i];
+    }
+  }
+
+  // All slots are in use, replace them in turn.
+  message = &g_latency.messages[g_latency.next_slot];
+  g_latency.next_slot = (g_latency.next_slot + 1u) %
+                        PIPELINE_LATENCY_MAX_MESSAGES;
+  return message;
+}
+
+static void Record(PipelineStage stage, Timestamp start, Timestamp end) {
+  const uint32_t interval = Timestamp_ToMicroSeconds(end - start);
+  PipelineLatency_Stats *stats = &g_latency.stats[stage];
+  stats->count++;
+  stats->total += interval;
+  if (stats->count == 1u || interval < stats->min) {
+    stats->min = interval;
+  }
+  if (interval > stats->max) {
+    stats->max = interval;
+  }
+
+  unsigned int bucket = 0u;
+  uint32_t limit = interval >> FIRST_BUCKET_SHIFT;
+  while (limit && bucket < PIPELINE_LATENCY_BUCKETS - 1u) {
+    limit >>= 1;
+    bucket++;
+  }
+  stats->histogram[bucket]++;
+}
+
+// Public Functions
+// ----------------------------------------------------------------------------
+void PipelineLatency_Initialize() {
+  memset(&g_latency, 0, sizeof(g_latency));
+}
+
+void PipelineLatency_ResetStats() {
+  memset(g_latency.stats, 0, sizeof(g_latency.stats));
+}
+
+void PipelineLatency_TransferReceived() {
+  g_latency.last_transfer = Timestamp_Now();
+}
+
+void PipelineLatency_MessageReceived(uint8_t token) {
+  InFlightMessage *message = AllocateMessage(token);
+  message->received = g_latency.last_transfer;
+  message->handled = Timestamp_Now();
+  message->frame_start = 0u;
+  message->event = 0u;
+  message->token = token;
+  message->in_use = true;
+}
+
+void PipelineLatency_TransceiverEvent(int16_t token, Timestamp frame_start) {
+  if (token < 0) {
+    return;
+  }
+  InFlightMessage *message = FindMessage((uint8_t) token);
+  if (message) {
+    message->frame_start = frame_start;
+    message->event = Timestamp_Now();
+  }
+}
+
+void PipelineLatency_ResponseSent(uint8_t token) {
+  InFlightMessage *message = FindMessage(token);
+  if (!message) {
+    return;
+  }
+
+  const Timestamp now = Timestamp_Now();
+  Record(PIPELINE_STAGE_DECODE, message->received, message->handled);
+  if (message->event) {
+    if (message->frame_start) {
+      Record(PIPELINE_STAGE_QUEUE, message->handled, message->frame_start);
+      Record(PIPELINE_STAGE_LINE, message->frame_start, message->event);
+    }
+    Record(PIPELINE_STAGE_RESPONSE, message->event, now);
+  } else {
+    Record(PIPELINE_STAGE_RESPONSE, message->handled, now);
+  }
+  Record(PIPELINE_STAGE_TOTAL, message->received, now);
+  message->in_use = false;
+}
+
+const PipelineLatency_Stats *PipelineLatency_GetStats() {
+  return g_latency.stats;
+}
@@ -0,0 +1,172 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * pipeline_latency.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup pipeline_latency Pipeline Latency
+ * @brief Measure how long host messages spend in each stage of the pipeline.
+ *
+ * A message from the host passes through the following stages, each of which
+ * is timestamped, keyed by the message's token:
+ *  - The USB transfer containing the end of the message is received.
+ *  - The message is decoded and passed to the message handler.
+ *  - The transceiver starts the break for the frame.
+ *  - The transceiver event is delivered to the message handler.
+ *  - The response is sent to the host.
+ *
+ * When the response is sent, the time between each stage is added to the
+ * distribution for that stage. Messages that don't use the transceiver skip
+ * the queue and line stages.
+ *
+ * The hooks are called from the board's app_pipeline.h and the host reads the
+ * distributions with the @ref message-commands-getlatencystats command.
+ *
+ * @addtogroup pipeline_latency
+ * @{
+ * @file pipeline_latency.h
+ * @brief Measure how long host messages spend in each stage of the pipeline.
+ */
+
+#ifndef FIRMWARE_SRC_PIPELINE_LATENCY_H_
+#define FIRMWARE_SRC_PIPELINE_LATENCY_H_
+
+#include <stdint.h>
+
+#include "timestamp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The intervals between the pipeline stages.
+ *
+ * The values are part of the host protocol, new stages must be added at the
+ * end.
+ */
+typedef enum {
+  /**
+   * @brief From the USB transfer arriving to the message being handled.
+   */
+  PIPELINE_STAGE_DECODE,
+  /**
+   * @brief From the message being handled to the start of the break.
+   *
+   * This is the time spent waiting for earlier frames to complete.
+   */
+  PIPELINE_STAGE_QUEUE,
+  /**
+   * @brief From the start of the break to the transceiver event.
+   *
+   * This includes the request, the RDM response or timeout and the time
+   * until Transceiver_Tasks() runs.
+   */
+  PIPELINE_STAGE_LINE,
+  /**
+   * @brief From the transceiver event, or the message being handled if the
+   * transceiver wasn't used, to the response being sent.
+   */
+  PIPELINE_STAGE_RESPONSE,
+  /**
+   * @brief From the USB transfer arriving to the response being sent.
+   */
+  PIPELINE_STAGE_TOTAL,
+  PIPELINE_STAGE_COUNT  //!< The number of stages, not a valid stage.
+} PipelineStage;
+
+/**
+ * @brief The number of histogram buckets.
+ *
+ * Bucket 0 counts intervals shorter than 32us, each following bucket covers
+ * twice the range of the previous one and the last bucket counts everything
+ * from 65.5ms.
+ */
+#define PIPELINE_LATENCY_BUCKETS 13u
+
+/**
+ * @brief The maximum number of messages that can be tracked at once.
+ *
+ * If more messages are in flight, the oldest is forgotten.
+ */
+#define PIPELINE_LATENCY_MAX_MESSAGES 8u
+
+/**
+ * @brief The distribution of the interval for a stage.
+ *
+ * All times are in microseconds.
+ */
+typedef struct {
+  uint64_t total;  //!< The sum of the intervals.
+  uint32_t count;  //!< The number of intervals recorded.
+  uint32_t min;  //!< The shortest interval, 0 if count is 0.
+  uint32_t max;  //!< The longest interval.
+  uint32_t histogram[PIPELINE_LATENCY_BUCKETS];  //!< The interval histogram.
+} PipelineLatency_Stats;
+
+/**
+ * @brief Clear the distributions and forget the messages in flight.
+ */
+void PipelineLatency_Initialize();
+
+/**
+ * @brief Clear the distributions.
+ */
+void PipelineLatency_ResetStats();
+
+/**
+ * @brief Called when a USB transfer is received from the host.
+ */
+void PipelineLatency_TransferReceived();
+
+/**
+ * @brief Called when a message is passed to the message handler.
+ * @param token The token of the message.
+ */
+void PipelineLatency_MessageReceived(uint8_t token);
+
+/**
+ * @brief Called when a transceiver event is passed to the message handler.
+ * @param token The token of the event.
+ * @param frame_start The start of the break, or 0 if no frame was sent.
+ */
+void PipelineLatency_TransceiverEvent(int16_t token, Timestamp frame_start);
+
+/**
+ * @brief Called when a response is sent to the host.
+ * @param token The token of the response.
+ *
+ * If the token matches a message in flight, the intervals are recorded.
+ */
+void PipelineLatency_ResponseSent(uint8_t token);
+
+/**
+ * @brief Get the distributions.
+ * @returns An array of PIPELINE_STAGE_COUNT distributions, indexed by
+ *   PipelineStage.
+ */
+const PipelineLatency_Stats *PipelineLatency_GetStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FIRMWARE_SRC_PIPELINE_LATENCY_H_
+
+/**
+ * @}
+ */
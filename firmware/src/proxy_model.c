@@ -81,6 +81,11 @@ static ChildDevice g_children[NUMBER_OF_CHILDREN];
 static const ResponderDefinition ROOT_RESPONDER_DEFINITION;
 static const ResponderDefinition CHILD_DEVICE_RESPONDER_DEFINITION;
 
+static const ResponderDefinition *const RESPONDER_DEFINITIONS[] = {
+  &ROOT_RESPONDER_DEFINITION,
+  &CHILD_DEVICE_RESPONDER_DEFINITION
+};
+
 // Helper functions
 // ----------------------------------------------------------------------------
 void ResetProxyBuffers() {
@@ -311,7 +316,10 @@ const ModelEntry PROXY_MODEL_ENTRY = {
   .deactivate_fn = ProxyModel_Deactivate,
   .ioctl_fn = RDMResponder_Ioctl,
   .request_fn = ProxyModel_HandleRequest,
-  .tasks_fn = ProxyModel_Tasks
+  .tasks_fn = ProxyModel_Tasks,
+  .definitions = RESPONDER_DEFINITIONS,
+  .definition_count = sizeof(RESPONDER_DEFINITIONS) /
+                      sizeof(RESPONDER_DEFINITIONS[0])
 };
 
 // Root device definition
@@ -379,7 +379,13 @@ typedef enum {
   PID_DEVICE_MODEL_LIST = 0x8003,
   // 8004 is reserved for MODEL_ID_DESCRIPTION if we ever implement it
   PID_PIXEL_TYPE = 0x8005,
-  PID_PIXEL_COUNT = 0x8006
+  PID_PIXEL_COUNT = 0x8006,
+  PID_PIXEL_GAMMA = 0x8007,
+  PID_PIXEL_WHITE_BALANCE = 0x8008,
+  PID_PIXEL_DITHERING = 0x8009,
+  PID_DEVICE_METRICS = 0x800a,
+  PID_DEVICE_METRIC_DESCRIPTION = 0x800b,
+  PID_PIXEL_BRIGHTNESS = 0x800c
 } OpenLightingManufacturerPID;
 
 /**
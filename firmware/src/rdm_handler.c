@@ -25,6 +25,7 @@
 #include "constants.h"
 #include "iovec.h"
 #include "macros.h"
+#include "metrics.h"
 #include "rdm_buffer.h"
 #include "rdm_frame.h"
 #include "rdm_util.h"
@@ -43,6 +44,18 @@ typedef struct {
 
 static RDMHandlerState g_rdm_handler;
 
+/*
+ * @brief The NACK reason to use for the root-only PIDs handled here.
+ * @param sub_device The sub device the request was sent to.
+ *
+ * Sub devices that exist don't support the PID; sub devices that don't exist
+ * are out of range.
+ */
+static RDMNackReason SubDeviceNackReason(uint16_t sub_device) {
+  return RDMResponder_SubDeviceSlot(sub_device) < 0 ?
+      NR_SUB_DEVICE_OUT_OF_RANGE : NR_UNKNOWN_PID;
+}
+
 static int GetSetModelId(const RDMHeader *header,
                          const uint8_t *param_data) {
   uint8_t our_uid[UID_LENGTH];
@@ -53,9 +66,8 @@ static int GetSetModelId(const RDMHeader *header,
   }
 
   uint16_t sub_device = ntohs(header->sub_device);
-  // No subdevice support for now.
   if (sub_device != SUBDEVICE_ROOT && sub_device != SUBDEVICE_ALL) {
-    return RDMResponder_BuildNack(header, NR_SUB_DEVICE_OUT_OF_RANGE);
+    return RDMResponder_BuildNack(header, SubDeviceNackReason(sub_device));
   } else if (sub_device == SUBDEVICE_ALL &&
              header->command_class == GET_COMMAND) {
     return RDMResponder_BuildNack(header, NR_SUB_DEVICE_OUT_OF_RANGE);
@@ -100,26 +112,48 @@ static int GetSetModelId(const RDMHeader *header,
   return RDM_RESPONDER_NO_RESPONSE;
 }
 
-static int GetModelList(const RDMHeader *header) {
+/*
+ * @brief Check the common requirements of the root-only GET PIDs.
+ * @param header The request header.
+ * @param param_data_length The expected param data length.
+ * @param[out] response_size The size of the response to send, if the request
+ *   shouldn't be handled.
+ * @returns true if the request should be handled.
+ */
+static bool CheckRootGet(const RDMHeader *header, uint8_t param_data_length,
+                         int *response_size) {
   uint8_t our_uid[UID_LENGTH];
   RDMHandler_GetUID(our_uid);
 
+  *response_size = RDM_RESPONDER_NO_RESPONSE;
   if (RDMUtil_UIDCompare(our_uid, header->dest_uid)) {
-    return RDM_RESPONDER_NO_RESPONSE;
+    return false;
   }
 
   uint16_t sub_device = ntohs(header->sub_device);
-  // No subdevice support for now.
   if (sub_device != SUBDEVICE_ROOT) {
-    return RDMResponder_BuildNack(header, NR_SUB_DEVICE_OUT_OF_RANGE);
+    *response_size = RDMResponder_BuildNack(header,
+                                            SubDeviceNackReason(sub_device));
+    return false;
   }
 
   if (header->command_class != GET_COMMAND) {
-    return RDMResponder_BuildNack(header, NR_UNSUPPORTED_COMMAND_CLASS);
+    *response_size = RDMResponder_BuildNack(header,
+                                            NR_UNSUPPORTED_COMMAND_CLASS);
+    return false;
+  }
+
+  if (header->param_data_length != param_data_length) {
+    *response_size = RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+    return false;
   }
+  return true;
+}
 
-  if (header->param_data_length) {
-    return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+static int GetModelList(const RDMHeader *header) {
+  int response_size;
+  if (!CheckRootGet(header, 0u, &response_size)) {
+    return response_size;
   }
 
   uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
@@ -133,6 +167,41 @@ static int GetModelList(const RDMHeader *header) {
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
 
+static int GetDeviceMetrics(const RDMHeader *header) {
+  int response_size;
+  if (!CheckRootGet(header, 0u, &response_size)) {
+    return response_size;
+  }
+
+  uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
+  unsigned int i = 0u;
+  for (; i < METRIC_COUNT; i++) {
+    ptr = PushUInt32(ptr, Metrics_Get((MetricId) i));
+  }
+  return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
+}
+
+static int GetDeviceMetricDescription(const RDMHeader *header,
+                                      const uint8_t *param_data) {
+  int response_size;
+  if (!CheckRootGet(header, sizeof(uint8_t), &response_size)) {
+    return response_size;
+  }
+
+  uint8_t metric = param_data[0];
+  if (metric >= METRIC_COUNT) {
+    return RDMResponder_BuildNack(header, NR_DATA_OUT_OF_RANGE);
+  }
+
+  uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
+  *ptr++ = metric;
+  *ptr++ = Metrics_Type((MetricId) metric);
+  ptr += RDMUtil_StringCopy((char*) ptr, RDM_DEFAULT_STRING_SIZE,
+                            Metrics_Name((MetricId) metric),
+                            RDM_DEFAULT_STRING_SIZE);
+  return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
+}
+
 // Public Functions
 // ----------------------------------------------------------------------------
 void RDMHandler_Initialize(const RDMHandlerSettings *settings) {
@@ -160,6 +229,9 @@ bool RDMHandler_AddModel(const ModelEntry *entry) {
       g_models[i].ioctl_fn = entry->ioctl_fn;
       g_models[i].request_fn = entry->request_fn;
       g_models[i].tasks_fn = entry->tasks_fn;
+      g_models[i].dmx_fn = entry->dmx_fn;
+      g_models[i].definitions = entry->definitions;
+      g_models[i].definition_count = entry->definition_count;
       if (entry->model_id == g_rdm_handler.default_model) {
         g_rdm_handler.active_model = &g_models[i];
         g_rdm_handler.active_model->activate_fn();
@@ -214,6 +286,10 @@ void RDMHandler_HandleRequest(const RDMHeader *header,
     response_size = GetSetModelId(header, param_data);
   } else if (ntohs(header->param_id) == PID_DEVICE_MODEL_LIST) {
     response_size = GetModelList(header);
+  } else if (ntohs(header->param_id) == PID_DEVICE_METRICS) {
+    response_size = GetDeviceMetrics(header);
+  } else if (ntohs(header->param_id) == PID_DEVICE_METRIC_DESCRIPTION) {
+    response_size = GetDeviceMetricDescription(header, param_data);
   } else {
     if (!g_rdm_handler.active_model) {
       return;
@@ -235,6 +311,13 @@ void RDMHandler_HandleRequest(const RDMHeader *header,
   }
 }
 
+void RDMHandler_HandleDMX(unsigned int offset, const uint8_t *data,
+                          unsigned int length) {
+  if (g_rdm_handler.active_model && g_rdm_handler.active_model->dmx_fn) {
+    g_rdm_handler.active_model->dmx_fn(offset, data, length);
+  }
+}
+
 void RDMHandler_GetUID(uint8_t *uid) {
   if (g_rdm_handler.active_model) {
     g_rdm_handler.active_model->ioctl_fn(IOCTL_GET_UID, uid, UID_LENGTH);
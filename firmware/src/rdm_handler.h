@@ -114,6 +114,17 @@ uint16_t RDMHandler_ActiveModel();
 void RDMHandler_HandleRequest(const RDMHeader *header,
                               const uint8_t *param_data);
 
+/**
+ * @brief Handle DMX512 data.
+ * @param offset The offset of the first slot in data, 0 is slot 1.
+ * @param data The slot data.
+ * @param length The number of slots in data.
+ *
+ * This passes the data to the dmx_fn of the active model, if there is one.
+ */
+void RDMHandler_HandleDMX(unsigned int offset, const uint8_t *data,
+                          unsigned int length);
+
 /**
  * @brief Get the UID of the responder.
  * @param[out] uid A pointer to copy the UID to; should be at least UID_LENGTH.
@@ -108,6 +108,8 @@ typedef enum {
   IOCTL_GET_UID,
 } ModelIoctl;
 
+struct ResponderDefinition_s;
+
 /**
  * @brief The function table entry for a particular responder model.
  *
@@ -157,6 +159,32 @@ typedef struct {
    * This is called periodically by RDMHandler_Tasks().
    */
   void (*tasks_fn)();
+
+  /**
+   * @brief The function used to receive DMX512 data.
+   * @param offset The offset of the first slot in data, 0 is slot 1.
+   * @param data The slot data.
+   * @param length The number of slots in data.
+   *
+   * This is called by RDMHandler_HandleDMX() as NULL start code frames are
+   * received. A frame may be delivered over several calls. This may be NULL
+   * if the model doesn't use DMX data.
+   */
+  void (*dmx_fn)(unsigned int offset, const uint8_t *data,
+                 unsigned int length);
+
+  /**
+   * @brief The ResponderDefinitions used by the model.
+   *
+   * This includes the definitions for sub devices and child responders, so
+   * the PID tables can be checked and benchmarked.
+   */
+  const struct ResponderDefinition_s *const *definitions;
+
+  /**
+   * @brief The number of entries in definitions.
+   */
+  unsigned int definition_count;
 } ModelEntry;
 
 #ifdef __cplusplus
@@ -40,6 +40,18 @@ static const uint8_t SENSOR_VALUE_PARAM_DATA_LENGTH = 9u;
 static const uint16_t FLASH_FAST = 1000u;
 static const uint16_t FLASH_SLOW = 10000u;
 
+// SUBDEVICE_MAX + 1, as an enum so it can be used as an array size.
+enum { SUBDEVICE_TABLE_SIZE = 0x0201 };
+
+/*
+ * @brief The bits used in RDMResponderCache.valid.
+ */
+enum {
+  CACHE_DEVICE_INFO = 0x01,
+  CACHE_SUPPORTED_PARAMETERS = 0x02,
+  CACHE_PRODUCT_DETAIL_IDS = 0x04
+};
+
 // Microchip defines this macro in stdlib.h but it's non standard.
 // We define it here so that the unit tests work.
 #ifndef min
@@ -77,6 +89,23 @@ typedef struct {
 
 static InternalResponderState g_internal_state;
 
+/*
+ * @brief The sub device registry.
+ */
+typedef struct {
+  SubDeviceSelectFn select_fn;
+  SubDeviceReleaseFn release_fn;
+  uint16_t count;
+
+  /*
+   * Maps sub device index to slot + 1. 0 means there is no sub device at that
+   * index.
+   */
+  uint16_t slots[SUBDEVICE_TABLE_SIZE];
+} SubDeviceRegistry;
+
+static SubDeviceRegistry g_subdevice_registry;
+
 // Helper functions
 // ----------------------------------------------------------------------------
 
@@ -140,12 +169,76 @@ static uint8_t *BuildSensorValueResponse(uint8_t *ptr, uint8_t index,
   return ptr;
 }
 
+/*
+ * @brief Get the cache for the current responder.
+ *
+ * If the responder's definition has changed since the cache was built, the
+ * cached data is discarded.
+ */
+static inline RDMResponderCache *GetCache() {
+  RDMResponderCache *cache = &g_responder->cache;
+  if (cache->def != g_responder->def) {
+    cache->def = g_responder->def;
+    cache->valid = 0u;
+  }
+  return cache;
+}
+
+/*
+ * @brief Build an ACK response from cached parameter data.
+ */
+static int ReturnCachedParamData(const RDMHeader *header,
+                                 const uint8_t *data,
+                                 unsigned int size) {
+  memcpy(g_rdm_buffer + sizeof(RDMHeader), data, size);
+  return RDMResponder_AddHeaderAndChecksum(header, ACK,
+                                           sizeof(RDMHeader) + size);
+}
+
+/*
+ * @brief Find the PIDDescriptor for a PID.
+ * @param pid The PID to look for.
+ * @returns The PIDDescriptor or NULL if the PID isn't supported.
+ *
+ * This relies on the descriptor table being sorted by PID.
+ */
+static const PIDDescriptor *FindDescriptor(uint16_t pid) {
+  const ResponderDefinition *definition = g_responder->def;
+  unsigned int lower = 0u;
+  unsigned int upper = definition->descriptor_count;
+  while (lower < upper) {
+    unsigned int mid = lower + (upper - lower) / 2u;
+    uint16_t mid_pid = definition->descriptors[mid].pid;
+    if (mid_pid == pid) {
+      return &definition->descriptors[mid];
+    } else if (mid_pid < pid) {
+      lower = mid + 1u;
+    } else {
+      upper = mid;
+    }
+  }
+  return NULL;
+}
+
 static inline uint16_t GetControlField() {
   return (g_responder->sub_device_count ? MUTE_SUBDEVICE_FLAG : 0) |
          (g_responder->is_managed_proxy ? MUTE_MANAGED_PROXY_FLAG : 0) |
          (g_responder->is_proxied_device ? MUTE_PROXY_FLAG : 0);
 }
 
+/*
+ * @brief Dispatch a request to the sub device in the specified slot.
+ */
+static int DispatchToSubDevice(unsigned int slot, const RDMHeader *header,
+                               const uint8_t *param_data) {
+  g_subdevice_registry.select_fn(slot);
+  int response_size = RDMResponder_DispatchPID(header, param_data);
+  if (g_subdevice_registry.release_fn) {
+    g_subdevice_registry.release_fn(slot);
+  }
+  return response_size;
+}
+
 // Public Functions
 // ----------------------------------------------------------------------------
 void RDMResponder_Initialize(const RDMResponderSettings *settings) {
@@ -171,6 +264,7 @@ void RDMResponder_Initialize(const RDMResponderSettings *settings) {
   memcpy(g_responder->uid, settings->uid, UID_LENGTH);
   g_responder->def = NULL;
   RDMResponder_InitResponder();
+  RDMResponder_ResetSubDevices(NULL, NULL);
 }
 
 void RDMResponder_Tasks() {
@@ -199,6 +293,34 @@ void RDMResponder_RestoreResponder() {
   g_responder = &root_responder;
 }
 
+void RDMResponder_ResetSubDevices(SubDeviceSelectFn select_fn,
+                                  SubDeviceReleaseFn release_fn) {
+  g_subdevice_registry.select_fn = select_fn;
+  g_subdevice_registry.release_fn = release_fn;
+  g_subdevice_registry.count = 0u;
+  memset(g_subdevice_registry.slots, 0, sizeof(g_subdevice_registry.slots));
+}
+
+bool RDMResponder_AddSubDevice(uint16_t index) {
+  if (index == SUBDEVICE_ROOT || index > SUBDEVICE_MAX ||
+      g_subdevice_registry.slots[index]) {
+    return false;
+  }
+  g_subdevice_registry.slots[index] = ++g_subdevice_registry.count;
+  return true;
+}
+
+uint16_t RDMResponder_SubDeviceCount() {
+  return g_subdevice_registry.count;
+}
+
+int RDMResponder_SubDeviceSlot(uint16_t index) {
+  if (index > SUBDEVICE_MAX) {
+    return -1;
+  }
+  return (int) g_subdevice_registry.slots[index] - 1;
+}
+
 void RDMResponder_InitResponder() {
   // This resets the non-mutable state of the responder and then calls
   // RDMResponder_ResetToFactoryDefaults() to reset the mutable state.
@@ -229,6 +351,11 @@ void RDMResponder_ResetToFactoryDefaults() {
     }
   }
   g_responder->using_factory_defaults = true;
+  RDMResponder_InvalidateCache();
+}
+
+void RDMResponder_InvalidateCache() {
+  g_responder->cache.valid = 0u;
 }
 
 void RDMResponder_GetUID(uint8_t *uid) {
@@ -375,38 +502,55 @@ int RDMResponder_BuildParamDescription(
 
 int RDMResponder_DispatchPID(const RDMHeader *header,
                              const uint8_t *param_data) {
-  const ResponderDefinition *definition = g_responder->def;
-  uint16_t pid = ntohs(header->param_id);
-  unsigned int i = 0u;
-  // TODO(simon): convert to binary search if the list gets long.
-  // We'll need to add a check to ensure it's sorted though.
-  for (; i < definition->descriptor_count; i++) {
-    if (pid == definition->descriptors[i].pid) {
-      if (header->command_class == GET_COMMAND) {
-        if (RDMUtil_IsUnicast(header->dest_uid)) {\
-          if (definition->descriptors[i].get_handler) {
-            if (header->param_data_length ==
-                definition->descriptors[i].get_param_size) {
-              return definition->descriptors[i].get_handler(header, param_data);
-            } else {
-              return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
-            }
-          } else {
-            return RDMResponder_BuildNack(header, NR_UNSUPPORTED_COMMAND_CLASS);
-          }
-        } else {
-          return RDM_RESPONDER_NO_RESPONSE;
-        }
-      } else {
-        if (definition->descriptors[i].set_handler) {
-          return definition->descriptors[i].set_handler(header, param_data);
-        } else {
-          return RDMResponder_BuildNack(header, NR_UNSUPPORTED_COMMAND_CLASS);
-        }
-      }
+  const PIDDescriptor *descriptor = FindDescriptor(ntohs(header->param_id));
+  if (!descriptor) {
+    return RDMResponder_BuildNack(header, NR_UNKNOWN_PID);
+  }
+
+  if (header->command_class == GET_COMMAND) {
+    if (!RDMUtil_IsUnicast(header->dest_uid)) {
+      return RDM_RESPONDER_NO_RESPONSE;
+    }
+    if (!descriptor->get_handler) {
+      return RDMResponder_BuildNack(header, NR_UNSUPPORTED_COMMAND_CLASS);
+    }
+    if (header->param_data_length != descriptor->get_param_size) {
+      return RDMResponder_BuildNack(header, NR_FORMAT_ERROR);
+    }
+    return descriptor->get_handler(header, param_data);
+  } else {
+    if (!descriptor->set_handler) {
+      return RDMResponder_BuildNack(header, NR_UNSUPPORTED_COMMAND_CLASS);
+    }
+    return descriptor->set_handler(header, param_data);
+  }
+}
+
+int RDMResponder_DispatchSubDevice(const RDMHeader *header,
+                                   const uint8_t *param_data) {
+  const uint16_t sub_device = ntohs(header->sub_device);
+  int response_size = RDM_RESPONDER_NO_RESPONSE;
+
+  if (sub_device == SUBDEVICE_ALL) {
+    if (header->command_class == GET_COMMAND ||
+        g_subdevice_registry.count == 0u) {
+      return RDMResponder_BuildNack(header, NR_SUB_DEVICE_OUT_OF_RANGE);
     }
+
+    unsigned int slot = 0u;
+    for (; slot < g_subdevice_registry.count; slot++) {
+      response_size = DispatchToSubDevice(slot, header, param_data);
+    }
+  } else {
+    int slot = RDMResponder_SubDeviceSlot(sub_device);
+    if (slot < 0) {
+      return RDMResponder_BuildNack(header, NR_SUB_DEVICE_OUT_OF_RANGE);
+    }
+    response_size = DispatchToSubDevice(slot, header, param_data);
   }
-  return RDMResponder_BuildNack(header, NR_UNKNOWN_PID);
+
+  RDMResponder_RestoreResponder();
+  return response_size;
 }
 
 int RDMResponder_Ioctl(ModelIoctl command, uint8_t *data, unsigned int length) {
@@ -541,10 +685,16 @@ int RDMResponder_SetUnMute(const RDMHeader *header) {
 int RDMResponder_GetSupportedParameters(const RDMHeader *header,
                                         UNUSED const uint8_t *param_data) {
   const ResponderDefinition *definition = g_responder->def;
+  RDMResponderCache *cache = GetCache();
+  if (cache->valid & CACHE_SUPPORTED_PARAMETERS) {
+    return ReturnCachedParamData(header, cache->supported_parameters,
+                                 cache->supported_parameters_size);
+  }
 
   // TODO(simon): handle ack-overflow here
   unsigned int i = 0u;
-  uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
+  uint8_t *start = g_rdm_buffer + sizeof(RDMHeader);
+  uint8_t *ptr = start;
   for (; i < definition->descriptor_count; i++) {
     switch (definition->descriptors[i].pid) {
       case PID_DISC_UNIQUE_BRANCH:
@@ -565,6 +715,12 @@ int RDMResponder_GetSupportedParameters(const RDMHeader *header,
     }
   }
 
+  unsigned int size = ptr - start;
+  if (size <= sizeof(cache->supported_parameters)) {
+    memcpy(cache->supported_parameters, start, size);
+    cache->supported_parameters_size = size;
+    cache->valid |= CACHE_SUPPORTED_PARAMETERS;
+  }
   return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
 }
 
@@ -590,9 +746,15 @@ int RDMResponder_SetCommsStatus(const RDMHeader *header,
 
 int RDMResponder_GetDeviceInfo(const RDMHeader *header,
                                UNUSED const uint8_t *param_data) {
+  RDMResponderCache *cache = GetCache();
+  if (cache->valid & CACHE_DEVICE_INFO) {
+    return ReturnCachedParamData(header, cache->device_info,
+                                 DEVICE_INFO_PARAM_DATA_SIZE);
+  }
+
   const PersonalityDefinition *personality = CurrentPersonality();
 
-  uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
+  uint8_t *ptr = cache->device_info;
   ptr = PushUInt16(ptr, RDM_VERSION);
   ptr = PushUInt16(ptr, g_responder->def->model_id);
   ptr = PushUInt16(ptr, g_responder->def->product_category);
@@ -609,23 +771,31 @@ int RDMResponder_GetDeviceInfo(const RDMHeader *header,
   ptr = PushUInt16(ptr, g_responder->sub_device_count);
   *ptr++ = g_responder->def->sensor_count;
 
-  return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
+  cache->valid |= CACHE_DEVICE_INFO;
+  return ReturnCachedParamData(header, cache->device_info,
+                               DEVICE_INFO_PARAM_DATA_SIZE);
 }
 
 int RDMResponder_GetProductDetailIds(const RDMHeader *header,
                                      UNUSED const uint8_t *param_data) {
   const ResponderDefinition *definition = g_responder->def;
-  uint8_t *ptr = g_rdm_buffer + sizeof(RDMHeader);
-  if (definition->product_detail_ids) {
-    unsigned int i = 0;
-    unsigned int count = min(definition->product_detail_ids->size,
-                             MAX_PRODUCT_DETAILS);
-    for (; i < count; i++) {
-      ptr = PushUInt16(ptr, definition->product_detail_ids->ids[i]);
+  RDMResponderCache *cache = GetCache();
+  if (!(cache->valid & CACHE_PRODUCT_DETAIL_IDS)) {
+    uint8_t *ptr = cache->product_detail_ids;
+    if (definition->product_detail_ids) {
+      unsigned int i = 0;
+      unsigned int count = min(definition->product_detail_ids->size,
+                               MAX_PRODUCT_DETAILS);
+      for (; i < count; i++) {
+        ptr = PushUInt16(ptr, definition->product_detail_ids->ids[i]);
+      }
     }
+    cache->product_detail_ids_size = ptr - cache->product_detail_ids;
+    cache->valid |= CACHE_PRODUCT_DETAIL_IDS;
   }
 
-  return RDMResponder_AddHeaderAndChecksum(header, ACK, ptr - g_rdm_buffer);
+  return ReturnCachedParamData(header, cache->product_detail_ids,
+                               cache->product_detail_ids_size);
 }
 
 int RDMResponder_GetDeviceModelDescription(const RDMHeader *header,
@@ -704,6 +874,7 @@ int RDMResponder_SetDMXPersonality(const RDMHeader *header,
     g_responder->using_factory_defaults = false;
   }
   g_responder->current_personality = new_personality;
+  RDMResponder_InvalidateCache();
   return RDMResponder_BuildSetAck(header);
 }
 
@@ -751,6 +922,7 @@ int RDMResponder_SetDMXStartAddress(const RDMHeader *header,
     g_responder->using_factory_defaults = false;
   }
   g_responder->dmx_start_address = address;
+  RDMResponder_InvalidateCache();
   return RDMResponder_BuildSetAck(header);
 }
 
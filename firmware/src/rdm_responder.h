@@ -39,6 +39,10 @@
  *    pointers as part of the responder definition and then later, when a RDM
  *    request arrives, RDMResponder_DispatchPID() is called which invokes the
  *    correct function. You can think of this like a vtable in C++.
+ *  - The sub device registry, which maps sub device indices to the sub
+ *    device's RDMResponder. Models register their sub devices with
+ *    RDMResponder_AddSubDevice() and then route requests with
+ *    RDMResponder_DispatchSubDevice().
  *
  * When implementing a model, you can reference the PID functions in the
  * dispatch table, or point to your own functions that (optionally) wrap the
@@ -229,9 +233,12 @@ typedef struct {
  * This contains the PID dispatch table, and const data, like the
  * manufacturer name, device model etc, sensor definitions, etc.
  */
-typedef struct {
+typedef struct ResponderDefinition_s {
   /**
    * @brief The descriptor table.
+   *
+   * The table must be sorted by PID, with no duplicates, since
+   * RDMResponder_DispatchPID() uses a binary search.
    */
   const PIDDescriptor *descriptors;
 
@@ -279,6 +286,49 @@ typedef struct {
   uint8_t sensor_count;  //!< The number of sensors
 } ResponderDefinition;
 
+/**
+ * @brief The size of the DEVICE_INFO parameter data.
+ */
+enum { DEVICE_INFO_PARAM_DATA_SIZE = 19 };
+
+/**
+ * @brief The maximum number of PIDs held in the SUPPORTED_PARAMETERS cache.
+ *
+ * Responders with more PIDs than this build the response on each request.
+ */
+enum { MAX_CACHED_SUPPORTED_PARAMETERS = 32 };
+
+/**
+ * @brief Serialized parameter data for the static GET PIDs.
+ *
+ * The cache is filled the first time a PID is requested and served from then
+ * on. It's tied to the ResponderDefinition it was built from; changing the
+ * definition, or calling RDMResponder_InvalidateCache(), discards it.
+ */
+typedef struct {
+  /**
+   * @brief The ResponderDefinition the cached data was built from.
+   */
+  const ResponderDefinition *def;
+
+  uint8_t device_info[DEVICE_INFO_PARAM_DATA_SIZE];  //!< DEVICE_INFO data
+
+  /**
+   * @brief SUPPORTED_PARAMETERS data.
+   */
+  uint8_t supported_parameters[MAX_CACHED_SUPPORTED_PARAMETERS *
+                               sizeof(uint16_t)];
+
+  /**
+   * @brief PRODUCT_DETAIL_ID_LIST data.
+   */
+  uint8_t product_detail_ids[MAX_PRODUCT_DETAILS * sizeof(uint16_t)];
+
+  uint8_t supported_parameters_size;  //!< Size of the supported_parameters.
+  uint8_t product_detail_ids_size;  //!< Size of the product_detail_ids.
+  uint8_t valid;  //!< A bitmask of the valid entries.
+} RDMResponderCache;
+
 /**
  * @brief A core implementation of a responder.
  *
@@ -311,6 +361,11 @@ typedef struct {
   bool is_subdevice;  // true if this is a subdevice.
   bool is_managed_proxy;  // true if this is a managed proxy.
   bool is_proxied_device;  // true if this is a proxied device.
+
+  /**
+   * @brief Cached parameter data for the static GET PIDs.
+   */
+  RDMResponderCache cache;
 } RDMResponder;
 
 /**
@@ -358,6 +413,58 @@ void RDMResponder_SwitchResponder(RDMResponder *responder);
  */
 void RDMResponder_RestoreResponder();
 
+/**
+ * @brief Make a sub device the current responder.
+ * @param slot The slot of the sub device, see RDMResponder_AddSubDevice().
+ *
+ * The function should call RDMResponder_SwitchResponder() with the sub
+ * device's RDMResponder.
+ */
+typedef void (*SubDeviceSelectFn)(unsigned int slot);
+
+/**
+ * @brief Called once a request has been dispatched to a sub device.
+ * @param slot The slot of the sub device, see RDMResponder_AddSubDevice().
+ *
+ * This allows models that share a single RDMResponder between sub devices to
+ * store any state that was changed by the request.
+ */
+typedef void (*SubDeviceReleaseFn)(unsigned int slot);
+
+/**
+ * @brief Remove all sub devices from the registry.
+ * @param select_fn The function used to switch to a sub device. May be NULL
+ *   if the model doesn't have sub devices.
+ * @param release_fn The function to call after a sub device has handled a
+ *   request, may be NULL.
+ */
+void RDMResponder_ResetSubDevices(SubDeviceSelectFn select_fn,
+                                  SubDeviceReleaseFn release_fn);
+
+/**
+ * @brief Add a sub device to the registry.
+ * @param index The sub device index, from 1 to SUBDEVICE_MAX.
+ * @returns true if the sub device was added, false if the index was out of
+ *   range or already registered.
+ *
+ * Sub devices are assigned slots in the order they are added, starting from
+ * 0. The slot is passed to the SubDeviceSelectFn.
+ */
+bool RDMResponder_AddSubDevice(uint16_t index);
+
+/**
+ * @brief Get the number of registered sub devices.
+ * @returns The number of sub devices.
+ */
+uint16_t RDMResponder_SubDeviceCount();
+
+/**
+ * @brief Look up the slot for a sub device.
+ * @param index The sub device index.
+ * @returns The slot of the sub device, or -1 if it isn't registered.
+ */
+int RDMResponder_SubDeviceSlot(uint16_t index);
+
 /**
  * @brief Initialize the current responder with default values.
  */
@@ -368,6 +475,14 @@ void RDMResponder_InitResponder();
  */
 void RDMResponder_ResetToFactoryDefaults();
 
+/**
+ * @brief Discard the cached parameter data for the current responder.
+ *
+ * This must be called by models that modify the responder's start address,
+ * personality or sub device state directly, rather than via the PID handlers.
+ */
+void RDMResponder_InvalidateCache();
+
 /**
  * @brief Get the UID of the responder.
  * @param uid A pointer to copy the UID to; should be at least UID_LENGTH.
@@ -461,6 +576,24 @@ int RDMResponder_BuildParamDescription(const RDMHeader *incoming_header,
 int RDMResponder_DispatchPID(const RDMHeader *incoming_header,
                              const uint8_t *param_data);
 
+/**
+ * @brief Dispatch a request to the sub device(s) it's addressed to.
+ * @param incoming_header The header of the incoming frame.
+ * @param param_data The received parameter data.
+ * @returns The size of the RDM response frame.
+ *
+ * For each sub device addressed, this switches to the sub device's responder,
+ * calls RDMResponder_DispatchPID() and then the SubDeviceReleaseFn. SETs to
+ * SUBDEVICE_ALL are handled in a single pass over the registered sub devices,
+ * and the response from the last sub device is returned. GETs to
+ * SUBDEVICE_ALL, and requests to sub devices that aren't registered, are
+ * NACKed with NR_SUB_DEVICE_OUT_OF_RANGE.
+ *
+ * The root responder is restored before returning.
+ */
+int RDMResponder_DispatchSubDevice(const RDMHeader *incoming_header,
+                                   const uint8_t *param_data);
+
 /**
  * @brief A base Ioctl handler.
  * @param command The ioctl command to run.
@@ -29,6 +29,7 @@
 #include "rdm_util.h"
 #include "spi_rgb.h"
 #include "syslog.h"
+#include "timestamp.h"
 #include "transceiver.h"
 #include "utils.h"
 
@@ -53,11 +54,18 @@ typedef enum {
 
 static const uint16_t UNINITIALIZED_COUNTER = 0xffffu;
 
+enum { SLOTS_PER_PIXEL = 3u };
+
 /*
  * @brief The timing information for the current frame.
  */
 static TransceiverTiming g_timing;
 
+/*
+ * @brief The time the current frame started.
+ */
+static Timestamp g_frame_start = 0u;
+
 /*
  * @brief The current g_state
  */
@@ -68,6 +76,11 @@ static ResponderState g_state = STATE_START_CODE;
  */
 static unsigned int g_offset = 0u;
 
+/*
+ * @brief The number of DMX slots used by the SPI pixels in the current frame.
+ */
+static unsigned int g_pixel_slots = 0u;
+
 /*
  * @brief Call the RDM handler when we have a complete and valid frame.
  */
@@ -78,13 +91,15 @@ static inline void DispatchRDMRequest(const uint8_t *frame) {
       header->param_data_length ? frame + RDM_PARAM_DATA_OFFSET : NULL);
   SysLog_Print(
       SYSLOG_INFO,
-      "RDM: break %dus, mark %dus, TN %d CC 0x%x, PID 0x%x, PDL %d",
+      "RDM: break %dus, mark %dus, TN %d CC 0x%x, PID 0x%x, PDL %d, "
+      "%dus since break",
       g_timing.request.break_time / 10u,
       g_timing.request.mark_time / 10u,
       header->transaction_number,
       header->command_class,
       ntohs(header->param_id),
-      header->param_data_length);
+      header->param_data_length,
+      Timestamp_ToMicroSeconds(Timestamp_Now() - g_frame_start));
 }
 
 /*
@@ -147,6 +162,7 @@ void Responder_Receive(const TransceiverEvent *event) {
     if (event->timing) {
       g_timing = *event->timing;
     }
+    g_frame_start = event->timestamp;
   }
 
   if (event->result == T_RESULT_RX_FRAME_TIMEOUT) {
@@ -154,6 +170,10 @@ void Responder_Receive(const TransceiverEvent *event) {
     return;
   }
 
+  // Slot data is passed to the RDM handler once per event, rather than once per
+  // slot.
+  const unsigned int first_slot = g_offset ? g_offset : 1u;
+
   for (; g_offset < event->length; g_offset++) {
     uint8_t b = event->data[g_offset];
     switch (g_state) {
@@ -164,6 +184,7 @@ void Responder_Receive(const TransceiverEvent *event) {
           SysLog_Message(SYSLOG_DEBUG, "DMX frame");
           g_responder_counters.dmx_frames++;
           g_state = STATE_DMX_DATA;
+          g_pixel_slots = SPIRGB_PixelCount() * SLOTS_PER_PIXEL;
           SPIRGB_BeginUpdate();
         } else if (b == RDM_START_CODE) {
           g_responder_counters.rdm_frames++;
@@ -225,10 +246,13 @@ void Responder_Receive(const TransceiverEvent *event) {
         break;
       case STATE_DMX_DATA:
         // TODO(simon): configure this with DMX_START_ADDRESS and footprints.
-        if (g_offset - 1u < 6u) {
-          SPIRGB_SetPixel((g_offset - 1u) / 3u, (g_offset - 1u) % 3u, b);
-        } else if (g_offset - 1u == 6u) {
-          SPIRGB_CompleteUpdate();
+        if (g_offset - 1u < g_pixel_slots) {
+          SPIRGB_SetPixel((g_offset - 1u) / SLOTS_PER_PIXEL,
+                          (g_offset - 1u) % SLOTS_PER_PIXEL, b);
+          // Don't wait for the end of the frame once the last pixel is set.
+          if (g_offset == g_pixel_slots) {
+            SPIRGB_CompleteUpdate();
+          }
         }
 
         g_responder_counters.dmx_last_checksum += b;
@@ -244,4 +268,9 @@ void Responder_Receive(const TransceiverEvent *event) {
         break;
     }
   }
+
+  if (g_state == STATE_DMX_DATA && g_offset > first_slot) {
+    RDMHandler_HandleDMX(first_slot - 1u, &event->data[first_slot],
+                         g_offset - first_slot);
+  }
 }
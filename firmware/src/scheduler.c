@@ -0,0 +1,167 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * scheduler.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "scheduler.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_settings.h"
+#include "core_timer.h"
+
+typedef struct {
+  Scheduler_TaskFn fn;
+  Scheduler_TaskStats stats;
+  Scheduler_TaskType type;
+  bool enabled;
+  volatile bool woken;
+} Task;
+
+typedef struct {
+  Task tasks[SCHEDULER_MAX_TASKS];
+  unsigned int task_count;
+  uint32_t busy_cycles;  //!< The cycles spent in wakeable tasks.
+  uint32_t window_start;  //!< When the load sample window started.
+} Scheduler;
+
+static Scheduler g_scheduler;
+
+// Helper functions
+// ----------------------------------------------------------------------------
+static Task *FindTask(Scheduler_TaskFn fn) {
+  unsigned int i = 0u;
+  for (; i < g_scheduler.task_count; i++) {
+    if (g_scheduler.tasks[i].fn == fn) {
+      return &g_scheduler.tasks[i];
+    }
+  }
+  return NULL;
+}
+
+static void RunTask(Task *task) {
+#ifndef SCHEDULER_TASK_STATS
+  // Polled tasks don't count towards the load, so don't time them.
+  if (task->type == SCHEDULER_POLLED) {
+    task->fn();
+    return;
+  }
+#endif
+
+  const uint32_t start = CoreTimer_GetCount();
+  task->fn();
+  const uint32_t cycles = CoreTimer_GetCount() - start;
+
+#ifdef SCHEDULER_TASK_STATS
+  task->stats.calls++;
+  task->stats.cycles += cycles;
+  if (cycles > task->stats.max_cycles) {
+    task->stats.max_cycles = cycles;
+  }
+#endif
+  if (task->type == SCHEDULER_WAKEABLE) {
+    g_scheduler.busy_cycles += cycles;
+  }
+}
+
+// Public Functions
+// ----------------------------------------------------------------------------
+void Scheduler_Initialize() {
+  g_scheduler.task_count = 0u;
+  Scheduler_ResetStats();
+}
+
+bool Scheduler_AddTask(Scheduler_TaskFn fn, Scheduler_TaskType type) {
+  if (g_scheduler.task_count == SCHEDULER_MAX_TASKS) {
+    return false;
+  }
+  Task *task = &g_scheduler.tasks[g_scheduler.task_count];
+  task->fn = fn;
+  memset(&task->stats, 0, sizeof(task->stats));
+  task->type = type;
+  task->enabled = true;
+  task->woken = true;
+  g_scheduler.task_count++;
+  return true;
+}
+
+void Scheduler_Wake(Scheduler_TaskFn fn) {
+  Task *task = FindTask(fn);
+  if (task) {
+    task->woken = true;
+  }
+}
+
+void Scheduler_SetEnabled(Scheduler_TaskFn fn, bool enabled) {
+  Task *task = FindTask(fn);
+  if (task) {
+    task->enabled = enabled;
+  }
+}
+
+void Scheduler_Run() {
+  unsigned int i = 0u;
+  for (; i < g_scheduler.task_count; i++) {
+    Task *task = &g_scheduler.tasks[i];
+    if (!task->enabled) {
+      continue;
+    }
+    if (task->type == SCHEDULER_WAKEABLE) {
+      if (!task->woken) {
+        continue;
+      }
+      // Clear the flag first, so a wake from an ISR while the task is running
+      // isn't lost.
+      task->woken = false;
+    }
+    RunTask(task);
+  }
+}
+
+bool Scheduler_GetTaskStats(Scheduler_TaskFn fn, Scheduler_TaskStats *stats) {
+  const Task *task = FindTask(fn);
+  if (!task) {
+    return false;
+  }
+  *stats = task->stats;
+  return true;
+}
+
+uint16_t Scheduler_SampleLoad() {
+  const uint32_t now = CoreTimer_GetCount();
+  const uint32_t total_cycles = now - g_scheduler.window_start;
+  uint16_t load = 0u;
+  if (total_cycles) {
+    // A task that was running when the window started is counted in full.
+    load = g_scheduler.busy_cycles >= total_cycles ? 1000u :
+        ((uint64_t) g_scheduler.busy_cycles * 1000u) / total_cycles;
+  }
+  g_scheduler.busy_cycles = 0u;
+  g_scheduler.window_start = now;
+  return load;
+}
+
+void Scheduler_ResetStats() {
+  unsigned int i = 0u;
+  for (; i < g_scheduler.task_count; i++) {
+    memset(&g_scheduler.tasks[i].stats, 0,
+           sizeof(g_scheduler.tasks[i].stats));
+  }
+  g_scheduler.busy_cycles = 0u;
+  g_scheduler.window_start = CoreTimer_GetCount();
+}
@@ -0,0 +1,163 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * scheduler.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup scheduler Scheduler
+ * @brief A cooperative scheduler for the main loop.
+ *
+ * Each subsystem provides a Tasks function. Polled tasks run on every pass of
+ * the main loop. Wakeable tasks only run after Scheduler_Wake() has been
+ * called, so a subsystem with nothing to do costs nothing. Scheduler_Wake()
+ * may be called from an ISR.
+ *
+ * Tasks are identified by their Tasks function, so a module can wake itself
+ * without knowing how it was registered. Waking a task that isn't registered
+ * does nothing.
+ *
+ * The load is the fraction of time spent in wakeable tasks. They only run when
+ * there's work to do, whereas polled tasks run on every pass whether or not
+ * they have work, so polled tasks count as idle time.
+ *
+ * Per-task accounting is opt-in, define SCHEDULER_TASK_STATS in
+ * app_settings.h to record the number of calls & the core timer cycles spent
+ * in each task. Otherwise only the wakeable tasks are timed.
+ *
+ * @addtogroup scheduler
+ * @{
+ * @file scheduler.h
+ * @brief A cooperative scheduler for the main loop.
+ */
+
+#ifndef FIRMWARE_SRC_SCHEDULER_H_
+#define FIRMWARE_SRC_SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The maximum number of tasks.
+ */
+#define SCHEDULER_MAX_TASKS 12u
+
+/**
+ * @brief A Tasks function.
+ */
+typedef void (*Scheduler_TaskFn)();
+
+/**
+ * @brief When a task runs.
+ */
+typedef enum {
+  SCHEDULER_POLLED,  //!< Run on every pass.
+  SCHEDULER_WAKEABLE  //!< Run once after each call to Scheduler_Wake().
+} Scheduler_TaskType;
+
+/**
+ * @brief The accounting data for a task.
+ *
+ * This is only recorded if SCHEDULER_TASK_STATS is defined.
+ */
+typedef struct {
+  uint32_t calls;  //!< The number of times the task has run.
+  uint64_t cycles;  //!< The total core timer cycles spent in the task.
+  uint32_t max_cycles;  //!< The longest single run, in core timer cycles.
+} Scheduler_TaskStats;
+
+/**
+ * @brief Initialize the scheduler.
+ *
+ * This removes all tasks.
+ */
+void Scheduler_Initialize();
+
+/**
+ * @brief Add a task.
+ * @param fn The Tasks function.
+ * @param type When the task should run.
+ * @returns true if the task was added, false if there are already
+ *   SCHEDULER_MAX_TASKS tasks.
+ *
+ * Tasks run in the order they were added. Wakeable tasks run once after being
+ * added, so any work queued before the task was added isn't lost.
+ */
+bool Scheduler_AddTask(Scheduler_TaskFn fn, Scheduler_TaskType type);
+
+/**
+ * @brief Run a wakeable task on the next pass.
+ * @param fn The Tasks function to wake.
+ *
+ * This is safe to call from an ISR. If called while the task is running, the
+ * task will run again on the next pass.
+ */
+void Scheduler_Wake(Scheduler_TaskFn fn);
+
+/**
+ * @brief Enable or disable a task.
+ * @param fn The Tasks function.
+ * @param enabled true to enable the task, false to disable it.
+ *
+ * Tasks are enabled when they're added. A disabled wakeable task remembers
+ * if it was woken, and runs once it's enabled again.
+ */
+void Scheduler_SetEnabled(Scheduler_TaskFn fn, bool enabled);
+
+/**
+ * @brief Run one pass of the main loop.
+ *
+ * This should be called from APP_Tasks().
+ */
+void Scheduler_Run();
+
+/**
+ * @brief Get the accounting data for a task.
+ * @param fn The Tasks function.
+ * @param[out] stats The accounting data, all zero if SCHEDULER_TASK_STATS
+ *   isn't defined.
+ * @returns true if the task exists, false otherwise.
+ */
+bool Scheduler_GetTaskStats(Scheduler_TaskFn fn, Scheduler_TaskStats *stats);
+
+/**
+ * @brief Sample the CPU load, and start a new sample window.
+ * @returns The fraction of core timer cycles spent in wakeable tasks since the
+ *   last sample, in tenths of a percent.
+ *
+ * Time spent in ISRs, polled tasks and the scheduler itself is counted as idle
+ * time. The core timer wraps, so this must be called at least once a minute.
+ */
+uint16_t Scheduler_SampleLoad();
+
+/**
+ * @brief Reset the accounting data, and start a new load sample window.
+ */
+void Scheduler_ResetStats();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FIRMWARE_SRC_SCHEDULER_H_
+
+/**
+ * @}
+ */
@@ -20,13 +20,13 @@
 
 #include <stdlib.h>
 
-#include "coarse_timer.h"
 #include "constants.h"
 #include "random.h"
 #include "rdm_frame.h"
 #include "rdm_responder.h"
 #include "rdm_util.h"
 #include "temperature.h"
+#include "timer_wheel.h"
 #include "utils.h"
 
 #include "app_settings.h"
@@ -46,11 +46,15 @@ static const char SENSOR_NAME3[] = "Voltage";
 
 static const ResponderDefinition RESPONDER_DEFINITION;
 
+static const ResponderDefinition *const RESPONDER_DEFINITIONS[] = {
+  &RESPONDER_DEFINITION
+};
+
 /*
  * @brief The sensor model state.
  */
 typedef struct {
-  CoarseTimer_Value sensor_sample_time;
+  TimerWheel_Timer sample_timer;
   SensorData sensors[NUMBER_OF_SENSORS];
 } SensorModel;
 
@@ -69,8 +73,6 @@ static uint16_t GetSensorValue(unsigned int i) {
 }
 
 void SampleSensors() {
-  g_sensor_model.sensor_sample_time = CoarseTimer_GetTime();
-
   unsigned int i = 0;
   for (; i < NUMBER_OF_SENSORS; i++) {
     RDMUtil_UpdateSensor(
@@ -105,9 +107,13 @@ static void SensorModel_Activate() {
   RDMResponder_InitResponder();
   SampleSensors();
   g_responder->sensors = g_sensor_model.sensors;
+  TimerWheel_SchedulePeriodic(&g_sensor_model.sample_timer, SENSOR_SAMPLE_RATE,
+                              SampleSensors);
 }
 
-static void SensorModel_Deactivate() {}
+static void SensorModel_Deactivate() {
+  TimerWheel_Cancel(&g_sensor_model.sample_timer);
+}
 
 static int SensorModel_Ioctl(ModelIoctl command, uint8_t *data,
                              unsigned int length) {
@@ -147,12 +153,7 @@ static int SensorModel_HandleRequest(const RDMHeader *header,
   return RDMResponder_DispatchPID(header, param_data);
 }
 
-static void SensorModel_Tasks() {
-  if (CoarseTimer_HasElapsed(g_sensor_model.sensor_sample_time,
-                             SENSOR_SAMPLE_RATE)) {
-    SampleSensors();
-  }
-}
+static void SensorModel_Tasks() {}
 
 const ModelEntry SENSOR_MODEL_ENTRY = {
   .model_id = SENSOR_MODEL_ID,
@@ -160,7 +161,10 @@ const ModelEntry SENSOR_MODEL_ENTRY = {
   .deactivate_fn = SensorModel_Deactivate,
   .ioctl_fn = SensorModel_Ioctl,
   .request_fn = SensorModel_HandleRequest,
-  .tasks_fn = SensorModel_Tasks
+  .tasks_fn = SensorModel_Tasks,
+  .definitions = RESPONDER_DEFINITIONS,
+  .definition_count = sizeof(RESPONDER_DEFINITIONS) /
+                      sizeof(RESPONDER_DEFINITIONS[0])
 };
 
 static const PIDDescriptor PID_DESCRIPTORS[] = {
@@ -20,231 +20,568 @@
 #include "spi.h"
 
 #include <stdlib.h>
+#include <string.h>
 
+#include "scheduler.h"
 #include "system/int/sys_int.h"
+#include "peripheral/dma/plib_dma.h"
 #include "peripheral/spi/plib_spi.h"
 #include "sys/attribs.h"
+#include "sys/kmem.h"
 #include "system_config.h"
 
-#define MY_SPI SPI_ID_2
+/*
+ * @brief The number of SPI modules the driver supports.
+ *
+ * An interrupt handler is defined for each of these modules.
+ */
+enum { SPI_MODULE_COUNT = 2u };
+
+/*
+ * @brief The interrupt sources & DMA triggers for an SPI module.
+ */
+typedef struct {
+  SPI_MODULE_ID module_id;
+  INT_SOURCE tx_source;
+  INT_SOURCE rx_source;
+  INT_VECTOR vector;
+  DMA_TRIGGER_SOURCE tx_trigger;
+  DMA_TRIGGER_SOURCE rx_trigger;
+} SPIModule;
+
+static const SPIModule SPI_MODULES[SPI_MODULE_COUNT] = {
+  {
+    SPI_ID_1, INT_SOURCE_SPI_1_TRANSMIT, INT_SOURCE_SPI_1_RECEIVE,
+    INT_VECTOR_SPI1, DMA_TRIGGER_SPI_1_TRANSMIT, DMA_TRIGGER_SPI_1_RECEIVE
+  },
+  {
+    SPI_ID_2, INT_SOURCE_SPI_2_TRANSMIT, INT_SOURCE_SPI_2_RECEIVE,
+    INT_VECTOR_SPI2, DMA_TRIGGER_SPI_2_TRANSMIT, DMA_TRIGGER_SPI_2_RECEIVE
+  }
+};
 
 /*
- * @brief The number of slots for transfers.
+ * @brief The number of DMA channels the driver supports.
+ *
+ * An interrupt handler is defined for each of these channels, so the DMA
+ * channels in the SPIConfiguration must be less than this.
  */
-enum { TRANSFER_SLOTS = 2 };
+enum { SPI_DMA_CHANNEL_COUNT = 4u };
+
+/*
+ * @brief The largest DMA block.
+ *
+ * DCHxSSIZ & DCHxDSIZ are 8 bits on the PIC32MX5/6/7, a size of 0 is 256
+ * bytes. Longer transfers are split into blocks.
+ */
+enum { DMA_MAX_BLOCK_SIZE = 256u };
+
+/*
+ * @brief The interrupt source & vector for a DMA channel.
+ */
+typedef struct {
+  INT_SOURCE source;
+  INT_VECTOR vector;
+} DMAInterrupt;
+
+static const DMAInterrupt DMA_INTERRUPTS[SPI_DMA_CHANNEL_COUNT] = {
+  { INT_SOURCE_DMA_0, INT_VECTOR_DMA0 },
+  { INT_SOURCE_DMA_1, INT_VECTOR_DMA1 },
+  { INT_SOURCE_DMA_2, INT_VECTOR_DMA2 },
+  { INT_SOURCE_DMA_3, INT_VECTOR_DMA3 }
+};
 
 typedef enum {
-  FREE,  // transfer slot is empty
-  QUEUED,  // transfer is queued, but not being sent.
+  IDLE,  // no transfer is active.
   IN_TRANSFER,
   DRAINING,
   COMPLETE
 } TransferState;
 
+/*
+ * @brief A queued transfer.
+ */
 typedef struct {
+  const uint8_t *output;
+  uint8_t *input;
+  uint16_t output_length;
+  uint16_t input_length;
+  SPI_Callback callback;
+} Transfer;
+
+/*
+ * @brief The state of an SPI module.
+ *
+ * Transfers are queued in a ring buffer, the transfer at queue_head is the
+ * active transfer while state != IDLE.
+ */
+typedef struct {
+  const SPIModule *module;
+  bool initialized;
+  bool use_enhanced_buffering;
+  bool use_dma;
+  DMA_CHANNEL tx_dma_channel;
+  DMA_CHANNEL rx_dma_channel;
+
+  volatile TransferState state;
+  bool dma_transfer;  // true if the active transfer is using DMA.
+
+  // The progress of the active transfer, when using interrupts.
   const uint8_t *output;
   unsigned int output_remaining;
   unsigned int extra_zeros_to_send;
   uint8_t *input;
   unsigned int skip_input_bytes;
   unsigned int input_remaining;
-  TransferState state;
-  SPI_Callback callback;
-} Transfer;
 
-Transfer g_transfers[TRANSFER_SLOTS];
+  // The progress of the active transfer, when using DMA. These are the number
+  // of bytes handed to each channel so far.
+  unsigned int tx_dma_offset;
+  unsigned int rx_dma_offset;
 
-// The index of the active transfer, or -1 if no transfers are active.
-int g_active_transfer = -1;
+  Transfer queue[SPI_QUEUE_SIZE];
+  uint8_t queue_head;
+  uint8_t queue_count;
+} SPIBus;
+
+static SPIBus g_buses[SPI_MODULE_COUNT];
 
 // Helper methods
 // -----------------------------------------------------------------------------
-static void PickNextTransfer() {
-  unsigned int i = 0;
-  for (; i < TRANSFER_SLOTS; i++) {
-    if (g_transfers[i].state == QUEUED) {
-      g_active_transfer = i;
-      break;
+static SPIBus *GetBus(SPI_MODULE_ID module_id) {
+  unsigned int i = 0u;
+  for (; i < SPI_MODULE_COUNT; i++) {
+    if (SPI_MODULES[i].module_id == module_id) {
+      return &g_buses[i];
     }
   }
+  return NULL;
 }
 
-static void QueueBytes(Transfer *transfer) {
+static void QueueBytes(SPIBus *bus) {
+  const SPI_MODULE_ID module_id = bus->module->module_id;
   while (true) {
-    if (PLIB_SPI_TransmitBufferIsFull(MY_SPI)) {
+    if (PLIB_SPI_TransmitBufferIsFull(module_id)) {
       return;
     }
     uint8_t data = 0;
-    if (transfer->output_remaining) {
-      data = *transfer->output;
-      transfer->output++;
-      transfer->output_remaining--;
-    } else if (transfer->extra_zeros_to_send) {
-      transfer->extra_zeros_to_send--;
+    if (bus->output_remaining) {
+      data = *bus->output;
+      bus->output++;
+      bus->output_remaining--;
+    } else if (bus->extra_zeros_to_send) {
+      bus->extra_zeros_to_send--;
     } else {
       // Switch to drain mode
-      PLIB_SPI_FIFOInterruptModeSelect(
-          MY_SPI,
-          SPI_FIFO_INTERRUPT_WHEN_TRANSMISSION_IS_COMPLETE);
-      transfer->state = DRAINING;
+      if (bus->use_enhanced_buffering) {
+        PLIB_SPI_FIFOInterruptModeSelect(
+            module_id,
+            SPI_FIFO_INTERRUPT_WHEN_TRANSMISSION_IS_COMPLETE);
+      }
+      bus->state = DRAINING;
       return;
     }
-    PLIB_SPI_BufferWrite(MY_SPI, data);
+    PLIB_SPI_BufferWrite(module_id, data);
   }
 }
 
-static void ReadBytes(Transfer *transfer) {
-  while (!PLIB_SPI_ReceiverFIFOIsEmpty(MY_SPI)) {
-    uint8_t data = PLIB_SPI_BufferRead(MY_SPI);
-    if (transfer->skip_input_bytes) {
-      transfer->skip_input_bytes--;
+static void ReadBytes(SPIBus *bus) {
+  const SPI_MODULE_ID module_id = bus->module->module_id;
+  while (!PLIB_SPI_ReceiverFIFOIsEmpty(module_id)) {
+    uint8_t data = PLIB_SPI_BufferRead(module_id);
+    if (bus->skip_input_bytes) {
+      bus->skip_input_bytes--;
     } else {
-      if (transfer->input_remaining) {
-        *transfer->input = data;
-        transfer->input++;
-        transfer->input_remaining--;
+      if (bus->input_remaining) {
+        *bus->input = data;
+        bus->input++;
+        bus->input_remaining--;
       }
-      if (transfer->input_remaining == 0) {
-        SYS_INT_SourceDisable(INT_SOURCE_SPI_2_RECEIVE);
+      if (bus->input_remaining == 0) {
+        SYS_INT_SourceDisable(bus->module->rx_source);
       }
     }
   }
 }
 
-void __ISR(_SPI_2_VECTOR, ipl3AUTO) SPI_Event() {
-  if (g_active_transfer < 0) {
+static void HandleInterrupt(SPIBus *bus) {
+  // DMA transfers only use the SPI interrupt to wait for the last byte.
+  if (bus->state == IDLE || (bus->dma_transfer && bus->state != DRAINING)) {
     return;
   }
-  Transfer *transfer = &g_transfers[g_active_transfer];
 
-  if (SYS_INT_SourceStatusGet(INT_SOURCE_SPI_2_TRANSMIT)) {
-    if (transfer->state == DRAINING) {
-      transfer->state = COMPLETE;
-      SYS_INT_SourceDisable(INT_SOURCE_SPI_2_TRANSMIT);
+  const SPIModule *module = bus->module;
+  if (SYS_INT_SourceStatusGet(module->tx_source)) {
+    if (bus->state == DRAINING) {
+      bus->state = COMPLETE;
+      SYS_INT_SourceDisable(module->tx_source);
+      Scheduler_Wake(SPI_Tasks);
     } else {
-      QueueBytes(transfer);
+      QueueBytes(bus);
     }
-    SYS_INT_SourceStatusClear(INT_SOURCE_SPI_2_TRANSMIT);
+    SYS_INT_SourceStatusClear(module->tx_source);
   }
 
-  if (SYS_INT_SourceStatusGet(INT_SOURCE_SPI_2_RECEIVE)) {
-    ReadBytes(transfer);
-    SYS_INT_SourceStatusClear(INT_SOURCE_SPI_2_RECEIVE);
+  if (SYS_INT_SourceStatusGet(module->rx_source)) {
+    ReadBytes(bus);
+    SYS_INT_SourceStatusClear(module->rx_source);
   }
 }
 
-static void StartTransfer(Transfer *transfer) {
-  if (transfer->output_remaining == 0 && transfer->input_remaining == 0) {
-    transfer->state = FREE;
+void __ISR(_SPI_1_VECTOR, ipl3AUTO) SPI1_Event() {
+  HandleInterrupt(&g_buses[0]);
+}
+
+void __ISR(_SPI_2_VECTOR, ipl3AUTO) SPI2_Event() {
+  HandleInterrupt(&g_buses[1]);
+}
+
+/*
+ * @brief Setup a DMA channel to move one byte per SPI interrupt.
+ */
+static void StartDMAChannel(DMA_CHANNEL channel, const void *source,
+                            uint16_t source_size, void *destination,
+                            uint16_t destination_size) {
+  PLIB_DMA_ChannelXSourceStartAddressSet(DMA_ID_0, channel,
+                                         KVA_TO_PA(source));
+  PLIB_DMA_ChannelXSourceSizeSet(DMA_ID_0, channel, source_size);
+  PLIB_DMA_ChannelXDestinationStartAddressSet(DMA_ID_0, channel,
+                                              KVA_TO_PA(destination));
+  PLIB_DMA_ChannelXDestinationSizeSet(DMA_ID_0, channel, destination_size);
+  PLIB_DMA_ChannelXEnable(DMA_ID_0, channel);
+}
+
+/*
+ * @brief The size of the next DMA block.
+ * @param length The length of the transfer.
+ * @param offset The bytes already handed to the channel.
+ */
+static uint16_t NextBlockSize(unsigned int length, unsigned int offset) {
+  const unsigned int remaining = length - offset;
+  return remaining < DMA_MAX_BLOCK_SIZE ? remaining : DMA_MAX_BLOCK_SIZE;
+}
+
+/*
+ * @brief The number of bytes the TX DMA channel sends.
+ */
+static unsigned int TXDMALength(const Transfer *transfer) {
+  return transfer->input_length ? transfer->input_length :
+      transfer->output_length;
+}
+
+/*
+ * @brief Start the next block on the TX DMA channel.
+ *
+ * Read-only transfers send 0s from the input buffer, while reading into the
+ * same buffer. Each byte is sent before it's overwritten.
+ */
+static void StartTXBlock(SPIBus *bus, const Transfer *transfer) {
+  const uint8_t *source = transfer->input_length ? transfer->input :
+      transfer->output;
+  const uint16_t block_size = NextBlockSize(TXDMALength(transfer),
+                                            bus->tx_dma_offset);
+  StartDMAChannel(bus->tx_dma_channel, source + bus->tx_dma_offset,
+                  block_size,
+                  PLIB_SPI_BufferAddressGet(bus->module->module_id), 1u);
+  bus->tx_dma_offset += block_size;
+}
+
+/*
+ * @brief Start the next block on the RX DMA channel.
+ */
+static void StartRXBlock(SPIBus *bus, const Transfer *transfer) {
+  const uint16_t block_size = NextBlockSize(transfer->input_length,
+                                            bus->rx_dma_offset);
+  StartDMAChannel(bus->rx_dma_channel,
+                  PLIB_SPI_BufferAddressGet(bus->module->module_id), 1u,
+                  transfer->input + bus->rx_dma_offset, block_size);
+  bus->rx_dma_offset += block_size;
+}
+
+/*
+ * @brief Start a write-only or read-only transfer using DMA.
+ */
+static void StartDMATransfer(SPIBus *bus, const Transfer *transfer) {
+  const SPI_MODULE_ID module_id = bus->module->module_id;
+
+  if (bus->use_enhanced_buffering) {
+    // Raise the TX flag, and so trigger a DMA cell, while the FIFO has room.
+    PLIB_SPI_FIFOInterruptModeSelect(
+        module_id,
+        SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_NOT_FULL);
+  }
+
+  // The RX FIFO is drained once the transfer completes, nothing is stored.
+  bus->skip_input_bytes = 0u;
+  bus->input_remaining = 0u;
+  bus->tx_dma_offset = 0u;
+  bus->rx_dma_offset = 0u;
+
+  if (transfer->input_length) {
+    memset(transfer->input, 0, transfer->input_length);
+    StartRXBlock(bus, transfer);
+  }
+  StartTXBlock(bus, transfer);
+}
+
+/*
+ * @brief Wait for the last byte of a write-only DMA transfer to be sent.
+ */
+static void StartDraining(SPIBus *bus) {
+  const SPIModule *module = bus->module;
+  bus->state = DRAINING;
+  if (bus->use_enhanced_buffering) {
+    PLIB_SPI_FIFOInterruptModeSelect(
+        module->module_id,
+        SPI_FIFO_INTERRUPT_WHEN_TRANSMISSION_IS_COMPLETE);
+  }
+  SYS_INT_SourceStatusClear(module->tx_source);
+  SYS_INT_SourceEnable(module->tx_source);
+}
+
+/*
+ * @brief Called when a DMA channel completes a block.
+ *
+ * This either starts the next block, or moves the transfer on. A read-only
+ * transfer is complete once the RX channel has stored the last byte. A
+ * write-only transfer still has to wait for the bytes in the FIFO to be sent.
+ */
+static void HandleDMAInterrupt(DMA_CHANNEL channel) {
+  unsigned int i = 0u;
+  for (; i < SPI_MODULE_COUNT; i++) {
+    SPIBus *bus = &g_buses[i];
+    if (!(bus->dma_transfer && bus->state == IN_TRANSFER)) {
+      continue;
+    }
+
+    const Transfer *transfer = &bus->queue[bus->queue_head];
+    if (channel == bus->tx_dma_channel) {
+      if (bus->tx_dma_offset != TXDMALength(transfer)) {
+        StartTXBlock(bus, transfer);
+      } else if (transfer->input_length == 0u) {
+        StartDraining(bus);
+      }
+    } else if (channel == bus->rx_dma_channel) {
+      if (bus->rx_dma_offset != transfer->input_length) {
+        StartRXBlock(bus, transfer);
+      } else {
+        bus->state = COMPLETE;
+        Scheduler_Wake(SPI_Tasks);
+      }
+    }
+  }
+
+  PLIB_DMA_ChannelXINTSourceFlagClear(DMA_ID_0, channel,
+                                      DMA_INT_BLOCK_TRANSFER_COMPLETE);
+  SYS_INT_SourceStatusClear(DMA_INTERRUPTS[channel].source);
+}
+
+void __ISR(_DMA_0_VECTOR, ipl3AUTO) SPI_DMA0Event() {
+  HandleDMAInterrupt(DMA_CHANNEL_0);
+}
+
+void __ISR(_DMA_1_VECTOR, ipl3AUTO) SPI_DMA1Event() {
+  HandleDMAInterrupt(DMA_CHANNEL_1);
+}
+
+void __ISR(_DMA_2_VECTOR, ipl3AUTO) SPI_DMA2Event() {
+  HandleDMAInterrupt(DMA_CHANNEL_2);
+}
+
+void __ISR(_DMA_3_VECTOR, ipl3AUTO) SPI_DMA3Event() {
+  HandleDMAInterrupt(DMA_CHANNEL_3);
+}
+
+static void CompleteTransfer(SPIBus *bus) {
+  const Transfer *transfer = &bus->queue[bus->queue_head];
+  bus->state = IDLE;
+  bus->queue_head = (bus->queue_head + 1u) % SPI_QUEUE_SIZE;
+  bus->queue_count--;
+  if (transfer->callback) {
     transfer->callback(SPI_COMPLETE_TRANSFER);
+  }
+}
+
+static void StartTransfer(SPIBus *bus) {
+  const SPIModule *module = bus->module;
+  const Transfer *transfer = &bus->queue[bus->queue_head];
+
+  if (transfer->output_length == 0u && transfer->input_length == 0u) {
+    CompleteTransfer(bus);
+    return;
+  }
+
+  PLIB_SPI_BufferClear(module->module_id);
+  if (transfer->callback) {
+    transfer->callback(SPI_BEGIN_TRANSFER);
+  }
+  bus->state = IN_TRANSFER;
+
+  // Transfers that both write & read use interrupts, since the bytes sent
+  // while writing need to be discarded from the receive buffer.
+  bus->dma_transfer = bus->use_dma &&
+                      !(transfer->output_length && transfer->input_length);
+  if (bus->dma_transfer) {
+    StartDMATransfer(bus, transfer);
     return;
   }
 
-  PLIB_SPI_BufferClear(MY_SPI);
-  transfer->callback(SPI_BEGIN_TRANSFER);
+  bus->output = transfer->output;
+  bus->output_remaining = transfer->output_length;
+  bus->extra_zeros_to_send = transfer->input_length;
+  bus->input = transfer->input;
+  bus->input_remaining = transfer->input_length;
+  bus->skip_input_bytes = transfer->output_length;
+
+  if (bus->use_enhanced_buffering) {
+    PLIB_SPI_FIFOInterruptModeSelect(
+        module->module_id,
+        SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_1HALF_EMPTY_OR_MORE);
+  }
+  QueueBytes(bus);
+
+  SYS_INT_SourceStatusClear(module->tx_source);
+  SYS_INT_SourceEnable(module->tx_source);
+  if (bus->input_remaining) {
+    SYS_INT_SourceStatusClear(module->rx_source);
+    SYS_INT_SourceEnable(module->rx_source);
+  }
+}
+
+static bool HasDMAInterrupt(DMA_CHANNEL channel) {
+  const unsigned int index = channel;
+  return index < SPI_DMA_CHANNEL_COUNT;
+}
+
+/*
+ * @brief Setup a DMA channel to move one byte per SPI interrupt, and interrupt
+ * at the end of each block.
+ */
+static void InitializeDMAChannel(DMA_CHANNEL channel,
+                                 DMA_TRIGGER_SOURCE trigger) {
+  const DMAInterrupt *interrupt = &DMA_INTERRUPTS[channel];
+  PLIB_DMA_ChannelXStartIRQSet(DMA_ID_0, channel, trigger);
+  PLIB_DMA_ChannelXTriggerEnable(DMA_ID_0, channel,
+                                 DMA_CHANNEL_TRIGGER_TRANSFER_START);
+  PLIB_DMA_ChannelXCellSizeSet(DMA_ID_0, channel, 1u);
+  PLIB_DMA_ChannelXINTSourceEnable(DMA_ID_0, channel,
+                                   DMA_INT_BLOCK_TRANSFER_COMPLETE);
 
-  transfer->state = IN_TRANSFER;
-  PLIB_SPI_FIFOInterruptModeSelect(
-      MY_SPI,
-      SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_1HALF_EMPTY_OR_MORE);
+  SYS_INT_VectorPrioritySet(interrupt->vector, INT_PRIORITY_LEVEL3);
+  SYS_INT_VectorSubprioritySet(interrupt->vector, INT_SUBPRIORITY_LEVEL0);
+  SYS_INT_SourceStatusClear(interrupt->source);
+  SYS_INT_SourceEnable(interrupt->source);
+}
 
-  PLIB_SPI_Enable(MY_SPI);
-  QueueBytes(transfer);
+static void BusTasks(SPIBus *bus) {
+  switch (bus->state) {
+    case IDLE:
+      break;
+    case IN_TRANSFER:
+    case DRAINING:
+      break;
+    case COMPLETE:
+      // Drain the RX buffer
+      ReadBytes(bus);
+      CompleteTransfer(bus);
+      break;
+  }
 
-  SYS_INT_SourceStatusClear(INT_SOURCE_SPI_2_TRANSMIT);
-  SYS_INT_SourceEnable(INT_SOURCE_SPI_2_TRANSMIT);
-  if (transfer->input_remaining) {
-    SYS_INT_SourceStatusClear(INT_SOURCE_SPI_2_RECEIVE);
-    SYS_INT_SourceEnable(INT_SOURCE_SPI_2_RECEIVE);
+  // Start the next transfer straight away so the bus doesn't sit idle.
+  if (bus->state == IDLE && bus->queue_count) {
+    StartTransfer(bus);
   }
 }
 
 // Public functions
 // ----------------------------------------------------------------------------
-bool SPI_QueueTransfer(const uint8_t *output,
+bool SPI_QueueTransfer(SPI_MODULE_ID module_id,
+                       const uint8_t *output,
                        unsigned int output_length,
                        uint8_t *input,
                        unsigned int input_length,
                        SPI_Callback callback) {
-  Transfer *transfer = NULL;
-  unsigned int i = 0;
-  for (; i < TRANSFER_SLOTS; i++) {
-    if (g_transfers[i].state == FREE) {
-      transfer = &g_transfers[i];
-      break;
-    }
-  }
-  if (!transfer) {
+  SPIBus *bus = GetBus(module_id);
+  if (!(bus && bus->initialized) || bus->queue_count == SPI_QUEUE_SIZE) {
     return false;
   }
 
-  transfer->state = QUEUED;
+  if (output == NULL) {
+    output_length = 0u;
+  }
+  if (input == NULL) {
+    input_length = 0u;
+  }
+  if (output_length > SPI_MAX_TRANSFER_LENGTH ||
+      input_length > SPI_MAX_TRANSFER_LENGTH) {
+    return false;
+  }
+  Transfer *transfer = &bus->queue[
+      (bus->queue_head + bus->queue_count) % SPI_QUEUE_SIZE];
   transfer->output = output;
-  transfer->output_remaining = output_length;
-  transfer->extra_zeros_to_send = input_length;
+  transfer->output_length = output_length;
   transfer->input = input;
-  transfer->input_remaining = input_length;
-  transfer->skip_input_bytes = output_length;
+  transfer->input_length = input_length;
   transfer->callback = callback;
+  bus->queue_count++;
+  Scheduler_Wake(SPI_Tasks);
   return true;
 }
 
-void SPI_Initialize() {
-  PLIB_SPI_BaudRateSet(MY_SPI, SYS_CLK_FREQ, 1000000u);
-  PLIB_SPI_CommunicationWidthSelect(MY_SPI, SPI_COMMUNICATION_WIDTH_8BITS);
-  PLIB_SPI_ClockPolaritySelect(MY_SPI, SPI_CLOCK_POLARITY_IDLE_HIGH);
-  PLIB_SPI_FIFOEnable(MY_SPI);  // use enhanced buffering
-  PLIB_SPI_SlaveSelectDisable(MY_SPI);
-  PLIB_SPI_PinDisable(MY_SPI, SPI_PIN_SLAVE_SELECT);
-  PLIB_SPI_MasterEnable(MY_SPI);
+void SPI_Initialize(const SPIConfiguration *config) {
+  SPIBus *bus = GetBus(config->module_id);
+  if (!bus) {
+    return;
+  }
 
-  PLIB_SPI_FIFOInterruptModeSelect(
-      MY_SPI,
-      SPI_FIFO_INTERRUPT_WHEN_RECEIVE_BUFFER_IS_1HALF_FULL_OR_MORE);
+  unsigned int index = bus - g_buses;
+  bus->module = &SPI_MODULES[index];
+  bus->initialized = true;
+  bus->use_enhanced_buffering = config->use_enhanced_buffering;
+  // Fall back to interrupts if we don't have handlers for the DMA channels.
+  bus->use_dma = config->use_dma &&
+                 HasDMAInterrupt(config->tx_dma_channel) &&
+                 HasDMAInterrupt(config->rx_dma_channel);
+  bus->tx_dma_channel = config->tx_dma_channel;
+  bus->rx_dma_channel = config->rx_dma_channel;
+  bus->state = IDLE;
+  bus->dma_transfer = false;
+  bus->queue_head = 0u;
+  bus->queue_count = 0u;
 
-  SYS_INT_VectorPrioritySet(INT_VECTOR_SPI2, INT_PRIORITY_LEVEL3);
-  SYS_INT_VectorSubprioritySet(INT_VECTOR_SPI2, INT_SUBPRIORITY_LEVEL0);
+  const SPI_MODULE_ID module_id = config->module_id;
+  PLIB_SPI_BaudRateSet(module_id, SYS_CLK_FREQ, config->baud_rate);
+  PLIB_SPI_CommunicationWidthSelect(module_id, SPI_COMMUNICATION_WIDTH_8BITS);
+  PLIB_SPI_ClockPolaritySelect(module_id, SPI_CLOCK_POLARITY_IDLE_HIGH);
+  if (config->use_enhanced_buffering) {
+    PLIB_SPI_FIFOEnable(module_id);
+    // With DMA, raise the RX flag, and so trigger a DMA cell, for each byte.
+    PLIB_SPI_FIFOInterruptModeSelect(
+        module_id,
+        bus->use_dma ?
+        SPI_FIFO_INTERRUPT_WHEN_RECEIVE_BUFFER_IS_NOT_EMPTY :
+        SPI_FIFO_INTERRUPT_WHEN_RECEIVE_BUFFER_IS_1HALF_FULL_OR_MORE);
+  }
+  PLIB_SPI_SlaveSelectDisable(module_id);
+  PLIB_SPI_PinDisable(module_id, SPI_PIN_SLAVE_SELECT);
+  PLIB_SPI_MasterEnable(module_id);
+  PLIB_SPI_Enable(module_id);
 
-  unsigned int i = 0;
-  for (; i < TRANSFER_SLOTS; i++) {
-    g_transfers[i].state = FREE;
+  SYS_INT_VectorPrioritySet(bus->module->vector, INT_PRIORITY_LEVEL3);
+  SYS_INT_VectorSubprioritySet(bus->module->vector, INT_SUBPRIORITY_LEVEL0);
+
+  if (bus->use_dma) {
+    PLIB_DMA_Enable(DMA_ID_0);
+    InitializeDMAChannel(bus->tx_dma_channel, bus->module->tx_trigger);
+    InitializeDMAChannel(bus->rx_dma_channel, bus->module->rx_trigger);
   }
-  g_active_transfer = -1;
 }
 
 void SPI_Tasks() {
-  if (g_active_transfer < 0) {
-    unsigned int i = 0;
-    for (; i < TRANSFER_SLOTS; i++) {
-      if (g_transfers[i].state == QUEUED) {
-        g_active_transfer = i;
-        break;
-      }
+  unsigned int i = 0u;
+  for (; i < SPI_MODULE_COUNT; i++) {
+    if (g_buses[i].initialized) {
+      BusTasks(&g_buses[i]);
     }
   }
-
-  if (g_active_transfer < 0) {
-    return;
-  }
-  Transfer *transfer = &g_transfers[g_active_transfer];
-
-  switch (transfer->state) {
-    case FREE:
-      return;
-    case QUEUED:
-      StartTransfer(transfer);
-      break;
-    case IN_TRANSFER:
-    case DRAINING:
-      break;
-    case COMPLETE:
-      // Drain the RX buffer
-      ReadBytes(transfer);
-      PLIB_SPI_Disable(MY_SPI);
-      transfer->state = FREE;
-      transfer->callback(SPI_COMPLETE_TRANSFER);
-      // Pick now so we don't starve the higher indices.
-      PickNextTransfer();
-      break;
-  }
 }
@@ -21,15 +21,22 @@
  * @defgroup spi SPI
  * @brief SPI Driver
  *
- * This driver allows multiple clients to share the SPI bus. This assumes that
- * all clients use the same SPI configuration. If that isn't the case we'll
- * need to introduce client handles or something.
+ * This driver allows multiple clients to share an SPI bus. Each SPI module
+ * is initialized once with SPI_Initialize(), and all clients of that module
+ * share its configuration.
  *
- * Clients can queue an SPI transfer with the SPI_QueueTransfer() method. The
+ * Clients queue SPI transfers with SPI_QueueTransfer(). Each module has its own
+ * FIFO of transfers, which are performed in the order they were queued. The
  * callback argument can be used to specify a callback to be run before and
  * after the transfer is performed. This callback can be used to set the
  * relevant chip-enable line.
  *
+ * If DMA is enabled for a module, write-only and read-only transfers are
+ * performed using DMA. Transfers that write then read use the SPI interrupt.
+ * DMA transfers are split into blocks of at most 256 bytes, the channel is
+ * re-armed from its block complete interrupt. The driver defines the
+ * interrupt handlers for DMA channels 0 - 3.
+ *
  * @addtogroup spi
  * @{
  * @file spi.h
@@ -42,10 +49,23 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "peripheral/dma/plib_dma.h"
+#include "peripheral/spi/plib_spi.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief The number of transfers that can be queued for each module.
+ */
+#define SPI_QUEUE_SIZE 4u
+
+/**
+ * @brief The maximum output or input length of a transfer.
+ */
+#define SPI_MAX_TRANSFER_LENGTH UINT16_MAX
+
 /**
  * @brief SPI Event types.
  */
@@ -60,31 +80,65 @@ typedef enum {
  */
 typedef void (*SPI_Callback)(SPIEventType event);
 
+/**
+ * @brief The configuration for an SPI module.
+ */
+typedef struct {
+  SPI_MODULE_ID module_id;  //!< The SPI module, SPI_ID_1 or SPI_ID_2.
+  uint32_t baud_rate;  //!< The Baud rate
+
+  /**
+   * @brief Use enhanced buffer mode, not all chips support this.
+   *
+   * Enhanced mode allows us to queue up multiple bytes of SPI data at once. In
+   * normal mode there may be delays between bytes.
+   */
+  bool use_enhanced_buffering;
+
+  /**
+   * @brief Use DMA for write-only and read-only transfers.
+   *
+   * The DMA channels must be DMA_CHANNEL_0 - DMA_CHANNEL_3, otherwise the
+   * SPI interrupt is used.
+   */
+  bool use_dma;
+  DMA_CHANNEL tx_dma_channel;  //!< The DMA channel used to transmit.
+  DMA_CHANNEL rx_dma_channel;  //!< The DMA channel used to receive.
+} SPIConfiguration;
+
 /**
  * @brief Queue an SPI transfer.
+ * @param module_id The SPI module to use.
  * @param output The output buffer to send, may be NULL.
  * @param output_length The size of the output buffer.
  * @param input The location to store received data, may be NULL.
  * @param input_length The length of the input data buffer.
- * @param callback The callback run prior and post this transfer.
- * @returns True if the transfer was scheduled, false if the queue was full.
+ * @param callback The callback run prior and post this transfer, may be NULL.
+ * @returns True if the transfer was scheduled, false if the queue was full,
+ *   the module wasn't initialized or either length is more than
+ *   SPI_MAX_TRANSFER_LENGTH.
  *
  * This queues a write / read SPI operation. First the data in output will be
  * sent, then input_length worth of data will be read while 0s are sent. Both
  * stages are optional.
  *
  * The total number of bytes sent will be the sum of (output_length,
- * input_length).
+ * input_length). The buffers must remain valid until the transfer completes.
  */
-bool SPI_QueueTransfer(const uint8_t *output,
+bool SPI_QueueTransfer(SPI_MODULE_ID module_id,
+                       const uint8_t *output,
                        unsigned int output_length,
                        uint8_t *input,
                        unsigned int input_length,
                        SPI_Callback callback);
+
 /**
- * @brief Initialize the SPI driver.
+ * @brief Initialize an SPI module.
+ * @param config The configuration for the module.
+ *
+ * This can be called once for each module.
  */
-void SPI_Initialize();
+void SPI_Initialize(const SPIConfiguration *config);
 
 /**
  * @brief The tasks function, this should be called from the main event loop.
@@ -21,47 +21,533 @@
 
 #include <string.h>
 
-#include "peripheral/spi/plib_spi.h"
+#include "scheduler.h"
+#include "spi.h"
 #include "syslog.h"
 
-// TODO(simon): move these into the config (and set with RDM?)
 static const uint8_t LPD8806_PIXEL_BYTE = 0x80u;
+static const uint8_t LPD8806_MAX_LEVEL = 0x7fu;
+static const uint8_t P9813_FLAG_BYTE = 0xc0u;
+static const uint8_t APA102_PIXEL_BYTE = 0xe0u;
 
-enum { LATCH_BYTES = 1u };
-enum { PIXEL_COUNT = 2u };
 enum { SLOTS_PER_PIXEL = 3u };
+enum { DEFAULT_PIXEL_COUNT = 2u };
+enum { LINEAR_GAMMA = 10u };
+enum { DITHER_STEPS = 8u };
 
+/*
+ * Added to the scaled level before it's truncated to the output depth. With
+ * dithering disabled the level is rounded to the nearest step.
+ */
+static const uint16_t NO_DITHER = 0x8000u;
+
+/*
+ * The dither offsets, in bit-reversed order so consecutive frames are spread
+ * across the step.
+ */
+static const uint16_t DITHER_SEQUENCE[DITHER_STEPS] = {
+  0x1000u, 0x9000u, 0x5000u, 0xd000u, 0x3000u, 0xb000u, 0x7000u, 0xf000u
+};
+
+/*
+ * The largest frame is an APA102 strip: a 4 byte start frame, 4 bytes per
+ * pixel and an end frame of one byte per 16 pixels.
+ */
+enum { MAX_START_BYTES = 4u };
+enum { MAX_BYTES_PER_PIXEL = 4u };
+enum { MAX_END_BYTES = (SPIRGB_MAX_PIXELS + 15u) / 16u };
+enum {
+  MAX_FRAME_SIZE = MAX_START_BYTES + MAX_BYTES_PER_PIXEL * SPIRGB_MAX_PIXELS +
+                   MAX_END_BYTES
+};
+
+/*
+ * Gamma curves, generated with round(65535 * (i / 255) ^ gamma).
+ */
+static const uint16_t GAMMA_18[UINT8_MAX + 1u] = {
+  0, 3, 11, 22, 37, 55, 77, 101,
+  129, 159, 193, 229, 267, 309, 353, 400,
+  449, 501, 555, 612, 671, 732, 796, 863,
+  931, 1002, 1076, 1151, 1229, 1309, 1392, 1476,
+  1563, 1652, 1743, 1837, 1932, 2030, 2130, 2232,
+  2336, 2442, 2550, 2660, 2773, 2887, 3004, 3122,
+  3243, 3366, 3490, 3617, 3745, 3876, 4009, 4143,
+  4280, 4419, 4559, 4701, 4846, 4992, 5141, 5291,
+  5443, 5597, 5753, 5911, 6070, 6232, 6396, 6561,
+  6728, 6897, 7068, 7241, 7416, 7592, 7771, 7951,
+  8133, 8317, 8503, 8690, 8880, 9071, 9264, 9459,
+  9655, 9854, 10054, 10256, 10460, 10665, 10873, 11082,
+  11292, 11505, 11719, 11936, 12153, 12373, 12595, 12818,
+  13043, 13269, 13497, 13728, 13959, 14193, 14428, 14665,
+  14904, 15144, 15386, 15630, 15875, 16123, 16372, 16622,
+  16874, 17128, 17384, 17641, 17900, 18161, 18423, 18687,
+  18953, 19220, 19489, 19760, 20032, 20306, 20582, 20859,
+  21138, 21419, 21701, 21985, 22271, 22558, 22847, 23137,
+  23429, 23723, 24018, 24315, 24613, 24914, 25215, 25519,
+  25824, 26130, 26439, 26748, 27060, 27373, 27687, 28004,
+  28322, 28641, 28962, 29285, 29609, 29935, 30262, 30591,
+  30921, 31253, 31587, 31922, 32259, 32597, 32937, 33279,
+  33622, 33967, 34313, 34661, 35010, 35361, 35713, 36067,
+  36423, 36780, 37138, 37499, 37860, 38224, 38588, 38955,
+  39323, 39692, 40063, 40436, 40810, 41185, 41562, 41941,
+  42321, 42703, 43086, 43470, 43857, 44244, 44634, 45024,
+  45417, 45810, 46206, 46603, 47001, 47401, 47802, 48205,
+  48609, 49015, 49422, 49831, 50241, 50653, 51067, 51481,
+  51898, 52315, 52735, 53155, 53578, 54001, 54427, 54853,
+  55281, 55711, 56142, 56575, 57009, 57444, 57881, 58320,
+  58760, 59201, 59644, 60089, 60534, 60982, 61431, 61881,
+  62332, 62786, 63240, 63696, 64154, 64613, 65073, 65535
+};
+
+static const uint16_t GAMMA_22[UINT8_MAX + 1u] = {
+  0, 0, 2, 4, 7, 11, 17, 24,
+  32, 42, 53, 65, 79, 94, 111, 129,
+  148, 169, 192, 216, 242, 270, 299, 330,
+  362, 396, 432, 469, 508, 549, 591, 635,
+  681, 729, 779, 830, 883, 938, 995, 1053,
+  1113, 1175, 1239, 1305, 1373, 1443, 1514, 1587,
+  1663, 1740, 1819, 1900, 1983, 2068, 2155, 2243,
+  2334, 2427, 2521, 2618, 2717, 2817, 2920, 3024,
+  3131, 3240, 3350, 3463, 3578, 3694, 3813, 3934,
+  4057, 4182, 4309, 4438, 4570, 4703, 4838, 4976,
+  5115, 5257, 5401, 5547, 5695, 5845, 5998, 6152,
+  6309, 6468, 6629, 6792, 6957, 7124, 7294, 7466,
+  7640, 7816, 7994, 8175, 8358, 8543, 8730, 8919,
+  9111, 9305, 9501, 9699, 9900, 10102, 10307, 10515,
+  10724, 10936, 11150, 11366, 11585, 11806, 12029, 12254,
+  12482, 12712, 12944, 13179, 13416, 13655, 13896, 14140,
+  14386, 14635, 14885, 15138, 15394, 15652, 15912, 16174,
+  16439, 16706, 16975, 17247, 17521, 17798, 18077, 18358,
+  18642, 18928, 19216, 19507, 19800, 20095, 20393, 20694,
+  20996, 21301, 21609, 21919, 22231, 22546, 22863, 23182,
+  23504, 23829, 24156, 24485, 24817, 25151, 25487, 25826,
+  26168, 26512, 26858, 27207, 27558, 27912, 28268, 28627,
+  28988, 29351, 29717, 30086, 30457, 30830, 31206, 31585,
+  31966, 32349, 32735, 33124, 33514, 33908, 34304, 34702,
+  35103, 35507, 35913, 36321, 36732, 37146, 37562, 37981,
+  38402, 38825, 39252, 39680, 40112, 40546, 40982, 41421,
+  41862, 42306, 42753, 43202, 43654, 44108, 44565, 45025,
+  45487, 45951, 46418, 46888, 47360, 47835, 48313, 48793,
+  49275, 49761, 50249, 50739, 51232, 51728, 52226, 52727,
+  53230, 53736, 54245, 54756, 55270, 55787, 56306, 56828,
+  57352, 57879, 58409, 58941, 59476, 60014, 60554, 61097,
+  61642, 62190, 62741, 63295, 63851, 64410, 64971, 65535
+};
+
+static const uint16_t GAMMA_25[UINT8_MAX + 1u] = {
+  0, 0, 0, 1, 2, 4, 6, 8,
+  11, 15, 20, 25, 31, 38, 46, 55,
+  65, 75, 87, 99, 113, 128, 143, 160,
+  178, 197, 218, 239, 262, 286, 311, 338,
+  366, 395, 425, 457, 491, 526, 562, 599,
+  639, 679, 722, 765, 811, 857, 906, 956,
+  1007, 1061, 1116, 1172, 1231, 1291, 1352, 1416,
+  1481, 1548, 1617, 1688, 1760, 1834, 1910, 1988,
+  2068, 2150, 2233, 2319, 2407, 2496, 2587, 2681,
+  2776, 2874, 2973, 3075, 3178, 3284, 3391, 3501,
+  3613, 3727, 3843, 3961, 4082, 4204, 4329, 4456,
+  4585, 4716, 4850, 4986, 5124, 5264, 5407, 5552,
+  5699, 5849, 6001, 6155, 6311, 6470, 6632, 6795,
+  6962, 7130, 7301, 7475, 7650, 7829, 8009, 8193,
+  8379, 8567, 8758, 8951, 9147, 9345, 9546, 9750,
+  9956, 10165, 10376, 10590, 10806, 11025, 11247, 11472,
+  11699, 11929, 12161, 12397, 12634, 12875, 13119, 13365,
+  13614, 13865, 14120, 14377, 14637, 14899, 15165, 15433,
+  15705, 15979, 16256, 16535, 16818, 17104, 17392, 17683,
+  17978, 18275, 18575, 18878, 19184, 19493, 19805, 20119,
+  20437, 20758, 21082, 21409, 21739, 22072, 22407, 22746,
+  23089, 23434, 23782, 24133, 24487, 24845, 25206, 25569,
+  25936, 26306, 26679, 27055, 27435, 27818, 28203, 28592,
+  28985, 29380, 29779, 30181, 30586, 30994, 31406, 31820,
+  32239, 32660, 33085, 33513, 33944, 34379, 34817, 35258,
+  35702, 36150, 36602, 37056, 37514, 37976, 38441, 38909,
+  39380, 39856, 40334, 40816, 41301, 41790, 42282, 42778,
+  43277, 43780, 44286, 44795, 45308, 45825, 46345, 46869,
+  47396, 47927, 48461, 48999, 49540, 50085, 50634, 51186,
+  51742, 52301, 52864, 53431, 54001, 54575, 55153, 55734,
+  56318, 56907, 57499, 58095, 58695, 59298, 59905, 60515,
+  61130, 61748, 62370, 62995, 63624, 64258, 64894, 65535
+};
+
+static const uint16_t GAMMA_28[UINT8_MAX + 1u] = {
+  0, 0, 0, 0, 1, 1, 2, 3,
+  4, 6, 8, 10, 13, 16, 19, 24,
+  28, 33, 39, 46, 53, 60, 69, 78,
+  88, 98, 110, 122, 135, 149, 164, 179,
+  196, 214, 232, 252, 273, 295, 317, 341,
+  366, 393, 420, 449, 478, 510, 542, 575,
+  610, 647, 684, 723, 764, 806, 849, 894,
+  940, 988, 1037, 1088, 1140, 1194, 1250, 1307,
+  1366, 1427, 1489, 1553, 1619, 1686, 1756, 1827,
+  1900, 1975, 2051, 2130, 2210, 2293, 2377, 2463,
+  2552, 2642, 2734, 2829, 2925, 3024, 3124, 3227,
+  3332, 3439, 3548, 3660, 3774, 3890, 4008, 4128,
+  4251, 4376, 4504, 4634, 4766, 4901, 5038, 5177,
+  5319, 5464, 5611, 5760, 5912, 6067, 6224, 6384,
+  6546, 6711, 6879, 7049, 7222, 7397, 7576, 7757,
+  7941, 8128, 8317, 8509, 8704, 8902, 9103, 9307,
+  9514, 9723, 9936, 10151, 10370, 10591, 10816, 11043,
+  11274, 11507, 11744, 11984, 12227, 12473, 12722, 12975,
+  13230, 13489, 13751, 14017, 14285, 14557, 14833, 15111,
+  15393, 15678, 15967, 16259, 16554, 16853, 17155, 17461,
+  17770, 18083, 18399, 18719, 19042, 19369, 19700, 20034,
+  20372, 20713, 21058, 21407, 21759, 22115, 22475, 22838,
+  23206, 23577, 23952, 24330, 24713, 25099, 25489, 25884,
+  26282, 26683, 27089, 27499, 27913, 28330, 28752, 29178,
+  29608, 30041, 30479, 30921, 31367, 31818, 32272, 32730,
+  33193, 33660, 34131, 34606, 35085, 35569, 36057, 36549,
+  37046, 37547, 38052, 38561, 39075, 39593, 40116, 40643,
+  41175, 41711, 42251, 42796, 43346, 43899, 44458, 45021,
+  45588, 46161, 46737, 47319, 47905, 48495, 49091, 49691,
+  50295, 50905, 51519, 52138, 52761, 53390, 54023, 54661,
+  55303, 55951, 56604, 57261, 57923, 58590, 59262, 59939,
+  60621, 61308, 62000, 62697, 63399, 64106, 64818, 65535
+};
+
+
+typedef struct {
+  uint8_t gamma;  //!< In tenths.
+  const uint16_t *curve;  //!< NULL for a linear response.
+} GammaCurve;
+
+static const GammaCurve GAMMA_CURVES[] = {
+  {LINEAR_GAMMA, NULL},
+  {18u, GAMMA_18},
+  {22u, GAMMA_22},
+  {25u, GAMMA_25},
+  {28u, GAMMA_28},
+};
+
+enum { GAMMA_CURVE_COUNT = sizeof(GAMMA_CURVES) / sizeof(GAMMA_CURVES[0]) };
+
+/*
+ * @brief The color correction stage.
+ *
+ * Each channel has a table that maps a DMX value to a 16-bit level, with the
+ * gamma curve and white balance already applied. The encoders scale the level
+ * to the chip's bit depth.
+ */
+typedef struct {
+  const uint16_t *curve;
+  uint8_t white_balance[SLOTS_PER_PIXEL];
+  bool dither;
+  uint8_t dither_step;
+  uint8_t brightness;  //!< The APA102 global brightness.
+  uint16_t lut[SLOTS_PER_PIXEL][UINT8_MAX + 1u];
+} ColorCorrection;
+
+static ColorCorrection g_correction;
+
+/*
+ * @brief Encodes RGB values into the wire format of a pixel chip.
+ * @param rgb The RGB values, 3 bytes per pixel.
+ * @param count The number of pixels.
+ * @param output The location to write the first pixel to.
+ * @param dither The offset to add to each level before truncation.
+ */
+typedef void (*PixelEncodeFn)(const uint8_t *rgb, uint16_t count,
+                              uint8_t *output, uint16_t dither);
+
+/*
+ * @brief Describes the frame layout for a pixel chip.
+ *
+ * The start and end frames are all zeros. The end frame is end_bytes long,
+ * plus one byte for every pixels_per_end_byte pixels if that's non-zero.
+ */
+typedef struct {
+  PixelType type;
+  PixelEncodeFn encode_fn;
+  uint8_t bytes_per_pixel;
+  uint8_t start_bytes;
+  uint8_t end_bytes;
+  uint8_t pixels_per_end_byte;
+} PixelEncoder;
+
+/*
+ * Both the pixel values and the encoded frames are double buffered.
+ *
+ * The receive path writes to rgb[write_rgb]. When the update completes the
+ * buffers are swapped, and the finished values are encoded into the frame
+ * that isn't being sent. Once the current frame has been sent, the frames
+ * are swapped. This means a frame is never modified while it's being sent,
+ * and updates don't pause the transmission.
+ */
 typedef struct {
   SPI_MODULE_ID module_id;
-  bool use_enhanced_buffering;
   bool in_update;
-  uint32_t tx_index;
-  uint8_t pixels[SLOTS_PER_PIXEL * PIXEL_COUNT + LATCH_BYTES];
+  bool tx_busy;  //!< A frame is queued with the SPI driver.
+  bool encode_pending;  //!< The other rgb buffer needs to be encoded.
+  bool frame_ready;  //!< The other frame buffer is ready to be sent.
+  bool reframe_pending;  //!< The frame being sent has the old layout.
+  uint8_t write_rgb;  //!< The rgb buffer that SPIRGB_SetPixel() writes to.
+  uint8_t tx_frame;  //!< The frame buffer being sent.
+  const PixelEncoder *encoder;
+  uint16_t pixel_count;
+  uint16_t frame_size;
+  uint8_t rgb[2][SLOTS_PER_PIXEL * SPIRGB_MAX_PIXELS];
+  uint8_t frames[2][MAX_FRAME_SIZE];
 } SPIState;
 
 static SPIState g_spi;
 
+// Encoders
+// ----------------------------------------------------------------------------
+
+/*
+ * @brief Scale a 16-bit level to [0, max_level].
+ */
+static inline uint8_t ScaleLevel(uint16_t level, uint32_t max_level,
+                                 uint16_t dither) {
+  return (level * max_level + dither) >> 16;
+}
+
+/*
+ * Each encoder runs once per frame, so keep the loops free of per-pixel
+ * branches.
+ */
+static void EncodeLPD8806(const uint8_t *rgb, uint16_t count,
+                          uint8_t *output, uint16_t dither) {
+  const uint16_t *red = g_correction.lut[RED];
+  const uint16_t *green = g_correction.lut[GREEN];
+  const uint16_t *blue = g_correction.lut[BLUE];
+  const uint8_t *end = rgb + count * SLOTS_PER_PIXEL;
+  for (; rgb != end; rgb += SLOTS_PER_PIXEL, output += 3u) {
+    output[0] = LPD8806_PIXEL_BYTE |
+                ScaleLevel(green[rgb[GREEN]], LPD8806_MAX_LEVEL, dither);
+    output[1] = LPD8806_PIXEL_BYTE |
+                ScaleLevel(red[rgb[RED]], LPD8806_MAX_LEVEL, dither);
+    output[2] = LPD8806_PIXEL_BYTE |
+                ScaleLevel(blue[rgb[BLUE]], LPD8806_MAX_LEVEL, dither);
+  }
+}
+
+static void EncodeWS2801(const uint8_t *rgb, uint16_t count,
+                         uint8_t *output, uint16_t dither) {
+  const uint16_t *red = g_correction.lut[RED];
+  const uint16_t *green = g_correction.lut[GREEN];
+  const uint16_t *blue = g_correction.lut[BLUE];
+  const uint8_t *end = rgb + count * SLOTS_PER_PIXEL;
+  for (; rgb != end; rgb += SLOTS_PER_PIXEL, output += 3u) {
+    output[0] = ScaleLevel(red[rgb[RED]], UINT8_MAX, dither);
+    output[1] = ScaleLevel(green[rgb[GREEN]], UINT8_MAX, dither);
+    output[2] = ScaleLevel(blue[rgb[BLUE]], UINT8_MAX, dither);
+  }
+}
+
+static void EncodeP9813(const uint8_t *rgb, uint16_t count,
+                        uint8_t *output, uint16_t dither) {
+  const uint16_t *red = g_correction.lut[RED];
+  const uint16_t *green = g_correction.lut[GREEN];
+  const uint16_t *blue = g_correction.lut[BLUE];
+  const uint8_t *end = rgb + count * SLOTS_PER_PIXEL;
+  for (; rgb != end; rgb += SLOTS_PER_PIXEL, output += 4u) {
+    const uint8_t r = ScaleLevel(red[rgb[RED]], UINT8_MAX, dither);
+    const uint8_t g = ScaleLevel(green[rgb[GREEN]], UINT8_MAX, dither);
+    const uint8_t b = ScaleLevel(blue[rgb[BLUE]], UINT8_MAX, dither);
+    // The flag byte holds the inverted top two bits of each color.
+    output[0] = P9813_FLAG_BYTE |
+                (~b & 0xc0u) >> 2 |
+                (~g & 0xc0u) >> 4 |
+                (~r & 0xc0u) >> 6;
+    output[1] = b;
+    output[2] = g;
+    output[3] = r;
+  }
+}
+
+static void EncodeAPA102(const uint8_t *rgb, uint16_t count,
+                         uint8_t *output, uint16_t dither) {
+  const uint16_t *red = g_correction.lut[RED];
+  const uint16_t *green = g_correction.lut[GREEN];
+  const uint16_t *blue = g_correction.lut[BLUE];
+  const uint8_t header = APA102_PIXEL_BYTE | g_correction.brightness;
+  const uint8_t *end = rgb + count * SLOTS_PER_PIXEL;
+  for (; rgb != end; rgb += SLOTS_PER_PIXEL, output += 4u) {
+    output[0] = header;
+    output[1] = ScaleLevel(blue[rgb[BLUE]], UINT8_MAX, dither);
+    output[2] = ScaleLevel(green[rgb[GREEN]], UINT8_MAX, dither);
+    output[3] = ScaleLevel(red[rgb[RED]], UINT8_MAX, dither);
+  }
+}
+
+static const PixelEncoder PIXEL_ENCODERS[] = {
+  {
+    .type = PIXEL_TYPE_LPD8806,
+    .encode_fn = EncodeLPD8806,
+    .bytes_per_pixel = 3u,
+    .start_bytes = 0u,
+    .end_bytes = 0u,
+    .pixels_per_end_byte = 32u
+  },
+  {
+    .type = PIXEL_TYPE_WS2801,
+    .encode_fn = EncodeWS2801,
+    .bytes_per_pixel = 3u,
+    .start_bytes = 0u,
+    .end_bytes = 0u,
+    .pixels_per_end_byte = 0u
+  },
+  {
+    .type = PIXEL_TYPE_P9813,
+    .encode_fn = EncodeP9813,
+    .bytes_per_pixel = 4u,
+    .start_bytes = 4u,
+    .end_bytes = 4u,
+    .pixels_per_end_byte = 0u
+  },
+  {
+    .type = PIXEL_TYPE_APA102,
+    .encode_fn = EncodeAPA102,
+    .bytes_per_pixel = 4u,
+    .start_bytes = 4u,
+    .end_bytes = 0u,
+    .pixels_per_end_byte = 16u
+  },
+};
+
+enum {
+  PIXEL_ENCODER_COUNT = sizeof(PIXEL_ENCODERS) / sizeof(PIXEL_ENCODERS[0])
+};
+
+// Helper functions
+// ----------------------------------------------------------------------------
+
+/*
+ * @brief Recalculate the frame size, and write the start & end frames.
+ */
+static void Reframe() {
+  const PixelEncoder *encoder = g_spi.encoder;
+  uint16_t end_bytes = encoder->end_bytes;
+  if (encoder->pixels_per_end_byte) {
+    end_bytes += (g_spi.pixel_count + encoder->pixels_per_end_byte - 1u) /
+                 encoder->pixels_per_end_byte;
+  }
+  g_spi.frame_size = encoder->start_bytes +
+                     g_spi.pixel_count * encoder->bytes_per_pixel + end_bytes;
+  // The frame being sent may still be in use, so it's cleared by
+  // SPIRGB_Tasks() once the transfer completes. The new frame size only
+  // applies to frames queued after that.
+  memset(g_spi.frames[g_spi.tx_frame ^ 1u], 0, MAX_FRAME_SIZE);
+  g_spi.reframe_pending = true;
+  g_spi.encode_pending = false;
+  g_spi.frame_ready = false;
+}
+
+/*
+ * @brief Rebuild the color correction tables.
+ */
+static void BuildCorrectionTables() {
+  unsigned int color = 0u;
+  for (; color < SLOTS_PER_PIXEL; color++) {
+    const uint32_t balance = g_correction.white_balance[color];
+    uint16_t *lut = g_correction.lut[color];
+    unsigned int i = 0u;
+    for (; i <= UINT8_MAX; i++) {
+      const uint32_t level = g_correction.curve ?
+          g_correction.curve[i] : i * (UINT16_MAX / UINT8_MAX);
+      lut[i] = level * balance / UINT8_MAX;
+    }
+  }
+}
+
+/*
+ * @brief Encode the last completed pixel values into the frame not being sent.
+ */
+static void EncodeFrame() {
+  uint16_t dither = NO_DITHER;
+  if (g_correction.dither) {
+    dither = DITHER_SEQUENCE[g_correction.dither_step];
+    g_correction.dither_step = (g_correction.dither_step + 1u) % DITHER_STEPS;
+  }
+  g_spi.encoder->encode_fn(
+      g_spi.rgb[g_spi.write_rgb ^ 1u], g_spi.pixel_count,
+      &g_spi.frames[g_spi.tx_frame ^ 1u][g_spi.encoder->start_bytes], dither);
+}
+
+/*
+ * @brief Called by the SPI driver when the frame has been sent.
+ */
+static void FrameSent(SPIEventType event) {
+  if (event == SPI_COMPLETE_TRANSFER) {
+    g_spi.tx_busy = false;
+    Scheduler_Wake(SPIRGB_Tasks);
+  }
+}
+
+// Public Functions
+// ----------------------------------------------------------------------------
 void SPIRGB_Init(const SPIRGBConfiguration *config) {
   g_spi.module_id = config->module_id;
-  g_spi.use_enhanced_buffering = config->use_enhanced_buffering;
   g_spi.in_update = false;
-  g_spi.tx_index = 0u;
+  g_spi.tx_busy = false;
+  g_spi.write_rgb = 0u;
+  g_spi.tx_frame = 0u;
+  g_spi.encoder = &PIXEL_ENCODERS[0];
 
-  memset(g_spi.pixels, LPD8806_PIXEL_BYTE, SLOTS_PER_PIXEL * PIXEL_COUNT);
-  memset(&g_spi.pixels[SLOTS_PER_PIXEL * PIXEL_COUNT], 0, LATCH_BYTES);
+  g_correction.curve = NULL;
+  memset(g_correction.white_balance, UINT8_MAX,
+         sizeof(g_correction.white_balance));
+  g_correction.dither = false;
+  g_correction.dither_step = 0u;
+  g_correction.brightness = SPIRGB_MAX_BRIGHTNESS;
+  BuildCorrectionTables();
 
-  // Init the SPI hardware.
-  PLIB_SPI_BaudRateSet(g_spi.module_id, SYS_CLK_FREQ, config->baud_rate);
-  PLIB_SPI_CommunicationWidthSelect(g_spi.module_id,
-                                    SPI_COMMUNICATION_WIDTH_8BITS);
-  PLIB_SPI_ClockPolaritySelect(g_spi.module_id, SPI_CLOCK_POLARITY_IDLE_HIGH);
-  if (g_spi.use_enhanced_buffering) {
-    PLIB_SPI_FIFOEnable(g_spi.module_id);
+  SPIRGB_SetPixelCount(DEFAULT_PIXEL_COUNT);
+}
+
+void SPIRGB_SetPixelCount(uint16_t count) {
+  if (count > SPIRGB_MAX_PIXELS) {
+    count = SPIRGB_MAX_PIXELS;
   }
-  PLIB_SPI_SlaveSelectDisable(g_spi.module_id);
-  PLIB_SPI_PinDisable(g_spi.module_id, SPI_PIN_SLAVE_SELECT);
-  PLIB_SPI_MasterEnable(g_spi.module_id);
-  PLIB_SPI_Enable(g_spi.module_id);
+  g_spi.pixel_count = count;
+  memset(g_spi.rgb, 0, sizeof(g_spi.rgb));
+  Reframe();
+}
+
+uint16_t SPIRGB_PixelCount() {
+  return g_spi.pixel_count;
+}
+
+void SPIRGB_SetPixelType(PixelType type) {
+  unsigned int i = 0u;
+  for (; i < PIXEL_ENCODER_COUNT; i++) {
+    if (PIXEL_ENCODERS[i].type == type) {
+      g_spi.encoder = &PIXEL_ENCODERS[i];
+      Reframe();
+      return;
+    }
+  }
+}
+
+bool SPIRGB_SetGamma(uint8_t gamma) {
+  unsigned int i = 0u;
+  for (; i < GAMMA_CURVE_COUNT; i++) {
+    if (GAMMA_CURVES[i].gamma == gamma) {
+      g_correction.curve = GAMMA_CURVES[i].curve;
+      BuildCorrectionTables();
+      return true;
+    }
+  }
+  return false;
+}
+
+void SPIRGB_SetWhiteBalance(uint8_t red, uint8_t green, uint8_t blue) {
+  g_correction.white_balance[RED] = red;
+  g_correction.white_balance[GREEN] = green;
+  g_correction.white_balance[BLUE] = blue;
+  BuildCorrectionTables();
+}
+
+void SPIRGB_SetDithering(bool enabled) {
+  g_correction.dither = enabled;
+  Scheduler_Wake(SPIRGB_Tasks);
+}
+
+void SPIRGB_SetBrightness(uint8_t brightness) {
+  if (brightness > SPIRGB_MAX_BRIGHTNESS) {
+    brightness = SPIRGB_MAX_BRIGHTNESS;
+  }
+  g_correction.brightness = brightness;
 }
 
 void SPIRGB_BeginUpdate() {
@@ -69,45 +555,56 @@ void SPIRGB_BeginUpdate() {
 }
 
 void SPIRGB_SetPixel(uint16_t index, RGB_Color color, uint8_t value) {
-  if (index >= PIXEL_COUNT || !g_spi.in_update) {
+  if (index >= g_spi.pixel_count || !g_spi.in_update) {
     return;
   }
-  // Map RGB to GRB
-  uint8_t color_offset = 0u;
-  switch (color) {
-    case RED:
-      color_offset = 1u;
-      break;
-    case GREEN:
-      color_offset = 0u;
-      break;
-    case BLUE:
-      color_offset = 2u;
-      break;
-    }
-  g_spi.pixels[index * SLOTS_PER_PIXEL + color_offset] =
-      LPD8806_PIXEL_BYTE | value >> 1;
+  g_spi.rgb[g_spi.write_rgb][index * SLOTS_PER_PIXEL + color] = value;
 }
 
 void SPIRGB_CompleteUpdate() {
+  if (!g_spi.in_update) {
+    return;
+  }
   g_spi.in_update = false;
-  g_spi.tx_index = 0u;
+
+  // Swap the buffers. The next update starts from these values, since a
+  // short DMX frame only updates some of the pixels.
+  const uint8_t *rgb = g_spi.rgb[g_spi.write_rgb];
+  g_spi.write_rgb ^= 1u;
+  memcpy(g_spi.rgb[g_spi.write_rgb], rgb, g_spi.pixel_count * SLOTS_PER_PIXEL);
+  g_spi.encode_pending = true;
+  Scheduler_Wake(SPIRGB_Tasks);
 }
 
 void SPIRGB_Tasks() {
-  if (g_spi.in_update) {
-    return;
+  if (g_spi.reframe_pending && !g_spi.tx_busy) {
+    memset(g_spi.frames[g_spi.tx_frame], 0, MAX_FRAME_SIZE);
+    g_spi.reframe_pending = false;
   }
 
-  while (g_spi.tx_index < PIXEL_COUNT * SLOTS_PER_PIXEL + LATCH_BYTES) {
-    if (g_spi.use_enhanced_buffering) {
-      if (PLIB_SPI_TransmitBufferIsFull(g_spi.module_id)) {
-        return;
-      }
-    } else if (PLIB_SPI_IsBusy(g_spi.module_id)) {
-      return;
+  if (g_correction.dither && !g_spi.frame_ready) {
+    // Dithering only works if the frames keep coming, so re-send the last
+    // values.
+    g_spi.encode_pending = true;
+  }
+
+  if (g_spi.encode_pending) {
+    EncodeFrame();
+    g_spi.encode_pending = false;
+    g_spi.frame_ready = true;
+  }
+
+  if (g_spi.frame_ready && !g_spi.tx_busy) {
+    // Set tx_busy first, in case the transfer completes straight away. If the
+    // SPI queue is full, try again next time.
+    g_spi.tx_busy = true;
+    if (SPI_QueueTransfer(g_spi.module_id, g_spi.frames[g_spi.tx_frame ^ 1u],
+                          g_spi.frame_size, NULL, 0u, FrameSent)) {
+      g_spi.tx_frame ^= 1u;
+      g_spi.frame_ready = false;
+    } else {
+      g_spi.tx_busy = false;
+      Scheduler_Wake(SPIRGB_Tasks);
     }
-    PLIB_SPI_BufferWrite(g_spi.module_id, g_spi.pixels[g_spi.tx_index]);
-    g_spi.tx_index++;
   }
 }
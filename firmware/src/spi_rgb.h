@@ -21,8 +21,15 @@
  * @defgroup spi_dmx SPI Pixel Controller
  * @brief Control RGB Pixels using SPI
  *
- * This only supports the LPD8806 chip for now. We're happy to accept pull
- * requests adding support for different pixel types.
+ * Supports LPD8806, WS2801, P9813 and APA102 pixels. Pixel values are stored
+ * as RGB and encoded into the chip's wire format once per frame, just before
+ * the frame is sent. Frames are sent using the @ref spi, so the bus can be
+ * shared with other SPI devices.
+ *
+ * Encoding passes each value through a per-channel lookup table, which applies
+ * the gamma curve and white balance. Temporal dithering can be enabled to
+ * recover the levels lost when the result is truncated to the chip's bit
+ * depth.
  *
  * @addtogroup spi_dmx
  * @{
@@ -41,6 +48,18 @@ extern "C" {
 #include "system_config.h"
 #include "peripheral/spi/plib_spi.h"
 
+/**
+ * @brief The maximum number of pixels that can be driven.
+ *
+ * 170 pixels uses 510 slots of a DMX universe.
+ */
+#define SPIRGB_MAX_PIXELS 170u
+
+/**
+ * @brief The maximum global brightness of an APA102 pixel.
+ */
+#define SPIRGB_MAX_BRIGHTNESS 31u
+
 /**
  * @brief RGB color values.
  */
@@ -50,20 +69,25 @@ typedef enum {
   BLUE = 2
 } RGB_Color;
 
+/**
+ * @brief The type of pixel chip.
+ *
+ * These values are used in the PIXEL_TYPE PID.
+ */
+typedef enum {
+  PIXEL_TYPE_LPD8806 = 0x0001,  //!< 7-bit GRB, no start frame.
+  PIXEL_TYPE_WS2801 = 0x0002,  //!< 8-bit RGB, latched by a pause.
+  PIXEL_TYPE_P9813 = 0x0003,  //!< Flag byte plus 8-bit BGR.
+  PIXEL_TYPE_APA102 = 0x0004,  //!< Brightness byte plus 8-bit BGR.
+} PixelType;
+
 /**
  * @brief SPI RGB Module configuration
+ *
+ * The SPI module must have been initialized with SPI_Initialize().
  */
 typedef struct {
   SPI_MODULE_ID module_id;  //!< The SPI module to use
-  uint32_t baud_rate;  //!< The Baud rate
-
-  /**
-   * @brief Use enhanced buffer mode, not all chips support this.
-   *
-   * Enhanced mode allows us to queue up multiple bytes of SPI data at once. In
-   * normal mode there may be delays between bytes.
-   */
-  bool use_enhanced_buffering;
 } SPIRGBConfiguration;
 
 /**
@@ -72,10 +96,68 @@ typedef struct {
  */
 void SPIRGB_Init(const SPIRGBConfiguration *config);
 
+/**
+ * @brief Set the number of pixels to drive.
+ * @param count The number of pixels, values greater than SPIRGB_MAX_PIXELS are
+ *   truncated.
+ *
+ * This resets all pixels to off.
+ */
+void SPIRGB_SetPixelCount(uint16_t count);
+
+/**
+ * @brief Return the number of pixels being driven.
+ */
+uint16_t SPIRGB_PixelCount();
+
+/**
+ * @brief Set the type of pixel chip.
+ * @param type The pixel type, unknown types are ignored.
+ *
+ * The current pixel values are kept, and will be sent in the new format after
+ * the next update completes.
+ */
+void SPIRGB_SetPixelType(PixelType type);
+
+/**
+ * @brief Set the gamma curve.
+ * @param gamma The gamma value in tenths. 10 (linear), 18, 22, 25 and 28 are
+ *   supported.
+ * @returns true if the gamma value was supported, false otherwise.
+ */
+bool SPIRGB_SetGamma(uint8_t gamma);
+
+/**
+ * @brief Set the white balance.
+ * @param red The scale for the red channel, 255 is full output.
+ * @param green The scale for the green channel, 255 is full output.
+ * @param blue The scale for the blue channel, 255 is full output.
+ */
+void SPIRGB_SetWhiteBalance(uint8_t red, uint8_t green, uint8_t blue);
+
+/**
+ * @brief Enable or disable temporal dithering.
+ * @param enabled true to enable dithering.
+ *
+ * With dithering enabled, frames are sent continuously and the rounding of
+ * each level varies over an 8 frame cycle.
+ */
+void SPIRGB_SetDithering(bool enabled);
+
+/**
+ * @brief Set the global brightness of APA102 pixels.
+ * @param brightness The brightness, values greater than SPIRGB_MAX_BRIGHTNESS
+ *   are truncated.
+ *
+ * This is sent in the header byte of each pixel, and is ignored by the other
+ * pixel types. It applies from the next update.
+ */
+void SPIRGB_SetBrightness(uint8_t brightness);
+
 /**
  * @brief Begin a frame update.
  *
- * This pauses the SPI sending task.
+ * The previous frame continues to be sent while the update is in progress.
  */
 void SPIRGB_BeginUpdate();
 
@@ -90,8 +172,9 @@ void SPIRGB_SetPixel(uint16_t index, RGB_Color color, uint8_t value);
 /**
  * @brief Complete a frame update.
  *
- * This unpauses the SPI sending task. The frame will be sent on the next call
- * to SPIRGB_Tasks().
+ * The frame is encoded on the next call to SPIRGB_Tasks(), and sent once the
+ * previous frame has been sent. This does nothing if there isn't an update in
+ * progress.
  */
 void SPIRGB_CompleteUpdate();
 
@@ -24,6 +24,7 @@
 
 #include "app_pipeline.h"
 #include "constants.h"
+#include "metrics.h"
 
 // Microchip defines this macro in stdlib.h but it's non standard.
 // We define it here so that the unit tests work.
@@ -154,11 +155,14 @@ void StreamDecoder_Process(const uint8_t* data, unsigned int size) {
         break;
       case END_OF_MESSAGE:
         if (*data == END_OF_MESSAGE_ID) {
+          Metrics_Increment(METRIC_HOST_MESSAGES);
 #ifdef PIPELINE_HANDLE_MESSAGE
           PIPELINE_HANDLE_MESSAGE(&g_stream_data.message);
 #else
           g_stream_data.handler(&g_stream_data.message);
 #endif
+        } else {
+          Metrics_Increment(METRIC_HOST_FRAMING_ERRORS);
         }
         g_stream_data.fragment_offset = 0u;
         g_stream_data.state = START_OF_MESSAGE;
@@ -63,6 +63,7 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 #include <xc.h>
 #include <sys/attribs.h>
 #include "app.h"
+#include "isr_profiler.h"
 #include "system_definitions.h"
 
 // *****************************************************************************
@@ -75,9 +76,9 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 	
 void __ISR(_USB_1_VECTOR, ipl4AUTO) _IntHandlerUSBInstance0(void)
 {
-
+    ISR_PROFILER_ENTER();
     DRV_USBFS_Tasks_ISR(sysObj.drvUSBObject);
-            
+    ISR_PROFILER_EXIT(ISR_PROFILER_USB);
 }
 
 
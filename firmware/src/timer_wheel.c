@@ -0,0 +1,175 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * timer_wheel.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "timer_wheel.h"
+
+#include <stdlib.h>
+
+/*
+ * @brief The number of slots in the wheel, must be a power of 2.
+ */
+enum { WHEEL_SLOTS = 64u };
+
+/*
+ * @brief The length of a wheel tick, in 10ths of a millisecond.
+ */
+enum { TICK_LENGTH = 10u };
+
+typedef struct {
+  TimerWheel_Timer *slots[WHEEL_SLOTS];
+  CoarseTimer_Value tick_time;  //!< When the current tick started.
+  uint32_t tick;  //!< The current tick.
+  unsigned int timer_count;  //!< The number of scheduled timers.
+} TimerWheel;
+
+static TimerWheel g_wheel;
+
+// Helper functions
+// ----------------------------------------------------------------------------
+
+/*
+ * @brief Add a timer to the slot for its expiry time.
+ */
+static void Insert(TimerWheel_Timer *timer) {
+  // Round up to the next tick, so the timer doesn't fire early.
+  int32_t remaining = timer->expiry - g_wheel.tick_time;
+  uint32_t ticks = 1u;
+  if (remaining > 0) {
+    ticks = (remaining + TICK_LENGTH - 1u) / TICK_LENGTH;
+  }
+  timer->expiry_tick = g_wheel.tick + ticks;
+
+  TimerWheel_Timer **slot = &g_wheel.slots[timer->expiry_tick &
+                                           (WHEEL_SLOTS - 1u)];
+  timer->prev = NULL;
+  timer->next = *slot;
+  if (*slot) {
+    (*slot)->prev = timer;
+  }
+  *slot = timer;
+  timer->scheduled = true;
+  g_wheel.timer_count++;
+}
+
+static void Remove(TimerWheel_Timer *timer) {
+  if (timer->prev) {
+    timer->prev->next = timer->next;
+  } else {
+    g_wheel.slots[timer->expiry_tick & (WHEEL_SLOTS - 1u)] = timer->next;
+  }
+  if (timer->next) {
+    timer->next->prev = timer->prev;
+  }
+  timer->next = NULL;
+  timer->prev = NULL;
+  timer->scheduled = false;
+  g_wheel.timer_count--;
+}
+
+/*
+ * @brief Run the expired timers in the current tick's slot.
+ *
+ * Slots also hold timers that expire on later revolutions of the wheel, these
+ * are skipped.
+ */
+static void ExpireSlot() {
+  TimerWheel_Timer *timer = g_wheel.slots[g_wheel.tick & (WHEEL_SLOTS - 1u)];
+  while (timer) {
+    if ((int32_t) (g_wheel.tick - timer->expiry_tick) < 0) {
+      timer = timer->next;
+      continue;
+    }
+
+    Remove(timer);
+    if (timer->period) {
+      timer->expiry += timer->period;
+      CoarseTimer_Value now = CoarseTimer_GetTime();
+      if ((int32_t) (now - timer->expiry) >= 0) {
+        // We've fallen behind, don't try to run the missed periods.
+        timer->expiry = now + timer->period;
+      }
+      Insert(timer);
+    }
+    timer->callback();
+    // The callback may have modified this slot, so start again.
+    timer = g_wheel.slots[g_wheel.tick & (WHEEL_SLOTS - 1u)];
+  }
+}
+
+// Public Functions
+// ----------------------------------------------------------------------------
+void TimerWheel_Initialize() {
+  unsigned int i = 0u;
+  for (; i < WHEEL_SLOTS; i++) {
+    while (g_wheel.slots[i]) {
+      Remove(g_wheel.slots[i]);
+    }
+  }
+  g_wheel.tick_time = CoarseTimer_GetTime();
+  g_wheel.tick = 0u;
+  g_wheel.timer_count = 0u;
+}
+
+void TimerWheel_Schedule(TimerWheel_Timer *timer, uint32_t delay,
+                         TimerWheel_Callback callback) {
+  TimerWheel_Cancel(timer);
+  timer->callback = callback;
+  // Like CoarseTimer_HasElapsed(), more than delay must pass.
+  timer->expiry = CoarseTimer_GetTime() + delay + 1u;
+  timer->period = 0u;
+  Insert(timer);
+}
+
+void TimerWheel_SchedulePeriodic(TimerWheel_Timer *timer, uint32_t period,
+                                 TimerWheel_Callback callback) {
+  TimerWheel_Schedule(timer, period, callback);
+  timer->period = period;
+}
+
+void TimerWheel_Cancel(TimerWheel_Timer *timer) {
+  if (timer->scheduled) {
+    Remove(timer);
+  }
+}
+
+bool TimerWheel_IsScheduled(const TimerWheel_Timer *timer) {
+  return timer->scheduled;
+}
+
+void TimerWheel_Tasks() {
+  uint32_t elapsed = CoarseTimer_ElapsedTime(g_wheel.tick_time);
+  if (elapsed < TICK_LENGTH) {
+    return;
+  }
+
+  if (g_wheel.timer_count == 0u) {
+    // Nothing to run, catch up in one step.
+    uint32_t ticks = elapsed / TICK_LENGTH;
+    g_wheel.tick += ticks;
+    g_wheel.tick_time += ticks * TICK_LENGTH;
+    return;
+  }
+
+  while (elapsed >= TICK_LENGTH) {
+    g_wheel.tick++;
+    g_wheel.tick_time += TICK_LENGTH;
+    elapsed -= TICK_LENGTH;
+    ExpireSlot();
+  }
+}
@@ -0,0 +1,135 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * timer_wheel.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup timer_wheel Timer Wheel
+ * @brief Run callbacks after a delay, or periodically.
+ *
+ * Rather than polling CoarseTimer_HasElapsed() from a Tasks function, a module
+ * can schedule a callback. Timers are kept in a hashed timer wheel, so
+ * scheduling & cancelling a timer is O(1) and each millisecond only the timers
+ * in one slot are checked. When no timers are scheduled, TimerWheel_Tasks()
+ * does no work.
+ *
+ * The TimerWheel_Timer structures are owned by the caller and must remain
+ * valid while the timer is scheduled. Callbacks are run from
+ * TimerWheel_Tasks(), not from an ISR.
+ *
+ * @addtogroup timer_wheel
+ * @{
+ * @file timer_wheel.h
+ * @brief Run callbacks after a delay, or periodically.
+ */
+
+#ifndef FIRMWARE_SRC_TIMER_WHEEL_H_
+#define FIRMWARE_SRC_TIMER_WHEEL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "coarse_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The callback run when a timer expires.
+ */
+typedef void (*TimerWheel_Callback)();
+
+/**
+ * @brief A timer.
+ *
+ * The members are private to the timer wheel.
+ */
+typedef struct TimerWheel_Timer_s {
+  struct TimerWheel_Timer_s *next;
+  struct TimerWheel_Timer_s *prev;
+  TimerWheel_Callback callback;
+  CoarseTimer_Value expiry;  //!< When the timer expires.
+  uint32_t expiry_tick;  //!< The wheel tick the timer expires on.
+  uint32_t period;  //!< The period, or 0 for one-shot timers.
+  bool scheduled;
+} TimerWheel_Timer;
+
+/**
+ * @brief Initialize the timer wheel.
+ *
+ * This cancels all scheduled timers. CoarseTimer_Initialize() must be called
+ * first.
+ */
+void TimerWheel_Initialize();
+
+/**
+ * @brief Run a callback once, after a delay.
+ * @param timer The timer to use.
+ * @param delay The delay in 10ths of a millisecond.
+ * @param callback The callback to run.
+ *
+ * If the timer is already scheduled, it's rescheduled. Like
+ * CoarseTimer_HasElapsed(), the callback won't run early, but may run up to
+ * 1ms late.
+ */
+void TimerWheel_Schedule(TimerWheel_Timer *timer, uint32_t delay,
+                         TimerWheel_Callback callback);
+
+/**
+ * @brief Run a callback periodically.
+ * @param timer The timer to use.
+ * @param period The period in 10ths of a millisecond, must be non-0.
+ * @param callback The callback to run.
+ *
+ * The first call occurs after one period. Each period is measured from when
+ * the previous one should have expired, so the callback doesn't drift. If the
+ * main loop stalls for more than a period, the missed periods are skipped.
+ */
+void TimerWheel_SchedulePeriodic(TimerWheel_Timer *timer, uint32_t period,
+                                 TimerWheel_Callback callback);
+
+/**
+ * @brief Cancel a timer.
+ * @param timer The timer to cancel. It's safe to cancel a timer that isn't
+ *   scheduled.
+ */
+void TimerWheel_Cancel(TimerWheel_Timer *timer);
+
+/**
+ * @brief Check if a timer is scheduled.
+ * @param timer The timer to check.
+ * @returns true if the timer is scheduled, false otherwise.
+ */
+bool TimerWheel_IsScheduled(const TimerWheel_Timer *timer);
+
+/**
+ * @brief Run the callbacks for any expired timers.
+ *
+ * This should be called from the main event loop.
+ */
+void TimerWheel_Tasks();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FIRMWARE_SRC_TIMER_WHEEL_H_
+
+/**
+ * @}
+ */
@@ -0,0 +1,54 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * timestamp.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "timestamp.h"
+
+#include "core_timer.h"
+
+typedef struct {
+  volatile Timestamp base;  //!< The time of the last update.
+  volatile uint32_t sequence;  //!< Incremented each time the base changes.
+} Timestamp_Data;
+
+static Timestamp_Data g_timestamp;
+
+void Timestamp_Initialize() {
+  g_timestamp.base = CoreTimer_GetCount();
+  g_timestamp.sequence = 0u;
+}
+
+void Timestamp_Update() {
+  g_timestamp.base = Timestamp_Now();
+  g_timestamp.sequence++;
+}
+
+Timestamp Timestamp_Now() {
+  // The 64-bit base can't be read atomically. If the ISR moves it while we're
+  // reading it, try again.
+  uint32_t sequence;
+  Timestamp base;
+  uint32_t count;
+  do {
+    sequence = g_timestamp.sequence;
+    base = g_timestamp.base;
+    count = CoreTimer_GetCount();
+  } while (sequence != g_timestamp.sequence);
+  // The low 32 bits of the base are the core timer count at the last update.
+  return base + (uint32_t) (count - (uint32_t) base);
+}
@@ -0,0 +1,131 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * timestamp.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup timestamp Timestamp
+ * @brief A high resolution, monotonic 64-bit timestamp.
+ *
+ * Timestamps count core timer ticks (25ns with an 80MHz system clock) and
+ * never wrap, so timestamps taken anywhere in the firmware can be compared
+ * directly.
+ *
+ * The core timer is only 32 bits, so Timestamp_Update() must be called at
+ * least once per core timer wrap (107s). The core timer interrupt, which
+ * fires every 26s, does this.
+ *
+ * The low 32 bits of a timestamp are the core timer count, so cycle counts
+ * from CoreTimer_GetCount() can be compared with timestamps.
+ *
+ * @addtogroup timestamp
+ * @{
+ * @file timestamp.h
+ * @brief A high resolution, monotonic 64-bit timestamp.
+ */
+
+#ifndef FIRMWARE_SRC_TIMESTAMP_H_
+#define FIRMWARE_SRC_TIMESTAMP_H_
+
+#include <stdint.h>
+
+#include "system_config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief A point in time, or a duration, in core timer ticks.
+ */
+typedef uint64_t Timestamp;
+
+/**
+ * @brief The number of timestamp ticks in a microsecond.
+ */
+#define TIMESTAMP_TICKS_PER_MICROSECOND (SYS_CLK_FREQ / 2u / 1000000u)
+
+/**
+ * @brief Initialize the timestamp module.
+ */
+void Timestamp_Initialize();
+
+/**
+ * @brief Move the timestamp base forward.
+ *
+ * This must be called from the core timer interrupt, or at least once every
+ * 2^32 core timer ticks.
+ */
+void Timestamp_Update();
+
+/**
+ * @brief Get the current time.
+ * @returns The number of core timer ticks since the timestamp module was
+ *   initialized, plus the core timer count at initialization.
+ *
+ * This may be called from an ISR, provided the ISR runs at or below the
+ * priority of the core timer interrupt.
+ */
+Timestamp Timestamp_Now();
+
+/**
+ * @brief Convert a duration to microseconds.
+ * @param duration The duration in timestamp ticks.
+ * @returns The duration in microseconds, truncated to 32 bits.
+ */
+static inline uint32_t Timestamp_ToMicroSeconds(Timestamp duration) {
+  return duration / TIMESTAMP_TICKS_PER_MICROSECOND;
+}
+
+/**
+ * @brief Convert a duration to 10ths of a microsecond.
+ * @param duration The duration in timestamp ticks.
+ * @returns The duration in 10ths of a microsecond, truncated to 32 bits.
+ *
+ * This matches the units used in TransceiverTiming.
+ */
+static inline uint32_t Timestamp_ToTenthsOfMicroSeconds(Timestamp duration) {
+  return duration * 10u / TIMESTAMP_TICKS_PER_MICROSECOND;
+}
+
+/**
+ * @brief Convert microseconds to a duration.
+ * @param micro_seconds The number of microseconds.
+ * @returns The duration in timestamp ticks.
+ */
+static inline Timestamp Timestamp_FromMicroSeconds(uint32_t micro_seconds) {
+  return (Timestamp) micro_seconds * TIMESTAMP_TICKS_PER_MICROSECOND;
+}
+
+/**
+ * @brief Convert 10ths of a microsecond to a duration.
+ * @param tenths The number of 10ths of a microsecond.
+ * @returns The duration in timestamp ticks.
+ */
+static inline Timestamp Timestamp_FromTenthsOfMicroSeconds(uint32_t tenths) {
+  return (Timestamp) tenths * TIMESTAMP_TICKS_PER_MICROSECOND / 10u;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FIRMWARE_SRC_TIMESTAMP_H_
+
+/**
+ * @}
+ */
@@ -30,13 +30,17 @@
 #include "coarse_timer.h"
 #include "constants.h"
 #include "dmx_spec.h"
+#include "isr_profiler.h"
+#include "metrics.h"
 #include "peripheral/ic/plib_ic.h"
 #include "peripheral/tmr/plib_tmr.h"
 #include "peripheral/usart/plib_usart.h"
 #include "setting_macros.h"
 #include "syslog.h"
 #include "system_definitions.h"
+#include "timestamp.h"
 #include "transceiver_timing.h"
+#include "transceiver_trace.h"
 #include "random.h"
 
 #include "app_settings.h"
@@ -153,6 +157,14 @@ typedef struct {
    */
   uint16_t event_index;
 
+  /**
+   * @brief The start of the current frame.
+   *
+   * This is the start of the break we sent, or the falling edge of the break
+   * we received.
+   */
+  Timestamp frame_start;
+
   /**
    * @brief The time of the last level change.
    */
@@ -230,6 +242,22 @@ static TransceiverEventCallback g_rx_callback = NULL;
 // The timing settings
 static TimingSettings g_timing_settings;
 
+/*
+ * @brief Change state, and record the change in the trace.
+ */
+static inline void SetState(TransceiverState state) {
+  g_transceiver.state = state;
+  if (g_transceiver.active) {
+    TransceiverTrace_Record(state, g_transceiver.active->op,
+                            g_transceiver.active->token,
+                            g_transceiver.data_index);
+  } else {
+    TransceiverTrace_Record(state, TRANSCEIVER_TRACE_NO_OP,
+                            TRANSCEIVER_NO_NOTIFICATION,
+                            g_transceiver.data_index);
+  }
+}
+
 // Timer Functions
 // ----------------------------------------------------------------------------
 /*
@@ -252,6 +280,18 @@ static inline void RebaseTimer(uint16_t last_event) {
       PLIB_TMR_Counter16BitGet(g_hw_settings.timer_module_id) - last_event);
 }
 
+/*
+ * @brief Convert an input capture value to a timestamp.
+ *
+ * While receiving, the timer runs at 10MHz, so it's only valid for captures
+ * in the last 6.5ms.
+ */
+static inline Timestamp CaptureToTimestamp(uint16_t value) {
+  uint16_t age = PLIB_TMR_Counter16BitGet(g_hw_settings.timer_module_id) -
+                 value;
+  return Timestamp_Now() - Timestamp_FromTenthsOfMicroSeconds(age);
+}
+
 // I/O Functions
 // ----------------------------------------------------------------------------
 
@@ -342,9 +382,10 @@ bool UART_RXBytes() {
     if (g_transceiver.found_expected_length) {
       if (g_transceiver.data_index == g_transceiver.expected_length) {
         // We've got enough data to move on
+        PLIB_TMR_Stop(g_hw_settings.timer_module_id);
         PLIB_USART_ReceiverDisable(g_hw_settings.usart);
         ResetToMark();
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
       }
     } else {
       if (g_transceiver.data_index >= 3u) {
@@ -460,7 +501,8 @@ static inline void FrameComplete() {
     g_transceiver.result,
     data,
     length,
-    &g_timing
+    &g_timing,
+    g_transceiver.frame_start
   };
   RunTXEventHandler(&event);
 }
@@ -476,7 +518,8 @@ static inline void RXFrameEvent() {
         T_RESULT_RX_CONTINUE_FRAME,
     g_transceiver.active->data,
     g_transceiver.data_index,
-    &g_timing
+    &g_timing,
+    g_transceiver.frame_start
   };
   RunRXEventHandler(&event);
 }
@@ -491,7 +534,8 @@ static inline void RXEndFrameEvent() {
     T_RESULT_RX_FRAME_TIMEOUT,
     g_transceiver.active->data,
     g_transceiver.data_index,
-    &g_timing
+    &g_timing,
+    g_transceiver.frame_start
   };
   RunRXEventHandler(&event);
 }
@@ -503,15 +547,15 @@ static void SwitchMode() {
   switch (g_transceiver.mode) {
     case T_MODE_CONTROLLER:
       SysLog_Message(SYSLOG_INFO, "Changed to Controller mode");
-      g_transceiver.state = STATE_C_INITIALIZE;
+      SetState(STATE_C_INITIALIZE);
       break;
     case T_MODE_RESPONDER:
       SysLog_Message(SYSLOG_INFO, "Changed to Responder mode");
-      g_transceiver.state = STATE_R_INITIALIZE;
+      SetState(STATE_R_INITIALIZE);
       break;
     case T_MODE_SELF_TEST:
       SysLog_Message(SYSLOG_INFO, "Changed to self-test mode");
-      g_transceiver.state = STATE_T_INITIALIZE;
+      SetState(STATE_T_INITIALIZE);
       break;
     default:
       SysLog_Print(SYSLOG_INFO, "Unknown mode: %d",
@@ -526,7 +570,8 @@ static void SwitchMode() {
       T_RESULT_CANCELLED,
       NULL,
       0,
-      &g_timing
+      &g_timing,
+      0u
     };
     RunTXEventHandler(&event);
   }
@@ -536,7 +581,7 @@ static void SwitchMode() {
       g_transceiver.mode_change_token,
       T_OP_MODE_CHANGE,
       T_RESULT_OK,
-      NULL, 0, NULL
+      NULL, 0, NULL, 0u
     };
     RunTXEventHandler(&event);
     g_transceiver.mode_change_token = TRANSCEIVER_NO_NOTIFICATION;
@@ -548,7 +593,7 @@ static inline void PrepareRDMResponse() {
   // Rebase the timer to when the last byte was received
   RebaseTimer(g_transceiver.last_byte);
 
-  g_transceiver.state = STATE_R_TX_WAITING;
+  SetState(STATE_R_TX_WAITING);
   PLIB_USART_ReceiverDisable(g_hw_settings.usart);
   PLIB_USART_TransmitterInterruptModeSelect(g_hw_settings.usart,
                                             USART_TRANSMIT_FIFO_EMPTY);
@@ -579,21 +624,12 @@ static inline void StartSendingRDMResponse() {
         g_transceiver.active->data[g_transceiver.data_index]);
     g_transceiver.data_index++;
   }
-  g_transceiver.state = STATE_R_TX_DATA;
+  SetState(STATE_R_TX_DATA);
 
   SYS_INT_SourceStatusClear(g_hw_settings.usart_tx_source);
   SYS_INT_SourceEnable(g_hw_settings.usart_tx_source);
 }
 
-static inline void LogStateChange() {
-  static TransceiverState last_state = STATE_RESET;
-
-  if (g_transceiver.state != last_state) {
-    SysLog_Print(SYSLOG_DEBUG, "Changed to %d", g_transceiver.state);
-    last_state = g_transceiver.state;
-  }
-}
-
 /*
  * @brief Reset the settings to their default values.
  */
@@ -614,26 +650,27 @@ static void ResetTimingSettings() {
  */
 void __ISR(AS_IC_ISR_VECTOR(TRANSCEIVER_IC), ipl6AUTO)
     InputCaptureEvent(void) {
+  ISR_PROFILER_ENTER();
   while (!PLIB_IC_BufferIsEmpty(g_hw_settings.input_capture_module)) {
     uint16_t value = PLIB_IC_Buffer16BitGet(g_hw_settings.input_capture_module);
     switch (g_transceiver.state) {
       case STATE_C_RX_WAIT_FOR_DUB:
         g_timing.dub_response.start = value;
-        g_transceiver.state = STATE_C_RX_IN_DUB;
+        SetState(STATE_C_RX_IN_DUB);
         break;
       case STATE_C_RX_IN_DUB:
         g_timing.dub_response.end = value;
         break;
       case STATE_C_RX_WAIT_FOR_BREAK:
         g_timing.get_set_response.break_start = value;
-        g_transceiver.state = STATE_C_RX_IN_BREAK;
+        SetState(STATE_C_RX_IN_BREAK);
         break;
       case STATE_C_RX_IN_BREAK:
         if ((uint16_t) (value - g_timing.get_set_response.break_start) <
             CONTROLLER_RX_BREAK_TIME_MIN) {
           // The break was too short, keep looking for a break
           g_timing.get_set_response.break_start = value;
-          g_transceiver.state = STATE_C_RX_WAIT_FOR_BREAK;
+          SetState(STATE_C_RX_WAIT_FOR_BREAK);
         } else {
           g_timing.get_set_response.mark_start = value;
           // Break was good, enable UART
@@ -642,20 +679,21 @@ void __ISR(AS_IC_ISR_VECTOR(TRANSCEIVER_IC), ipl6AUTO)
           SYS_INT_SourceStatusClear(g_hw_settings.usart_error_source);
           SYS_INT_SourceEnable(g_hw_settings.usart_error_source);
           PLIB_USART_ReceiverEnable(g_hw_settings.usart);
-          g_transceiver.state = STATE_C_RX_IN_MARK;
+          SetState(STATE_C_RX_IN_MARK);
         }
         break;
       case STATE_C_RX_IN_MARK:
         g_timing.get_set_response.mark_end = value;
         SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
         PLIB_IC_Disable(g_hw_settings.input_capture_module);
-        g_transceiver.state = STATE_C_RX_DATA;
+        SetState(STATE_C_RX_DATA);
         break;
 
       case STATE_R_RX_MBB:
+        g_transceiver.frame_start = CaptureToTimestamp(value);
         // Rebase the timer to when the falling edge occurred.
         RebaseTimer(value);
-        g_transceiver.state = STATE_R_RX_BREAK;
+        SetState(STATE_R_RX_BREAK);
         break;
       case STATE_R_RX_BREAK:
         if (value >= RESPONDER_RX_BREAK_TIME_MIN &&
@@ -665,10 +703,10 @@ void __ISR(AS_IC_ISR_VECTOR(TRANSCEIVER_IC), ipl6AUTO)
           SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
           SYS_INT_SourceEnable(g_hw_settings.usart_rx_source);
           PLIB_USART_ReceiverEnable(g_hw_settings.usart);
-          g_transceiver.state = STATE_R_RX_MARK;
+          SetState(STATE_R_RX_MARK);
         } else {
           // Break was out of range.
-          g_transceiver.state = STATE_R_RX_MBB;
+          SetState(STATE_R_RX_MBB);
         }
         break;
       case STATE_R_RX_MARK:
@@ -683,10 +721,10 @@ void __ISR(AS_IC_ISR_VECTOR(TRANSCEIVER_IC), ipl6AUTO)
           PLIB_USART_ReceiverDisable(g_hw_settings.usart);
           SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
           SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
-          g_transceiver.state = STATE_R_RX_BREAK;
+          SetState(STATE_R_RX_BREAK);
         } else {
           g_timing.request.mark_time = value - g_timing.request.break_time;
-          g_transceiver.state = STATE_R_RX_DATA;
+          SetState(STATE_R_RX_DATA);
         }
         g_transceiver.last_change = value;
         break;
@@ -724,6 +762,7 @@ void __ISR(AS_IC_ISR_VECTOR(TRANSCEIVER_IC), ipl6AUTO)
     }
   }
   SYS_INT_SourceStatusClear(g_hw_settings.input_capture_source);
+  ISR_PROFILER_EXIT(ISR_PROFILER_TRANSCEIVER_IC);
 }
 
 /*
@@ -731,13 +770,14 @@ void __ISR(AS_IC_ISR_VECTOR(TRANSCEIVER_IC), ipl6AUTO)
  */
 void __ISR(AS_TIMER_ISR_VECTOR(TRANSCEIVER_TIMER), ipl6AUTO)
     Transceiver_TimerEvent() {
+  ISR_PROFILER_ENTER();
   switch (g_transceiver.state) {
     case STATE_C_IN_BREAK:
     case STATE_R_TX_BREAK:
       // Transition to MAB.
       SetMark();
-      g_transceiver.state = g_transceiver.state == STATE_C_IN_BREAK ?
-          STATE_C_IN_MARK : STATE_R_TX_MARK;
+      SetState(g_transceiver.state == STATE_C_IN_BREAK ?
+               STATE_C_IN_MARK : STATE_R_TX_MARK);
       PLIB_TMR_Counter16BitClear(g_hw_settings.timer_module_id);
       PLIB_TMR_Period16BitSet(g_hw_settings.timer_module_id,
                               g_timing_settings.mark_ticks);
@@ -759,12 +799,15 @@ void __ISR(AS_TIMER_ISR_VECTOR(TRANSCEIVER_TIMER), ipl6AUTO)
       }
       PLIB_USART_Enable(g_hw_settings.usart);
       PLIB_USART_TransmitterEnable(g_hw_settings.usart);
-      g_transceiver.state = STATE_C_TX_DATA;
+      SetState(STATE_C_TX_DATA);
       SYS_INT_SourceStatusClear(g_hw_settings.usart_tx_source);
       SYS_INT_SourceEnable(g_hw_settings.usart_tx_source);
       break;
     case STATE_R_TX_WAITING:
       EnableTX();
+      // This runs in the timer ISR, the controller frames are counted in
+      // Transceiver_Tasks().
+      Metrics_Increment(METRIC_RDM_RESPONSES_SENT);
 
       if (g_transceiver.active->op == OP_RDM_WITH_RESPONSE) {
         SetBreak();
@@ -775,7 +818,7 @@ void __ISR(AS_TIMER_ISR_VECTOR(TRANSCEIVER_TIMER), ipl6AUTO)
         PLIB_TMR_Period16BitSet(g_hw_settings.timer_module_id,
                                 g_timing_settings.break_ticks);
         PLIB_TMR_Start(g_hw_settings.timer_module_id);
-        g_transceiver.state = STATE_R_TX_BREAK;
+        SetState(STATE_R_TX_BREAK);
       } else {
         SYS_INT_SourceDisable(g_hw_settings.timer_source);
         StartSendingRDMResponse();
@@ -822,6 +865,7 @@ void __ISR(AS_TIMER_ISR_VECTOR(TRANSCEIVER_TIMER), ipl6AUTO)
       {}
   }
   SYS_INT_SourceStatusClear(g_hw_settings.timer_source);
+  ISR_PROFILER_EXIT(ISR_PROFILER_TRANSCEIVER_TIMER);
 }
 
 /*
@@ -834,6 +878,7 @@ void __ISR(AS_TIMER_ISR_VECTOR(TRANSCEIVER_TIMER), ipl6AUTO)
  */
 void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
     Transceiver_UARTEvent() {
+  ISR_PROFILER_ENTER();
   // TX
   if (SYS_INT_SourceStatusGet(g_hw_settings.usart_tx_source)) {
     if (g_transceiver.state == STATE_C_TX_DATA) {
@@ -841,7 +886,7 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
       if (g_transceiver.data_index == g_transceiver.active->size) {
         PLIB_USART_TransmitterInterruptModeSelect(
             g_hw_settings.usart, USART_TRANSMIT_FIFO_IDLE);
-        g_transceiver.state = STATE_C_TX_DRAIN;
+        SetState(STATE_C_TX_DRAIN);
       }
     } else if (g_transceiver.state == STATE_C_TX_DRAIN) {
       // The last byte has been transmitted. This event occurs around 1.5us
@@ -862,11 +907,11 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
         PLIB_USART_Disable(g_hw_settings.usart);
         SetMark();
         PLIB_TMR_Stop(g_hw_settings.timer_module_id);
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
       } else {
         // Switch to RX Mode.
         if (g_transceiver.active->op == OP_RDM_DUB) {
-          g_transceiver.state = STATE_C_RX_WAIT_FOR_DUB;
+          SetState(STATE_C_RX_WAIT_FOR_DUB);
           g_transceiver.data_index = 0u;
 
           // Turn around the line
@@ -890,14 +935,14 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
           // Go directly to the complete state.
           PLIB_TMR_Stop(g_hw_settings.timer_module_id);
           g_transceiver.data_index = 0u;
-          g_transceiver.state = STATE_C_COMPLETE;
+          SetState(STATE_C_COMPLETE);
         } else {
           // Either T_OP_RDM_WITH_RESPONSE or a non-0 broadcast listen time.
           g_transceiver.rdm_response_timeout = (
               g_transceiver.active->op == OP_RDM_BROADCAST ?
               g_timing_settings.rdm_broadcast_timeout :
               g_timing_settings.rdm_response_timeout);
-          g_transceiver.state = STATE_C_RX_WAIT_FOR_BREAK;
+          SetState(STATE_C_RX_WAIT_FOR_BREAK);
           g_transceiver.data_index = 0u;
 
           EnableRX();
@@ -915,13 +960,13 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
       if (g_transceiver.data_index == g_transceiver.active->size) {
         PLIB_USART_TransmitterInterruptModeSelect(
             g_hw_settings.usart, USART_TRANSMIT_FIFO_IDLE);
-        g_transceiver.state = STATE_R_TX_DRAIN;
+        SetState(STATE_R_TX_DRAIN);
       }
     } else if (g_transceiver.state == STATE_R_TX_DRAIN) {
       EnableRX();
       SYS_INT_SourceDisable(g_hw_settings.usart_tx_source);
       PLIB_USART_TransmitterDisable(g_hw_settings.usart);
-      g_transceiver.state = STATE_R_TX_COMPLETE;
+      SetState(STATE_R_TX_COMPLETE);
     } else if (g_transceiver.state == STATE_T_RX_WAIT) {
       PLIB_USART_TransmitterDisable(g_hw_settings.usart);
     }
@@ -946,7 +991,7 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
        SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
        PLIB_USART_ReceiverDisable(g_hw_settings.usart);
        ResetToMark();
-       g_transceiver.state = STATE_C_COMPLETE;
+       SetState(STATE_C_COMPLETE);
      }
     } else if (g_transceiver.state == STATE_R_RX_DATA) {
       if (PLIB_USART_ErrorsGet(g_hw_settings.usart) & USART_ERROR_FRAMING) {
@@ -958,17 +1003,17 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
         RebaseTimer(g_transceiver.last_change);
         g_transceiver.data_index = 0u;
         g_transceiver.event_index = 0u;
-        g_transceiver.state = STATE_R_RX_BREAK;
+        SetState(STATE_R_RX_BREAK);
       } else if (UART_RXBytes()) {
         // RX buffer is full.
         SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
         SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
         PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-        g_transceiver.state = STATE_R_TX_COMPLETE;
+        SetState(STATE_R_TX_COMPLETE);
       }
     } else if (g_transceiver.state == STATE_T_RX_WAIT) {
       UART_RXBytes();
-      g_transceiver.state = STATE_T_VERIFY;
+      SetState(STATE_T_VERIFY);
     }
     SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
   }
@@ -986,7 +1031,7 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
         SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
         PLIB_USART_ReceiverDisable(g_hw_settings.usart);
         ResetToMark();
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
         break;
       case STATE_R_RX_DATA:
         // This is probably a new break
@@ -994,7 +1039,7 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
         SYS_INT_SourceDisable(g_hw_settings.usart_error_source);
         PLIB_USART_ReceiverDisable(g_hw_settings.usart);
         RebaseTimer(g_transceiver.last_change);
-        g_transceiver.state = STATE_R_RX_BREAK;
+        SetState(STATE_R_RX_BREAK);
         break;
 
       case STATE_C_INITIALIZE:
@@ -1032,6 +1077,7 @@ void __ISR(AS_USART_ISR_VECTOR(TRANSCEIVER_UART), ipl6AUTO)
     }
     SYS_INT_SourceStatusClear(g_hw_settings.usart_error_source);
   }
+  ISR_PROFILER_EXIT(ISR_PROFILER_TRANSCEIVER_UART);
 }
 
 // Public API Functions
@@ -1043,10 +1089,12 @@ void Transceiver_Initialize(const TransceiverHardwareSettings* settings,
   g_tx_callback = tx_callback;
   g_rx_callback = rx_callback;
 
-  g_transceiver.state = STATE_R_INITIALIZE;
+  TransceiverTrace_Initialize();
+  SetState(STATE_R_INITIALIZE);
   g_transceiver.mode = T_MODE_RESPONDER;
   g_transceiver.desired_mode = T_MODE_RESPONDER;
   g_transceiver.data_index = 0u;
+  g_transceiver.frame_start = 0u;
   g_transceiver.mode_change_token = TRANSCEIVER_NO_NOTIFICATION;
 
   InitializeBuffers();
@@ -1144,7 +1192,6 @@ TransceiverMode Transceiver_GetMode() {
 
 void Transceiver_Tasks() {
   bool ok;
-  LogStateChange();
 
   switch (g_transceiver.state) {
     // Controller States
@@ -1155,7 +1202,7 @@ void Transceiver_Tasks() {
       PLIB_USART_Disable(g_hw_settings.usart);
       PLIB_IC_Disable(g_hw_settings.input_capture_module);
       ResetToMark();
-      g_transceiver.state = STATE_C_TX_READY;
+      SetState(STATE_C_TX_READY);
       // Fall through
     case STATE_C_TX_READY:
       if (g_transceiver.desired_mode != T_MODE_CONTROLLER) {
@@ -1187,10 +1234,12 @@ void Transceiver_Tasks() {
                                                 USART_TRANSMIT_FIFO_EMPTY);
 
       // Set break and start timer.
-      g_transceiver.state = STATE_C_IN_BREAK;
+      SetState(STATE_C_IN_BREAK);
       PLIB_TMR_PrescaleSelect(g_hw_settings.timer_module_id,
                               TMR_PRESCALE_VALUE_1);
       g_transceiver.tx_frame_start = CoarseTimer_GetTime();
+      g_transceiver.frame_start = Timestamp_Now();
+      Metrics_Increment(METRIC_TX_FRAMES);
       PLIB_TMR_Counter16BitClear(g_hw_settings.timer_module_id);
       PLIB_TMR_Period16BitSet(g_hw_settings.timer_module_id,
                               g_timing_settings.break_ticks);
@@ -1220,7 +1269,7 @@ void Transceiver_Tasks() {
         PLIB_TMR_Stop(g_hw_settings.timer_module_id);
         PLIB_USART_ReceiverDisable(g_hw_settings.usart);
         ResetToMark();
-        g_transceiver.state = STATE_C_RX_TIMEOUT;
+        SetState(STATE_C_RX_TIMEOUT);
       }
       break;
 
@@ -1233,9 +1282,10 @@ void Transceiver_Tasks() {
             CONTROLLER_RX_BREAK_TIME_MAX)) {
         // Break was too long
         g_transceiver.result = T_RESULT_RX_INVALID;
+        Metrics_Increment(METRIC_RDM_INVALID_RESPONSES);
         PLIB_TMR_Stop(g_hw_settings.timer_module_id);
         ResetToMark();
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
         return;
       }
       SYS_INT_SourceEnable(g_hw_settings.input_capture_source);
@@ -1249,9 +1299,10 @@ void Transceiver_Tasks() {
             CONTROLLER_RX_MARK_TIME_MAX)) {
         // Break was too long
         g_transceiver.result = T_RESULT_RX_INVALID;
+        Metrics_Increment(METRIC_RDM_INVALID_RESPONSES);
         PLIB_TMR_Stop(g_hw_settings.timer_module_id);
         ResetToMark();
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
         return;
       }
       SYS_INT_SourceEnable(g_hw_settings.input_capture_source);
@@ -1278,7 +1329,7 @@ void Transceiver_Tasks() {
         PLIB_TMR_Stop(g_hw_settings.timer_module_id);
         PLIB_USART_ReceiverDisable(g_hw_settings.usart);
         ResetToMark();
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
         return;
       }
       SYS_INT_SourceEnable(g_hw_settings.usart_rx_source);
@@ -1297,7 +1348,7 @@ void Transceiver_Tasks() {
         PLIB_USART_ReceiverDisable(g_hw_settings.usart);
         PLIB_TMR_Stop(g_hw_settings.timer_module_id);
         ResetToMark();
-        g_transceiver.state = STATE_C_RX_TIMEOUT;
+        SetState(STATE_C_RX_TIMEOUT);
       }
       break;
     case STATE_C_RX_IN_DUB:
@@ -1315,14 +1366,15 @@ void Transceiver_Tasks() {
         ResetToMark();
         // We got at least a falling edge, so this should probably be
         // considered a collision, rather than a timeout.
-        g_transceiver.state = STATE_C_COMPLETE;
+        SetState(STATE_C_COMPLETE);
       }
       break;
 
     case STATE_C_RX_TIMEOUT:
       SysLog_Message(SYSLOG_INFO, "RX timeout");
-      g_transceiver.state = STATE_C_COMPLETE;
+      SetState(STATE_C_COMPLETE);
       g_transceiver.result = T_RESULT_RX_TIMEOUT;
+      Metrics_Increment(METRIC_RDM_TIMEOUTS);
       break;
     case STATE_C_COMPLETE:
       if (g_transceiver.active->op == OP_RDM_DUB) {
@@ -1342,7 +1394,7 @@ void Transceiver_Tasks() {
                       g_timing.get_set_response.mark_start));
       }
       FrameComplete();
-      g_transceiver.state = STATE_C_BACKOFF;
+      SetState(STATE_C_BACKOFF);
       // Fall through
     case STATE_C_BACKOFF:
       // From E1.11, the min break-to-break time is 1.204ms.
@@ -1389,7 +1441,7 @@ void Transceiver_Tasks() {
 
       if (ok) {
         FreeActiveBuffer();
-        g_transceiver.state = STATE_C_TX_READY;
+        SetState(STATE_C_TX_READY);
       }
       break;
 
@@ -1419,7 +1471,7 @@ void Transceiver_Tasks() {
       if (!g_transceiver.active) {
         if (g_transceiver.free_size == 0u) {
           SysLog_Message(SYSLOG_INFO, "Lost buffers!");
-          g_transceiver.state = STATE_ERROR;
+          SetState(STATE_ERROR);
           return;
         }
 
@@ -1434,7 +1486,7 @@ void Transceiver_Tasks() {
       g_transceiver.event_index = 0u;
       g_transceiver.active->op = OP_RX;
 
-      g_transceiver.state = STATE_R_RX_MBB;
+      SetState(STATE_R_RX_MBB);
 
       // Catch the next falling edge.
       SYS_INT_SourceDisable(g_hw_settings.input_capture_source);
@@ -1482,7 +1534,7 @@ void Transceiver_Tasks() {
           // RDM inter-slot timeout
           RXEndFrameEvent();
           PLIB_USART_ReceiverDisable(g_hw_settings.usart);
-          g_transceiver.state = STATE_R_RX_PREPARE;
+          SetState(STATE_R_RX_PREPARE);
           break;
         }
       }
@@ -1518,7 +1570,7 @@ void Transceiver_Tasks() {
       PLIB_TMR_Period16BitSet(g_hw_settings.timer_module_id, 65535u);
       PLIB_TMR_Start(g_hw_settings.timer_module_id);
       g_transceiver.data_index = 0u;
-      g_transceiver.state = STATE_R_RX_PREPARE;
+      SetState(STATE_R_RX_PREPARE);
       break;
 
     // Self Test States
@@ -1541,7 +1593,7 @@ void Transceiver_Tasks() {
                         g_hw_settings.port,
                         g_hw_settings.tx_enable_bit);
 
-      g_transceiver.state = STATE_T_TX_READY;
+      SetState(STATE_T_TX_READY);
       // Fall through
     case STATE_T_TX_READY:
       if (g_transceiver.desired_mode != T_MODE_SELF_TEST) {
@@ -1554,7 +1606,7 @@ void Transceiver_Tasks() {
       TakeNextBuffer();
       g_transceiver.data_index = 0;
       g_transceiver.tx_frame_start = CoarseTimer_GetTime();
-      g_transceiver.state = STATE_T_RX_WAIT;
+      SetState(STATE_T_RX_WAIT);
 
       SYS_INT_SourceStatusClear(g_hw_settings.usart_rx_source);
       SYS_INT_SourceEnable(g_hw_settings.usart_rx_source);
@@ -1566,7 +1618,7 @@ void Transceiver_Tasks() {
       if (CoarseTimer_HasElapsed(g_transceiver.tx_frame_start,
                                  SELF_TEST_TIMEOUT)) {
         SYS_INT_SourceDisable(g_hw_settings.usart_rx_source);
-        g_transceiver.state = STATE_T_VERIFY;
+        SetState(STATE_T_VERIFY);
       }
       break;
     case STATE_T_VERIFY:
@@ -1582,7 +1634,7 @@ void Transceiver_Tasks() {
       g_transceiver.data_index = 0;
       FrameComplete();
       FreeActiveBuffer();
-      g_transceiver.state = STATE_T_TX_READY;
+      SetState(STATE_T_TX_READY);
       break;
 
     case STATE_RESET:
@@ -1737,7 +1789,7 @@ void Transceiver_Reset() {
   // Set us back into the TX Mark state.
   ResetToMark();
 
-  g_transceiver.state = STATE_RESET;
+  SetState(STATE_RESET);
 }
 
 bool Transceiver_SetBreakTime(uint16_t break_time_us) {
@@ -80,6 +80,7 @@
 
 #include "iovec.h"
 #include "system_config.h"
+#include "timestamp.h"
 #include "peripheral/ic/plib_ic.h"
 #include "peripheral/ports/plib_ports.h"
 #include "peripheral/tmr/plib_tmr.h"
@@ -231,6 +232,15 @@ typedef struct {
    * This may be NULL, if no timing information was available.
    */
   TransceiverTiming *timing;
+
+  /**
+   * @brief The time the frame started.
+   *
+   * For operations in controller mode, this is the start of the break we
+   * sent. For received frames, this is the falling edge of the break. It's 0
+   * if the operation didn't involve a frame.
+   */
+  Timestamp timestamp;
 } TransceiverEvent;
 
 /**
@@ -0,0 +1,81 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * transceiver_trace.c
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "transceiver_trace.h"
+
+#include <string.h>
+
+#include "core_timer.h"
+
+typedef struct {
+  TransceiverTraceEvent events[TRANSCEIVER_TRACE_SIZE];
+
+  /*
+   * The total number of events written and read. Events are recorded from
+   * the main loop and from the transceiver ISRs, so a slot is reserved with an
+   * atomic increment of written. Only the reader updates read.
+   */
+  volatile uint32_t written;
+  uint32_t read;
+} TraceBuffer;
+
+static TraceBuffer g_trace;
+
+void TransceiverTrace_Initialize() {
+  memset(&g_trace, 0, sizeof(g_trace));
+}
+
+void TransceiverTrace_Record(uint8_t state, uint8_t op, int16_t token,
+                             uint16_t data_index) {
+  // If an ISR records an event while the main loop is part way through this,
+  // the two events get different slots. The reader runs in the main loop, so
+  // it never sees a reserved slot before it's filled.
+  const uint32_t slot =
+      __atomic_fetch_add(&g_trace.written, 1u, __ATOMIC_RELAXED);
+  TransceiverTraceEvent *event =
+      &g_trace.events[slot & (TRANSCEIVER_TRACE_SIZE - 1u)];
+  event->time = CoreTimer_GetCount();
+  event->token = token;
+  event->data_index = data_index;
+  event->state = state;
+  event->op = op;
+}
+
+unsigned int TransceiverTrace_Peek(const TransceiverTraceEvent **events,
+                                   uint32_t *dropped) {
+  const uint32_t written = g_trace.written;
+  *dropped = 0u;
+  if (written - g_trace.read > TRANSCEIVER_TRACE_SIZE) {
+    // Skip the events that have been overwritten.
+    *dropped = written - g_trace.read - TRANSCEIVER_TRACE_SIZE;
+    g_trace.read = written - TRANSCEIVER_TRACE_SIZE;
+  }
+
+  const unsigned int offset = g_trace.read & (TRANSCEIVER_TRACE_SIZE - 1u);
+  unsigned int count = written - g_trace.read;
+  if (offset + count > TRANSCEIVER_TRACE_SIZE) {
+    count = TRANSCEIVER_TRACE_SIZE - offset;
+  }
+  *events = &g_trace.events[offset];
+  return count;
+}
+
+void TransceiverTrace_Consume(unsigned int count) {
+  g_trace.read += count;
+}
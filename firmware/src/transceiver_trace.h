@@ -0,0 +1,129 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * transceiver_trace.h
+ * Copyright (C) 2015 Simon Newton
+ */
+
+/**
+ * @defgroup transceiver_trace Transceiver Trace
+ * @brief A binary trace of the transceiver state changes.
+ *
+ * Each time the transceiver changes state, it records an event containing
+ * the time, the new state and the current operation. The events are stored
+ * in a ring buffer, once it's full the oldest events are overwritten.
+ *
+ * Recording an event is a handful of stores, so unlike logging to the syslog
+ * it doesn't change the timing of the break, mark and turnaround periods
+ * being observed.
+ *
+ * Events are recorded from both the main loop and the transceiver ISRs.
+ *
+ * The host reads the trace with the @ref message-commands-gettrace command.
+ * Reading is done in the main loop while the ISRs are recording, so an event
+ * that is overwritten during the read may be corrupt. This is only possible
+ * once the buffer has overflowed, which is reported in the dropped count.
+ *
+ * @addtogroup transceiver_trace
+ * @{
+ * @file transceiver_trace.h
+ * @brief A binary trace of the transceiver state changes.
+ */
+
+#ifndef FIRMWARE_SRC_TRANSCEIVER_TRACE_H_
+#define FIRMWARE_SRC_TRANSCEIVER_TRACE_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief The number of events in the trace buffer, must be a power of 2.
+ */
+#define TRANSCEIVER_TRACE_SIZE 128u
+
+/**
+ * @brief The op value used when there is no operation in progress.
+ */
+#define TRANSCEIVER_TRACE_NO_OP 0xffu
+
+/**
+ * @brief A trace event.
+ */
+typedef struct {
+  /**
+   * @brief The core timer count when the event was recorded.
+   *
+   * This is the low 32 bits of the Timestamp, each count is 25ns.
+   */
+  uint32_t time;
+  int16_t token;  //!< The token of the operation.
+  uint16_t data_index;  //!< The number of bytes sent or received.
+  uint8_t state;  //!< The new state of the transceiver.
+  uint8_t op;  //!< The current operation, or TRANSCEIVER_TRACE_NO_OP.
+  uint16_t reserved;  //!< Always 0.
+} TransceiverTraceEvent;
+
+/**
+ * @brief Clear the trace.
+ */
+void TransceiverTrace_Initialize();
+
+/**
+ * @brief Record an event.
+ * @param state The new state.
+ * @param op The current operation, or TRANSCEIVER_TRACE_NO_OP.
+ * @param token The token of the current operation.
+ * @param data_index The number of bytes sent or received.
+ *
+ * This may be called from the transceiver ISRs or tasks, but not both at once.
+ * The transceiver state machine already ensures this, since only one context
+ * changes the state at a time.
+ */
+void TransceiverTrace_Record(uint8_t state, uint8_t op, int16_t token,
+                             uint16_t data_index);
+
+/**
+ * @brief Get the oldest unread events.
+ * @param[out] events A pointer to the oldest unread event.
+ * @param[out] dropped The number of events that were overwritten before they
+ *   were read.
+ * @returns The number of unread events that are contiguous in memory,
+ *   starting from events. This is less than the total number of unread events
+ *   if the unread events wrap around the end of the buffer.
+ *
+ * The dropped count is reset by this call.
+ */
+unsigned int TransceiverTrace_Peek(const TransceiverTraceEvent **events,
+                                   uint32_t *dropped);
+
+/**
+ * @brief Mark events as read.
+ * @param count The number of events to mark as read, this must be no more
+ *   than the number returned by TransceiverTrace_Peek().
+ */
+void TransceiverTrace_Consume(unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FIRMWARE_SRC_TRANSCEIVER_TRACE_H_
+
+/**
+ * @}
+ */
@@ -28,6 +28,7 @@
 #include "dfu_spec.h"
 #include "flags.h"
 #include "macros.h"
+#include "metrics.h"
 #include "reset.h"
 #include "stream_decoder.h"
 #include "system_config.h"
@@ -292,6 +293,7 @@ void USBTransport_Tasks() {
         // We have received data.
         if (g_usb_transport_data.tx_in_progress == false) {
           // we only go ahead and process the data if we can respond.
+          Metrics_Increment(METRIC_USB_RX_TRANSFERS);
 #ifdef PIPELINE_TRANSPORT_RX
           PIPELINE_TRANSPORT_RX(receivedDataBuffer,
                                 g_usb_transport_data.rx_data_size);
@@ -336,8 +338,12 @@ void USBTransport_Tasks() {
 
 bool USBTransport_SendResponse(uint8_t token, Command command, uint8_t rc,
                                const IOVec* data, unsigned int iov_count) {
-  if (g_usb_transport_data.tx_in_progress ||
-      g_usb_transport_data.state != USB_STATE_MAIN_TASK) {
+  if (g_usb_transport_data.state != USB_STATE_MAIN_TASK) {
+    return false;
+  }
+
+  if (g_usb_transport_data.tx_in_progress) {
+    Metrics_Increment(METRIC_USB_TX_DROPS);
     return false;
   }
 
@@ -381,8 +387,11 @@ bool USBTransport_SendResponse(uint8_t token, Command command, uint8_t rc,
       g_usb_transport_data.tx_endpoint, transmitDataBuffer,
       offset + 9,
       USB_DEVICE_TRANSFER_FLAGS_DATA_COMPLETE);
-  if (result != USB_DEVICE_RESULT_OK) {
+  if (result == USB_DEVICE_RESULT_OK) {
+    Metrics_Increment(METRIC_USB_TX_MESSAGES);
+  } else {
     g_usb_transport_data.tx_in_progress = false;
+    Metrics_Increment(METRIC_USB_TX_ERRORS);
   }
   return result == USB_DEVICE_RESULT_OK;
 }
@@ -1,3 +1,4 @@
+include tests/bench/Makefile.mk
 include tests/harmony/Makefile.mk
 include tests/mocks/Makefile.mk
 include tests/sim/Makefile.mk
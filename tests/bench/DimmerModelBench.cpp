@@ -0,0 +1,150 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DimmerModelBench.cpp
+ * Benchmarks for the dimmer model's output engine.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <arpa/inet.h>
+#include <string.h>
+#include <vector>
+
+#include "app_settings.h"
+#include "coarse_timer.h"
+#include "constants.h"
+#include "dimmer_model.h"
+#include "dmx_spec.h"
+#include "rdm.h"
+#include "rdm_frame.h"
+#include "rdm_model.h"
+#include "rdm_responder.h"
+#include "rdm_util.h"
+#include "timer_wheel.h"
+
+using std::vector;
+
+static_assert(DIMMER_SUB_DEVICE_COUNT == SUBDEVICE_MAX,
+              "Benchmark the dimmer with the full set of sub devices");
+
+namespace {
+
+const uint8_t kControllerUID[UID_LENGTH] = {0x7a, 0x70, 0, 0, 0, 0};
+const uint8_t kOurUID[UID_LENGTH] = {0x7a, 0x70, 0x12, 0x34, 0x56, 0x78};
+
+// The dimmer's output tick, in 10ths of a millisecond.
+const uint32_t kTickInterval = 100u;
+
+// Restart the preset fade before it completes.
+const unsigned int kFadeRestartTicks = 5000u;
+
+void SendSet(uint16_t pid, const uint8_t *param_data,
+             uint8_t param_data_length) {
+  vector<uint8_t> frame(sizeof(RDMHeader) + param_data_length +
+                        RDM_CHECKSUM_LENGTH);
+  RDMHeader *header = reinterpret_cast<RDMHeader*>(frame.data());
+  header->start_code = RDM_START_CODE;
+  header->sub_start_code = RDM_SUB_START_CODE;
+  header->message_length = sizeof(RDMHeader) + param_data_length;
+  memcpy(header->dest_uid, kOurUID, UID_LENGTH);
+  memcpy(header->src_uid, kControllerUID, UID_LENGTH);
+  header->port_id = 1u;
+  header->sub_device = htons(SUBDEVICE_ROOT);
+  header->command_class = SET_COMMAND;
+  header->param_id = htons(pid);
+  header->param_data_length = param_data_length;
+  memcpy(frame.data() + sizeof(RDMHeader), param_data, param_data_length);
+  RDMUtil_AppendChecksum(frame.data());
+  DIMMER_MODEL_ENTRY.request_fn(header, frame.data() + sizeof(RDMHeader));
+}
+
+void ActivateDimmer() {
+  CoarseTimer_SetCounter(0u);
+  TimerWheel_Initialize();
+
+  RDMResponderSettings settings;
+  memset(&settings, 0, sizeof(settings));
+  memcpy(settings.uid, kOurUID, UID_LENGTH);
+  RDMResponder_Initialize(&settings);
+  DimmerModel_Initialize();
+  DIMMER_MODEL_ENTRY.activate_fn();
+}
+
+/*
+ * Capture the current DMX levels as scene 2, with 100s fades.
+ */
+void CapturePreset() {
+  const uint8_t capture_data[] = { 0, 2, 0x03, 0xe8, 0x03, 0xe8, 0, 0 };
+  SendSet(PID_CAPTURE_PRESET, capture_data, sizeof(capture_data));
+}
+
+void StartPresetFade() {
+  const uint8_t playback_data[] = { 0, 2, 0xff };
+  SendSet(PID_PRESET_PLAYBACK, playback_data, sizeof(playback_data));
+}
+
+}  // namespace
+
+/*
+ * Run one output tick per iteration, the way the main loop does: a DMX frame
+ * arrives, the clock moves on by a tick and the timer wheel runs the signal
+ * monitor, playback, merge and dimming engine for all the sub devices.
+ */
+static void BM_DimmerModelTick(benchmark::State &state, bool preset) {
+  ActivateDimmer();
+
+  // Alternate between two frames so the outputs are always moving.
+  vector<uint8_t> frames[2] = {
+    vector<uint8_t>(DMX_FRAME_SIZE), vector<uint8_t>(DMX_FRAME_SIZE)
+  };
+  for (unsigned int i = 0u; i < DMX_FRAME_SIZE; i++) {
+    frames[0][i] = i;
+    frames[1][i] = UINT8_MAX - i;
+  }
+  if (preset) {
+    // The preset overrides the DMX data, and fades from one frame to the
+    // other.
+    DIMMER_MODEL_ENTRY.dmx_fn(0u, frames[0].data(), DMX_FRAME_SIZE);
+    CapturePreset();
+    DIMMER_MODEL_ENTRY.dmx_fn(0u, frames[1].data(), DMX_FRAME_SIZE);
+    StartPresetFade();
+  }
+
+  CoarseTimer_Value now = 0u;
+  unsigned int ticks = 0u;
+  for (auto _ : state) {
+    DIMMER_MODEL_ENTRY.dmx_fn(0u, frames[ticks & 1u].data(), DMX_FRAME_SIZE);
+    now += kTickInterval;
+    CoarseTimer_SetCounter(now);
+    TimerWheel_Tasks();
+    DIMMER_MODEL_ENTRY.tasks_fn();
+    ticks++;
+    if (preset && ticks % kFadeRestartTicks == 0u) {
+      StartPresetFade();
+    }
+  }
+  benchmark::DoNotOptimize(DimmerModel_GetOutputLevel(1u));
+
+  DIMMER_MODEL_ENTRY.deactivate_fn();
+  state.SetItemsProcessed(state.iterations() * DIMMER_SUB_DEVICE_COUNT);
+  state.counters["sub_devices"] = DIMMER_SUB_DEVICE_COUNT;
+}
+
+BENCHMARK_CAPTURE(BM_DimmerModelTick, dmx, false);
+BENCHMARK_CAPTURE(BM_DimmerModelTick, preset_fade, true);
+
+BENCHMARK_MAIN();
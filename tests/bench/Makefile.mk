@@ -0,0 +1,99 @@
+# BENCHMARKS
+################################################
+# Run with 'make bench'. Extra flags can be passed to the benchmarks using
+# BENCHMARK_FLAGS, e.g. make bench BENCHMARK_FLAGS=--benchmark_format=json
+BENCHMARKS =
+
+if BUILD_BENCHMARKS
+BENCHMARKS += tests/bench/dimmer_model_bench \
+              tests/bench/rdm_responder_bench \
+              tests/bench/rdm_util_bench \
+              tests/bench/responder_bench \
+              tests/bench/stream_decoder_bench \
+              tests/bench/usb_transport_bench
+
+noinst_PROGRAMS += $(BENCHMARKS)
+
+BENCHMARK_CXXFLAGS = $(TESTING_CXXFLAGS) $(BENCHMARK_CFLAGS)
+
+# The dimmer is built with the same number of sub devices as the boards.
+tests_bench_dimmer_model_bench_SOURCES = tests/bench/DimmerModelBench.cpp
+tests_bench_dimmer_model_bench_CXXFLAGS = $(BENCHMARK_CXXFLAGS) \
+                                          -DDIMMER_SUB_DEVICE_COUNT=512
+tests_bench_dimmer_model_bench_LDADD = \
+    $(BENCHMARK_LIBS) $(TESTING_LIBS) \
+    firmware/src/libdimmermodel512.la \
+    firmware/src/librdmresponder.la \
+    firmware/src/libreceivercounters.la \
+    firmware/src/libcoarsetimer.la \
+    tests/mocks/libcoretimermock.la \
+    firmware/src/libtimerwheel.la \
+    firmware/src/librdmbuffer.la \
+    firmware/src/librdmutil.la \
+    tests/harmony/mocks/libharmonymock.la
+
+tests_bench_rdm_responder_bench_SOURCES = tests/bench/RDMResponderBench.cpp
+tests_bench_rdm_responder_bench_CXXFLAGS = $(BENCHMARK_CXXFLAGS)
+tests_bench_rdm_responder_bench_LDADD = \
+    $(BENCHMARK_LIBS) $(TESTING_LIBS) \
+    firmware/src/libdimmermodel.la \
+    firmware/src/libledmodel.la \
+    firmware/src/libmovinglightmodel.la \
+    firmware/src/libnetworkmodel.la \
+    firmware/src/libproxymodel.la \
+    firmware/src/libsensormodel.la \
+    firmware/src/librdmresponder.la \
+    firmware/src/libreceivercounters.la \
+    firmware/src/libcoarsetimer.la \
+    tests/mocks/libcoretimermock.la \
+    firmware/src/libtimerwheel.la \
+    firmware/src/librdmbuffer.la \
+    firmware/src/librandom.la \
+    firmware/src/librdmutil.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libspirgbmock.la
+
+tests_bench_rdm_util_bench_SOURCES = tests/bench/RDMUtilBench.cpp
+tests_bench_rdm_util_bench_CXXFLAGS = $(BENCHMARK_CXXFLAGS)
+tests_bench_rdm_util_bench_LDADD = $(BENCHMARK_LIBS) \
+                                   firmware/src/librdmutil.la
+
+tests_bench_responder_bench_SOURCES = tests/bench/ResponderBench.cpp
+tests_bench_responder_bench_CXXFLAGS = $(BENCHMARK_CXXFLAGS)
+# The mocks need gmock, so the testing libs go after them.
+tests_bench_responder_bench_LDADD = $(BENCHMARK_LIBS) \
+                                    firmware/src/libresponder.la \
+                                    firmware/src/librdmutil.la \
+                                    firmware/src/libreceivercounters.la \
+                                    firmware/src/libtimestamp.la \
+                                    tests/mocks/libcoretimermock.la \
+                                    tests/mocks/librdmhandlermock.la \
+                                    tests/mocks/libspirgbmock.la \
+                                    tests/mocks/libsyslogmock.la \
+                                    $(TESTING_LIBS)
+
+tests_bench_stream_decoder_bench_SOURCES = tests/bench/StreamDecoderBench.cpp
+tests_bench_stream_decoder_bench_CXXFLAGS = $(BENCHMARK_CXXFLAGS)
+tests_bench_stream_decoder_bench_LDADD = $(BENCHMARK_LIBS) \
+                                         firmware/src/libstreamdecoder.la \
+                                         firmware/src/libmetrics.la
+
+tests_bench_usb_transport_bench_SOURCES = tests/bench/USBTransportBench.cpp
+tests_bench_usb_transport_bench_CXXFLAGS = $(BENCHMARK_CXXFLAGS)
+tests_bench_usb_transport_bench_LDADD = \
+    $(BENCHMARK_LIBS) $(TESTING_LIBS) \
+    firmware/src/libusbtransport.la \
+    firmware/src/libmetrics.la \
+    firmware/src/libflags.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libbootloaderoptionsmock.la \
+    tests/mocks/libresetmock.la \
+    tests/mocks/libstreamdecodermock.la
+endif
+
+bench: $(BENCHMARKS)
+	@for bench in $(BENCHMARKS); do \
+	  ./$$bench $(BENCHMARK_FLAGS) || exit 1; \
+	done
+
+.PHONY: bench
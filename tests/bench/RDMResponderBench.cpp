@@ -0,0 +1,354 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * RDMResponderBench.cpp
+ * Benchmarks for the RDM responder and models.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <arpa/inet.h>
+#include <string.h>
+#include <vector>
+
+#include "constants.h"
+#include "dimmer_model.h"
+#include "led_model.h"
+#include "moving_light.h"
+#include "network_model.h"
+#include "proxy_model.h"
+#include "rdm.h"
+#include "rdm_frame.h"
+#include "rdm_model.h"
+#include "rdm_responder.h"
+#include "rdm_util.h"
+#include "sensor_model.h"
+#include "timer_wheel.h"
+
+using std::vector;
+
+namespace {
+
+const uint8_t kControllerUID[UID_LENGTH] = {0x7a, 0x70, 0, 0, 0, 0};
+const uint8_t kOurUID[UID_LENGTH] = {0x7a, 0x70, 0x12, 0x34, 0x56, 0x78};
+
+void InitializeResponder() {
+  TimerWheel_Initialize();
+
+  RDMResponderSettings settings;
+  memset(&settings, 0, sizeof(settings));
+  memcpy(settings.uid, kOurUID, UID_LENGTH);
+  RDMResponder_Initialize(&settings);
+}
+
+vector<uint8_t> BuildRequest(RDMCommandClass command_class, uint16_t pid,
+                             uint16_t sub_device = SUBDEVICE_ROOT,
+                             uint8_t uid_offset = 0u,
+                             uint8_t param_data_length = 0u) {
+  vector<uint8_t> frame(sizeof(RDMHeader) + param_data_length +
+                        RDM_CHECKSUM_LENGTH);
+  RDMHeader *header = reinterpret_cast<RDMHeader*>(frame.data());
+  header->start_code = RDM_START_CODE;
+  header->sub_start_code = RDM_SUB_START_CODE;
+  header->message_length = sizeof(RDMHeader) + param_data_length;
+  memcpy(header->dest_uid, kOurUID, UID_LENGTH);
+  header->dest_uid[UID_LENGTH - 1] += uid_offset;
+  memcpy(header->src_uid, kControllerUID, UID_LENGTH);
+  header->port_id = 1u;
+  header->sub_device = htons(sub_device);
+  header->command_class = command_class;
+  header->param_id = htons(pid);
+  header->param_data_length = param_data_length;
+  RDMUtil_AppendChecksum(frame.data());
+  return frame;
+}
+
+/*
+ * The number of table entries RDMResponder_DispatchPID() compares against
+ * when looking up a PID. This mirrors the binary search in rdm_responder.c.
+ */
+unsigned int LookupProbes(const ResponderDefinition *definition, uint16_t pid,
+                          bool *found) {
+  unsigned int lower = 0u;
+  unsigned int upper = definition->descriptor_count;
+  unsigned int probes = 0u;
+  *found = false;
+  while (lower < upper) {
+    unsigned int mid = lower + (upper - lower) / 2u;
+    uint16_t mid_pid = definition->descriptors[mid].pid;
+    probes++;
+    if (mid_pid == pid) {
+      *found = true;
+      break;
+    } else if (mid_pid < pid) {
+      lower = mid + 1u;
+    } else {
+      upper = mid;
+    }
+  }
+  return probes;
+}
+
+/*
+ * The GET-able descriptor with the longest lookup.
+ */
+const PIDDescriptor *WorstCaseDescriptor(
+    const ResponderDefinition *definition) {
+  const PIDDescriptor *worst = nullptr;
+  unsigned int worst_probes = 0u;
+  for (unsigned int i = 0u; i < definition->descriptor_count; i++) {
+    const PIDDescriptor *descriptor = &definition->descriptors[i];
+    bool found;
+    unsigned int probes = LookupProbes(definition, descriptor->pid, &found);
+    if (descriptor->get_handler && probes > worst_probes) {
+      worst = descriptor;
+      worst_probes = probes;
+    }
+  }
+  return worst;
+}
+
+/*
+ * The unsupported PID with the longest lookup. Each gap in the table is
+ * tried, including those before the first and after the last PID.
+ */
+uint16_t WorstCaseUnknownPID(const ResponderDefinition *definition) {
+  vector<uint16_t> candidates;
+  if (definition->descriptors[0].pid != 0u) {
+    candidates.push_back(definition->descriptors[0].pid - 1u);
+  }
+  for (unsigned int i = 0u; i < definition->descriptor_count; i++) {
+    candidates.push_back(definition->descriptors[i].pid + 1u);
+  }
+
+  uint16_t worst = 0u;
+  unsigned int worst_probes = 0u;
+  for (uint16_t pid : candidates) {
+    bool found;
+    unsigned int probes = LookupProbes(definition, pid, &found);
+    if (!found && probes > worst_probes) {
+      worst = pid;
+      worst_probes = probes;
+    }
+  }
+  return worst;
+}
+
+/*
+ * @brief How to address the responder using one of a model's
+ *   ResponderDefinitions.
+ */
+struct DispatchTarget {
+  const ModelEntry *model;
+  void (*initialize_fn)();
+  unsigned int definition;  // The index into model->definitions.
+  uint16_t sub_device;
+  uint8_t uid_offset;  // Added to the last byte of our UID.
+};
+
+const DispatchTarget kDimmerRoot = {
+  &DIMMER_MODEL_ENTRY, DimmerModel_Initialize, 0u, SUBDEVICE_ROOT, 0u
+};
+const DispatchTarget kDimmerSubDevice = {
+  &DIMMER_MODEL_ENTRY, DimmerModel_Initialize, 1u, 1u, 0u
+};
+const DispatchTarget kLED = {
+  &LED_MODEL_ENTRY, LEDModel_Initialize, 0u, SUBDEVICE_ROOT, 0u
+};
+const DispatchTarget kMovingLight = {
+  &MOVING_LIGHT_MODEL_ENTRY, MovingLightModel_Initialize, 0u, SUBDEVICE_ROOT,
+  0u
+};
+const DispatchTarget kNetwork = {
+  &NETWORK_MODEL_ENTRY, NetworkModel_Initialize, 0u, SUBDEVICE_ROOT, 0u
+};
+const DispatchTarget kProxyRoot = {
+  &PROXY_MODEL_ENTRY, ProxyModel_Initialize, 0u, SUBDEVICE_ROOT, 0u
+};
+// The first child's UID is one more than the proxy's.
+const DispatchTarget kProxyChild = {
+  &PROXY_MODEL_ENTRY, ProxyModel_Initialize, 1u, SUBDEVICE_ROOT, 1u
+};
+const DispatchTarget kSensor = {
+  &SENSOR_MODEL_ENTRY, SensorModel_Initialize, 0u, SUBDEVICE_ROOT, 0u
+};
+
+/*
+ * Send the same request to the model's request_fn on every iteration. This
+ * includes the model's routing to sub devices and child responders.
+ */
+void RunDispatch(benchmark::State &state, const DispatchTarget &target,
+                 const vector<uint8_t> &request, unsigned int probes) {
+  const RDMHeader *header = reinterpret_cast<const RDMHeader*>(request.data());
+  if (target.model->request_fn(header, request.data() + sizeof(RDMHeader)) ==
+      RDM_RESPONDER_NO_RESPONSE) {
+    target.model->deactivate_fn();
+    state.SkipWithError("The request wasn't answered");
+    return;
+  }
+
+  for (auto _ : state) {
+    int size = target.model->request_fn(header,
+                                        request.data() + sizeof(RDMHeader));
+    benchmark::DoNotOptimize(size);
+  }
+
+  target.model->deactivate_fn();
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * request.size());
+  state.counters["probes"] = probes;
+}
+
+const ResponderDefinition *ActivateTarget(const DispatchTarget &target) {
+  InitializeResponder();
+  target.initialize_fn();
+  target.model->activate_fn();
+  return target.model->definitions[target.definition];
+}
+
+}  // namespace
+
+/*
+ * Sweep over every GET the model's root device supports, one dispatch per
+ * iteration.
+ */
+static void BM_RDMResponderDispatchPID(benchmark::State &state,
+                                       const ModelEntry *model,
+                                       void (*initialize_fn)()) {
+  InitializeResponder();
+  initialize_fn();
+  model->activate_fn();
+
+  vector<vector<uint8_t>> requests;
+  const ResponderDefinition *definition = g_responder->def;
+  for (unsigned int i = 0u; i < definition->descriptor_count; i++) {
+    if (definition->descriptors[i].get_handler) {
+      requests.push_back(
+          BuildRequest(GET_COMMAND, definition->descriptors[i].pid));
+    }
+  }
+
+  unsigned int index = 0u;
+  int64_t bytes = 0;
+  for (auto _ : state) {
+    const vector<uint8_t> &request = requests[index];
+    int size = RDMResponder_DispatchPID(
+        reinterpret_cast<const RDMHeader*>(request.data()),
+        request.data() + sizeof(RDMHeader));
+    benchmark::DoNotOptimize(size);
+    bytes += request.size();
+    index = index + 1u == requests.size() ? 0u : index + 1u;
+  }
+
+  model->deactivate_fn();
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(bytes);
+  state.counters["pids"] = requests.size();
+}
+BENCHMARK_CAPTURE(BM_RDMResponderDispatchPID, dimmer,
+                  &DIMMER_MODEL_ENTRY, DimmerModel_Initialize);
+BENCHMARK_CAPTURE(BM_RDMResponderDispatchPID, led,
+                  &LED_MODEL_ENTRY, LEDModel_Initialize);
+BENCHMARK_CAPTURE(BM_RDMResponderDispatchPID, moving_light,
+                  &MOVING_LIGHT_MODEL_ENTRY, MovingLightModel_Initialize);
+BENCHMARK_CAPTURE(BM_RDMResponderDispatchPID, network,
+                  &NETWORK_MODEL_ENTRY, NetworkModel_Initialize);
+BENCHMARK_CAPTURE(BM_RDMResponderDispatchPID, proxy,
+                  &PROXY_MODEL_ENTRY, ProxyModel_Initialize);
+BENCHMARK_CAPTURE(BM_RDMResponderDispatchPID, sensor,
+                  &SENSOR_MODEL_ENTRY, SensorModel_Initialize);
+
+/*
+ * A GET for the PID that takes the most lookup steps, in each of the model's
+ * ResponderDefinitions.
+ */
+static void BM_RDMResponderWorstCasePID(benchmark::State &state,
+                                        const DispatchTarget &target) {
+  const ResponderDefinition *definition = ActivateTarget(target);
+  const PIDDescriptor *descriptor = WorstCaseDescriptor(definition);
+  if (!descriptor) {
+    state.SkipWithError("No GET PIDs");
+    return;
+  }
+
+  bool found;
+  unsigned int probes = LookupProbes(definition, descriptor->pid, &found);
+  vector<uint8_t> request = BuildRequest(
+      GET_COMMAND, descriptor->pid, target.sub_device, target.uid_offset,
+      descriptor->get_param_size);
+  RunDispatch(state, target, request, probes);
+}
+BENCHMARK_CAPTURE(BM_RDMResponderWorstCasePID, dimmer, kDimmerRoot);
+BENCHMARK_CAPTURE(BM_RDMResponderWorstCasePID, dimmer_sub_device,
+                  kDimmerSubDevice);
+BENCHMARK_CAPTURE(BM_RDMResponderWorstCasePID, led, kLED);
+BENCHMARK_CAPTURE(BM_RDMResponderWorstCasePID, moving_light, kMovingLight);
+BENCHMARK_CAPTURE(BM_RDMResponderWorstCasePID, network, kNetwork);
+BENCHMARK_CAPTURE(BM_RDMResponderWorstCasePID, proxy, kProxyRoot);
+BENCHMARK_CAPTURE(BM_RDMResponderWorstCasePID, proxy_child, kProxyChild);
+BENCHMARK_CAPTURE(BM_RDMResponderWorstCasePID, sensor, kSensor);
+
+/*
+ * A GET for an unsupported PID, chosen to take the most lookup steps. This
+ * is NACKed with NR_UNKNOWN_PID.
+ */
+static void BM_RDMResponderUnknownPID(benchmark::State &state,
+                                      const DispatchTarget &target) {
+  const ResponderDefinition *definition = ActivateTarget(target);
+  const uint16_t pid = WorstCaseUnknownPID(definition);
+
+  bool found;
+  unsigned int probes = LookupProbes(definition, pid, &found);
+  vector<uint8_t> request = BuildRequest(GET_COMMAND, pid, target.sub_device,
+                                         target.uid_offset);
+  RunDispatch(state, target, request, probes);
+}
+BENCHMARK_CAPTURE(BM_RDMResponderUnknownPID, dimmer, kDimmerRoot);
+BENCHMARK_CAPTURE(BM_RDMResponderUnknownPID, dimmer_sub_device,
+                  kDimmerSubDevice);
+BENCHMARK_CAPTURE(BM_RDMResponderUnknownPID, led, kLED);
+BENCHMARK_CAPTURE(BM_RDMResponderUnknownPID, moving_light, kMovingLight);
+BENCHMARK_CAPTURE(BM_RDMResponderUnknownPID, network, kNetwork);
+BENCHMARK_CAPTURE(BM_RDMResponderUnknownPID, proxy, kProxyRoot);
+BENCHMARK_CAPTURE(BM_RDMResponderUnknownPID, proxy_child, kProxyChild);
+BENCHMARK_CAPTURE(BM_RDMResponderUnknownPID, sensor, kSensor);
+
+/*
+ * A DUB for the full UID range produces a response, a DUB for a range that
+ * doesn't contain our UID returns early.
+ */
+static void BM_RDMResponderHandleDUBRequest(benchmark::State &state,
+                                            uint64_t lower, uint64_t upper) {
+  uint8_t param_data[2 * UID_LENGTH];
+  for (unsigned int i = 0u; i < UID_LENGTH; i++) {
+    param_data[i] = lower >> (8u * (UID_LENGTH - 1u - i));
+    param_data[UID_LENGTH + i] = upper >> (8u * (UID_LENGTH - 1u - i));
+  }
+
+  InitializeResponder();
+  for (auto _ : state) {
+    int size = RDMResponder_HandleDUBRequest(param_data, sizeof(param_data));
+    benchmark::DoNotOptimize(size);
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * sizeof(param_data));
+}
+BENCHMARK_CAPTURE(BM_RDMResponderHandleDUBRequest, response,
+                  0u, 0xffffffffffffu);
+BENCHMARK_CAPTURE(BM_RDMResponderHandleDUBRequest, no_response,
+                  0u, 0x7a7000000000u);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,58 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * RDMUtilBench.cpp
+ * Benchmarks for the RDM utility functions.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+#include <vector>
+
+#include "constants.h"
+#include "rdm.h"
+#include "rdm_frame.h"
+#include "rdm_util.h"
+
+using std::vector;
+
+static void BM_RDMUtilVerifyChecksum(benchmark::State &state) {
+  const unsigned int param_data_length = state.range(0);
+  vector<uint8_t> frame(
+      sizeof(RDMHeader) + param_data_length + RDM_CHECKSUM_LENGTH, 0x5a);
+  RDMHeader *header = reinterpret_cast<RDMHeader*>(frame.data());
+  header->start_code = RDM_START_CODE;
+  header->sub_start_code = RDM_SUB_START_CODE;
+  header->message_length = sizeof(RDMHeader) + param_data_length;
+  header->param_data_length = param_data_length;
+  RDMUtil_AppendChecksum(frame.data());
+
+  for (auto _ : state) {
+    bool ok = RDMUtil_VerifyChecksum(frame.data(), frame.size());
+    benchmark::DoNotOptimize(ok);
+  }
+  if (!RDMUtil_VerifyChecksum(frame.data(), frame.size())) {
+    state.SkipWithError("Checksum mismatch");
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_RDMUtilVerifyChecksum)
+    ->Arg(0)
+    ->Arg(RDM_MAX_FRAME_SIZE - sizeof(RDMHeader) - RDM_CHECKSUM_LENGTH);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,98 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * ResponderBench.cpp
+ * Benchmarks for the DMX / RDM receive path.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "dmx_spec.h"
+#include "receiver_counters.h"
+#include "responder.h"
+#include "transceiver.h"
+
+using std::vector;
+
+namespace {
+
+/*
+ * Deliver a frame in chunks of chunk_size, the way the transceiver does.
+ */
+void ReceiveFrame(const vector<uint8_t> &frame, unsigned int chunk_size) {
+  TransceiverEvent event;
+  event.token = 0;
+  event.op = T_OP_RX;
+  event.data = frame.data();
+  event.timing = NULL;
+  event.timestamp = 0u;
+
+  unsigned int i = 0u;
+  while (i < frame.size()) {
+    event.result = i ? T_RESULT_RX_CONTINUE_FRAME : T_RESULT_RX_START_FRAME;
+    event.length = std::min(i + chunk_size,
+                            static_cast<unsigned int>(frame.size()));
+    Responder_Receive(&event);
+    i += chunk_size;
+  }
+}
+
+}  // namespace
+
+static void BM_ResponderReceiveDMX(benchmark::State &state) {
+  vector<uint8_t> frame(state.range(0) + 1u);
+  frame[0] = NULL_START_CODE;
+  for (unsigned int i = 1u; i < frame.size(); i++) {
+    frame[i] = i;
+  }
+  const unsigned int chunk_size = state.range(1);
+
+  Responder_Initialize();
+  for (auto _ : state) {
+    ReceiveFrame(frame, chunk_size);
+  }
+  benchmark::DoNotOptimize(ReceiverCounters_DMXFrames());
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_ResponderReceiveDMX)
+    ->Args({24, 25})
+    ->Args({DMX_FRAME_SIZE, DMX_FRAME_SIZE + 1})
+    ->Args({DMX_FRAME_SIZE, 16});
+
+static void BM_ResponderReceiveRDM(benchmark::State &state) {
+  // A GET DEVICE_INFO
+  const vector<uint8_t> frame = {
+    0xcc, 0x01, 0x18, 0x7a, 0x70, 0x12, 0x34, 0x56, 0x78, 0x7a, 0x70, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x20, 0x00, 0x60, 0x00,
+    0x04, 0x4e
+  };
+  const unsigned int chunk_size = state.range(0);
+
+  Responder_Initialize();
+  for (auto _ : state) {
+    ReceiveFrame(frame, chunk_size);
+  }
+  benchmark::DoNotOptimize(ReceiverCounters_RDMFrames());
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_ResponderReceiveRDM)->Arg(26)->Arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,97 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * StreamDecoderBench.cpp
+ * Benchmarks for the host message decoder.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "constants.h"
+#include "stream_decoder.h"
+#include "utils.h"
+
+using std::vector;
+
+namespace {
+
+void HandleMessage(const Message *message) {
+  benchmark::DoNotOptimize(message->payload);
+}
+
+vector<uint8_t> BuildFrame(unsigned int payload_size) {
+  vector<uint8_t> frame;
+  frame.push_back(START_OF_MESSAGE_ID);
+  frame.push_back(1);  // token
+  frame.push_back(ShortLSB(COMMAND_ECHO));
+  frame.push_back(ShortMSB(COMMAND_ECHO));
+  frame.push_back(ShortLSB(payload_size));
+  frame.push_back(ShortMSB(payload_size));
+  for (unsigned int i = 0; i < payload_size; i++) {
+    frame.push_back(i);
+  }
+  frame.push_back(END_OF_MESSAGE_ID);
+  return frame;
+}
+
+}  // namespace
+
+/*
+ * Each frame arrives in a single buffer, so the payload is passed through
+ * without a copy.
+ */
+static void BM_StreamDecoderUnfragmented(benchmark::State &state) {
+  const vector<uint8_t> frame = BuildFrame(state.range(0));
+  StreamDecoder_Initialize(HandleMessage);
+
+  for (auto _ : state) {
+    StreamDecoder_Process(frame.data(), frame.size());
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_StreamDecoderUnfragmented)->Arg(0)->Arg(64)->Arg(PAYLOAD_SIZE);
+
+/*
+ * The frame is split into chunks, the way large messages arrive over USB.
+ * This takes the slow path, where the decoder buffers the partial frame.
+ */
+static void BM_StreamDecoderFragmented(benchmark::State &state) {
+  const vector<uint8_t> frame = BuildFrame(state.range(0));
+  const unsigned int chunk_size = state.range(1);
+  StreamDecoder_Initialize(HandleMessage);
+
+  for (auto _ : state) {
+    unsigned int offset = 0u;
+    while (offset < frame.size()) {
+      unsigned int size = std::min(
+          chunk_size, static_cast<unsigned int>(frame.size()) - offset);
+      StreamDecoder_Process(frame.data() + offset, size);
+      offset += size;
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * frame.size());
+}
+BENCHMARK(BM_StreamDecoderFragmented)
+    ->Args({64, USB_MAX_PACKET_SIZE})
+    ->Args({PAYLOAD_SIZE, USB_MAX_PACKET_SIZE})
+    ->Args({PAYLOAD_SIZE, 8});
+
+BENCHMARK_MAIN();
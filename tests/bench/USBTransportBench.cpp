@@ -0,0 +1,161 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * USBTransportBench.cpp
+ * Benchmarks for the USB transport.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "constants.h"
+#include "iovec.h"
+#include "usb_device_mock.h"
+#include "usb_transport.h"
+
+using std::vector;
+
+namespace {
+
+/*
+ * A USB device which accepts every transfer. The gmock version adds more
+ * overhead than the code we're trying to measure.
+ */
+class FakeUSBDevice : public USBDeviceInterface {
+ public:
+  USB_DEVICE_EVENT_HANDLER event_handler = nullptr;
+
+  void Attach(USB_DEVICE_HANDLE) {}
+  void Detach(USB_DEVICE_HANDLE) {}
+  USB_DEVICE_HANDLE Open(const uint16_t, const DRV_IO_INTENT) { return 0; }
+
+  void EventHandlerSet(USB_DEVICE_HANDLE,
+                       const USB_DEVICE_EVENT_HANDLER callBackFunc,
+                       uintptr_t) {
+    event_handler = callBackFunc;
+  }
+
+  USB_DEVICE_CONTROL_TRANSFER_RESULT ControlStatus(
+      USB_DEVICE_HANDLE, USB_DEVICE_CONTROL_STATUS) {
+    return USB_DEVICE_CONTROL_TRANSFER_RESULT_SUCCESS;
+  }
+
+  USB_DEVICE_CONTROL_TRANSFER_RESULT ControlSend(USB_DEVICE_HANDLE, void*,
+                                                 size_t) {
+    return USB_DEVICE_CONTROL_TRANSFER_RESULT_SUCCESS;
+  }
+
+  USB_DEVICE_CONTROL_TRANSFER_RESULT ControlReceive(USB_DEVICE_HANDLE, void*,
+                                                    size_t) {
+    return USB_DEVICE_CONTROL_TRANSFER_RESULT_SUCCESS;
+  }
+
+  USB_SPEED ActiveSpeedGet(USB_DEVICE_HANDLE) { return USB_SPEED_FULL; }
+
+  bool EndpointIsEnabled(USB_DEVICE_HANDLE, USB_ENDPOINT_ADDRESS) {
+    return false;
+  }
+
+  USB_DEVICE_RESULT EndpointEnable(USB_DEVICE_HANDLE, uint8_t,
+                                   USB_ENDPOINT_ADDRESS, USB_TRANSFER_TYPE,
+                                   size_t) {
+    return USB_DEVICE_RESULT_OK;
+  }
+
+  USB_DEVICE_RESULT EndpointDisable(USB_DEVICE_HANDLE, USB_ENDPOINT_ADDRESS) {
+    return USB_DEVICE_RESULT_OK;
+  }
+
+  void EndpointStall(USB_DEVICE_HANDLE, USB_ENDPOINT_ADDRESS) {}
+
+  USB_DEVICE_RESULT EndpointRead(USB_DEVICE_HANDLE,
+                                 USB_DEVICE_TRANSFER_HANDLE*,
+                                 USB_ENDPOINT_ADDRESS, void*, size_t) {
+    return USB_DEVICE_RESULT_OK;
+  }
+
+  USB_DEVICE_RESULT EndpointWrite(USB_DEVICE_HANDLE,
+                                  USB_DEVICE_TRANSFER_HANDLE*,
+                                  USB_ENDPOINT_ADDRESS, const void *data,
+                                  size_t, USB_DEVICE_TRANSFER_FLAGS) {
+    benchmark::DoNotOptimize(data);
+    return USB_DEVICE_RESULT_OK;
+  }
+
+  USB_DEVICE_RESULT EndpointTransferCancel(USB_DEVICE_HANDLE,
+                                           USB_ENDPOINT_ADDRESS,
+                                           USB_DEVICE_TRANSFER_HANDLE) {
+    return USB_DEVICE_RESULT_OK;
+  }
+
+  void SendEvent(USB_DEVICE_EVENT event, uint8_t value) {
+    event_handler(event, &value, 0);
+  }
+};
+
+}  // namespace
+
+/*
+ * Send a response with a payload of the given size, split over a number of
+ * IOVecs, then complete the write so the next one can be queued. The bytes/s
+ * is the payload rate.
+ */
+static void BM_USBTransportSendResponse(benchmark::State &state) {
+  const unsigned int payload_size = state.range(0);
+  const unsigned int iov_count = state.range(1);
+
+  vector<uint8_t> payload(payload_size, 0x5a);
+  vector<IOVec> iovs(iov_count);
+  for (unsigned int i = 0u; i < iov_count; i++) {
+    unsigned int start = payload_size * i / iov_count;
+    unsigned int end = payload_size * (i + 1u) / iov_count;
+    iovs[i].base = payload.data() + start;
+    iovs[i].length = end - start;
+  }
+
+  FakeUSBDevice device;
+  USBDevice_SetMock(&device);
+  USBTransport_Initialize(nullptr);
+  USBTransport_Tasks();
+  device.SendEvent(USB_DEVICE_EVENT_POWER_DETECTED, 0u);
+  device.SendEvent(USB_DEVICE_EVENT_CONFIGURED, 1u);
+  USBTransport_Tasks();
+
+  if (!USBTransport_IsConfigured()) {
+    state.SkipWithError("Failed to configure the USB transport");
+  }
+
+  for (auto _ : state) {
+    if (!USBTransport_SendResponse(1u, COMMAND_ECHO, RC_OK, iovs.data(),
+                                   iov_count)) {
+      state.SkipWithError("Failed to send response");
+      break;
+    }
+    device.SendEvent(USB_DEVICE_EVENT_ENDPOINT_WRITE_COMPLETE, 0u);
+  }
+
+  USBDevice_SetMock(nullptr);
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(state.iterations() * payload_size);
+}
+BENCHMARK(BM_USBTransportSendResponse)
+    ->Args({0, 0})
+    ->Args({64, 1})
+    ->Args({PAYLOAD_SIZE, 1})
+    ->Args({PAYLOAD_SIZE, 4});
+
+BENCHMARK_MAIN();
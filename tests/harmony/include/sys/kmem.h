@@ -0,0 +1,31 @@
+/*
+ * This is the stub for kmem.h used for the tests.
+ *
+ * On the PIC32, KVA_TO_PA() converts a virtual address to the physical address
+ * used by the DMA controller. Host pointers don't fit in 32 bits, so the tests
+ * assign each address a 32-bit handle instead. PA_TO_KVA() maps the handle
+ * back to the pointer.
+ */
+
+#ifndef TESTS_HARMONY_INCLUDE_SYS_KMEM_H_
+#define TESTS_HARMONY_INCLUDE_SYS_KMEM_H_
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+uint32_t KMem_VirtualToPhysical(const volatile void *address);
+
+void *KMem_PhysicalToVirtual(uint32_t address);
+
+#define KVA_TO_PA(v) KMem_VirtualToPhysical(v)
+#define PA_TO_KVA0(pa) KMem_PhysicalToVirtual(pa)
+#define PA_TO_KVA1(pa) KMem_PhysicalToVirtual(pa)
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif  // TESTS_HARMONY_INCLUDE_SYS_KMEM_H_
@@ -0,0 +1,26 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "sys/kmem.h"
+
+namespace {
+// Physical address 0 is never handed out.
+std::vector<const volatile void*> g_addresses(1, NULL);
+}
+
+uint32_t KMem_VirtualToPhysical(const volatile void *address) {
+  for (unsigned int i = 1; i < g_addresses.size(); i++) {
+    if (g_addresses[i] == address) {
+      return i;
+    }
+  }
+  g_addresses.push_back(address);
+  return g_addresses.size() - 1;
+}
+
+void *KMem_PhysicalToVirtual(uint32_t address) {
+  if (address == 0 || address >= g_addresses.size()) {
+    return NULL;
+  }
+  return const_cast<void*>(g_addresses[address]);
+}
@@ -0,0 +1,100 @@
+#include <gmock/gmock.h>
+#include "plib_dma_mock.h"
+
+namespace {
+  PeripheralDMAInterface *g_plib_dma_mock = NULL;
+}
+
+void PLIB_DMA_SetMock(PeripheralDMAInterface* dma) {
+  g_plib_dma_mock = dma;
+}
+
+void PLIB_DMA_Enable(DMA_MODULE_ID index) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->Enable(index);
+  }
+}
+
+void PLIB_DMA_ChannelXStartIRQSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                  DMA_TRIGGER_SOURCE IRQ) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXStartIRQSet(index, channel, IRQ);
+  }
+}
+
+void PLIB_DMA_ChannelXTriggerEnable(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                    DMA_CHANNEL_TRIGGER_TYPE trigger) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXTriggerEnable(index, channel, trigger);
+  }
+}
+
+void PLIB_DMA_ChannelXSourceStartAddressSet(DMA_MODULE_ID index,
+                                            DMA_CHANNEL channel,
+                                            uint32_t sourceStartAddress) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXSourceStartAddressSet(index, channel,
+                                                   sourceStartAddress);
+  }
+}
+
+void PLIB_DMA_ChannelXDestinationStartAddressSet(
+    DMA_MODULE_ID index,
+    DMA_CHANNEL channel,
+    uint32_t destinationStartAddress) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXDestinationStartAddressSet(
+        index, channel, destinationStartAddress);
+  }
+}
+
+void PLIB_DMA_ChannelXSourceSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                    uint16_t sourceSize) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXSourceSizeSet(index, channel, sourceSize);
+  }
+}
+
+void PLIB_DMA_ChannelXDestinationSizeSet(DMA_MODULE_ID index,
+                                         DMA_CHANNEL channel,
+                                         uint16_t destinationSize) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXDestinationSizeSet(index, channel,
+                                                destinationSize);
+  }
+}
+
+void PLIB_DMA_ChannelXCellSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                  uint16_t CellSize) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXCellSizeSet(index, channel, CellSize);
+  }
+}
+
+void PLIB_DMA_ChannelXEnable(DMA_MODULE_ID index, DMA_CHANNEL channel) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXEnable(index, channel);
+  }
+}
+
+bool PLIB_DMA_ChannelXIsEnabled(DMA_MODULE_ID index, DMA_CHANNEL channel) {
+  if (g_plib_dma_mock) {
+    return g_plib_dma_mock->ChannelXIsEnabled(index, channel);
+  }
+  return false;
+}
+
+void PLIB_DMA_ChannelXINTSourceEnable(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                     DMA_INT_TYPE dmaINTSource) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXINTSourceEnable(index, channel, dmaINTSource);
+  }
+}
+
+void PLIB_DMA_ChannelXINTSourceFlagClear(DMA_MODULE_ID index,
+                                        DMA_CHANNEL channel,
+                                        DMA_INT_TYPE dmaINTSource) {
+  if (g_plib_dma_mock) {
+    g_plib_dma_mock->ChannelXINTSourceFlagClear(index, channel, dmaINTSource);
+  }
+}
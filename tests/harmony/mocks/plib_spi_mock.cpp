@@ -95,6 +95,13 @@ uint8_t PLIB_SPI_BufferRead(SPI_MODULE_ID index) {
   return 0;
 }
 
+void* PLIB_SPI_BufferAddressGet(SPI_MODULE_ID index) {
+  if (g_plib_spi_mock) {
+    return g_plib_spi_mock->BufferAddressGet(index);
+  }
+  return NULL;
+}
+
 void PLIB_SPI_SlaveSelectDisable(SPI_MODULE_ID index) {
   if (g_plib_spi_mock) {
     g_plib_spi_mock->SlaveSelectDisable(index);
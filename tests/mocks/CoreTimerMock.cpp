@@ -0,0 +1,49 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * CoreTimerMock.cpp
+ * A mock core timer module.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "CoreTimerMock.h"
+
+namespace {
+MockCoreTimer *g_core_timer_mock = NULL;
+}
+
+void CoreTimer_SetMock(MockCoreTimer* mock) {
+  g_core_timer_mock = mock;
+}
+
+uint32_t CoreTimer_GetCount() {
+  if (g_core_timer_mock) {
+    return g_core_timer_mock->GetCount();
+  }
+  return 0;
+}
+
+void CoreTimer_SetCompare(uint32_t value) {
+  if (g_core_timer_mock) {
+    g_core_timer_mock->SetCompare(value);
+  }
+}
+
+uint32_t CoreTimer_GetCompare() {
+  if (g_core_timer_mock) {
+    return g_core_timer_mock->GetCompare();
+  }
+  return 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * CoreTimerMock.h
+ * A mock core timer module.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TESTS_MOCKS_CORETIMERMOCK_H_
+#define TESTS_MOCKS_CORETIMERMOCK_H_
+
+#include <gmock/gmock.h>
+#include "core_timer.h"
+
+class MockCoreTimer {
+ public:
+  MOCK_METHOD0(GetCount, uint32_t());
+  MOCK_METHOD1(SetCompare, void(uint32_t value));
+  MOCK_METHOD0(GetCompare, uint32_t());
+};
+
+void CoreTimer_SetMock(MockCoreTimer* mock);
+
+#endif  // TESTS_MOCKS_CORETIMERMOCK_H_
@@ -4,6 +4,7 @@
 noinst_LTLIBRARIES += tests/mocks/libappmock.la \
                       tests/mocks/libbootloaderoptionsmock.la \
                       tests/mocks/libcoarsetimermock.la \
+                      tests/mocks/libcoretimermock.la \
                       tests/mocks/libflagsmock.la \
                       tests/mocks/libflashmock.la \
                       tests/mocks/liblaunchermock.la \
@@ -11,6 +12,7 @@ noinst_LTLIBRARIES += tests/mocks/libappmock.la \
                       tests/mocks/libmessagehandlermock.la \
                       tests/mocks/librdmhandlermock.la \
                       tests/mocks/libresetmock.la \
+                      tests/mocks/libspimock.la \
                       tests/mocks/libspirgbmock.la \
                       tests/mocks/libstreamdecodermock.la \
                       tests/mocks/libsyslogmock.la \
@@ -36,6 +38,11 @@ tests_mocks_libcoarsetimermock_la_SOURCES = tests/mocks/CoarseTimerMock,h \
 tests_mocks_libcoarsetimermock_la_CXXFLAGS = $(MOCK_CXXFLAGS)
 tests_mocks_libcoarsetimermock_la_LIBADD = $(MOCK_LIBS)
 
+tests_mocks_libcoretimermock_la_SOURCES = tests/mocks/CoreTimerMock.h \
+                                          tests/mocks/CoreTimerMock.cpp
+tests_mocks_libcoretimermock_la_CXXFLAGS = $(MOCK_CXXFLAGS)
+tests_mocks_libcoretimermock_la_LIBADD = $(MOCK_LIBS)
+
 tests_mocks_libflagsmock_la_SOURCES = tests/mocks/FlagsMock.h \
                                       tests/mocks/FlagsMock.cpp
 tests_mocks_libflagsmock_la_CXXFLAGS = $(MOCK_CXXFLAGS)
@@ -72,6 +79,11 @@ tests_mocks_libresetmock_la_SOURCES = tests/mocks/ResetMock.h \
 tests_mocks_libresetmock_la_CXXFLAGS = $(MOCK_CXXFLAGS)
 tests_mocks_libresetmock_la_LIBADD = $(MOCK_LIBS)
 
+tests_mocks_libspimock_la_SOURCES = tests/mocks/SPIMock.h \
+                                    tests/mocks/SPIMock.cpp
+tests_mocks_libspimock_la_CXXFLAGS = $(MOCK_CXXFLAGS)
+tests_mocks_libspimock_la_LIBADD = $(MOCK_LIBS)
+
 tests_mocks_libspirgbmock_la_SOURCES = tests/mocks/SPIRGBMock.h \
                                        tests/mocks/SPIRGBMock.cpp
 tests_mocks_libspirgbmock_la_CXXFLAGS = $(MOCK_CXXFLAGS)
@@ -61,6 +61,13 @@ void RDMHandler_HandleRequest(const RDMHeader *header,
   }
 }
 
+void RDMHandler_HandleDMX(unsigned int offset, const uint8_t *data,
+                          unsigned int length) {
+  if (g_rdmhandler_mock) {
+    g_rdmhandler_mock->HandleDMX(offset, data, length);
+  }
+}
+
 void RDMHandler_Tasks() {
   if (g_rdmhandler_mock) {
     g_rdmhandler_mock->Tasks();
@@ -33,6 +33,8 @@ class MockRDMHandler {
   MOCK_METHOD1(GetUID, void(uint8_t *uid));
   MOCK_METHOD2(HandleRequest, void(const RDMHeader *header,
                                    const uint8_t *param_data));
+  MOCK_METHOD3(HandleDMX, void(unsigned int offset, const uint8_t *data,
+                               unsigned int length));
   MOCK_METHOD0(Tasks, void());
 };
 
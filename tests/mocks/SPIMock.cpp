@@ -0,0 +1,54 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * SPIMock.cpp
+ * A mock SPI driver.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "SPIMock.h"
+
+namespace {
+MockSPI *g_spi_mock = NULL;
+}
+
+void SPI_SetMock(MockSPI* mock) {
+  g_spi_mock = mock;
+}
+
+bool SPI_QueueTransfer(SPI_MODULE_ID module_id,
+                       const uint8_t *output,
+                       unsigned int output_length,
+                       uint8_t *input,
+                       unsigned int input_length,
+                       SPI_Callback callback) {
+  if (g_spi_mock) {
+    return g_spi_mock->QueueTransfer(module_id, output, output_length, input,
+                                     input_length, callback);
+  }
+  return false;
+}
+
+void SPI_Initialize(const SPIConfiguration *config) {
+  if (g_spi_mock) {
+    g_spi_mock->Initialize(config);
+  }
+}
+
+void SPI_Tasks() {
+  if (g_spi_mock) {
+    g_spi_mock->Tasks();
+  }
+}
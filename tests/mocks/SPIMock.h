@@ -0,0 +1,39 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * SPIMock.h
+ * A mock SPI driver.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TESTS_MOCKS_SPIMOCK_H_
+#define TESTS_MOCKS_SPIMOCK_H_
+
+#include <gmock/gmock.h>
+#include "spi.h"
+
+class MockSPI {
+ public:
+  MOCK_METHOD6(QueueTransfer,
+               bool(SPI_MODULE_ID module_id, const uint8_t *output,
+                    unsigned int output_length, uint8_t *input,
+                    unsigned int input_length, SPI_Callback callback));
+  MOCK_METHOD1(Initialize, void(const SPIConfiguration *config));
+  MOCK_METHOD0(Tasks, void());
+};
+
+void SPI_SetMock(MockSPI* mock);
+
+#endif  // TESTS_MOCKS_SPIMOCK_H_
@@ -34,6 +34,50 @@ void SPIRGB_Init(const SPIRGBConfiguration *config) {
   }
 }
 
+void SPIRGB_SetPixelCount(uint16_t count) {
+  if (g_spirgb_mock) {
+    g_spirgb_mock->SetPixelCount(count);
+  }
+}
+
+uint16_t SPIRGB_PixelCount() {
+  if (g_spirgb_mock) {
+    return g_spirgb_mock->PixelCount();
+  }
+  return 0;
+}
+
+void SPIRGB_SetPixelType(PixelType type) {
+  if (g_spirgb_mock) {
+    g_spirgb_mock->SetPixelType(type);
+  }
+}
+
+bool SPIRGB_SetGamma(uint8_t gamma) {
+  if (g_spirgb_mock) {
+    return g_spirgb_mock->SetGamma(gamma);
+  }
+  return true;
+}
+
+void SPIRGB_SetWhiteBalance(uint8_t red, uint8_t green, uint8_t blue) {
+  if (g_spirgb_mock) {
+    g_spirgb_mock->SetWhiteBalance(red, green, blue);
+  }
+}
+
+void SPIRGB_SetDithering(bool enabled) {
+  if (g_spirgb_mock) {
+    g_spirgb_mock->SetDithering(enabled);
+  }
+}
+
+void SPIRGB_SetBrightness(uint8_t brightness) {
+  if (g_spirgb_mock) {
+    g_spirgb_mock->SetBrightness(brightness);
+  }
+}
+
 void SPIRGB_BeginUpdate() {
   if (g_spirgb_mock) {
     g_spirgb_mock->BeginUpdate();
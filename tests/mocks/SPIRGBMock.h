@@ -27,6 +27,14 @@
 class MockSPIRGB {
  public:
   MOCK_METHOD1(Init, void(const SPIRGBConfiguration *config));
+  MOCK_METHOD1(SetPixelCount, void(uint16_t count));
+  MOCK_METHOD0(PixelCount, uint16_t());
+  MOCK_METHOD1(SetPixelType, void(PixelType type));
+  MOCK_METHOD1(SetGamma, bool(uint8_t gamma));
+  MOCK_METHOD3(SetWhiteBalance,
+               void(uint8_t red, uint8_t green, uint8_t blue));
+  MOCK_METHOD1(SetDithering, void(bool enabled));
+  MOCK_METHOD1(SetBrightness, void(uint8_t brightness));
   MOCK_METHOD0(BeginUpdate, void());
   MOCK_METHOD3(SetPixel, void(uint16_t index, RGB_Color color, uint8_t value));
   MOCK_METHOD0(CompleteUpdate, void());
@@ -20,15 +20,21 @@
 
 #include "InterruptController.h"
 
+#include <algorithm>
 #include <map>
 
 #include "macros.h"
 #include "ola/Callback.h"
 #include "ola/stl/STLUtils.h"
 
+const INT_PRIORITY_LEVEL InterruptController::kDefaultPriority;
+
 InterruptController::Interrupt::Interrupt()
     : enabled(false),
       active(false),
+      has_vector(false),
+      vector(static_cast<INT_VECTOR>(0)),
+      count(0),
       callback(nullptr) {
 }
 
@@ -38,6 +44,18 @@ InterruptController::Interrupt::~Interrupt() {
   }
 }
 
+InterruptController::Vector::Vector()
+    : priority(INT_DISABLE_INTERRUPT),
+      subpriority(INT_SUBPRIORITY_LEVEL0) {
+}
+
+InterruptController::InterruptController()
+    : m_cpu_priority(INT_DISABLE_INTERRUPT),
+      m_depth(0),
+      m_max_depth(0),
+      m_total_count(0) {
+}
+
 InterruptController::~InterruptController() {
   ola::STLDeleteValues(&m_interrupts);
 }
@@ -51,21 +69,59 @@ void InterruptController::RegisterISR(INT_SOURCE source,
   interrupt->callback = callback;
 }
 
+void InterruptController::RegisterISR(INT_SOURCE source,
+                                      INT_VECTOR vector,
+                                      ISRCallback *callback) {
+  RegisterISR(source, callback);
+  Interrupt *interrupt = GetInterrupt(source);
+  interrupt->has_vector = true;
+  interrupt->vector = vector;
+}
+
+void InterruptController::AddObserver(Observer *observer) {
+  m_observers.push_back(observer);
+}
+
+void InterruptController::RemoveObserver(Observer *observer) {
+  m_observers.erase(
+      std::remove(m_observers.begin(), m_observers.end(), observer),
+      m_observers.end());
+}
+
 void InterruptController::RaiseInterrupt(INT_SOURCE source) {
   Interrupt *interrupt = GetInterrupt(source);
   interrupt->active = true;
-  if (!interrupt->enabled) {
-    return;
+  for (auto observer : m_observers) {
+    observer->InterruptRaised(source);
+  }
+  if (interrupt->enabled) {
+    Dispatch();
   }
+}
 
-  while (interrupt->active) {
-    if (interrupt->callback) {
-      // The ISR is responsible for clearing the active flag
-      interrupt->callback->Run();
-    } else {
-      FAIL() << "Interrupt " << source << " is active but no callback set!";
-    }
+INT_PRIORITY_LEVEL InterruptController::CurrentPriority() const {
+  return m_cpu_priority;
+}
+
+unsigned int InterruptController::InterruptCount(INT_SOURCE source) const {
+  const Interrupt *interrupt = ola::STLFindOrNull(m_interrupts, source);
+  return interrupt ? interrupt->count : 0;
+}
+
+unsigned int InterruptController::TotalInterruptCount() const {
+  return m_total_count;
+}
+
+unsigned int InterruptController::MaxNestingDepth() const {
+  return m_max_depth;
+}
+
+void InterruptController::ResetCounters() {
+  for (auto &iter : m_interrupts) {
+    iter.second->count = 0;
   }
+  m_total_count = 0;
+  m_max_depth = 0;
 }
 
 bool InterruptController::SourceStatusGet(INT_SOURCE source) {
@@ -81,25 +137,113 @@ void InterruptController::SourceStatusClear(INT_SOURCE source) {
 void InterruptController::SourceEnable(INT_SOURCE source) {
   Interrupt *interrupt = GetInterrupt(source);
   interrupt->enabled = true;
+  if (interrupt->active) {
+    Dispatch();
+  }
 }
 
 bool InterruptController::SourceDisable(INT_SOURCE source) {
   Interrupt *interrupt = GetInterrupt(source);
+  bool was_enabled = interrupt->enabled;
   interrupt->enabled = false;
-  return true;
+  return was_enabled;
 }
 
-void InterruptController::VectorPrioritySet(
-    UNUSED INT_VECTOR vector,
-    UNUSED INT_PRIORITY_LEVEL priority) {
+void InterruptController::VectorPrioritySet(INT_VECTOR vector,
+                                            INT_PRIORITY_LEVEL priority) {
+  m_vectors[vector].priority = priority;
 }
 
 void InterruptController::VectorSubprioritySet(
-    UNUSED INT_VECTOR vector,
-    UNUSED INT_SUBPRIORITY_LEVEL subpriority) {
+    INT_VECTOR vector,
+    INT_SUBPRIORITY_LEVEL subpriority) {
+  m_vectors[vector].subpriority = subpriority;
 }
 
 InterruptController::Interrupt *InterruptController::GetInterrupt(
     INT_SOURCE source) {
   return ola::STLLookupOrInsertNew(&m_interrupts, source)->second;
 }
+
+INT_PRIORITY_LEVEL InterruptController::Priority(
+    const Interrupt &interrupt) const {
+  if (!interrupt.has_vector) {
+    return kDefaultPriority;
+  }
+  auto iter = m_vectors.find(interrupt.vector);
+  return iter == m_vectors.end() ? INT_DISABLE_INTERRUPT :
+      iter->second.priority;
+}
+
+INT_SUBPRIORITY_LEVEL InterruptController::Subpriority(
+    const Interrupt &interrupt) const {
+  if (!interrupt.has_vector) {
+    return INT_SUBPRIORITY_LEVEL0;
+  }
+  auto iter = m_vectors.find(interrupt.vector);
+  return iter == m_vectors.end() ? INT_SUBPRIORITY_LEVEL0 :
+      iter->second.subpriority;
+}
+
+/*
+ * When the priority & sub-priority are the same, the lower vector number
+ * wins.
+ */
+unsigned int InterruptController::NaturalOrder(
+    INT_SOURCE source, const Interrupt &interrupt) const {
+  if (interrupt.has_vector) {
+    return interrupt.vector;
+  }
+  return source;
+}
+
+/*
+ * Run the ISRs of any pending interrupts with a priority above the current
+ * CPU priority. An ISR that raises a higher priority interrupt will be
+ * preempted, since RaiseInterrupt() calls back into here.
+ */
+void InterruptController::Dispatch() {
+  while (true) {
+    INT_SOURCE source = static_cast<INT_SOURCE>(0);
+    Interrupt *next = nullptr;
+    for (auto &iter : m_interrupts) {
+      const Interrupt &interrupt = *iter.second;
+      if (!interrupt.enabled || !interrupt.active ||
+          Priority(interrupt) <= m_cpu_priority) {
+        continue;
+      }
+
+      if (next == nullptr ||
+          Priority(interrupt) > Priority(*next) ||
+          (Priority(interrupt) == Priority(*next) &&
+           (Subpriority(interrupt) > Subpriority(*next) ||
+            (Subpriority(interrupt) == Subpriority(*next) &&
+             NaturalOrder(iter.first, interrupt) <
+             NaturalOrder(source, *next))))) {
+        source = iter.first;
+        next = iter.second;
+      }
+    }
+
+    if (next == nullptr) {
+      return;
+    }
+
+    if (!next->callback) {
+      FAIL() << "Interrupt " << source << " is active but no callback set!";
+    }
+
+    // The ISR is responsible for clearing the active flag
+    INT_PRIORITY_LEVEL previous_priority = m_cpu_priority;
+    m_cpu_priority = Priority(*next);
+    m_depth++;
+    m_max_depth = std::max(m_max_depth, m_depth);
+    next->count++;
+    m_total_count++;
+
+    next->callback->Run();
+
+    m_depth--;
+    m_cpu_priority = previous_priority;
+  }
+}
@@ -22,20 +22,66 @@
 #define TESTS_SIM_INTERRUPTCONTROLLER_H_
 
 #include <map>
+#include <vector>
 #include "ola/Callback.h"
 #include "sys_int_mock.h"
 
+/*
+ * @brief The interrupt controller.
+ *
+ * Interrupts are dispatched in priority order. Sources registered with a
+ * vector take the priority & sub-priority the firmware assigns to that vector;
+ * as on the hardware, a vector with priority 0 never interrupts. Sources
+ * registered without a vector run at kDefaultPriority.
+ *
+ * An interrupt raised while an ISR is running preempts it if the new
+ * interrupt has a higher priority, otherwise it's held pending until the CPU
+ * priority drops. Pending interrupts are also delivered as soon as their
+ * source is enabled, which is when the firmware leaves a critical section.
+ */
 class InterruptController : public SysIntInterface {
  public:
   typedef ola::Callback0<void> ISRCallback;
 
+  /*
+   * @brief Notified each time an interrupt flag is raised, even if the source
+   * is disabled. This is how the DMA controller is triggered.
+   */
+  class Observer {
+   public:
+    virtual ~Observer() {}
+
+    virtual void InterruptRaised(INT_SOURCE source) = 0;
+  };
+
+  InterruptController();
   ~InterruptController();
 
   // Ownership of the callback is transferred.
   void RegisterISR(INT_SOURCE source, ISRCallback *callback);
+  void RegisterISR(INT_SOURCE source, INT_VECTOR vector,
+                   ISRCallback *callback);
+
+  // Ownership is not transferred.
+  void AddObserver(Observer *observer);
+  void RemoveObserver(Observer *observer);
 
   void RaiseInterrupt(INT_SOURCE source);
 
+  // The priority the CPU is running at, 0 outside of an ISR.
+  INT_PRIORITY_LEVEL CurrentPriority() const;
+
+  // The number of times the ISR for a source has run.
+  unsigned int InterruptCount(INT_SOURCE source) const;
+
+  // The total number of ISRs run.
+  unsigned int TotalInterruptCount() const;
+
+  // The deepest ISR nesting seen, 1 if no ISR was ever preempted.
+  unsigned int MaxNestingDepth() const;
+
+  void ResetCounters();
+
   bool SourceStatusGet(INT_SOURCE source);
   void SourceStatusClear(INT_SOURCE source);
   void SourceEnable(INT_SOURCE source);
@@ -45,6 +91,8 @@ class InterruptController : public SysIntInterface {
   void VectorSubprioritySet(INT_VECTOR vector,
                             INT_SUBPRIORITY_LEVEL subpriority);
 
+  static const INT_PRIORITY_LEVEL kDefaultPriority = INT_PRIORITY_LEVEL1;
+
  private:
   struct Interrupt {
    public:
@@ -53,12 +101,34 @@ class InterruptController : public SysIntInterface {
 
     bool enabled;
     bool active;
+    bool has_vector;
+    INT_VECTOR vector;
+    unsigned int count;
     ISRCallback *callback;
   };
 
+  struct Vector {
+   public:
+    Vector();
+
+    INT_PRIORITY_LEVEL priority;
+    INT_SUBPRIORITY_LEVEL subpriority;
+  };
+
   std::map<INT_SOURCE, Interrupt*> m_interrupts;
+  std::map<INT_VECTOR, Vector> m_vectors;
+  std::vector<Observer*> m_observers;
+  INT_PRIORITY_LEVEL m_cpu_priority;
+  unsigned int m_depth;
+  unsigned int m_max_depth;
+  unsigned int m_total_count;
 
   Interrupt *GetInterrupt(INT_SOURCE source);
+  INT_PRIORITY_LEVEL Priority(const Interrupt &interrupt) const;
+  INT_SUBPRIORITY_LEVEL Subpriority(const Interrupt &interrupt) const;
+  unsigned int NaturalOrder(INT_SOURCE source,
+                            const Interrupt &interrupt) const;
+  void Dispatch();
 };
 
 #endif  // TESTS_SIM_INTERRUPTCONTROLLER_H_
@@ -7,12 +7,16 @@ tests_sim_libsim_la_SOURCES = tests/sim/InterruptController.cpp \
                               tests/sim/InterruptController.h \
                               tests/sim/PeripheralInputCapture.cpp \
                               tests/sim/PeripheralInputCapture.h \
+                              tests/sim/PeripheralDMA.cpp \
+                              tests/sim/PeripheralDMA.h \
                               tests/sim/PeripheralSPI.cpp \
                               tests/sim/PeripheralSPI.h \
                               tests/sim/PeripheralTimer.cpp \
                               tests/sim/PeripheralTimer.h \
                               tests/sim/PeripheralUART.cpp \
                               tests/sim/PeripheralUART.h \
+                              tests/sim/RDMBus.cpp \
+                              tests/sim/RDMBus.h \
                               tests/sim/SignalGenerator.cpp \
                               tests/sim/SignalGenerator.h \
                               tests/sim/Simulator.cpp \
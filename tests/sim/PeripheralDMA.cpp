@@ -0,0 +1,308 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PeripheralDMA.cpp
+ * The DMA controller used with the simulator.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "PeripheralDMA.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "macros.h"
+#include "sys/kmem.h"
+
+namespace {
+
+// The DMA triggers are the IRQ numbers, which don't match the INT_SOURCE
+// values in the mock headers.
+const std::map<DMA_TRIGGER_SOURCE, INT_SOURCE> kTriggers = {
+  {DMA_TRIGGER_SPI_1_RECEIVE, INT_SOURCE_SPI_1_RECEIVE},
+  {DMA_TRIGGER_SPI_1_TRANSMIT, INT_SOURCE_SPI_1_TRANSMIT},
+  {DMA_TRIGGER_SPI_2_RECEIVE, INT_SOURCE_SPI_2_RECEIVE},
+  {DMA_TRIGGER_SPI_2_TRANSMIT, INT_SOURCE_SPI_2_TRANSMIT},
+};
+
+}  // namespace
+
+PeripheralDMA::Channel::Channel()
+    : enabled(false),
+      block_interrupt_enabled(false),
+      start_irq_enabled(false),
+      has_start_irq(false),
+      start_irq(static_cast<INT_SOURCE>(0)),
+      source_address(0),
+      destination_address(0),
+      source_size(0),
+      destination_size(0),
+      cell_size(1),
+      source_pointer(0),
+      destination_pointer(0),
+      transferred(0),
+      cell_count(0),
+      block_count(0) {
+}
+
+PeripheralDMA::PeripheralDMA(InterruptController *interrupt_controller)
+    : m_interrupt_controller(interrupt_controller),
+      m_enabled(false),
+      m_channels(DMA_NUMBER_OF_CHANNELS) {
+  m_interrupt_controller->AddObserver(this);
+}
+
+PeripheralDMA::~PeripheralDMA() {
+  m_interrupt_controller->RemoveObserver(this);
+}
+
+void PeripheralDMA::MapRegister(const volatile void *address,
+                                DMARegister *reg) {
+  m_registers[address] = reg;
+}
+
+unsigned int PeripheralDMA::CellCount(DMA_CHANNEL channel) const {
+  return channel < m_channels.size() ? m_channels[channel].cell_count : 0;
+}
+
+unsigned int PeripheralDMA::BlockCount(DMA_CHANNEL channel) const {
+  return channel < m_channels.size() ? m_channels[channel].block_count : 0;
+}
+
+void PeripheralDMA::InterruptRaised(INT_SOURCE source) {
+  if (!m_enabled) {
+    return;
+  }
+
+  for (unsigned int i = 0; i < m_channels.size(); i++) {
+    Channel *channel = &m_channels[i];
+    if (channel->enabled && channel->start_irq_enabled &&
+        channel->has_start_irq && channel->start_irq == source) {
+      TransferCell(static_cast<DMA_CHANNEL>(i), channel);
+    }
+  }
+}
+
+void PeripheralDMA::Enable(DMA_MODULE_ID index) {
+  if (index != DMA_ID_0) {
+    ADD_FAILURE() << "Invalid DMA module " << index;
+    return;
+  }
+  m_enabled = true;
+}
+
+void PeripheralDMA::ChannelXStartIRQSet(DMA_MODULE_ID index,
+                                        DMA_CHANNEL channel,
+                                        DMA_TRIGGER_SOURCE IRQ) {
+  Channel *dma_channel = GetChannel(index, channel);
+  if (!dma_channel) {
+    return;
+  }
+
+  auto iter = kTriggers.find(IRQ);
+  if (iter == kTriggers.end()) {
+    ADD_FAILURE() << "Unsupported DMA trigger " << IRQ;
+    return;
+  }
+  dma_channel->has_start_irq = true;
+  dma_channel->start_irq = iter->second;
+}
+
+void PeripheralDMA::ChannelXTriggerEnable(DMA_MODULE_ID index,
+                                          DMA_CHANNEL channel,
+                                          DMA_CHANNEL_TRIGGER_TYPE trigger) {
+  Channel *dma_channel = GetChannel(index, channel);
+  if (!dma_channel) {
+    return;
+  }
+
+  if (trigger == DMA_CHANNEL_TRIGGER_TRANSFER_START) {
+    dma_channel->start_irq_enabled = true;
+  } else {
+    ADD_FAILURE() << "Unsupported DMA trigger type " << trigger;
+  }
+}
+
+void PeripheralDMA::ChannelXSourceStartAddressSet(DMA_MODULE_ID index,
+                                                  DMA_CHANNEL channel,
+                                                  uint32_t sourceStartAddress) {
+  Channel *dma_channel = GetChannel(index, channel);
+  if (dma_channel) {
+    dma_channel->source_address = sourceStartAddress;
+  }
+}
+
+void PeripheralDMA::ChannelXDestinationStartAddressSet(
+    DMA_MODULE_ID index,
+    DMA_CHANNEL channel,
+    uint32_t destinationStartAddress) {
+  Channel *dma_channel = GetChannel(index, channel);
+  if (dma_channel) {
+    dma_channel->destination_address = destinationStartAddress;
+  }
+}
+
+void PeripheralDMA::ChannelXSourceSizeSet(DMA_MODULE_ID index,
+                                          DMA_CHANNEL channel,
+                                          uint16_t sourceSize) {
+  Channel *dma_channel = GetChannel(index, channel);
+  if (dma_channel) {
+    // DCHxSSIZ only has 8 bits.
+    dma_channel->source_size = sourceSize & 0xff;
+  }
+}
+
+void PeripheralDMA::ChannelXDestinationSizeSet(DMA_MODULE_ID index,
+                                               DMA_CHANNEL channel,
+                                               uint16_t destinationSize) {
+  Channel *dma_channel = GetChannel(index, channel);
+  if (dma_channel) {
+    // DCHxDSIZ only has 8 bits.
+    dma_channel->destination_size = destinationSize & 0xff;
+  }
+}
+
+void PeripheralDMA::ChannelXCellSizeSet(DMA_MODULE_ID index,
+                                        DMA_CHANNEL channel,
+                                        uint16_t CellSize) {
+  Channel *dma_channel = GetChannel(index, channel);
+  if (dma_channel) {
+    dma_channel->cell_size = CellSize;
+  }
+}
+
+void PeripheralDMA::ChannelXEnable(DMA_MODULE_ID index, DMA_CHANNEL channel) {
+  Channel *dma_channel = GetChannel(index, channel);
+  if (!dma_channel) {
+    return;
+  }
+
+  dma_channel->enabled = true;
+  dma_channel->source_pointer = 0;
+  dma_channel->destination_pointer = 0;
+  dma_channel->transferred = 0;
+}
+
+bool PeripheralDMA::ChannelXIsEnabled(DMA_MODULE_ID index,
+                                      DMA_CHANNEL channel) {
+  Channel *dma_channel = GetChannel(index, channel);
+  return dma_channel ? dma_channel->enabled : false;
+}
+
+void PeripheralDMA::ChannelXINTSourceEnable(DMA_MODULE_ID index,
+                                            DMA_CHANNEL channel,
+                                            DMA_INT_TYPE dmaINTSource) {
+  Channel *dma_channel = GetChannel(index, channel);
+  if (!dma_channel) {
+    return;
+  }
+
+  if (dmaINTSource == DMA_INT_BLOCK_TRANSFER_COMPLETE) {
+    dma_channel->block_interrupt_enabled = true;
+  } else {
+    ADD_FAILURE() << "Unsupported DMA interrupt " << dmaINTSource;
+  }
+}
+
+void PeripheralDMA::ChannelXINTSourceFlagClear(DMA_MODULE_ID index,
+                                               DMA_CHANNEL channel,
+                                               DMA_INT_TYPE dmaINTSource) {
+  // The channel flags aren't modeled, only the interrupt they raise.
+  GetChannel(index, channel);
+  if (dmaINTSource != DMA_INT_BLOCK_TRANSFER_COMPLETE) {
+    ADD_FAILURE() << "Unsupported DMA interrupt " << dmaINTSource;
+  }
+}
+
+PeripheralDMA::Channel *PeripheralDMA::GetChannel(DMA_MODULE_ID index,
+                                                  DMA_CHANNEL channel) {
+  if (index != DMA_ID_0 || channel >= m_channels.size()) {
+    ADD_FAILURE() << "Invalid DMA channel " << index << ":" << channel;
+    return nullptr;
+  }
+  return &m_channels[channel];
+}
+
+/*
+ * A size register of 0 is a 256 byte block.
+ */
+unsigned int PeripheralDMA::BlockSize(uint8_t size_register) {
+  return size_register ? size_register : 256u;
+}
+
+/*
+ * The source & destination pointers wrap independently, the block is
+ * complete once the larger of the two sizes has been transferred.
+ */
+void PeripheralDMA::TransferCell(DMA_CHANNEL channel_id, Channel *channel) {
+  const unsigned int source_size = BlockSize(channel->source_size);
+  const unsigned int destination_size = BlockSize(channel->destination_size);
+  const uint32_t block_size = std::max(source_size, destination_size);
+  for (unsigned int i = 0; i < channel->cell_size; i++) {
+    uint8_t data = ReadByte(channel->source_address, channel->source_pointer);
+    WriteByte(channel->destination_address, channel->destination_pointer,
+              data);
+    channel->source_pointer = (channel->source_pointer + 1) % source_size;
+    channel->destination_pointer = (channel->destination_pointer + 1) %
+                                   destination_size;
+    channel->transferred++;
+    if (channel->transferred == block_size) {
+      break;
+    }
+  }
+  channel->cell_count++;
+
+  if (channel->transferred == block_size) {
+    channel->enabled = false;
+    channel->block_count++;
+    if (channel->block_interrupt_enabled) {
+      m_interrupt_controller->RaiseInterrupt(
+          static_cast<INT_SOURCE>(INT_SOURCE_DMA_0 + channel_id));
+    }
+  }
+}
+
+uint8_t PeripheralDMA::ReadByte(uint32_t address, uint16_t offset) {
+  void *ptr = PA_TO_KVA0(address);
+  if (!ptr) {
+    ADD_FAILURE() << "DMA read from invalid address " << address;
+    return 0;
+  }
+
+  auto iter = m_registers.find(ptr);
+  if (iter != m_registers.end()) {
+    return iter->second->Read();
+  }
+  return static_cast<const uint8_t*>(ptr)[offset];
+}
+
+void PeripheralDMA::WriteByte(uint32_t address, uint16_t offset,
+                              uint8_t data) {
+  void *ptr = PA_TO_KVA0(address);
+  if (!ptr) {
+    ADD_FAILURE() << "DMA write to invalid address " << address;
+    return;
+  }
+
+  auto iter = m_registers.find(ptr);
+  if (iter != m_registers.end()) {
+    iter->second->Write(data);
+    return;
+  }
+  static_cast<uint8_t*>(ptr)[offset] = data;
+}
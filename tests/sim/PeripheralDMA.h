@@ -0,0 +1,137 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PeripheralDMA.h
+ * The DMA controller used with the simulator.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TESTS_SIM_PERIPHERALDMA_H_
+#define TESTS_SIM_PERIPHERALDMA_H_
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "plib_dma_mock.h"
+
+#include "InterruptController.h"
+
+/*
+ * @brief A peripheral register the DMA controller can move data to & from,
+ * such as SPIxBUF.
+ */
+class DMARegister {
+ public:
+  virtual ~DMARegister() {}
+
+  virtual uint8_t Read() = 0;
+  virtual void Write(uint8_t data) = 0;
+};
+
+/*
+ * @brief The DMA controller.
+ *
+ * A channel with a start IRQ transfers one cell each time the interrupt flag
+ * for that IRQ is raised, regardless of whether the interrupt is enabled.
+ * Once the larger of the source or destination size has been transferred the
+ * channel disables itself. If the block complete interrupt is enabled for the
+ * channel, the channel's interrupt flag is raised.
+ *
+ * As on the PIC32MX5/6/7, the source & destination size registers are 8 bits
+ * wide, so a block is at most 256 bytes and a size of 0 means 256. Larger
+ * sizes are truncated to their low 8 bits, like the hardware does.
+ *
+ * Cell transfers complete immediately, we don't model the bus cycles. Memory
+ * is addressed using the physical addresses from KVA_TO_PA(). Addresses of
+ * peripheral registers must be mapped with MapRegister().
+ */
+class PeripheralDMA : public PeripheralDMAInterface,
+                      public InterruptController::Observer {
+ public:
+  // Ownership is not transferred.
+  explicit PeripheralDMA(InterruptController *interrupt_controller);
+  ~PeripheralDMA();
+
+  // Ownership is not transferred.
+  void MapRegister(const volatile void *address, DMARegister *reg);
+
+  // The number of cells transferred by a channel.
+  unsigned int CellCount(DMA_CHANNEL channel) const;
+
+  // The number of blocks a channel has completed.
+  unsigned int BlockCount(DMA_CHANNEL channel) const;
+
+  void InterruptRaised(INT_SOURCE source);
+
+  void Enable(DMA_MODULE_ID index);
+  void ChannelXStartIRQSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                           DMA_TRIGGER_SOURCE IRQ);
+  void ChannelXTriggerEnable(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                             DMA_CHANNEL_TRIGGER_TYPE trigger);
+  void ChannelXSourceStartAddressSet(DMA_MODULE_ID index,
+                                     DMA_CHANNEL channel,
+                                     uint32_t sourceStartAddress);
+  void ChannelXDestinationStartAddressSet(DMA_MODULE_ID index,
+                                          DMA_CHANNEL channel,
+                                          uint32_t destinationStartAddress);
+  void ChannelXSourceSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                             uint16_t sourceSize);
+  void ChannelXDestinationSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                  uint16_t destinationSize);
+  void ChannelXCellSizeSet(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                           uint16_t CellSize);
+  void ChannelXEnable(DMA_MODULE_ID index, DMA_CHANNEL channel);
+  bool ChannelXIsEnabled(DMA_MODULE_ID index, DMA_CHANNEL channel);
+  void ChannelXINTSourceEnable(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                               DMA_INT_TYPE dmaINTSource);
+  void ChannelXINTSourceFlagClear(DMA_MODULE_ID index, DMA_CHANNEL channel,
+                                  DMA_INT_TYPE dmaINTSource);
+
+ private:
+  struct Channel {
+   public:
+    Channel();
+
+    bool enabled;
+    bool block_interrupt_enabled;
+    bool start_irq_enabled;
+    bool has_start_irq;
+    INT_SOURCE start_irq;
+    uint32_t source_address;
+    uint32_t destination_address;
+    uint8_t source_size;
+    uint8_t destination_size;
+    uint16_t cell_size;
+    uint16_t source_pointer;
+    uint16_t destination_pointer;
+    uint32_t transferred;
+    unsigned int cell_count;
+    unsigned int block_count;
+  };
+
+  InterruptController *m_interrupt_controller;
+  bool m_enabled;
+  std::vector<Channel> m_channels;
+  std::map<const volatile void*, DMARegister*> m_registers;
+
+  Channel *GetChannel(DMA_MODULE_ID index, DMA_CHANNEL channel);
+  static unsigned int BlockSize(uint8_t size_register);
+  void TransferCell(DMA_CHANNEL channel_id, Channel *channel);
+  uint8_t ReadByte(uint32_t address, uint16_t offset);
+  void WriteByte(uint32_t address, uint16_t offset, uint8_t data);
+};
+
+#endif  // TESTS_SIM_PERIPHERALDMA_H_
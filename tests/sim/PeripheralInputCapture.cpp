@@ -26,7 +26,6 @@
 
 #include "macros.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 #include "peripheral/tmr/plib_tmr.h"
 
 PeripheralInputCapture::InputCapture::InputCapture(INT_SOURCE source)
@@ -53,9 +52,8 @@ PeripheralInputCapture::PeripheralInputCapture(
     Simulator *simulator,
     InterruptController *interrupt_controller)
     : m_simulator(simulator),
-      m_interrupt_controller(interrupt_controller),
-      m_callback(ola::NewCallback(this, &PeripheralInputCapture::Tick)) {
-  m_simulator->AddTask(m_callback.get());
+      m_interrupt_controller(interrupt_controller) {
+  m_simulator->AddPeripheral(this);
   std::vector<INT_SOURCE> timer_sources = {
     INT_SOURCE_INPUT_CAPTURE_1,
     INT_SOURCE_INPUT_CAPTURE_2,
@@ -69,7 +67,13 @@ PeripheralInputCapture::PeripheralInputCapture(
 }
 
 PeripheralInputCapture::~PeripheralInputCapture() {
-  m_simulator->RemoveTask(m_callback.get());
+  m_simulator->RemovePeripheral(this);
+}
+
+uint64_t PeripheralInputCapture::NextEvent() {
+  // Captures are triggered by the SignalGenerator, so there is nothing to
+  // schedule here.
+  return Simulator::kNoEvent;
 }
 
 void PeripheralInputCapture::Tick() {
@@ -22,16 +22,15 @@
 #define TESTS_SIM_PERIPHERALINPUTCAPTURE_H_
 
 #include <deque>
-#include <memory>
 #include <vector>
 
 #include "plib_ic_mock.h"
 
 #include "InterruptController.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
-class PeripheralInputCapture : public PeripheralInputCaptureInterface {
+class PeripheralInputCapture : public PeripheralInputCaptureInterface,
+                               public ClockedPeripheral {
  public:
   // Ownership is not transferred.
   PeripheralInputCapture(Simulator *simulator,
@@ -41,6 +40,7 @@ class PeripheralInputCapture : public PeripheralInputCaptureInterface {
   // Cause an IC event to fire.
   void TriggerEvent(IC_MODULE_ID index, IC_EDGE_TYPES edge_type);
 
+  uint64_t NextEvent();
   void Tick();
 
   void Enable(IC_MODULE_ID index);
@@ -60,7 +60,6 @@ class PeripheralInputCapture : public PeripheralInputCaptureInterface {
  private:
   Simulator *m_simulator;
   InterruptController *m_interrupt_controller;
-  std::unique_ptr<ola::Callback0<void>> m_callback;
 
   struct InputCapture {
    public:
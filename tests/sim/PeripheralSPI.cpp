@@ -22,11 +22,11 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <vector>
 
 #include "macros.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
 using std::vector;
 
@@ -35,12 +35,13 @@ PeripheralSPI::SPI::SPI(INT_SOURCE source)
       interrupt_source(source),
       fifo_size(1),
       ticks_per_byte(0),
-      counter(0),
+      transfer_end(0),
       in_transfer(false),
       has_overflowed(false),
       rx_interrupt_mode(SPI_FIFO_INTERRUPT_WHEN_RECEIVE_BUFFER_IS_FULL),
       tx_interrupt_mode(SPI_FIFO_INTERRUPT_WHEN_TRANSMIT_BUFFER_IS_NOT_FULL),
-      rx_iter(incoming_bytes.begin()) {
+      buffer_register(0),
+      rx_index(0) {
 }
 
 
@@ -48,9 +49,8 @@ PeripheralSPI::PeripheralSPI(
     Simulator *simulator,
     InterruptController *interrupt_controller)
     : m_simulator(simulator),
-      m_interrupt_controller(interrupt_controller),
-      m_callback(ola::NewCallback(this, &PeripheralSPI::Tick)) {
-  m_simulator->AddTask(m_callback.get());
+      m_interrupt_controller(interrupt_controller) {
+  m_simulator->AddPeripheral(this);
   std::vector<INT_SOURCE> spi_sources = {
     INT_SOURCE_SPI_1_ERROR,
     INT_SOURCE_SPI_2_ERROR,
@@ -58,12 +58,14 @@ PeripheralSPI::PeripheralSPI(
     INT_SOURCE_SPI_4_ERROR,
   };
   for (const auto &source : spi_sources) {
+    m_buffer_registers.emplace_back(new BufferRegisterImpl(
+        this, static_cast<SPI_MODULE_ID>(m_spi.size())));
     m_spi.push_back(SPI(source));
   }
 }
 
 PeripheralSPI::~PeripheralSPI() {
-  m_simulator->RemoveTask(m_callback.get());
+  m_simulator->RemovePeripheral(this);
 }
 
 void PeripheralSPI::QueueResponseByte(SPI_MODULE_ID index, uint8_t data) {
@@ -72,13 +74,7 @@ void PeripheralSPI::QueueResponseByte(SPI_MODULE_ID index, uint8_t data) {
     return;
   }
 
-  SPI *spi = &m_spi[index];
-  bool reset_iter = spi->rx_iter == spi->incoming_bytes.end();
-  spi->incoming_bytes.push_back(data);
-  if (reset_iter) {
-    spi->rx_iter = spi->incoming_bytes.end();
-    spi->rx_iter--;
-  }
+  m_spi[index].incoming_bytes.push_back(data);
 }
 
 vector<uint8_t> PeripheralSPI::SentBytes(SPI_MODULE_ID index) {
@@ -91,7 +87,31 @@ vector<uint8_t> PeripheralSPI::SentBytes(SPI_MODULE_ID index) {
   return spi->sent_bytes;
 }
 
+DMARegister *PeripheralSPI::BufferRegister(SPI_MODULE_ID index) {
+  if (index >= m_spi.size()) {
+    ADD_FAILURE() << "Invalid SPI " << index;
+    return nullptr;
+  }
+  return m_buffer_registers[index].get();
+}
+
+uint64_t PeripheralSPI::NextEvent() {
+  uint64_t next_event = Simulator::kNoEvent;
+  for (const auto &spi : m_spi) {
+    if (!spi.enabled) {
+      continue;
+    }
+    if (spi.in_transfer) {
+      next_event = std::min(next_event, spi.transfer_end);
+    } else if (!spi.tx_queue.empty()) {
+      next_event = std::min(next_event, m_simulator->Clock() + 1);
+    }
+  }
+  return next_event;
+}
+
 void PeripheralSPI::Tick() {
+  const uint64_t clock = m_simulator->Clock();
   for (auto &spi : m_spi) {
     if (!spi.enabled) {
       continue;
@@ -99,17 +119,16 @@ void PeripheralSPI::Tick() {
 
     bool run_tx_isr = false;
     if (spi.in_transfer) {
-      spi.counter++;
-      if (spi.counter == spi.ticks_per_byte) {
+      if (clock >= spi.transfer_end) {
         // transfer is complete.
         uint8_t tx_data = spi.tx_queue.front();
         spi.tx_queue.pop_front();
         spi.sent_bytes.push_back(tx_data);
 
         uint8_t rx_data = 0;
-        if (spi.rx_iter != spi.incoming_bytes.end()) {
-          rx_data = *spi.rx_iter;
-          spi.rx_iter++;
+        if (spi.rx_index < spi.incoming_bytes.size()) {
+          rx_data = spi.incoming_bytes[spi.rx_index];
+          spi.rx_index++;
         }
         if (spi.rx_queue.size() < spi.fifo_size) {
           spi.rx_queue.push_back(rx_data);
@@ -127,10 +146,10 @@ void PeripheralSPI::Tick() {
       }
     }
 
-    if (!spi.in_transfer) {
+    if (!spi.in_transfer && !spi.tx_queue.empty()) {
       // Start the next byte.
       spi.in_transfer = true;
-      spi.counter = 0;
+      spi.transfer_end = clock + spi.ticks_per_byte;
     }
 
     switch (spi.tx_interrupt_mode) {
@@ -304,6 +323,14 @@ uint8_t PeripheralSPI::BufferRead(SPI_MODULE_ID index) {
   return data;
 }
 
+void* PeripheralSPI::BufferAddressGet(SPI_MODULE_ID index) {
+  if (index >= m_spi.size()) {
+    ADD_FAILURE() << "Invalid SPI " << index;
+    return NULL;
+  }
+  return &m_spi[index].buffer_register;
+}
+
 void PeripheralSPI::SlaveSelectDisable(SPI_MODULE_ID index) {
   if (index >= m_spi.size()) {
     ADD_FAILURE() << "Invalid SPI " << index;
@@ -28,10 +28,11 @@
 #include "plib_spi_mock.h"
 
 #include "InterruptController.h"
+#include "PeripheralDMA.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
-class PeripheralSPI : public PeripheralSPIInterface {
+class PeripheralSPI : public PeripheralSPIInterface,
+                      public ClockedPeripheral {
  public:
   // Ownership is not transferred.
   PeripheralSPI(Simulator *simulator,
@@ -43,6 +44,10 @@ class PeripheralSPI : public PeripheralSPIInterface {
 
   std::vector<uint8_t> SentBytes(SPI_MODULE_ID index);
 
+  // The SPIxBUF register, for mapping into the DMA controller.
+  DMARegister *BufferRegister(SPI_MODULE_ID index);
+
+  uint64_t NextEvent();
   void Tick();
 
   void Enable(SPI_MODULE_ID index);
@@ -63,6 +68,7 @@ class PeripheralSPI : public PeripheralSPIInterface {
   void BufferWrite(SPI_MODULE_ID index, uint8_t data);
   void BufferClear(SPI_MODULE_ID index);
   uint8_t BufferRead(SPI_MODULE_ID index);
+  void* BufferAddressGet(SPI_MODULE_ID index);
   void SlaveSelectDisable(SPI_MODULE_ID index);
   void PinDisable(SPI_MODULE_ID index, SPI_PIN pin);
 
@@ -71,7 +77,6 @@ class PeripheralSPI : public PeripheralSPIInterface {
 
   Simulator *m_simulator;
   InterruptController *m_interrupt_controller;
-  std::unique_ptr<ola::Callback0<void>> m_callback;
 
   struct SPI {
    public:
@@ -81,11 +86,14 @@ class PeripheralSPI : public PeripheralSPIInterface {
     const INT_SOURCE interrupt_source;
     uint8_t fifo_size;
     uint32_t ticks_per_byte;
-    uint32_t counter;
+    // The clock value at which the current transfer completes.
+    uint64_t transfer_end;
     bool in_transfer;
     bool has_overflowed;
     SPI_FIFO_INTERRUPT rx_interrupt_mode;
     SPI_FIFO_INTERRUPT tx_interrupt_mode;
+    // Stands in for the SPIxBUF register.
+    uint32_t buffer_register;
 
     // The queue for outgoing bytes.
     std::deque<uint32_t> tx_queue;
@@ -96,12 +104,27 @@ class PeripheralSPI : public PeripheralSPIInterface {
     ByteVector sent_bytes;
     // Incoming bytes to return.
     ByteVector incoming_bytes;
-    ByteVector::iterator rx_iter;
+    // The index of the next incoming byte to return.
+    size_t rx_index;
 
     static const uint8_t ENHANCED_BUFFER_SIZE = 8;
   };
 
+  class BufferRegisterImpl : public DMARegister {
+   public:
+    BufferRegisterImpl(PeripheralSPI *spi, SPI_MODULE_ID index)
+        : m_spi(spi), m_index(index) {}
+
+    uint8_t Read() { return m_spi->BufferRead(m_index); }
+    void Write(uint8_t data) { m_spi->BufferWrite(m_index, data); }
+
+   private:
+    PeripheralSPI *m_spi;
+    const SPI_MODULE_ID m_index;
+  };
+
   std::vector<SPI> m_spi;
+  std::vector<std::unique_ptr<BufferRegisterImpl>> m_buffer_registers;
 };
 
 #endif  // TESTS_SIM_PERIPHERALSPI_H_
@@ -22,27 +22,28 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <vector>
 
 #include "macros.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
 PeripheralTimer::Timer::Timer(INT_SOURCE source)
     : enabled(false),
       in_isr(false),
+      matched(false),
       counter(0),
       period(0),
       interrupt_source(source),
-      prescale(TMR_PRESCALE_VALUE_1) {
+      prescale(TMR_PRESCALE_VALUE_1),
+      updated_at(0) {
 }
 
 PeripheralTimer::PeripheralTimer(Simulator *simulator,
                                  InterruptController *interrupt_controller)
     : m_simulator(simulator),
-      m_interrupt_controller(interrupt_controller),
-      m_callback(ola::NewCallback(this, &PeripheralTimer::Tick)) {
-  m_simulator->AddTask(m_callback.get());
+      m_interrupt_controller(interrupt_controller) {
+  m_simulator->AddPeripheral(this);
   std::vector<INT_SOURCE> timer_ids = {
     INT_SOURCE_TIMER_1,
     INT_SOURCE_TIMER_2,
@@ -66,23 +67,45 @@ PeripheralTimer::PeripheralTimer(Simulator *simulator,
 }
 
 PeripheralTimer::~PeripheralTimer() {
-  m_simulator->RemoveTask(m_callback.get());
+  m_simulator->RemovePeripheral(this);
 }
 
-void PeripheralTimer::Tick() {
-  uint64_t ticks = m_simulator->Clock();
+uint64_t PeripheralTimer::NextEvent() {
+  uint64_t next_event = Simulator::kNoEvent;
   for (auto &timer : m_timers) {
-    if (timer.enabled && (ticks % m_prescale_values[timer.prescale] == 0)) {
-      if (timer.counter == timer.period) {
-        timer.counter = 0;
-      } else {
-        timer.counter++;
-        if (timer.counter == timer.period) {
-          timer.in_isr = true;
-          m_interrupt_controller->RaiseInterrupt(timer.interrupt_source);
-          timer.in_isr = false;
-        }
+    if (!timer.enabled) {
+      continue;
+    }
+    UpdateCounter(&timer);
+
+    // The number of increments until the counter next matches the period.
+    uint64_t increments = static_cast<uint16_t>(timer.period - timer.counter);
+    if (timer.counter == timer.period) {
+      if (timer.period == 0) {
+        continue;
       }
+      // Reset to 0 and then count up to the period.
+      increments = timer.period + 1;
+    }
+
+    const uint16_t prescale = m_prescale_values[timer.prescale];
+    next_event = std::min(
+        next_event, (timer.updated_at / prescale + increments) * prescale);
+  }
+  return next_event;
+}
+
+void PeripheralTimer::Tick() {
+  for (auto &timer : m_timers) {
+    if (!timer.enabled) {
+      continue;
+    }
+    UpdateCounter(&timer);
+    if (timer.matched) {
+      timer.matched = false;
+      timer.in_isr = true;
+      m_interrupt_controller->RaiseInterrupt(timer.interrupt_source);
+      timer.in_isr = false;
     }
   }
 }
@@ -92,11 +115,15 @@ void PeripheralTimer::Counter16BitSet(TMR_MODULE_ID index, uint16_t value) {
     FAIL() << "Invalid timer " << index;
   }
 
-  m_timers[index].counter = value;
+  Timer *timer = &m_timers[index];
+  UpdateCounter(timer);
+  timer->counter = value;
+  timer->matched = false;
 }
 
 uint16_t PeripheralTimer::Counter16BitGet(TMR_MODULE_ID index) {
   if (index < m_timers.size()) {
+    UpdateCounter(&m_timers[index]);
     return m_timers[index].counter;
   }
   return 0;
@@ -125,6 +152,7 @@ void PeripheralTimer::Period16BitSet(TMR_MODULE_ID index, uint16_t period) {
 void PeripheralTimer::Stop(TMR_MODULE_ID index) {
   if (index < m_timers.size()) {
     // This does not reset the counter to 0
+    UpdateCounter(&m_timers[index]);
     m_timers[index].enabled = false;
   } else {
     FAIL() << "Invalid timer " << index;
@@ -133,7 +161,11 @@ void PeripheralTimer::Stop(TMR_MODULE_ID index) {
 
 void PeripheralTimer::Start(TMR_MODULE_ID index) {
   if (index < m_timers.size()) {
-    m_timers[index].enabled = true;
+    Timer *timer = &m_timers[index];
+    if (!timer->enabled) {
+      timer->enabled = true;
+      timer->updated_at = m_simulator->Clock();
+    }
   } else {
     FAIL() << "Invalid timer " << index;
   }
@@ -191,3 +223,38 @@ void PeripheralTimer::Mode16BitEnable(TMR_MODULE_ID index) {
   }
 }
 
+
+/*
+ * Bring the counter up to date with the simulator clock. The counter
+ * increments on every clock cycle that is a multiple of the prescaler.
+ */
+void PeripheralTimer::UpdateCounter(Timer *timer) {
+  const uint64_t now = m_simulator->Clock();
+  if (!timer->enabled || now <= timer->updated_at) {
+    return;
+  }
+
+  const uint16_t prescale = m_prescale_values[timer->prescale];
+  uint64_t increments = now / prescale - timer->updated_at / prescale;
+  timer->updated_at = now;
+  if (increments == 0) {
+    return;
+  }
+
+  timer->matched = false;
+  while (increments) {
+    if (timer->counter == timer->period) {
+      timer->counter = 0;
+      increments--;
+      continue;
+    }
+    const uint16_t until_match = timer->period - timer->counter;
+    if (increments < until_match) {
+      timer->counter += increments;
+      return;
+    }
+    timer->counter = timer->period;
+    increments -= until_match;
+    timer->matched = increments == 0;
+  }
+}
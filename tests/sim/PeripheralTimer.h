@@ -21,7 +21,6 @@
 #ifndef TESTS_SIM_PERIPHERALTIMER_H_
 #define TESTS_SIM_PERIPHERALTIMER_H_
 
-#include <memory>
 #include <map>
 #include <vector>
 
@@ -29,15 +28,16 @@
 
 #include "InterruptController.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
-class PeripheralTimer : public PeripheralTimerInterface {
+class PeripheralTimer : public PeripheralTimerInterface,
+                        public ClockedPeripheral {
  public:
   // Ownership is not transferred.
   PeripheralTimer(Simulator *simulator,
                   InterruptController *interrupt_controller);
   ~PeripheralTimer();
 
+  uint64_t NextEvent();
   void Tick();
 
   void Counter16BitSet(TMR_MODULE_ID index, uint16_t value);
@@ -54,7 +54,6 @@ class PeripheralTimer : public PeripheralTimerInterface {
  private:
   Simulator *m_simulator;
   InterruptController *m_interrupt_controller;
-  std::unique_ptr<ola::Callback0<void>> m_callback;
 
   struct Timer {
    public:
@@ -62,12 +61,18 @@ class PeripheralTimer : public PeripheralTimerInterface {
 
      bool enabled;
      bool in_isr;
+     // Set if the last increment took the counter to the period.
+     bool matched;
      uint16_t counter;
      uint16_t period;
      INT_SOURCE interrupt_source;
      TMR_PRESCALE prescale;
+     // The clock value the counter was last brought up to date at.
+     uint64_t updated_at;
   };
 
+  void UpdateCounter(Timer *timer);
+
   std::vector<Timer> m_timers;
   std::map<TMR_PRESCALE, uint16_t> m_prescale_values;
 };
@@ -21,11 +21,12 @@
 #include "PeripheralUART.h"
 
 #include <gtest/gtest.h>
+
+#include <algorithm>
 #include <vector>
 
 #include "macros.h"
 #include "Simulator.h"
-#include "ola/Callback.h"
 
 using std::vector;
 
@@ -38,7 +39,7 @@ PeripheralUART::UART::UART(INT_SOURCE source)
       tx_byte(0),
       errors(USART_ERROR_NONE),
       ticks_per_bit(16),
-      tx_counter(0),
+      tx_bit_end(0),
       tx_state(IDLE) {
 }
 
@@ -47,9 +48,8 @@ PeripheralUART::PeripheralUART(Simulator *simulator,
                                TXCallback *tx_callback)
     : m_simulator(simulator),
       m_interrupt_controller(interrupt_controller),
-      m_tx_callback(tx_callback),
-      m_callback(ola::NewCallback(this, &PeripheralUART::Tick)) {
-  m_simulator->AddTask(m_callback.get());
+      m_tx_callback(tx_callback) {
+  m_simulator->AddPeripheral(this);
 
   const vector<INT_SOURCE> sources = {
     INT_SOURCE_USART_1_ERROR,
@@ -65,10 +65,27 @@ PeripheralUART::PeripheralUART(Simulator *simulator,
 }
 
 PeripheralUART::~PeripheralUART() {
-  m_simulator->RemoveTask(m_callback.get());
+  m_simulator->RemovePeripheral(this);
+}
+
+uint64_t PeripheralUART::NextEvent() {
+  uint64_t next_event = Simulator::kNoEvent;
+  for (const auto &uart : m_uarts) {
+    if (!(uart.enabled && uart.tx_enable)) {
+      continue;
+    }
+    if (uart.tx_state != IDLE) {
+      next_event = std::min(next_event, uart.tx_bit_end);
+    } else if (!uart.tx_buffer.empty()) {
+      // The next byte is loaded on the following cycle.
+      next_event = std::min(next_event, m_simulator->Clock() + 1);
+    }
+  }
+  return next_event;
 }
 
 void PeripheralUART::Tick() {
+  const uint64_t clock = m_simulator->Clock();
   for (unsigned int i = 0; i < m_uarts.size(); i++) {
     UART &uart = m_uarts[i];
     if (!uart.enabled) {
@@ -80,12 +97,10 @@ void PeripheralUART::Tick() {
         uart.tx_state = START_BIT;
         uart.tx_byte = uart.tx_buffer.front();
         uart.tx_buffer.pop();
+        uart.tx_bit_end = clock + uart.ticks_per_bit - 1;
       }
       if (uart.tx_state != IDLE) {
-        uart.tx_counter++;
-        if (uart.tx_counter == uart.ticks_per_bit) {
-          uart.tx_counter = 0;
-
+        if (clock >= uart.tx_bit_end) {
           if (uart.tx_state == STOP_BIT_2) {
             if (m_tx_callback) {
               m_tx_callback->Run(static_cast<USART_MODULE_ID>(i), uart.tx_byte);
@@ -93,6 +108,7 @@ void PeripheralUART::Tick() {
             uart.tx_state = IDLE;
           } else {
             uart.tx_state = static_cast<UARTState>(uart.tx_state + 1);
+            uart.tx_bit_end += uart.ticks_per_bit;
           }
         }
 
@@ -131,6 +147,10 @@ void PeripheralUART::ReceiveByte(USART_MODULE_ID index, uint8_t byte) {
   UART &uart = m_uarts[index];
   if (uart.rx_enable) {
     uart.rx_buffer.push(byte);
+    if (uart.enabled) {
+      m_interrupt_controller->RaiseInterrupt(
+          static_cast<INT_SOURCE>(uart.interrupt_source + 1));
+    }
   }
 }
 
@@ -175,7 +195,6 @@ void PeripheralUART::Disable(USART_MODULE_ID index) {
   while (!uart.rx_buffer.empty()) {
     uart.rx_buffer.pop();
   }
-  uart.tx_counter = 0;
   uart.tx_state = IDLE;
   // TODO(simon): reset flags here
   uart.errors = USART_ERROR_NONE;
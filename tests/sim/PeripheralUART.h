@@ -21,7 +21,6 @@
 #ifndef TESTS_SIM_PERIPHERALUART_H_
 #define TESTS_SIM_PERIPHERALUART_H_
 
-#include <memory>
 #include <queue>
 #include <vector>
 
@@ -31,7 +30,8 @@
 #include "Simulator.h"
 #include "ola/Callback.h"
 
-class PeripheralUART : public PeripheralUSARTInterface {
+class PeripheralUART : public PeripheralUSARTInterface,
+                       public ClockedPeripheral {
  public:
   // Invoked when a byte is transmitted.
   typedef ola::Callback2<void, USART_MODULE_ID, uint8_t> TXCallback;
@@ -42,6 +42,7 @@ class PeripheralUART : public PeripheralUSARTInterface {
                  TXCallback *tx_callback);
   ~PeripheralUART();
 
+  uint64_t NextEvent();
   void Tick();
 
   // Used to push a byte of data to the receiver.
@@ -76,7 +77,6 @@ class PeripheralUART : public PeripheralUSARTInterface {
   Simulator *m_simulator;
   InterruptController *m_interrupt_controller;
   TXCallback *m_tx_callback;
-  std::unique_ptr<ola::Callback0<void>> m_callback;
 
   enum UARTState {
     IDLE,
@@ -110,7 +110,8 @@ class PeripheralUART : public PeripheralUSARTInterface {
     uint8_t errors;
 
     uint32_t ticks_per_bit;
-    uint32_t tx_counter;
+    // The clock value at which the current TX bit ends.
+    uint64_t tx_bit_end;
     UARTState tx_state;
 
     static const uint16_t FRAMING_ERROR_FLAG = 0x8000;
@@ -0,0 +1,300 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * RDMBus.cpp
+ * A simulated RDM bus with a number of virtual responders.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include "RDMBus.h"
+
+#include <algorithm>
+
+#include "constants.h"
+#include "rdm.h"
+
+namespace {
+
+// Offsets into the request, including the start code.
+enum {
+  DESTINATION_UID_OFFSET = 3,
+  SOURCE_UID_OFFSET = 9,
+  TRANSACTION_NUMBER_OFFSET = 15,
+  COMMAND_CLASS_OFFSET = 20,
+  PID_OFFSET = 21,
+};
+
+enum { DUB_PREAMBLE_LENGTH = 7 };
+enum { DUB_PARAM_DATA_LENGTH = 2 * UID_LENGTH };
+enum { MUTE_CONTROL_FIELD_SIZE = 2 };
+
+const uint8_t DUB_PREAMBLE_BYTE = 0xfe;
+const uint8_t DUB_PREAMBLE_SEPARATOR = 0xaa;
+
+}  // namespace
+
+const uint32_t RDMBus::kDefaultTurnaround;
+const uint64_t RDMBus::kBroadcastUID;
+
+RDMBus::RDMBus(Simulator *simulator,
+               SignalGenerator *signal_generator,
+               uint32_t clock_speed,
+               uint32_t baud_rate)
+    : m_simulator(simulator),
+      m_generator(signal_generator),
+      m_byte_time(11 * 1000000 / baud_rate),
+      m_frame_gap(2ull * 11 * clock_speed / baud_rate),
+      m_last_byte_at(0),
+      m_stats() {
+}
+
+void RDMBus::AddResponder(uint64_t uid, uint32_t turnaround) {
+  m_responders.insert(std::make_pair(uid, Responder(uid, turnaround)));
+}
+
+bool RDMBus::IsMuted(uint64_t uid) const {
+  ResponderMap::const_iterator iter = m_responders.find(uid);
+  return iter != m_responders.end() && iter->second.muted;
+}
+
+unsigned int RDMBus::ResponderCount() const {
+  return m_responders.size();
+}
+
+/*
+ * The controller sends a break before each request, which shows up here as a
+ * gap between bytes. We use that to find the start of the next frame.
+ */
+void RDMBus::ReceiveByte(uint8_t byte) {
+  uint64_t now = m_simulator->Clock();
+  if (!m_frame.empty() && now - m_last_byte_at > m_frame_gap) {
+    m_frame.clear();
+  }
+  m_last_byte_at = now;
+  m_frame.push_back(byte);
+
+  if (m_frame[0] != RDM_START_CODE || m_frame.size() <= MESSAGE_LENGTH_OFFSET) {
+    return;
+  }
+
+  unsigned int message_length = m_frame[MESSAGE_LENGTH_OFFSET];
+  if (message_length < RDM_PARAM_DATA_OFFSET) {
+    return;
+  }
+
+  if (m_frame.size() == message_length + RDM_CHECKSUM_LENGTH) {
+    HandleRequest();
+    m_frame.clear();
+  }
+}
+
+const RDMBus::Stats& RDMBus::GetStats() const {
+  return m_stats;
+}
+
+void RDMBus::ResetStats() {
+  m_stats = Stats();
+}
+
+void RDMBus::HandleRequest() {
+  const uint8_t *request = m_frame.data();
+  unsigned int message_length = request[MESSAGE_LENGTH_OFFSET];
+  uint16_t checksum = (request[message_length] << 8) +
+                      request[message_length + 1];
+  if (request[1] != SUB_START_CODE ||
+      Checksum(request, message_length) != checksum) {
+    m_stats.checksum_errors++;
+    return;
+  }
+
+  m_stats.requests++;
+  unsigned int param_data_length = request[RDM_PARAM_DATA_LENGTH_OFFSET];
+  if (RDM_PARAM_DATA_OFFSET + param_data_length != message_length ||
+      request[COMMAND_CLASS_OFFSET] != DISCOVERY_COMMAND) {
+    return;
+  }
+
+  uint64_t destination = ExtractUID(request + DESTINATION_UID_OFFSET);
+  uint16_t pid = (request[PID_OFFSET] << 8) + request[PID_OFFSET + 1];
+  switch (pid) {
+    case PID_DISC_UNIQUE_BRANCH:
+      if (param_data_length == DUB_PARAM_DATA_LENGTH &&
+          (destination & 0xffffffff) == 0xffffffff) {
+        const uint8_t *param_data = request + RDM_PARAM_DATA_OFFSET;
+        HandleDUB(ExtractUID(param_data), ExtractUID(param_data + UID_LENGTH));
+      }
+      break;
+    case PID_DISC_MUTE:
+      HandleMute(destination, true);
+      break;
+    case PID_DISC_UN_MUTE:
+      HandleMute(destination, false);
+      break;
+    default:
+      {}
+  }
+}
+
+/*
+ * Each replying responder writes its response into a series of byte slots,
+ * offset by how much later it starts than the fastest responder. Overlapping
+ * bytes are ORed together, slots that no responder wrote to are left idle.
+ */
+void RDMBus::HandleDUB(uint64_t lower, uint64_t upper) {
+  m_stats.dub_requests++;
+
+  std::vector<const Responder*> replying;
+  ResponderMap::const_iterator iter = m_responders.lower_bound(lower);
+  for (; iter != m_responders.end() && iter->first <= upper; ++iter) {
+    if (!iter->second.muted) {
+      replying.push_back(&iter->second);
+    }
+  }
+
+  if (replying.empty()) {
+    return;
+  }
+
+  m_stats.dub_responses++;
+  if (replying.size() > 1) {
+    m_stats.collisions++;
+  }
+
+  uint32_t min_turnaround = replying[0]->turnaround;
+  for (const Responder *responder : replying) {
+    min_turnaround = std::min(min_turnaround, responder->turnaround);
+  }
+
+  std::vector<int> slots;
+  for (const Responder *responder : replying) {
+    uint8_t response[DUB_RESPONSE_LENGTH];
+    uint8_t *ptr = response;
+    for (unsigned int i = 0; i < DUB_PREAMBLE_LENGTH; i++) {
+      *ptr++ = DUB_PREAMBLE_BYTE;
+    }
+    *ptr++ = DUB_PREAMBLE_SEPARATOR;
+
+    uint8_t uid[UID_LENGTH];
+    PackUID(responder->uid, uid);
+    for (unsigned int i = 0; i < UID_LENGTH; i++) {
+      *ptr++ = uid[i] | 0xaa;
+      *ptr++ = uid[i] | 0x55;
+    }
+    uint16_t checksum = Checksum(response + DUB_PREAMBLE_LENGTH + 1,
+                                 DUB_PARAM_DATA_LENGTH);
+    *ptr++ = (checksum >> 8) | 0xaa;
+    *ptr++ = (checksum >> 8) | 0x55;
+    *ptr++ = (checksum & 0xff) | 0xaa;
+    *ptr++ = (checksum & 0xff) | 0x55;
+
+    unsigned int offset = (responder->turnaround - min_turnaround) /
+                          m_byte_time;
+    if (slots.size() < offset + DUB_RESPONSE_LENGTH) {
+      slots.resize(offset + DUB_RESPONSE_LENGTH, -1);
+    }
+    for (unsigned int i = 0; i < DUB_RESPONSE_LENGTH; i++) {
+      int &slot = slots[offset + i];
+      slot = (slot < 0 ? 0 : slot) | response[i];
+    }
+  }
+
+  m_generator->AddDelay(min_turnaround);
+  for (int slot : slots) {
+    if (slot < 0) {
+      m_generator->AddDelay(m_byte_time);
+    } else {
+      m_generator->AddByte(slot);
+    }
+  }
+}
+
+void RDMBus::HandleMute(uint64_t destination, bool mute) {
+  if (mute) {
+    m_stats.mute_requests++;
+  } else {
+    m_stats.unmute_requests++;
+  }
+
+  for (auto &iter : m_responders) {
+    if (IsAddressed(destination, iter.first)) {
+      iter.second.muted = mute;
+    }
+  }
+
+  ResponderMap::const_iterator iter = m_responders.find(destination);
+  if (iter != m_responders.end()) {
+    SendMuteResponse(iter->second);
+  }
+}
+
+void RDMBus::SendMuteResponse(const Responder &responder) {
+  const uint8_t *request = m_frame.data();
+  const uint8_t message_length = RDM_PARAM_DATA_OFFSET +
+                                 MUTE_CONTROL_FIELD_SIZE;
+  uint8_t response[message_length + RDM_CHECKSUM_LENGTH] = {
+    RDM_START_CODE, SUB_START_CODE, message_length
+  };
+  std::copy(request + SOURCE_UID_OFFSET,
+            request + SOURCE_UID_OFFSET + UID_LENGTH,
+            response + DESTINATION_UID_OFFSET);
+  PackUID(responder.uid, response + SOURCE_UID_OFFSET);
+  response[TRANSACTION_NUMBER_OFFSET] = request[TRANSACTION_NUMBER_OFFSET];
+  response[TRANSACTION_NUMBER_OFFSET + 1] = ACK;
+  response[COMMAND_CLASS_OFFSET] = DISCOVERY_COMMAND_RESPONSE;
+  response[PID_OFFSET] = request[PID_OFFSET];
+  response[PID_OFFSET + 1] = request[PID_OFFSET + 1];
+  response[RDM_PARAM_DATA_LENGTH_OFFSET] = MUTE_CONTROL_FIELD_SIZE;
+
+  uint16_t checksum = Checksum(response, message_length);
+  response[message_length] = checksum >> 8;
+  response[message_length + 1] = checksum & 0xff;
+
+  m_generator->AddDelay(responder.turnaround);
+  m_generator->AddBreak(176);
+  m_generator->AddMark(12);
+  m_generator->AddFrame(response, sizeof(response));
+}
+
+bool RDMBus::IsAddressed(uint64_t destination, uint64_t uid) const {
+  if (destination == uid || destination == kBroadcastUID) {
+    return true;
+  }
+  // Vendorcast
+  return (destination & 0xffffffff) == 0xffffffff &&
+         (destination >> 32) == (uid >> 32);
+}
+
+uint64_t RDMBus::ExtractUID(const uint8_t *data) {
+  uint64_t uid = 0;
+  for (unsigned int i = 0; i < UID_LENGTH; i++) {
+    uid = (uid << 8) + data[i];
+  }
+  return uid;
+}
+
+void RDMBus::PackUID(uint64_t uid, uint8_t *data) {
+  for (int i = UID_LENGTH - 1; i >= 0; i--) {
+    data[i] = uid & 0xff;
+    uid >>= 8;
+  }
+}
+
+uint16_t RDMBus::Checksum(const uint8_t *data, unsigned int size) {
+  uint16_t checksum = 0;
+  for (unsigned int i = 0; i < size; i++) {
+    checksum += data[i];
+  }
+  return checksum;
+}
@@ -0,0 +1,136 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * RDMBus.h
+ * A simulated RDM bus with a number of virtual responders.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#ifndef TESTS_SIM_RDMBUS_H_
+#define TESTS_SIM_RDMBUS_H_
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "SignalGenerator.h"
+#include "Simulator.h"
+
+/*
+ * @brief Simulates the responders on an RDM line.
+ *
+ * The bus is fed the bytes the controller transmits, usually from the UART's
+ * TX callback. Once a complete RDM request has been received, each virtual
+ * responder decides if it should reply and the replies are played back to the
+ * controller using the SignalGenerator.
+ *
+ * Only the discovery commands are modeled:
+ *  - DISC_UNIQUE_BRANCH, every un-muted responder within the range replies.
+ *    If more than one responder replies, the responses collide and the
+ *    controller sees the bytes ORed together, offset by any difference in
+ *    the turnaround times.
+ *  - DISC_MUTE / DISC_UN_MUTE, these update the mute state of the addressed
+ *    responders. Unicast requests receive a response.
+ *
+ * UIDs are represented as 48-bit integers, with the manufacturer ID in the
+ * top 16 bits.
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ *  RDMBus bus(&simulator, &signal_generator, kClockSpeed, kBaudRate);
+ *  bus.AddResponder(0x7a7000000001);
+ *  bus.AddResponder(0x7a7000000002, 500);  // 500uS turnaround
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ */
+class RDMBus {
+ public:
+  struct Stats {
+    uint32_t requests;  // Valid RDM requests seen
+    uint32_t checksum_errors;
+    uint32_t dub_requests;
+    uint32_t dub_responses;  // DUBs that at least one responder replied to
+    uint32_t collisions;  // DUBs that more than one responder replied to
+    uint32_t mute_requests;
+    uint32_t unmute_requests;
+  };
+
+  RDMBus(Simulator *simulator,
+         SignalGenerator *signal_generator,
+         uint32_t clock_speed,
+         uint32_t baud_rate);
+
+  /*
+   * @brief Add a virtual responder to the bus.
+   * @param uid The UID of the responder.
+   * @param turnaround The delay in micro-seconds between the end of the
+   *   request and the start of the response.
+   */
+  void AddResponder(uint64_t uid, uint32_t turnaround = kDefaultTurnaround);
+
+  /*
+   * @brief Check if a responder is muted.
+   */
+  bool IsMuted(uint64_t uid) const;
+
+  /*
+   * @brief The number of responders on the bus.
+   */
+  unsigned int ResponderCount() const;
+
+  /*
+   * @brief Called for each byte the controller transmits.
+   */
+  void ReceiveByte(uint8_t byte);
+
+  const Stats& GetStats() const;
+  void ResetStats();
+
+  // The turnaround time, in micro-seconds, if one isn't specified.
+  static const uint32_t kDefaultTurnaround = 176;
+
+  static const uint64_t kBroadcastUID = 0xffffffffffffull;
+
+ private:
+  struct Responder {
+    Responder(uint64_t uid, uint32_t turnaround)
+      : uid(uid), turnaround(turnaround), muted(false) {}
+
+    uint64_t uid;
+    uint32_t turnaround;
+    bool muted;
+  };
+
+  typedef std::map<uint64_t, Responder> ResponderMap;
+
+  Simulator *m_simulator;
+  SignalGenerator *m_generator;
+  const uint32_t m_byte_time;  // in micro-seconds
+  const uint64_t m_frame_gap;  // in clock cycles
+  ResponderMap m_responders;
+  std::vector<uint8_t> m_frame;
+  uint64_t m_last_byte_at;
+  Stats m_stats;
+
+  void HandleRequest();
+  void HandleDUB(uint64_t lower, uint64_t upper);
+  void HandleMute(uint64_t destination, bool mute);
+  void SendMuteResponse(const Responder &responder);
+  bool IsAddressed(uint64_t destination, uint64_t uid) const;
+
+  static uint64_t ExtractUID(const uint8_t *data);
+  static void PackUID(uint64_t uid, uint8_t *data);
+  static uint16_t Checksum(const uint8_t *data, unsigned int size);
+};
+
+#endif  // TESTS_SIM_RDMBUS_H_
@@ -21,6 +21,8 @@
 #include "SignalGenerator.h"
 
 #include <stdint.h>
+
+#include <algorithm>
 #include <queue>
 
 #include "PeripheralInputCapture.h"
@@ -46,18 +48,42 @@ SignalGenerator::SignalGenerator(Simulator *simulator,
       m_framing_error_at(0),
       m_line_state(HIGH),
       m_tx_byte(0),
-      m_state(IDLE),
-      m_callback(ola::NewCallback(this, &SignalGenerator::Tick)) {
-  m_simulator->AddTask(m_callback.get());
+      m_state(IDLE) {
+  m_simulator->AddPeripheral(this);
 }
 
 SignalGenerator::~SignalGenerator() {
-  m_simulator->RemoveTask(m_callback.get());
+  m_simulator->RemovePeripheral(this);
+}
+
+uint64_t SignalGenerator::NextEvent() {
+  const uint64_t clock = m_simulator->Clock();
+  uint64_t next_event = Simulator::kNoEvent;
+  switch (m_state) {
+    case IDLE:
+      if (m_events.empty() && !m_stop_on_complete) {
+        break;
+      }
+      next_event = std::max(m_next_event_at, clock + 1);
+      break;
+    case STOPPED:
+      if (!m_events.empty()) {
+        next_event = clock + 1;
+      }
+      break;
+    default:
+      next_event = std::max(m_next_event_at, clock + 1);
+  }
+
+  if (m_framing_error_at) {
+    next_event = std::min(next_event, m_framing_error_at);
+  }
+  return next_event;
 }
 
 void SignalGenerator::Tick() {
   uint64_t clock = m_simulator->Clock();
-  if (m_framing_error_at && clock == m_framing_error_at) {
+  if (m_framing_error_at && clock >= m_framing_error_at) {
     // A framing error causes a byte to be received as well.
     m_uart->SignalFramingError(m_uart_index, 0);
     m_uart->ReceiveByte(m_uart_index, 0);
@@ -97,6 +123,12 @@ void SignalGenerator::Tick() {
       return;
     case HALTING:
       m_simulator->Stop();
+      m_state = STOPPED;
+      break;
+    case STOPPED:
+      if (!m_events.empty()) {
+        ProcessNextEvent();
+      }
       break;
   }
 }
@@ -144,6 +176,8 @@ void SignalGenerator::ProcessNextEvent() {
     if (m_stop_on_complete) {
       AddDurationToClock(10);
       m_state = HALTING;
+    } else {
+      m_state = IDLE;
     }
     return;
   }
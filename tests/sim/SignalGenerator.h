@@ -50,7 +50,7 @@
  *  signal_generator.AddByte(0);
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
  */
-class SignalGenerator {
+class SignalGenerator : public ClockedPeripheral {
  public:
   SignalGenerator(Simulator *simulator,
                   PeripheralInputCapture *input_capture,
@@ -61,6 +61,7 @@ class SignalGenerator {
                   uint32_t uart_baud_rate);
   ~SignalGenerator();
 
+  uint64_t NextEvent();
   void Tick();
 
   /*
@@ -145,6 +146,7 @@ class SignalGenerator {
     STOP_BIT_1,
     STOP_BIT_2,
     HALTING,
+    STOPPED,  // We stopped the simulator, wait for more events.
   };
 
   enum LineState {
@@ -166,7 +168,6 @@ class SignalGenerator {
   LineState m_line_state;
   uint8_t m_tx_byte;
   State m_state;
-  std::unique_ptr<ola::Callback0<void>> m_callback;
   std::queue<Event> m_events;
 
   void ProcessNextEvent();
@@ -22,12 +22,19 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <limits>
+
+const uint64_t Simulator::kNoEvent = std::numeric_limits<uint64_t>::max();
+const uint32_t Simulator::kDefaultTaskInterval = 1;
+
 Simulator::Simulator(uint32_t clock_speed)
     : m_clock_speed(clock_speed),
       m_run(true),
       m_clock_limit(0),
       m_clock_limit_fatal(false),
-      m_clock(0) {
+      m_clock(0),
+      m_task_interval((clock_speed / 1000000) * kDefaultTaskInterval) {
 }
 
 void Simulator::SetClockLimit(uint64_t duration, bool fatal) {
@@ -35,6 +42,11 @@ void Simulator::SetClockLimit(uint64_t duration, bool fatal) {
   m_clock_limit_fatal = fatal;
 }
 
+void Simulator::SetTaskInterval(uint32_t duration) {
+  m_task_interval = std::max<uint64_t>(
+      (m_clock_speed / 1000000) * duration, 1);
+}
+
 void Simulator::AddTask(TaskFn *fn) {
   m_tasks.insert(fn);
 }
@@ -43,19 +55,38 @@ void Simulator::RemoveTask(TaskFn *fn) {
   m_tasks.erase(fn);
 }
 
+void Simulator::AddPeripheral(ClockedPeripheral *peripheral) {
+  m_peripherals.push_back(peripheral);
+}
+
+void Simulator::RemovePeripheral(ClockedPeripheral *peripheral) {
+  m_peripherals.erase(
+      std::remove(m_peripherals.begin(), m_peripherals.end(), peripheral),
+      m_peripherals.end());
+}
+
 uint64_t Simulator::Clock() const {
   return m_clock;
 }
 
+/*
+ * Each step runs the tasks and then ticks the peripherals, which run any
+ * ISRs. The clock then jumps to the earliest pending peripheral event, or the
+ * next task interval, whichever comes first.
+ */
 void Simulator::Run() {
   m_run = true;
-  m_clock = 0;
   while (m_run) {
     for (const auto &task : m_tasks) {
       task->Run();
     }
-    m_clock++;
+    for (auto peripheral : m_peripherals) {
+      peripheral->Tick();
+    }
+
+    m_clock = NextStep();
     if (m_clock_limit && m_clock >= m_clock_limit) {
+      m_clock = m_clock_limit;
       if (m_clock_limit_fatal) {
         FAIL() << "Clock limit exceeded: " << m_clock_limit;
       }
@@ -67,3 +98,11 @@ void Simulator::Run() {
 void Simulator::Stop() {
   m_run = false;
 }
+
+uint64_t Simulator::NextStep() const {
+  uint64_t next = m_clock + m_task_interval;
+  for (auto peripheral : m_peripherals) {
+    next = std::min(next, peripheral->NextEvent());
+  }
+  return std::max(next, m_clock + 1);
+}
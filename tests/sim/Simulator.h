@@ -23,9 +23,31 @@
 
 #include <stdint.h>
 #include <set>
+#include <vector>
 
 #include "ola/Callback.h"
 
+/*
+ * @brief A peripheral that is driven by the simulator clock.
+ *
+ * Rather than being called on every clock cycle, peripherals report when
+ * their next event is due and the simulator advances the clock directly to
+ * the earliest one.
+ */
+class ClockedPeripheral {
+ public:
+  virtual ~ClockedPeripheral() {}
+
+  // Return the clock value of the next event, or Simulator::kNoEvent if the
+  // peripheral is idle. This is called at the end of each step, once all the
+  // peripherals have been ticked, since an ISR may have changed the registers.
+  virtual uint64_t NextEvent() = 0;
+
+  // Process any events that are due at the current clock value. This is
+  // called at every step, even if the peripheral's own event isn't due yet.
+  virtual void Tick() = 0;
+};
+
 class Simulator {
  public:
   typedef ola::Callback0<void> TaskFn;
@@ -36,17 +58,31 @@ class Simulator {
   // This can be made fatal to guard against tests that never complete.
   void SetClockLimit(uint64_t duration, bool fatal);
 
+  // The maximum interval, in micro-seconds, between calls to the tasks when
+  // no peripheral events are due. Defaults to kDefaultTaskInterval.
+  void SetTaskInterval(uint32_t duration);
+
+  // Tasks are run at the start of each step of the simulator.
   void AddTask(TaskFn *fn);
   void RemoveTask(TaskFn *fn);
 
+  // Ownership is not transferred. Peripherals are ticked in the order they
+  // were added.
+  void AddPeripheral(ClockedPeripheral *peripheral);
+  void RemovePeripheral(ClockedPeripheral *peripheral);
+
   // Monotomic clock
   uint64_t Clock() const;
 
   void Run();
   void Stop();
 
+  static const uint64_t kNoEvent;
+  static const uint32_t kDefaultTaskInterval;
+
  private:
   typedef std::set<TaskFn*> Tasks;
+  typedef std::vector<ClockedPeripheral*> Peripherals;
 
   const uint32_t m_clock_speed;
 
@@ -54,7 +90,11 @@ class Simulator {
   uint64_t m_clock_limit;
   bool m_clock_limit_fatal;
   uint64_t m_clock;
+  uint64_t m_task_interval;
   Tasks m_tasks;
+  Peripherals m_peripherals;
+
+  uint64_t NextStep() const;
 };
 
 #endif  // TESTS_SIM_SIMULATOR_H_
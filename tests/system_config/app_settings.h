@@ -29,20 +29,6 @@
  * These will need to be adjusted to suit the particular processor / board
  * used.
  *
- * @name Coarse Timer
- * Settings for the @ref timer. These are used to initialize
- * CoarseTimer_Settings.
- * @{
- */
-
-/**
- * @brief The timer to use for the coarse timer.
- */
-#define COARSE_TIMER_ID 2
-
-/**
- * @}
- *
  * @name Transceiver
  * Settings for the @ref transceiver. These are used to initialize
  * TransceiverHardwareSettings.
@@ -117,8 +103,8 @@
  * @}
  *
  * @name SPI DMX
- * Settings for the @ref spi_dmx. These are used to initialize
- * SPIRGBConfiguration.
+ * Settings for the @ref spi and @ref spi_dmx. These are used to initialize
+ * SPIConfiguration and SPIRGBConfiguration.
  * @{
  */
 
@@ -137,6 +123,63 @@
  */
 #define SPI_USE_ENHANCED_BUFFERING true
 
+/**
+ * @brief Use DMA for SPI transfers, rather than the SPI interrupt.
+ */
+#define SPI_USE_DMA true
+
+/**
+ * @brief The DMA channel to use for SPI transmit.
+ */
+#define SPI_TX_DMA_CHANNEL DMA_CHANNEL_0
+
+/**
+ * @brief The DMA channel to use for SPI receive.
+ */
+#define SPI_RX_DMA_CHANNEL DMA_CHANNEL_1
+
+/**
+ * @}
+ *
+ * @name Dimmer
+ * Settings for the dimmer model, see dimmer_model.h.
+ * @{
+ */
+
+/**
+ * @brief The number of sub devices the dimmer model provides, up to 512.
+ *
+ * Each sub device uses 25 bytes of RAM: 12 for the settings, 3 for the scene
+ * levels, 6 for the DMX input & output levels and 4 for the preset playback.
+ * The budget for 512 sub devices is 12.5KB, about 16KB for the whole dimmer
+ * model.
+ *
+ * This can be overridden, to test the full sized layout.
+ */
+#ifndef DIMMER_SUB_DEVICE_COUNT
+#define DIMMER_SUB_DEVICE_COUNT 4
+#endif
+
+/**
+ * @brief The number of custom labels the dimmer's sub devices can use.
+ *
+ * This is smaller than the number of sub devices, so the tests can run out.
+ */
+#define DIMMER_CUSTOM_LABEL_COUNT 2
+
+/**
+ * @}
+ *
+ * @name Profiling
+ * Settings for the @ref scheduler.
+ * @{
+ */
+
+/**
+ * @brief Record the calls & cycles for each scheduler task.
+ */
+#define SCHEDULER_TASK_STATS
+
 /**
  * @}
  */
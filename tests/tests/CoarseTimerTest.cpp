@@ -22,23 +22,41 @@
 
 #include "coarse_timer.h"
 #include "sys_int_mock.h"
+#include "CoreTimerMock.h"
+
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+// The number of core timer counts in 0.1ms.
+static const uint32_t kCountsPerTick = 4000u;
 
 class CoarseTimerTest : public ::testing::TestWithParam<uint32_t> {
  public:
   void SetUp() {
     SYS_INT_SetMock(&m_sys_int_mock);
+    CoreTimer_SetMock(&m_core_timer_mock);
+    ON_CALL(m_core_timer_mock, GetCount()).WillByDefault(Invoke([this]() {
+      return m_core_timer;
+    }));
+
     CoarseTimer_Settings timer_settings = {
-      .timer_id = TMR_ID_2,
-      .interrupt_source = INT_SOURCE_TIMER_2
+      .interrupt_source = INT_SOURCE_TIMER_CORE
     };
     CoarseTimer_Initialize(&timer_settings);
   }
 
   void TearDown() {
     SYS_INT_SetMock(NULL);
+    CoreTimer_SetMock(NULL);
+  }
+
+  void Tick() {
+    m_core_timer += kCountsPerTick;
   }
 
-  testing::NiceMock<MockSysInt> m_sys_int_mock;
+  NiceMock<MockSysInt> m_sys_int_mock;
+  NiceMock<MockCoreTimer> m_core_timer_mock;
+  uint32_t m_core_timer = 0u;
 };
 
 TEST_P(CoarseTimerTest, TimerWorks) {
@@ -53,8 +71,12 @@ TEST_P(CoarseTimerTest, TimerWorks) {
   EXPECT_FALSE(CoarseTimer_HasElapsed(start, 2));
   EXPECT_FALSE(CoarseTimer_HasElapsed(start, 10));
 
+  // Part way to the first tick.
+  m_core_timer += kCountsPerTick - 1u;
+  EXPECT_EQ(0, CoarseTimer_ElapsedTime(start));
+
   // First tick.
-  CoarseTimer_TimerEvent();
+  m_core_timer++;
 
   EXPECT_EQ(1, CoarseTimer_ElapsedTime(start));
   // See comments in CoarseTimer_HasElapsed.
@@ -63,20 +85,43 @@ TEST_P(CoarseTimerTest, TimerWorks) {
   EXPECT_FALSE(CoarseTimer_HasElapsed(start, 2));
   EXPECT_FALSE(CoarseTimer_HasElapsed(start, 10));
 
-  CoarseTimer_TimerEvent();
+  Tick();
   EXPECT_TRUE(CoarseTimer_HasElapsed(start, 0));
   EXPECT_TRUE(CoarseTimer_HasElapsed(start, 1));
   EXPECT_FALSE(CoarseTimer_HasElapsed(start, 2));
   EXPECT_FALSE(CoarseTimer_HasElapsed(start, 10));
 
   // Cycle until 100 ticks (10ms) have elapsed.
-  unsigned int timer_events = 0;
+  unsigned int ticks = 0;
   while (!CoarseTimer_HasElapsed(start, 100)) {
-    timer_events++;
-    CoarseTimer_TimerEvent();
+    ticks++;
+    Tick();
   }
   EXPECT_EQ(101, CoarseTimer_ElapsedTime(start));
-  EXPECT_EQ(99, timer_events);
+  EXPECT_EQ(99, ticks);
+}
+
+TEST_P(CoarseTimerTest, CoreTimerWraps) {
+  // Run the core timer past the point where it wraps, moving the time base
+  // forward each time the compare interrupt fires.
+  uint32_t compare = 0u;
+  ON_CALL(m_core_timer_mock, SetCompare(testing::_)).WillByDefault(
+      Invoke([&compare](uint32_t value) { compare = value; }));
+
+  m_core_timer = GetParam();
+  CoarseTimer_SetCounter(0u);
+  CoarseTimer_TimerEvent();
+  EXPECT_EQ(m_core_timer + (1u << 30), compare);
+
+  // 10 minutes, in 1s steps.
+  const uint32_t kOneSecond = 10000u * kCountsPerTick;
+  for (unsigned int i = 0; i < 600; i++) {
+    m_core_timer += kOneSecond;
+    if (static_cast<int32_t>(m_core_timer - compare) >= 0) {
+      CoarseTimer_TimerEvent();
+    }
+    EXPECT_EQ((i + 1) * 10000u, CoarseTimer_GetTime());
+  }
 }
 
 INSTANTIATE_TEST_CASE_P(InstantiationName,
@@ -84,6 +129,6 @@ INSTANTIATE_TEST_CASE_P(InstantiationName,
                         ::testing::Values(0, 1, 52, 0xfffffffe, 0xffffffff));
 
 TEST_F(CoarseTimerTest, interruptClear) {
-  EXPECT_CALL(m_sys_int_mock, SourceStatusClear(INT_SOURCE_TIMER_2));
+  EXPECT_CALL(m_sys_int_mock, SourceStatusClear(INT_SOURCE_TIMER_CORE));
   CoarseTimer_TimerEvent();
 }
@@ -28,10 +28,12 @@
 #include <string.h>
 #include <memory>
 
+#include "app_settings.h"
 #include "dimmer_model.h"
 #include "rdm.h"
 #include "rdm_buffer.h"
 #include "rdm_responder.h"
+#include "timer_wheel.h"
 #include "Array.h"
 #include "CoarseTimerMock.h"
 #include "Matchers.h"
@@ -46,7 +48,7 @@ using ola::rdm::RDMRequest;
 using ola::rdm::RDMResponse;
 using ola::rdm::RDMSetRequest;
 using std::unique_ptr;
-using testing::Return;
+using testing::Invoke;
 using testing::_;
 
 class DimmerModelTest : public ModelTest {
@@ -55,6 +57,7 @@ class DimmerModelTest : public ModelTest {
 
   void SetUp() {
     CoarseTimer_SetMock(&m_timer);
+    TimerWheel_Initialize();
 
     RDMResponderSettings settings;
     memcpy(settings.uid, TEST_UID, UID_LENGTH);
@@ -69,6 +72,40 @@ class DimmerModelTest : public ModelTest {
 
  protected:
   ::testing::NiceMock<MockCoarseTimer> m_timer;
+  CoarseTimer_Value m_now = 0;
+
+  /*
+   * @brief Drive the coarse timer mock from m_now.
+   */
+  void UseSimulatedTime() {
+    ON_CALL(m_timer, GetTime()).WillByDefault(Invoke([this]() {
+      return m_now;
+    }));
+    ON_CALL(m_timer, ElapsedTime(_)).WillByDefault(
+        Invoke([this](CoarseTimer_Value start) { return m_now - start; }));
+    ON_CALL(m_timer, HasElapsed(_, _)).WillByDefault(
+        Invoke([this](CoarseTimer_Value start, uint32_t duration) {
+          return duration == 0 || m_now - start > duration;
+        }));
+  }
+
+  /*
+   * @brief Advance the simulated time, running the tasks every 1ms.
+   */
+  void RunFor(unsigned int milliseconds) {
+    for (unsigned int i = 0; i < milliseconds; i++) {
+      m_now += 10;
+      TimerWheel_Tasks();
+      DIMMER_MODEL_ENTRY.tasks_fn();
+    }
+  }
+
+  void SendSet(uint16_t pid, const uint8_t *data, unsigned int length) {
+    unique_ptr<RDMRequest> request = BuildSetRequest(pid, data, length);
+    unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+    int size = InvokeRDMHandler(request.get());
+    EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  }
 };
 
 TEST_F(DimmerModelTest, testLifecycle) {
@@ -179,6 +216,7 @@ TEST_F(DimmerModelTest, statusIDDescription) {
 }
 
 TEST_F(DimmerModelTest, selfTest) {
+  UseSimulatedTime();
   unique_ptr<RDMRequest> get_request = BuildGetRequest(PID_PERFORM_SELFTEST);
 
   uint8_t selftest = 0;
@@ -207,11 +245,11 @@ TEST_F(DimmerModelTest, selfTest) {
   size = InvokeRDMHandler(get_request.get());
   EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
 
-  // Run Tasks
-  testing::InSequence seq;
-  EXPECT_CALL(m_timer, HasElapsed(_, 50000)).WillOnce(Return(true));
-  EXPECT_CALL(m_timer, HasElapsed(_, _)).WillRepeatedly(Return(false));
-  DIMMER_MODEL_ENTRY.tasks_fn();
+  // The quick test takes 5s.
+  RunFor(5000);
+  size = InvokeRDMHandler(get_request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  RunFor(1);
 
   // Confirm self test is complete
   selftest = 0;
@@ -508,6 +546,117 @@ TEST_F(DimmerModelTest, clearStatusId) {
   EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
 }
 
+TEST_F(DimmerModelTest, subDeviceLabel) {
+  unique_ptr<RDMRequest> request = BuildSubDeviceGetRequest(
+      PID_DEVICE_LABEL, 1);
+
+  const char default_label[] = "Ja Rule";
+  unique_ptr<RDMResponse> response(GetResponseFromData(
+        request.get(),
+        reinterpret_cast<const uint8_t*>(default_label),
+        arraysize(default_label) - 1));
+
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // Set the label on all sub devices, this shares a single label.
+  const char rack_label[] = "Rack";
+  request = BuildSubDeviceSetRequest(
+      PID_DEVICE_LABEL, SUBDEVICE_ALL,
+      reinterpret_cast<const uint8_t*>(rack_label),
+      arraysize(rack_label) - 1);
+
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // Now give sub device 3 its own label.
+  const char dimmer_label[] = "Dimmer 3";
+  request = BuildSubDeviceSetRequest(
+      PID_DEVICE_LABEL, 3,
+      reinterpret_cast<const uint8_t*>(dimmer_label),
+      arraysize(dimmer_label) - 1);
+
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  request = BuildSubDeviceGetRequest(PID_DEVICE_LABEL, 3);
+  response.reset(GetResponseFromData(
+        request.get(),
+        reinterpret_cast<const uint8_t*>(dimmer_label),
+        arraysize(dimmer_label) - 1));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // The other sub devices are unchanged.
+  request = BuildSubDeviceGetRequest(PID_DEVICE_LABEL, 1);
+  response.reset(GetResponseFromData(
+        request.get(),
+        reinterpret_cast<const uint8_t*>(rack_label),
+        arraysize(rack_label) - 1));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+}
+
+TEST_F(DimmerModelTest, subDeviceLabelExhaustion) {
+  // Use up every custom label, the sub devices are 1, 3, 4, ...
+  const char *labels[] = {"Dimmer 1", "Dimmer 3", "Dimmer 4"};
+  static_assert(DIMMER_CUSTOM_LABEL_COUNT + 1 == arraysize(labels),
+                "This test expects a pool of two labels");
+  for (unsigned int i = 0; i < DIMMER_CUSTOM_LABEL_COUNT; i++) {
+    unique_ptr<RDMRequest> request = BuildSubDeviceSetRequest(
+        PID_DEVICE_LABEL, i ? i + 2 : 1,
+        reinterpret_cast<const uint8_t*>(labels[i]), strlen(labels[i]));
+    unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+    int size = InvokeRDMHandler(request.get());
+    EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  }
+
+  // A new label is rejected.
+  const char *new_label = labels[DIMMER_CUSTOM_LABEL_COUNT];
+  const uint16_t next_sub_device = DIMMER_CUSTOM_LABEL_COUNT + 2;
+  unique_ptr<RDMRequest> request = BuildSubDeviceSetRequest(
+      PID_DEVICE_LABEL, next_sub_device,
+      reinterpret_cast<const uint8_t*>(new_label), strlen(new_label));
+  unique_ptr<RDMResponse> response(
+      NackWithReason(request.get(), ola::rdm::NR_ACTION_NOT_SUPPORTED));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // But an existing one can still be shared.
+  request = BuildSubDeviceSetRequest(
+      PID_DEVICE_LABEL, next_sub_device,
+      reinterpret_cast<const uint8_t*>(labels[0]), strlen(labels[0]));
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // Resetting sub device 3 to the default label frees its entry.
+  const char default_label[] = "Ja Rule";
+  request = BuildSubDeviceSetRequest(
+      PID_DEVICE_LABEL, 3,
+      reinterpret_cast<const uint8_t*>(default_label),
+      arraysize(default_label) - 1);
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  request = BuildSubDeviceSetRequest(
+      PID_DEVICE_LABEL, next_sub_device,
+      reinterpret_cast<const uint8_t*>(new_label), strlen(new_label));
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  request = BuildSubDeviceGetRequest(PID_DEVICE_LABEL, next_sub_device);
+  response.reset(GetResponseFromData(
+        request.get(), reinterpret_cast<const uint8_t*>(new_label),
+        strlen(new_label)));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+}
+
 TEST_F(DimmerModelTest, subDeviceReportingThreshold) {
   unique_ptr<RDMRequest> request = BuildSubDeviceGetRequest(
       PID_SUB_DEVICE_STATUS_REPORT_THRESHOLD, 1);
@@ -615,7 +764,7 @@ TEST_F(DimmerModelTest, maximumLevel) {
   unique_ptr<RDMRequest> request = BuildSubDeviceGetRequest(
       PID_MAXIMUM_LEVEL, 1);
 
-  const uint8_t expected_response[] = { 0, 0 };
+  const uint8_t expected_response[] = { 0xff, 0xfe };
   unique_ptr<RDMResponse> response(GetResponseFromData(
         request.get(),
         reinterpret_cast<const uint8_t*>(&expected_response),
@@ -754,8 +903,9 @@ TEST_F(DimmerModelTest, modulationFrequencyDescription) {
 }
 
 TEST_F(DimmerModelTest, queuedMessages) {
-  EXPECT_CALL(m_timer, HasElapsed(_, _)).WillOnce(Return(true));
-  DIMMER_MODEL_ENTRY.tasks_fn();
+  // Status messages are generated every 30s.
+  UseSimulatedTime();
+  RunFor(30001);
 
   uint8_t status_type = 0x02;
   unique_ptr<RDMRequest> request = BuildGetRequest(
@@ -780,3 +930,301 @@ TEST_F(DimmerModelTest, queuedMessages) {
   size = InvokeRDMHandler(request.get());
   EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
 }
+
+TEST_F(DimmerModelTest, outputEngine) {
+  UseSimulatedTime();
+
+  // Sub-devices 1, 3 & 4 use slots 1, 2 & 3.
+  const uint8_t dmx[] = { 255, 128, 1 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx, arraysize(dmx));
+
+  // The engine runs every 10ms, the first tick is just after 10ms.
+  RunFor(10);
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(1));
+  RunFor(1);
+  EXPECT_EQ(6554, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(6554, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(256, DimmerModel_GetOutputLevel(4));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(2));
+
+  // The default response time takes 100ms to reach full.
+  RunFor(90);
+  EXPECT_EQ(0xfffe, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(32895, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(256, DimmerModel_GetOutputLevel(4));
+
+  // Drop the first slot to zero.
+  const uint8_t blackout[] = { 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, blackout, arraysize(blackout));
+  RunFor(10);
+  EXPECT_EQ(58980, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(32895, DimmerModel_GetOutputLevel(3));
+}
+
+TEST_F(DimmerModelTest, presetFades) {
+  UseSimulatedTime();
+
+  const uint8_t dmx[] = { 200, 100, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx, arraysize(dmx));
+  RunFor(200);
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(25699, DimmerModel_GetOutputLevel(3));
+
+  // Capture scene 2, with a 1s up fade and a 2s down fade.
+  const uint8_t capture_data[] = { 0, 2, 0, 10, 0, 20, 0, 0 };
+  SendSet(PID_CAPTURE_PRESET, capture_data, arraysize(capture_data));
+
+  const uint8_t blackout[] = { 0, 0, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, blackout, arraysize(blackout));
+  RunFor(200);
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(3));
+
+  // Play back scene 2 at full.
+  const uint8_t playback_data[] = { 0, 2, 0xff };
+  SendSet(PID_PRESET_PLAYBACK, playback_data, arraysize(playback_data));
+  RunFor(500);
+  EXPECT_EQ(25236, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(12617, DimmerModel_GetOutputLevel(3));
+  RunFor(600);
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(25699, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(4));
+
+  // Drop the playback level, this uses the down fade time.
+  const uint8_t half_playback_data[] = { 0, 2, 0x80 };
+  SendSet(PID_PRESET_PLAYBACK, half_playback_data,
+          arraysize(half_playback_data));
+  RunFor(1000);
+  EXPECT_EQ(38714, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(19357, DimmerModel_GetOutputLevel(3));
+  RunFor(1100);
+  EXPECT_EQ(25799, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(12899, DimmerModel_GetOutputLevel(3));
+
+  // Turning playback off returns to the DMX data.
+  const uint8_t off_data[] = { 0, 0, 0 };
+  SendSet(PID_PRESET_PLAYBACK, off_data, arraysize(off_data));
+  RunFor(100);
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(3));
+}
+
+TEST_F(DimmerModelTest, presetSequence) {
+  UseSimulatedTime();
+
+  // Scene 2 has a 1s fade and a 0.5s wait, scene 3 has a 1s down fade and a
+  // 1s wait.
+  const uint8_t dmx[] = { 200, 100, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx, arraysize(dmx));
+  const uint8_t capture_data[] = { 0, 2, 0, 10, 0, 10, 0, 5 };
+  SendSet(PID_CAPTURE_PRESET, capture_data, arraysize(capture_data));
+
+  const uint8_t dmx2[] = { 50, 250, 10 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx2, arraysize(dmx2));
+  const uint8_t capture_data2[] = { 0, 3, 0, 0, 0, 10, 0, 10 };
+  SendSet(PID_CAPTURE_PRESET, capture_data2, arraysize(capture_data2));
+  RunFor(200);
+
+  // Play back all scenes. The factory scene is all zeros, with no fade or
+  // wait time, so we fade straight into scene 2.
+  const uint8_t playback_data[] = { 0xff, 0xff, 0xff };
+  SendSet(PID_PRESET_PLAYBACK, playback_data, arraysize(playback_data));
+  RunFor(1100);
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(25699, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(4));
+
+  // Scene 2 is held for 0.5s, then we move to scene 3.
+  RunFor(400);
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(1));
+  RunFor(600);
+  EXPECT_GT(51399, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(64249, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(2569, DimmerModel_GetOutputLevel(4));
+  RunFor(600);
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(1));
+
+  // After 1s, we wrap around to the factory scene.
+  RunFor(800);
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(64249, DimmerModel_GetOutputLevel(3));
+  RunFor(200);
+  EXPECT_GT(12849, DimmerModel_GetOutputLevel(1));
+  EXPECT_GT(64249, DimmerModel_GetOutputLevel(3));
+}
+
+TEST_F(DimmerModelTest, failScene) {
+  UseSimulatedTime();
+
+  // Scene 2 has no up fade and a 0.5s down fade.
+  const uint8_t dmx[] = { 200, 100, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx, arraysize(dmx));
+  const uint8_t capture_data[] = { 0, 2, 0, 0, 0, 5, 0, 0 };
+  SendSet(PID_CAPTURE_PRESET, capture_data, arraysize(capture_data));
+
+  // Play scene 2 after 2s without DMX, and hold it for 1s.
+  const uint8_t fail_data[] = { 0, 2, 0, 20, 0, 10, 0xff };
+  SendSet(PID_DMX_FAIL_MODE, fail_data, arraysize(fail_data));
+
+  const uint8_t blackout[] = { 0, 0, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, blackout, arraysize(blackout));
+  RunFor(1999);
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(3));
+
+  // The fail scene starts on the next output tick.
+  RunFor(12);
+  EXPECT_EQ(6554, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(6554, DimmerModel_GetOutputLevel(3));
+  RunFor(200);
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(25699, DimmerModel_GetOutputLevel(3));
+  RunFor(700);
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(25699, DimmerModel_GetOutputLevel(3));
+
+  // Once the hold time expires, the scene fades out.
+  RunFor(300);
+  EXPECT_EQ(29914, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(14957, DimmerModel_GetOutputLevel(3));
+  RunFor(400);
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(3));
+
+  // DMX resumes.
+  const uint8_t dmx2[] = { 50 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx2, arraysize(dmx2));
+  RunFor(200);
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(3));
+}
+
+TEST_F(DimmerModelTest, failModeChange) {
+  UseSimulatedTime();
+  // The deadlines are all run from the timer wheel.
+  EXPECT_CALL(m_timer, HasElapsed(_, _)).Times(0);
+
+  const uint8_t dmx[] = { 200, 100, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx, arraysize(dmx));
+  const uint8_t capture_data[] = { 0, 2, 0, 0, 0, 0, 0, 0 };
+  SendSet(PID_CAPTURE_PRESET, capture_data, arraysize(capture_data));
+
+  // Never play the fail scene.
+  const uint8_t never_fail_data[] = { 0, 2, 0xff, 0xff, 0xff, 0xff, 0xff };
+  SendSet(PID_DMX_FAIL_MODE, never_fail_data, arraysize(never_fail_data));
+
+  const uint8_t blackout[] = { 0, 0, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, blackout, arraysize(blackout));
+  RunFor(5000);
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(3));
+
+  // The signal was lost more than 2s ago, so this plays the scene right away.
+  const uint8_t fail_data[] = { 0, 2, 0, 20, 0xff, 0xff, 0xff };
+  SendSet(PID_DMX_FAIL_MODE, fail_data, arraysize(fail_data));
+  RunFor(200);
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(25699, DimmerModel_GetOutputLevel(3));
+}
+
+TEST_F(DimmerModelTest, startupScene) {
+  UseSimulatedTime();
+
+  const uint8_t dmx[] = { 200, 100, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx, arraysize(dmx));
+  const uint8_t capture_data[] = { 0, 2, 0, 0, 0, 0, 0, 0 };
+  SendSet(PID_CAPTURE_PRESET, capture_data, arraysize(capture_data));
+
+  // Play scene 2 at half level after 1s, and hold it forever.
+  const uint8_t startup_data[] = { 0, 2, 0, 10, 0xff, 0xff, 0x80 };
+  SendSet(PID_DMX_STARTUP_MODE, startup_data, arraysize(startup_data));
+
+  const uint8_t dmx2[] = { 50, 0, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx2, arraysize(dmx2));
+  RunFor(200);
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(1));
+
+  // Re-activating the model is the same as a power cycle.
+  DIMMER_MODEL_ENTRY.deactivate_fn();
+  DIMMER_MODEL_ENTRY.activate_fn();
+  RunFor(999);
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(3));
+  RunFor(200);
+  EXPECT_EQ(25799, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(12899, DimmerModel_GetOutputLevel(3));
+  RunFor(5000);
+  EXPECT_EQ(25799, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(12899, DimmerModel_GetOutputLevel(3));
+
+  // DMX takes over.
+  const uint8_t blackout[] = { 0, 0, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, blackout, arraysize(blackout));
+  RunFor(200);
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(3));
+}
+
+TEST_F(DimmerModelTest, presetMergeModes) {
+  UseSimulatedTime();
+
+  const uint8_t dmx[] = { 100, 200, 0 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx, arraysize(dmx));
+  const uint8_t capture_data[] = { 0, 2, 0, 0, 0, 0, 0, 0 };
+  SendSet(PID_CAPTURE_PRESET, capture_data, arraysize(capture_data));
+
+  const uint8_t dmx2[] = { 50, 50, 50 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx2, arraysize(dmx2));
+  RunFor(200);
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(4));
+
+  // LTP, starting the preset takes precedence.
+  const uint8_t ltp_data[] = { MERGE_MODE_LTP };
+  SendSet(PID_PRESET_MERGEMODE, ltp_data, arraysize(ltp_data));
+  const uint8_t playback_data[] = { 0, 2, 0xff };
+  SendSet(PID_PRESET_PLAYBACK, playback_data, arraysize(playback_data));
+  RunFor(200);
+  EXPECT_EQ(25699, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(4));
+
+  // Then the first DMX slot changes.
+  const uint8_t dmx3[] = { 150, 50, 50 };
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx3, arraysize(dmx3));
+  RunFor(200);
+  EXPECT_EQ(38549, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(4));
+
+  // HTP
+  const uint8_t htp_data[] = { MERGE_MODE_HTP };
+  SendSet(PID_PRESET_MERGEMODE, htp_data, arraysize(htp_data));
+  RunFor(200);
+  EXPECT_EQ(38549, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(4));
+
+  // DMX only, the preset is used once the DMX signal is lost.
+  const uint8_t dmx_only_data[] = { MERGE_MODE_DMX_ONLY };
+  SendSet(PID_PRESET_MERGEMODE, dmx_only_data, arraysize(dmx_only_data));
+  RunFor(200);
+  EXPECT_EQ(38549, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(12849, DimmerModel_GetOutputLevel(4));
+  RunFor(1000);
+  EXPECT_EQ(25699, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(4));
+
+  // Default, the preset overrides DMX.
+  const uint8_t default_data[] = { MERGE_MODE_DEFAULT };
+  SendSet(PID_PRESET_MERGEMODE, default_data, arraysize(default_data));
+  DIMMER_MODEL_ENTRY.dmx_fn(0, dmx3, arraysize(dmx3));
+  RunFor(200);
+  EXPECT_EQ(25699, DimmerModel_GetOutputLevel(1));
+  EXPECT_EQ(51399, DimmerModel_GetOutputLevel(3));
+  EXPECT_EQ(0, DimmerModel_GetOutputLevel(4));
+}
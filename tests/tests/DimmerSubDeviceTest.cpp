@@ -0,0 +1,138 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * DimmerSubDeviceTest.cpp
+ * Tests for the Dimmer Model with the full 512 sub devices.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include <ola/rdm/UID.h>
+#include <ola/rdm/RDMCommand.h>
+#include <ola/rdm/RDMEnums.h>
+#include <ola/rdm/RDMCommandSerializer.h>
+#include <string.h>
+#include <memory>
+
+#include "app_settings.h"
+#include "dimmer_model.h"
+#include "rdm.h"
+#include "rdm_buffer.h"
+#include "rdm_responder.h"
+#include "timer_wheel.h"
+#include "Array.h"
+#include "CoarseTimerMock.h"
+#include "Matchers.h"
+#include "ModelTest.h"
+#include "TestHelpers.h"
+
+using ola::rdm::GetResponseFromData;
+using ola::rdm::NackWithReason;
+using ola::rdm::RDMRequest;
+using ola::rdm::RDMResponse;
+using std::unique_ptr;
+
+static_assert(DIMMER_SUB_DEVICE_COUNT == SUBDEVICE_MAX,
+              "This test needs the full set of sub devices");
+
+class DimmerSubDeviceTest : public ModelTest {
+ public:
+  DimmerSubDeviceTest() : ModelTest(&DIMMER_MODEL_ENTRY) {}
+
+  void SetUp() {
+    CoarseTimer_SetMock(&m_timer);
+    TimerWheel_Initialize();
+
+    RDMResponderSettings settings;
+    memcpy(settings.uid, TEST_UID, UID_LENGTH);
+    RDMResponder_Initialize(&settings);
+    DimmerModel_Initialize();
+    DIMMER_MODEL_ENTRY.activate_fn();
+  }
+
+  void TearDown() {
+    DIMMER_MODEL_ENTRY.deactivate_fn();
+    CoarseTimer_SetMock(nullptr);
+  }
+
+ protected:
+  ::testing::NiceMock<MockCoarseTimer> m_timer;
+
+  void ExpectLabel(uint16_t sub_device, const char *label) {
+    unique_ptr<RDMRequest> request = BuildSubDeviceGetRequest(
+        PID_DEVICE_LABEL, sub_device);
+    unique_ptr<RDMResponse> response(GetResponseFromData(
+        request.get(), reinterpret_cast<const uint8_t*>(label),
+        strlen(label)));
+    int size = InvokeRDMHandler(request.get());
+    EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  }
+
+  int SetLabel(uint16_t sub_device, const char *label) {
+    unique_ptr<RDMRequest> request = BuildSubDeviceSetRequest(
+        PID_DEVICE_LABEL, sub_device,
+        reinterpret_cast<const uint8_t*>(label), strlen(label));
+    return InvokeRDMHandler(request.get());
+  }
+};
+
+TEST_F(DimmerSubDeviceTest, subDevicesAreContiguous) {
+  // With all 512 sub devices there's no room for a gap.
+  ExpectLabel(1, "Ja Rule");
+  ExpectLabel(2, "Ja Rule");
+  ExpectLabel(SUBDEVICE_MAX, "Ja Rule");
+
+  unique_ptr<RDMRequest> request = BuildSubDeviceGetRequest(
+      PID_DEVICE_LABEL, SUBDEVICE_MAX + 1);
+  unique_ptr<RDMResponse> response(
+      NackWithReason(request.get(), ola::rdm::NR_SUB_DEVICE_OUT_OF_RANGE));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+}
+
+TEST_F(DimmerSubDeviceTest, labelPool) {
+  // Every sub device shares a single entry.
+  unique_ptr<RDMRequest> request = BuildSubDeviceSetRequest(
+      PID_DEVICE_LABEL, SUBDEVICE_ALL,
+      reinterpret_cast<const uint8_t*>("Rack"), strlen("Rack"));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  ExpectLabel(1, "Rack");
+  ExpectLabel(SUBDEVICE_MAX, "Rack");
+
+  // Fill the rest of the pool.
+  const char *labels[] = {"Dimmer 2", "Dimmer 3"};
+  static_assert(DIMMER_CUSTOM_LABEL_COUNT == arraysize(labels),
+                "This test expects a pool of two labels");
+  EXPECT_LT(0, SetLabel(2, labels[0]));
+  ExpectLabel(2, labels[0]);
+
+  request = BuildSubDeviceSetRequest(
+      PID_DEVICE_LABEL, 3,
+      reinterpret_cast<const uint8_t*>(labels[1]), strlen(labels[1]));
+  response.reset(
+      NackWithReason(request.get(), ola::rdm::NR_ACTION_NOT_SUPPORTED));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  ExpectLabel(3, "Rack");
+
+  // Once every sub device is back on the default label, the pool is free.
+  EXPECT_LT(0, SetLabel(SUBDEVICE_ALL, "Ja Rule"));
+  EXPECT_LT(0, SetLabel(3, labels[1]));
+  ExpectLabel(3, labels[1]);
+  ExpectLabel(SUBDEVICE_MAX, "Ja Rule");
+}
@@ -0,0 +1,100 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * ISRProfilerTest.cpp
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include "isr_profiler.h"
+#include "CoreTimerMock.h"
+
+using ::testing::NiceMock;
+using ::testing::Return;
+
+class ISRProfilerTest : public testing::Test {
+ public:
+  void SetUp() {
+    CoreTimer_SetMock(&m_core_timer_mock);
+    ISRProfiler_Reset();
+  }
+
+  void TearDown() {
+    CoreTimer_SetMock(NULL);
+  }
+
+  void Run(ISRProfilerId id, uint32_t start, uint32_t cycles) {
+    EXPECT_CALL(m_core_timer_mock, GetCount())
+        .WillOnce(Return(start + cycles));
+    ISRProfiler_Exit(id, start);
+  }
+
+  NiceMock<MockCoreTimer> m_core_timer_mock;
+};
+
+TEST_F(ISRProfilerTest, recordsRuns) {
+  const ISRProfiler_Stats *stats =
+      &ISRProfiler_GetStats()[ISR_PROFILER_TRANSCEIVER_TIMER];
+  EXPECT_EQ(0u, stats->calls);
+  EXPECT_EQ(0u, stats->min_cycles);
+
+  Run(ISR_PROFILER_TRANSCEIVER_TIMER, 1000u, 100u);
+  Run(ISR_PROFILER_TRANSCEIVER_TIMER, 2000u, 40u);
+  // The core timer wraps during this run.
+  Run(ISR_PROFILER_TRANSCEIVER_TIMER, 0xfffffff0u, 300u);
+
+  EXPECT_EQ(3u, stats->calls);
+  EXPECT_EQ(40u, stats->min_cycles);
+  EXPECT_EQ(300u, stats->max_cycles);
+  EXPECT_EQ(440u, stats->total_cycles);
+  EXPECT_EQ(0u, stats->max_latency);
+
+  // The other ISRs are unaffected.
+  EXPECT_EQ(0u, ISRProfiler_GetStats()[ISR_PROFILER_USB].calls);
+
+  ISRProfiler_Reset();
+  EXPECT_EQ(0u, stats->calls);
+  EXPECT_EQ(0u, stats->total_cycles);
+}
+
+TEST_F(ISRProfilerTest, histogram) {
+  const ISRProfiler_Stats *stats =
+      &ISRProfiler_GetStats()[ISR_PROFILER_USB];
+
+  Run(ISR_PROFILER_USB, 0u, 0u);
+  Run(ISR_PROFILER_USB, 0u, 63u);
+  Run(ISR_PROFILER_USB, 0u, 64u);
+  Run(ISR_PROFILER_USB, 0u, 127u);
+  Run(ISR_PROFILER_USB, 0u, 128u);
+  Run(ISR_PROFILER_USB, 0u, 4095u);
+  Run(ISR_PROFILER_USB, 0u, 4096u);
+  Run(ISR_PROFILER_USB, 0u, 0xffffffffu);
+
+  const uint32_t expected[ISR_PROFILER_BUCKETS] = {2, 2, 1, 0, 0, 0, 1, 2};
+  for (unsigned int i = 0; i < ISR_PROFILER_BUCKETS; i++) {
+    EXPECT_EQ(expected[i], stats->histogram[i]) << "Bucket " << i;
+  }
+}
+
+TEST_F(ISRProfilerTest, latency) {
+  const ISRProfiler_Stats *stats =
+      &ISRProfiler_GetStats()[ISR_PROFILER_CORE_TIMER];
+
+  ISRProfiler_RecordLatency(ISR_PROFILER_CORE_TIMER, 20u);
+  ISRProfiler_RecordLatency(ISR_PROFILER_CORE_TIMER, 50u);
+  ISRProfiler_RecordLatency(ISR_PROFILER_CORE_TIMER, 30u);
+  EXPECT_EQ(50u, stats->max_latency);
+}
@@ -0,0 +1,186 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * InterruptControllerTest.cpp
+ * Tests for the simulator's interrupt controller.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "tests/sim/InterruptController.h"
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+using ola::NewCallback;
+using std::string;
+using std::vector;
+
+class InterruptControllerTest : public testing::Test {
+ public:
+  void SetUp() {
+    m_controller.RegisterISR(INT_SOURCE_TIMER_3, INT_VECTOR_T3,
+        NewCallback(this, &InterruptControllerTest::TimerISR));
+    m_controller.RegisterISR(INT_SOURCE_USART_1_RECEIVE, INT_VECTOR_UART1,
+        NewCallback(this, &InterruptControllerTest::UARTISR));
+    m_controller.RegisterISR(INT_SOURCE_INPUT_CAPTURE_2, INT_VECTOR_IC2,
+        NewCallback(this, &InterruptControllerTest::InputCaptureISR));
+    m_controller.SourceEnable(INT_SOURCE_TIMER_3);
+    m_controller.SourceEnable(INT_SOURCE_USART_1_RECEIVE);
+    m_controller.SourceEnable(INT_SOURCE_INPUT_CAPTURE_2);
+  }
+
+ protected:
+  InterruptController m_controller;
+  vector<string> m_log;
+  vector<INT_SOURCE> m_raise_from_timer;
+  vector<INT_SOURCE> m_raise_from_uart;
+
+  void TimerISR() {
+    RunISR("timer", INT_SOURCE_TIMER_3, m_raise_from_timer);
+  }
+
+  void UARTISR() {
+    RunISR("uart", INT_SOURCE_USART_1_RECEIVE, m_raise_from_uart);
+  }
+
+  void InputCaptureISR() {
+    m_log.push_back("ic");
+    m_controller.SourceStatusClear(INT_SOURCE_INPUT_CAPTURE_2);
+  }
+
+  void RunISR(const string &name, INT_SOURCE source,
+              const vector<INT_SOURCE> &raise) {
+    m_log.push_back(name + " start");
+    for (auto other : raise) {
+      m_controller.RaiseInterrupt(other);
+    }
+    m_controller.SourceStatusClear(source);
+    m_log.push_back(name + " end");
+  }
+};
+
+TEST_F(InterruptControllerTest, priorityZeroIsDisabled) {
+  m_controller.RaiseInterrupt(INT_SOURCE_TIMER_3);
+  EXPECT_THAT(m_log, IsEmpty());
+  EXPECT_TRUE(m_controller.SourceStatusGet(INT_SOURCE_TIMER_3));
+
+  // Setting the priority doesn't trigger the ISR, only the next event does.
+  m_controller.VectorPrioritySet(INT_VECTOR_T3, INT_PRIORITY_LEVEL6);
+  m_controller.RaiseInterrupt(INT_SOURCE_TIMER_3);
+  EXPECT_THAT(m_log, ElementsAre("timer start", "timer end"));
+  EXPECT_EQ(1u, m_controller.InterruptCount(INT_SOURCE_TIMER_3));
+}
+
+TEST_F(InterruptControllerTest, higherPriorityPreempts) {
+  m_controller.VectorPrioritySet(INT_VECTOR_T3, INT_PRIORITY_LEVEL3);
+  m_controller.VectorPrioritySet(INT_VECTOR_UART1, INT_PRIORITY_LEVEL6);
+  m_raise_from_timer.push_back(INT_SOURCE_USART_1_RECEIVE);
+
+  m_controller.RaiseInterrupt(INT_SOURCE_TIMER_3);
+  EXPECT_THAT(m_log, ElementsAre("timer start", "uart start", "uart end",
+                                 "timer end"));
+  EXPECT_EQ(2u, m_controller.MaxNestingDepth());
+  EXPECT_EQ(2u, m_controller.TotalInterruptCount());
+  EXPECT_EQ(INT_DISABLE_INTERRUPT, m_controller.CurrentPriority());
+}
+
+TEST_F(InterruptControllerTest, lowerPriorityIsDeferred) {
+  m_controller.VectorPrioritySet(INT_VECTOR_T3, INT_PRIORITY_LEVEL3);
+  m_controller.VectorPrioritySet(INT_VECTOR_UART1, INT_PRIORITY_LEVEL6);
+  m_raise_from_uart.push_back(INT_SOURCE_TIMER_3);
+
+  m_controller.RaiseInterrupt(INT_SOURCE_USART_1_RECEIVE);
+  EXPECT_THAT(m_log, ElementsAre("uart start", "uart end", "timer start",
+                                 "timer end"));
+  EXPECT_EQ(1u, m_controller.MaxNestingDepth());
+}
+
+TEST_F(InterruptControllerTest, samePriorityIsDeferred) {
+  m_controller.VectorPrioritySet(INT_VECTOR_T3, INT_PRIORITY_LEVEL6);
+  m_controller.VectorPrioritySet(INT_VECTOR_UART1, INT_PRIORITY_LEVEL6);
+  m_raise_from_timer.push_back(INT_SOURCE_USART_1_RECEIVE);
+
+  m_controller.RaiseInterrupt(INT_SOURCE_TIMER_3);
+  EXPECT_THAT(m_log, ElementsAre("timer start", "timer end", "uart start",
+                                 "uart end"));
+  EXPECT_EQ(1u, m_controller.MaxNestingDepth());
+}
+
+TEST_F(InterruptControllerTest, pendingOrder) {
+  // The UART ISR raises two pending interrupts at the same priority, the
+  // sub-priority decides which runs first.
+  m_controller.VectorPrioritySet(INT_VECTOR_UART1, INT_PRIORITY_LEVEL7);
+  m_controller.VectorPrioritySet(INT_VECTOR_T3, INT_PRIORITY_LEVEL3);
+  m_controller.VectorPrioritySet(INT_VECTOR_IC2, INT_PRIORITY_LEVEL3);
+  m_controller.VectorSubprioritySet(INT_VECTOR_T3, INT_SUBPRIORITY_LEVEL3);
+  m_raise_from_uart.push_back(INT_SOURCE_INPUT_CAPTURE_2);
+  m_raise_from_uart.push_back(INT_SOURCE_TIMER_3);
+
+  m_controller.RaiseInterrupt(INT_SOURCE_USART_1_RECEIVE);
+  EXPECT_THAT(m_log, ElementsAre("uart start", "uart end", "timer start",
+                                 "timer end", "ic"));
+
+  // With equal sub-priorities, the lower vector wins.
+  m_log.clear();
+  m_controller.VectorSubprioritySet(INT_VECTOR_T3, INT_SUBPRIORITY_LEVEL0);
+  m_controller.RaiseInterrupt(INT_SOURCE_USART_1_RECEIVE);
+  EXPECT_THAT(m_log, ElementsAre("uart start", "uart end", "ic",
+                                 "timer start", "timer end"));
+}
+
+TEST_F(InterruptControllerTest, pendingUntilEnabled) {
+  m_controller.VectorPrioritySet(INT_VECTOR_T3, INT_PRIORITY_LEVEL6);
+  EXPECT_TRUE(m_controller.SourceDisable(INT_SOURCE_TIMER_3));
+  EXPECT_FALSE(m_controller.SourceDisable(INT_SOURCE_TIMER_3));
+
+  m_controller.RaiseInterrupt(INT_SOURCE_TIMER_3);
+  EXPECT_THAT(m_log, IsEmpty());
+
+  // Leaving the critical section runs the ISR.
+  m_controller.SourceEnable(INT_SOURCE_TIMER_3);
+  EXPECT_THAT(m_log, ElementsAre("timer start", "timer end"));
+
+  // Unless the flag was cleared first.
+  m_log.clear();
+  m_controller.SourceDisable(INT_SOURCE_TIMER_3);
+  m_controller.RaiseInterrupt(INT_SOURCE_TIMER_3);
+  m_controller.SourceStatusClear(INT_SOURCE_TIMER_3);
+  m_controller.SourceEnable(INT_SOURCE_TIMER_3);
+  EXPECT_THAT(m_log, IsEmpty());
+}
+
+TEST_F(InterruptControllerTest, counters) {
+  m_controller.VectorPrioritySet(INT_VECTOR_T3, INT_PRIORITY_LEVEL6);
+  m_controller.VectorPrioritySet(INT_VECTOR_IC2, INT_PRIORITY_LEVEL6);
+  for (unsigned int i = 0; i < 3; i++) {
+    m_controller.RaiseInterrupt(INT_SOURCE_TIMER_3);
+  }
+  m_controller.RaiseInterrupt(INT_SOURCE_INPUT_CAPTURE_2);
+
+  EXPECT_EQ(3u, m_controller.InterruptCount(INT_SOURCE_TIMER_3));
+  EXPECT_EQ(1u, m_controller.InterruptCount(INT_SOURCE_INPUT_CAPTURE_2));
+  EXPECT_EQ(0u, m_controller.InterruptCount(INT_SOURCE_USART_1_RECEIVE));
+  EXPECT_EQ(4u, m_controller.TotalInterruptCount());
+
+  m_controller.ResetCounters();
+  EXPECT_EQ(0u, m_controller.InterruptCount(INT_SOURCE_TIMER_3));
+  EXPECT_EQ(0u, m_controller.TotalInterruptCount());
+  EXPECT_EQ(0u, m_controller.MaxNestingDepth());
+}
@@ -35,6 +35,7 @@
 #include "Array.h"
 #include "Matchers.h"
 #include "ModelTest.h"
+#include "SPIRGBMock.h"
 #include "TestHelpers.h"
 
 using ola::network::HostToNetwork;
@@ -45,6 +46,8 @@ using ola::rdm::RDMRequest;
 using ola::rdm::RDMResponse;
 using ola::rdm::RDMSetRequest;
 using std::unique_ptr;
+using ::testing::Return;
+using ::testing::StrictMock;
 
 class LEDModelTest : public ModelTest {
  public:
@@ -55,6 +58,127 @@ class LEDModelTest : public ModelTest {
     memcpy(settings.uid, TEST_UID, UID_LENGTH);
     RDMResponder_Initialize(&settings);
     LEDModel_Initialize();
+
+    SPIRGB_SetMock(&m_spi_mock);
+    EXPECT_CALL(m_spi_mock, SetPixelType(PIXEL_TYPE_LPD8806));
+    EXPECT_CALL(m_spi_mock, SetPixelCount(2));
+    EXPECT_CALL(m_spi_mock, SetGamma(10)).WillOnce(Return(true));
+    EXPECT_CALL(m_spi_mock, SetWhiteBalance(255, 255, 255));
+    EXPECT_CALL(m_spi_mock, SetDithering(false));
+    EXPECT_CALL(m_spi_mock, SetBrightness(31));
     LED_MODEL_ENTRY.activate_fn();
   }
+
+  void TearDown() {
+    SPIRGB_SetMock(nullptr);
+  }
+
+ protected:
+  StrictMock<MockSPIRGB> m_spi_mock;
 };
+
+TEST_F(LEDModelTest, pixelType) {
+  EXPECT_CALL(m_spi_mock, SetPixelType(PIXEL_TYPE_APA102));
+
+  const uint8_t type[] = { 0, 4 };
+  unique_ptr<RDMRequest> request = BuildSetRequest(
+      PID_PIXEL_TYPE, type, arraysize(type));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  const uint8_t unknown_type[] = { 0, 5 };
+  request = BuildSetRequest(PID_PIXEL_TYPE, unknown_type,
+                            arraysize(unknown_type));
+  response.reset(NackWithReason(request.get(), ola::rdm::NR_DATA_OUT_OF_RANGE));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+}
+
+TEST_F(LEDModelTest, pixelCount) {
+  EXPECT_CALL(m_spi_mock, SetPixelCount(170));
+
+  const uint8_t count[] = { 0, 170 };
+  unique_ptr<RDMRequest> request = BuildSetRequest(
+      PID_PIXEL_COUNT, count, arraysize(count));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // Out of range values are rejected and don't change the output.
+  const uint8_t too_many[] = { 0, 171 };
+  request = BuildSetRequest(PID_PIXEL_COUNT, too_many, arraysize(too_many));
+  response.reset(NackWithReason(request.get(), ola::rdm::NR_DATA_OUT_OF_RANGE));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+}
+
+TEST_F(LEDModelTest, colorCorrection) {
+  EXPECT_CALL(m_spi_mock, SetGamma(22)).WillOnce(Return(true));
+  EXPECT_CALL(m_spi_mock, SetGamma(23)).WillOnce(Return(false));
+  EXPECT_CALL(m_spi_mock, SetWhiteBalance(255, 200, 180));
+  EXPECT_CALL(m_spi_mock, SetDithering(true));
+
+  const uint8_t gamma[] = { 22 };
+  unique_ptr<RDMRequest> request = BuildSetRequest(
+      PID_PIXEL_GAMMA, gamma, arraysize(gamma));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  const uint8_t unsupported_gamma[] = { 23 };
+  request = BuildSetRequest(PID_PIXEL_GAMMA, unsupported_gamma,
+                            arraysize(unsupported_gamma));
+  response.reset(NackWithReason(request.get(), ola::rdm::NR_DATA_OUT_OF_RANGE));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  request = BuildGetRequest(PID_PIXEL_GAMMA);
+  response.reset(GetResponseFromData(request.get(), gamma, arraysize(gamma)));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  const uint8_t white_balance[] = { 255, 200, 180 };
+  request = BuildSetRequest(PID_PIXEL_WHITE_BALANCE, white_balance,
+                            arraysize(white_balance));
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  request = BuildGetRequest(PID_PIXEL_WHITE_BALANCE);
+  response.reset(GetResponseFromData(request.get(), white_balance,
+                                     arraysize(white_balance)));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  const uint8_t dithering[] = { 1 };
+  request = BuildSetRequest(PID_PIXEL_DITHERING, dithering,
+                            arraysize(dithering));
+  response.reset(GetResponseFromData(request.get()));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+}
+
+TEST_F(LEDModelTest, brightness) {
+  EXPECT_CALL(m_spi_mock, SetBrightness(8));
+
+  const uint8_t brightness[] = { 8 };
+  unique_ptr<RDMRequest> request = BuildSetRequest(
+      PID_PIXEL_BRIGHTNESS, brightness, arraysize(brightness));
+  unique_ptr<RDMResponse> response(GetResponseFromData(request.get()));
+  int size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  request = BuildGetRequest(PID_PIXEL_BRIGHTNESS);
+  response.reset(GetResponseFromData(request.get(), brightness,
+                                     arraysize(brightness)));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  const uint8_t too_bright[] = { 32 };
+  request = BuildSetRequest(PID_PIXEL_BRIGHTNESS, too_bright,
+                            arraysize(too_bright));
+  response.reset(NackWithReason(request.get(), ola::rdm::NR_DATA_OUT_OF_RANGE));
+  size = InvokeRDMHandler(request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+}
@@ -31,20 +31,32 @@ TESTS += tests/tests/bootloader_test \
          tests/tests/bootloader_transfer_test \
          tests/tests/coarse_timer_test \
          tests/tests/dimmer_model_test \
+         tests/tests/dimmer_subdevice_test \
          tests/tests/flags_test \
+         tests/tests/interrupt_controller_test \
+         tests/tests/isr_profiler_test \
          tests/tests/led_model_test \
          tests/tests/message_handler_test \
+         tests/tests/metrics_test \
          tests/tests/network_model_test \
+         tests/tests/peripheral_dma_test \
+         tests/tests/pipeline_latency_test \
          tests/tests/proxy_model_test \
          tests/tests/rdm_handler_test \
          tests/tests/rdm_responder_test \
          tests/tests/rdm_util_test \
+         tests/tests/responder_definition_test \
          tests/tests/responder_test \
+         tests/tests/scheduler_test \
          tests/tests/spirgb_test \
          tests/tests/stream_decoder_test \
+         tests/tests/simulated_discovery_test \
          tests/tests/simulated_transceiver_test \
          tests/tests/spi_test \
+         tests/tests/timer_wheel_test \
+         tests/tests/timestamp_test \
          tests/tests/transceiver_test \
+         tests/tests/transceiver_trace_test \
          tests/tests/usb_transport_test \
          tests/tests/utils_test
 
@@ -78,12 +90,14 @@ tests_tests_coarse_timer_test_SOURCES = tests/tests/CoarseTimerTest.cpp
 tests_tests_coarse_timer_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_coarse_timer_test_LDADD = $(TESTING_LIBS) \
                                       firmware/src/libcoarsetimer.la \
+                                      tests/mocks/libcoretimermock.la \
                                       tests/harmony/mocks/libharmonymock.la
 
 tests_tests_dimmer_model_test_SOURCES = tests/tests/DimmerModelTest.cpp
 tests_tests_dimmer_model_test_CXXFLAGS = $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
 tests_tests_dimmer_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                       firmware/src/libdimmermodel.la \
+                                      firmware/src/libtimerwheel.la \
                                       firmware/src/librdmresponder.la \
                                       firmware/src/libreceivercounters.la \
                                       firmware/src/librdmbuffer.la \
@@ -93,6 +107,23 @@ tests_tests_dimmer_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                       tests/tests/libmodeltest.la \
                                       tests/mocks/libmatchers.la
 
+tests_tests_dimmer_subdevice_test_SOURCES = \
+    tests/tests/DimmerSubDeviceTest.cpp
+tests_tests_dimmer_subdevice_test_CXXFLAGS = \
+    $(TESTING_CXXFLAGS) $(OLA_CFLAGS) -DDIMMER_SUB_DEVICE_COUNT=512
+tests_tests_dimmer_subdevice_test_LDADD = \
+    $(TESTING_LIBS) $(OLA_LIBS) \
+    firmware/src/libdimmermodel512.la \
+    firmware/src/libtimerwheel.la \
+    firmware/src/librdmresponder.la \
+    firmware/src/libreceivercounters.la \
+    firmware/src/librdmbuffer.la \
+    firmware/src/librdmutil.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libcoarsetimermock.la \
+    tests/tests/libmodeltest.la \
+    tests/mocks/libmatchers.la
+
 tests_tests_flags_test_SOURCES = tests/tests/FlagsTest.cpp
 tests_tests_flags_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_flags_test_LDADD = $(TESTING_LIBS) \
@@ -100,6 +131,12 @@ tests_tests_flags_test_LDADD = $(TESTING_LIBS) \
                                tests/mocks/libmatchers.la \
                                tests/mocks/libtransportmock.la
 
+tests_tests_isr_profiler_test_SOURCES = tests/tests/ISRProfilerTest.cpp
+tests_tests_isr_profiler_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_isr_profiler_test_LDADD = $(TESTING_LIBS) \
+                                      firmware/src/libisrprofiler.la \
+                                      tests/mocks/libcoretimermock.la
+
 tests_tests_led_model_test_SOURCES = tests/tests/LEDModelTest.cpp
 tests_tests_led_model_test_CXXFLAGS = $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
 tests_tests_led_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
@@ -107,18 +144,25 @@ tests_tests_led_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                    firmware/src/librdmresponder.la \
                                    firmware/src/libreceivercounters.la \
                                    firmware/src/libcoarsetimer.la \
+                                   tests/mocks/libcoretimermock.la \
                                    firmware/src/librdmbuffer.la \
                                    firmware/src/librandom.la \
                                    firmware/src/librdmutil.la \
                                    tests/tests/libmodeltest.la \
                                    tests/harmony/mocks/libharmonymock.la \
-                                   tests/mocks/libmatchers.la
+                                   tests/mocks/libmatchers.la \
+                                   tests/mocks/libspirgbmock.la
 
 tests_tests_message_handler_test_SOURCES = tests/tests/MessageHandlerTest.cpp
 tests_tests_message_handler_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_message_handler_test_LDADD = $(GMOCK_LIBS) $(GTEST_LIBS) \
+                                         firmware/src/libisrprofiler.la \
                                          firmware/src/libmessagehandler.la \
+                                         firmware/src/libmetrics.la \
+                                         firmware/src/libpipelinelatency.la \
+                                         firmware/src/libtransceivertrace.la \
                                          tests/mocks/libappmock.la \
+                                         tests/mocks/libcoretimermock.la \
                                          tests/mocks/libflagsmock.la \
                                          tests/mocks/libmatchers.la \
                                          tests/mocks/librdmhandlermock.la \
@@ -127,6 +171,11 @@ tests_tests_message_handler_test_LDADD = $(GMOCK_LIBS) $(GTEST_LIBS) \
                                          tests/mocks/libtransportmock.la \
                                          tests/harmony/mocks/libharmonymock.la
 
+tests_tests_metrics_test_SOURCES = tests/tests/MetricsTest.cpp
+tests_tests_metrics_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_metrics_test_LDADD = $(TESTING_LIBS) \
+                                 firmware/src/libmetrics.la
+
 tests_tests_network_model_test_SOURCES = tests/tests/NetworkModelTest.cpp
 tests_tests_network_model_test_CXXFLAGS = $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
 tests_tests_network_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
@@ -134,6 +183,7 @@ tests_tests_network_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                        firmware/src/librdmresponder.la \
                                        firmware/src/libreceivercounters.la \
                                        firmware/src/libcoarsetimer.la \
+                                       tests/mocks/libcoretimermock.la \
                                        firmware/src/librdmbuffer.la \
                                        firmware/src/librandom.la \
                                        firmware/src/librdmutil.la \
@@ -141,6 +191,14 @@ tests_tests_network_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                        tests/harmony/mocks/libharmonymock.la \
                                        tests/mocks/libmatchers.la
 
+tests_tests_pipeline_latency_test_SOURCES = \
+    tests/tests/PipelineLatencyTest.cpp
+tests_tests_pipeline_latency_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_pipeline_latency_test_LDADD = \
+    $(GMOCK_LIBS) $(GTEST_LIBS) \
+    firmware/src/libpipelinelatency.la \
+    tests/mocks/libcoretimermock.la
+
 tests_tests_proxy_model_test_SOURCES = tests/tests/ProxyModelTest.cpp
 tests_tests_proxy_model_test_CXXFLAGS = $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
 tests_tests_proxy_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
@@ -148,6 +206,7 @@ tests_tests_proxy_model_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                      firmware/src/librdmresponder.la \
                                      firmware/src/libreceivercounters.la \
                                      firmware/src/libcoarsetimer.la \
+                                     tests/mocks/libcoretimermock.la \
                                      firmware/src/librdmbuffer.la \
                                      firmware/src/librandom.la \
                                      firmware/src/librdmutil.la \
@@ -160,9 +219,11 @@ tests_tests_rdm_handler_test_CXXFLAGS = $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
 tests_tests_rdm_handler_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                      tests/mocks/libmatchers.la \
                                      firmware/src/librdmhandler.la \
+                                     firmware/src/libmetrics.la \
                                      firmware/src/librdmresponder.la \
                                      firmware/src/libreceivercounters.la \
                                      firmware/src/libcoarsetimer.la \
+                                     tests/mocks/libcoretimermock.la \
                                      firmware/src/librdmbuffer.la \
                                      firmware/src/librdmutil.la \
                                      tests/harmony/mocks/libharmonymock.la
@@ -174,6 +235,7 @@ tests_tests_rdm_responder_test_LDADD = $(TESTING_LIBS) $(OLA_LIBS) \
                                        firmware/src/libreceivercounters.la \
                                        firmware/src/librdmbuffer.la \
                                        firmware/src/libcoarsetimer.la \
+                                       tests/mocks/libcoretimermock.la \
                                        firmware/src/librdmutil.la \
                                        tests/harmony/mocks/libharmonymock.la \
                                        tests/mocks/libmatchers.la \
@@ -185,6 +247,28 @@ tests_tests_rdm_util_test_LDADD = $(TESTING_LIBS) \
                                   firmware/src/librdmutil.la \
                                   tests/mocks/libmatchers.la
 
+tests_tests_responder_definition_test_SOURCES = \
+    tests/tests/ResponderDefinitionTest.cpp
+tests_tests_responder_definition_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_responder_definition_test_LDADD = \
+    $(TESTING_LIBS) \
+    firmware/src/libdimmermodel.la \
+    firmware/src/libledmodel.la \
+    firmware/src/libmovinglightmodel.la \
+    firmware/src/libnetworkmodel.la \
+    firmware/src/libproxymodel.la \
+    firmware/src/libsensormodel.la \
+    firmware/src/librdmresponder.la \
+    firmware/src/libreceivercounters.la \
+    firmware/src/libcoarsetimer.la \
+    tests/mocks/libcoretimermock.la \
+    firmware/src/libtimerwheel.la \
+    firmware/src/librdmbuffer.la \
+    firmware/src/librandom.la \
+    firmware/src/librdmutil.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libspirgbmock.la
+
 tests_tests_responder_test_SOURCES = tests/tests/ResponderTest.cpp
 tests_tests_responder_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_responder_test_LDADD = $(TESTING_LIBS) \
@@ -192,28 +276,40 @@ tests_tests_responder_test_LDADD = $(TESTING_LIBS) \
                                    firmware/src/libreceivercounters.la \
                                    firmware/src/libresponder.la \
                                    firmware/src/librdmutil.la \
+                                   firmware/src/libtimestamp.la \
+                                   tests/mocks/libcoretimermock.la \
                                    tests/mocks/libmatchers.la \
                                    tests/mocks/librdmhandlermock.la \
                                    tests/mocks/libspirgbmock.la \
                                    tests/mocks/libsyslogmock.la
 
+tests_tests_scheduler_test_SOURCES = tests/tests/SchedulerTest.cpp
+tests_tests_scheduler_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_scheduler_test_LDADD = $(TESTING_LIBS) \
+                                   firmware/src/libscheduler.la \
+                                   tests/mocks/libcoretimermock.la
+
 tests_tests_spirgb_test_SOURCES = tests/tests/SPIRGBTest.cpp
 tests_tests_spirgb_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_spirgb_test_LDADD = $(TESTING_LIBS) \
                                 firmware/src/libspirgb.la \
-                                tests/harmony/mocks/libharmonymock.la \
-                                tests/mocks/libmatchers.la
+                                firmware/src/libscheduler.la \
+                                tests/mocks/libcoretimermock.la \
+                                tests/mocks/libmatchers.la \
+                                tests/mocks/libspimock.la
 
 tests_tests_stream_decoder_test_SOURCES = tests/tests/StreamDecoderTest.cpp
 tests_tests_stream_decoder_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_stream_decoder_test_LDADD = $(TESTING_LIBS) \
                                         firmware/src/libstreamdecoder.la \
+                                        firmware/src/libmetrics.la \
                                         tests/mocks/libmessagehandlermock.la
 
 tests_tests_usb_transport_test_SOURCES = tests/tests/USBTransportTest.cpp
 tests_tests_usb_transport_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_usb_transport_test_LDADD = $(TESTING_LIBS) \
                                        firmware/src/libusbtransport.la \
+                                       firmware/src/libmetrics.la \
                                        tests/harmony/mocks/libharmonymock.la \
                                        tests/mocks/libbootloaderoptionsmock.la \
                                        tests/mocks/libmatchers.la \
@@ -227,17 +323,70 @@ tests_tests_spi_test_LDADD = \
     $(GMOCK_LIBS) $(GTEST_LIBS) $(OLA_LIBS) \
     tests/sim/libsim.la \
     firmware/src/libspi.la \
+    firmware/src/libspirgb.la \
+    firmware/src/libscheduler.la \
+    tests/mocks/libcoretimermock.la \
     tests/mocks/libmatchers.la \
     tests/harmony/mocks/libharmonymock.la
 
+tests_tests_timer_wheel_test_SOURCES = tests/tests/TimerWheelTest.cpp
+tests_tests_timer_wheel_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_timer_wheel_test_LDADD = $(TESTING_LIBS) \
+                                     firmware/src/libtimerwheel.la \
+                                     firmware/src/libcoarsetimer.la \
+                                     tests/mocks/libcoretimermock.la \
+                                     tests/harmony/mocks/libharmonymock.la
+
+tests_tests_timestamp_test_SOURCES = tests/tests/TimestampTest.cpp
+tests_tests_timestamp_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_timestamp_test_LDADD = $(TESTING_LIBS) \
+                                   firmware/src/libtimestamp.la \
+                                   tests/mocks/libcoretimermock.la
+
 tests_tests_transceiver_test_SOURCES = tests/tests/TransceiverTest.cpp
 tests_tests_transceiver_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_transceiver_test_LDADD = $(GMOCK_LIBS) $(GTEST_LIBS) \
                                      firmware/src/libtransceiver.la \
+                                     firmware/src/libmetrics.la \
+                                     firmware/src/libtimestamp.la \
                                      tests/harmony/mocks/libharmonymock.la \
                                      tests/mocks/libcoarsetimermock.la \
+                                     tests/mocks/libcoretimermock.la \
                                      tests/mocks/libsyslogmock.la
 
+tests_tests_interrupt_controller_test_SOURCES = \
+    tests/tests/InterruptControllerTest.cpp
+tests_tests_interrupt_controller_test_CXXFLAGS = \
+    $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
+tests_tests_interrupt_controller_test_LDADD = \
+    $(GMOCK_LIBS) $(GTEST_LIBS) $(OLA_LIBS) \
+    tests/sim/libsim.la \
+    tests/harmony/mocks/libharmonymock.la
+
+tests_tests_peripheral_dma_test_SOURCES = \
+    tests/tests/PeripheralDMATest.cpp
+tests_tests_peripheral_dma_test_CXXFLAGS = \
+    $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
+tests_tests_peripheral_dma_test_LDADD = \
+    $(GMOCK_LIBS) $(GTEST_LIBS) $(OLA_LIBS) \
+    tests/sim/libsim.la \
+    tests/harmony/mocks/libharmonymock.la
+
+tests_tests_simulated_discovery_test_SOURCES = \
+    tests/tests/SimulatedDiscoveryTest.cpp
+tests_tests_simulated_discovery_test_CXXFLAGS = \
+    $(TESTING_CXXFLAGS) $(OLA_CFLAGS)
+tests_tests_simulated_discovery_test_LDADD = \
+    $(GMOCK_LIBS) $(GTEST_LIBS) $(OLA_LIBS) \
+    tests/sim/libsim.la \
+    firmware/src/libtransceiver.la \
+    firmware/src/libmetrics.la \
+    firmware/src/libtimestamp.la \
+    firmware/src/libcoarsetimer.la \
+    tests/mocks/libcoretimermock.la \
+    tests/harmony/mocks/libharmonymock.la \
+    tests/mocks/libsyslogmock.la
+
 tests_tests_simulated_transceiver_test_SOURCES = \
     tests/tests/SimulatedTransceiverTest.cpp
 tests_tests_simulated_transceiver_test_CXXFLAGS = \
@@ -246,10 +395,21 @@ tests_tests_simulated_transceiver_test_LDADD = \
     $(GMOCK_LIBS) $(GTEST_LIBS) $(OLA_LIBS) \
     tests/sim/libsim.la \
     firmware/src/libtransceiver.la \
+    firmware/src/libmetrics.la \
+    firmware/src/libtimestamp.la \
     firmware/src/libcoarsetimer.la \
+    tests/mocks/libcoretimermock.la \
     tests/harmony/mocks/libharmonymock.la \
     tests/mocks/libsyslogmock.la
 
+tests_tests_transceiver_trace_test_SOURCES = \
+    tests/tests/TransceiverTraceTest.cpp
+tests_tests_transceiver_trace_test_CXXFLAGS = $(TESTING_CXXFLAGS)
+tests_tests_transceiver_trace_test_LDADD = \
+    $(GMOCK_LIBS) $(GTEST_LIBS) \
+    firmware/src/libtransceivertrace.la \
+    tests/mocks/libcoretimermock.la
+
 tests_tests_utils_test_SOURCES = tests/tests/UtilsTest.cpp
 tests_tests_utils_test_CXXFLAGS = $(TESTING_CXXFLAGS)
 tests_tests_utils_test_LDADD = $(GMOCK_LIBS) $(GTEST_LIBS) \
@@ -19,6 +19,7 @@
  */
 
 #include <gtest/gtest.h>
+#include <string.h>
 
 #include "AppMock.h"
 #include "Array.h"
@@ -28,7 +29,11 @@
 #include "TransceiverMock.h"
 #include "TransportMock.h"
 #include "constants.h"
+#include "isr_profiler.h"
 #include "message_handler.h"
+#include "metrics.h"
+#include "pipeline_latency.h"
+#include "transceiver_trace.h"
 
 using ::testing::Args;
 using ::testing::Return;
@@ -228,7 +233,8 @@ class MessageHandlerTest : public testing::Test {
       .result = result,
       .data = data,
       .length = length,
-      .timing = &timing
+      .timing = &timing,
+      .timestamp = 0u
     };
     MessageHandler_TransceiverEvent(&event);
   }
@@ -329,6 +335,153 @@ TEST_F(MessageHandlerTest, testFlags) {
   MessageHandler_HandleMessage(&message);
 }
 
+TEST_F(MessageHandlerTest, testMetrics) {
+  Metrics_Initialize();
+  Metrics_Set(METRIC_UPTIME, 10u);
+
+  // A rejected frame is counted.
+  const uint8_t dmx_data[] = {1, 3, 4, 4};
+  EXPECT_CALL(m_transceiver_mock, QueueDMX(_, _, arraysize(dmx_data)))
+      .WillOnce(Return(false));
+  EXPECT_CALL(m_transport_mock, Send(kToken, TX_DMX, RC_BUFFER_FULL, NULL, 0))
+      .WillOnce(Return(true));
+  Message dmx_message = { kToken, TX_DMX, arraysize(dmx_data), &dmx_data[0] };
+  MessageHandler_HandleMessage(&dmx_message);
+  EXPECT_EQ(1u, Metrics_Get(METRIC_BUFFER_FULL));
+
+  uint32_t metrics[METRIC_COUNT] = {};
+  metrics[METRIC_UPTIME] = 10u;
+  metrics[METRIC_BUFFER_FULL] = 1u;
+  const uint8_t *response = reinterpret_cast<const uint8_t*>(metrics);
+
+  EXPECT_CALL(m_transport_mock, Send(kToken, COMMAND_GET_METRICS, RC_OK, _, 1))
+      .With(Args<3, 4>(PayloadIs(response, sizeof(metrics))))
+      .WillOnce(Return(true));
+
+  Message message = { kToken, COMMAND_GET_METRICS, 0, NULL };
+  MessageHandler_HandleMessage(&message);
+
+  // Extra data is an error.
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_GET_METRICS, RC_BAD_PARAM, NULL, 0))
+      .WillOnce(Return(true));
+
+  message.length = arraysize(dmx_data);
+  message.payload = dmx_data;
+  MessageHandler_HandleMessage(&message);
+}
+
+TEST_F(MessageHandlerTest, testISRStats) {
+  ISRProfiler_Reset();
+  ISRProfiler_RecordLatency(ISR_PROFILER_CORE_TIMER, 12u);
+
+  ISRProfiler_Stats stats[ISR_PROFILER_COUNT] = {};
+  stats[ISR_PROFILER_CORE_TIMER].max_latency = 12u;
+  const uint8_t *response = reinterpret_cast<const uint8_t*>(stats);
+
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_GET_ISR_STATS, RC_OK, _, 1))
+      .With(Args<3, 4>(PayloadIs(response, sizeof(stats))))
+      .Times(2)
+      .WillRepeatedly(Return(true));
+
+  Message message = { kToken, COMMAND_GET_ISR_STATS, 0, NULL };
+  MessageHandler_HandleMessage(&message);
+
+  // Read and reset.
+  const uint8_t reset = 1u;
+  message.length = sizeof(reset);
+  message.payload = &reset;
+  MessageHandler_HandleMessage(&message);
+  EXPECT_EQ(0u, ISRProfiler_GetStats()[ISR_PROFILER_CORE_TIMER].max_latency);
+
+  // Extra data is an error.
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_GET_ISR_STATS, RC_BAD_PARAM, NULL, 0))
+      .WillOnce(Return(true));
+
+  const uint8_t payload[] = {1, 2};
+  message.length = arraysize(payload);
+  message.payload = payload;
+  MessageHandler_HandleMessage(&message);
+}
+
+TEST_F(MessageHandlerTest, testLatencyStats) {
+  PipelineLatency_Initialize();
+  PipelineLatency_TransferReceived();
+  PipelineLatency_MessageReceived(kToken);
+  PipelineLatency_ResponseSent(kToken);
+
+  // With the core timer stopped, every interval is 0.
+  PipelineLatency_Stats stats[PIPELINE_STAGE_COUNT] = {};
+  stats[PIPELINE_STAGE_DECODE].count = 1u;
+  stats[PIPELINE_STAGE_DECODE].histogram[0] = 1u;
+  stats[PIPELINE_STAGE_RESPONSE].count = 1u;
+  stats[PIPELINE_STAGE_RESPONSE].histogram[0] = 1u;
+  stats[PIPELINE_STAGE_TOTAL].count = 1u;
+  stats[PIPELINE_STAGE_TOTAL].histogram[0] = 1u;
+  const uint8_t *response = reinterpret_cast<const uint8_t*>(stats);
+
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_GET_LATENCY_STATS, RC_OK, _, 1))
+      .With(Args<3, 4>(PayloadIs(response, sizeof(stats))))
+      .WillOnce(Return(true));
+
+  const uint8_t reset = 1u;
+  Message message = { kToken, COMMAND_GET_LATENCY_STATS, sizeof(reset),
+                      &reset };
+  MessageHandler_HandleMessage(&message);
+  EXPECT_EQ(0u, PipelineLatency_GetStats()[PIPELINE_STAGE_TOTAL].count);
+
+  // Extra data is an error.
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_GET_LATENCY_STATS, RC_BAD_PARAM, NULL, 0))
+      .WillOnce(Return(true));
+
+  const uint8_t payload[] = {1, 2};
+  message.length = arraysize(payload);
+  message.payload = payload;
+  MessageHandler_HandleMessage(&message);
+}
+
+TEST_F(MessageHandlerTest, testTrace) {
+  TransceiverTrace_Initialize();
+  TransceiverTrace_Record(1u, 2u, 3, 4u);
+
+  TransceiverTraceEvent event = {};
+  event.token = 3;
+  event.data_index = 4u;
+  event.state = 1u;
+  event.op = 2u;
+  uint8_t response[sizeof(uint32_t) + sizeof(event)] = {};
+  memcpy(response + sizeof(uint32_t), &event, sizeof(event));
+
+  EXPECT_CALL(m_transport_mock, Send(kToken, COMMAND_GET_TRACE, RC_OK, _, 2))
+      .With(Args<3, 4>(PayloadIs(response, arraysize(response))))
+      .WillOnce(Return(true));
+
+  Message message = { kToken, COMMAND_GET_TRACE, 0, NULL };
+  MessageHandler_HandleMessage(&message);
+
+  // The event was consumed.
+  const uint32_t dropped = 0u;
+  EXPECT_CALL(m_transport_mock, Send(kToken, COMMAND_GET_TRACE, RC_OK, _, 2))
+      .With(Args<3, 4>(PayloadIs(reinterpret_cast<const uint8_t*>(&dropped),
+                                 sizeof(dropped))))
+      .WillOnce(Return(true));
+  MessageHandler_HandleMessage(&message);
+
+  // Extra data is an error.
+  EXPECT_CALL(m_transport_mock,
+              Send(kToken, COMMAND_GET_TRACE, RC_BAD_PARAM, NULL, 0))
+      .WillOnce(Return(true));
+
+  const uint8_t payload[] = {1};
+  message.length = arraysize(payload);
+  message.payload = payload;
+  MessageHandler_HandleMessage(&message);
+}
+
 TEST_F(MessageHandlerTest, testReset) {
   MockApp app_mock;
   APP_SetMock(&app_mock);
@@ -0,0 +1,56 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * MetricsTest.cpp
+ * Tests for the Metrics code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <string>
+
+#include "metrics.h"
+
+TEST(MetricsTest, counterAndGauge) {
+  Metrics_Initialize();
+  EXPECT_EQ(0u, Metrics_Get(METRIC_TX_FRAMES));
+
+  Metrics_Increment(METRIC_TX_FRAMES);
+  Metrics_Increment(METRIC_TX_FRAMES);
+  EXPECT_EQ(2u, Metrics_Get(METRIC_TX_FRAMES));
+
+  Metrics_Set(METRIC_SCHEDULER_LOAD, 123u);
+  EXPECT_EQ(123u, Metrics_Get(METRIC_SCHEDULER_LOAD));
+
+  Metrics_Initialize();
+  EXPECT_EQ(0u, Metrics_Get(METRIC_TX_FRAMES));
+  EXPECT_EQ(0u, Metrics_Get(METRIC_SCHEDULER_LOAD));
+}
+
+TEST(MetricsTest, definitions) {
+  std::set<std::string> names;
+  for (unsigned int i = 0; i < METRIC_COUNT; i++) {
+    const char *name = Metrics_Name(static_cast<MetricId>(i));
+    ASSERT_NE(nullptr, name) << "Metric " << i;
+    EXPECT_TRUE(names.insert(name).second) << "Duplicate name " << name;
+  }
+  EXPECT_EQ(nullptr, Metrics_Name(METRIC_COUNT));
+
+  EXPECT_EQ(METRIC_TYPE_GAUGE, Metrics_Type(METRIC_UPTIME));
+  EXPECT_EQ(METRIC_TYPE_COUNTER, Metrics_Type(METRIC_TX_FRAMES));
+  EXPECT_STREQ("tx_frames", Metrics_Name(METRIC_TX_FRAMES));
+}
@@ -0,0 +1,111 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PeripheralDMATest.cpp
+ * Tests for the simulator's DMA controller.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "sys/kmem.h"
+
+#include "tests/sim/InterruptController.h"
+#include "tests/sim/PeripheralDMA.h"
+
+using std::vector;
+
+// Records the bytes written to a peripheral register.
+class FakeRegister : public DMARegister {
+ public:
+  uint8_t Read() { return 0; }
+  void Write(uint8_t data) { written.push_back(data); }
+
+  vector<uint8_t> written;
+};
+
+class PeripheralDMATest : public testing::Test {
+ public:
+  PeripheralDMATest()
+      : m_dma(&m_interrupt_controller),
+        m_data(600) {
+    for (unsigned int i = 0; i < m_data.size(); i++) {
+      m_data[i] = i;
+    }
+  }
+
+  void SetUp() {
+    m_dma.MapRegister(&m_register_address, &m_register);
+    m_dma.Enable(DMA_ID_0);
+    m_dma.ChannelXStartIRQSet(DMA_ID_0, DMA_CHANNEL_1,
+                              DMA_TRIGGER_SPI_2_TRANSMIT);
+    m_dma.ChannelXTriggerEnable(DMA_ID_0, DMA_CHANNEL_1,
+                                DMA_CHANNEL_TRIGGER_TRANSFER_START);
+    m_dma.ChannelXCellSizeSet(DMA_ID_0, DMA_CHANNEL_1, 1);
+  }
+
+ protected:
+  InterruptController m_interrupt_controller;
+  PeripheralDMA m_dma;
+  FakeRegister m_register;
+  uint8_t m_register_address;
+  vector<uint8_t> m_data;
+
+  // Start a block that writes the data to the register.
+  void StartBlock(uint16_t size) {
+    m_dma.ChannelXSourceStartAddressSet(DMA_ID_0, DMA_CHANNEL_1,
+                                        KVA_TO_PA(m_data.data()));
+    m_dma.ChannelXSourceSizeSet(DMA_ID_0, DMA_CHANNEL_1, size);
+    m_dma.ChannelXDestinationStartAddressSet(DMA_ID_0, DMA_CHANNEL_1,
+                                             KVA_TO_PA(&m_register_address));
+    m_dma.ChannelXDestinationSizeSet(DMA_ID_0, DMA_CHANNEL_1, 1);
+    m_dma.ChannelXEnable(DMA_ID_0, DMA_CHANNEL_1);
+  }
+
+  // Trigger cells until the channel disables itself.
+  void RunBlock() {
+    for (unsigned int i = 0; i < m_data.size(); i++) {
+      if (!m_dma.ChannelXIsEnabled(DMA_ID_0, DMA_CHANNEL_1)) {
+        return;
+      }
+      m_interrupt_controller.RaiseInterrupt(INT_SOURCE_SPI_2_TRANSMIT);
+    }
+  }
+};
+
+TEST_F(PeripheralDMATest, fullBlock) {
+  // A size of 256 is stored as 0, which is the largest block.
+  StartBlock(256);
+  RunBlock();
+
+  EXPECT_EQ(vector<uint8_t>(m_data.begin(), m_data.begin() + 256),
+            m_register.written);
+  EXPECT_EQ(256u, m_dma.CellCount(DMA_CHANNEL_1));
+  EXPECT_EQ(1u, m_dma.BlockCount(DMA_CHANNEL_1));
+}
+
+TEST_F(PeripheralDMATest, sizeIsTruncated) {
+  // Only the low 8 bits of the size fit in the register.
+  StartBlock(m_data.size());
+  RunBlock();
+
+  const unsigned int truncated_size = m_data.size() % 256;
+  EXPECT_EQ(vector<uint8_t>(m_data.begin(), m_data.begin() + truncated_size),
+            m_register.written);
+  EXPECT_EQ(1u, m_dma.BlockCount(DMA_CHANNEL_1));
+}
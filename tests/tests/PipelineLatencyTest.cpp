@@ -0,0 +1,136 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * PipelineLatencyTest.cpp
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include "pipeline_latency.h"
+#include "timestamp.h"
+#include "CoreTimerMock.h"
+
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+class PipelineLatencyTest : public testing::Test {
+ public:
+  void SetUp() {
+    CoreTimer_SetMock(&m_core_timer_mock);
+    ON_CALL(m_core_timer_mock, GetCount()).WillByDefault(Invoke([this]() {
+      return m_core_timer;
+    }));
+    Timestamp_Initialize();
+    PipelineLatency_Initialize();
+  }
+
+  void TearDown() {
+    CoreTimer_SetMock(NULL);
+  }
+
+  void AdvanceMicroSeconds(uint32_t micro_seconds) {
+    m_core_timer += micro_seconds * TIMESTAMP_TICKS_PER_MICROSECOND;
+  }
+
+  const PipelineLatency_Stats &Stats(PipelineStage stage) {
+    return PipelineLatency_GetStats()[stage];
+  }
+
+  NiceMock<MockCoreTimer> m_core_timer_mock;
+  uint32_t m_core_timer = 1000u;
+};
+
+TEST_F(PipelineLatencyTest, transceiverMessage) {
+  PipelineLatency_TransferReceived();
+  AdvanceMicroSeconds(10u);
+  PipelineLatency_MessageReceived(5u);
+  AdvanceMicroSeconds(100u);
+  const Timestamp frame_start = Timestamp_Now();
+  AdvanceMicroSeconds(3000u);
+  PipelineLatency_TransceiverEvent(5, frame_start);
+  AdvanceMicroSeconds(50u);
+  PipelineLatency_ResponseSent(5u);
+
+  EXPECT_EQ(1u, Stats(PIPELINE_STAGE_DECODE).count);
+  EXPECT_EQ(10u, Stats(PIPELINE_STAGE_DECODE).min);
+  EXPECT_EQ(100u, Stats(PIPELINE_STAGE_QUEUE).max);
+  EXPECT_EQ(3000u, Stats(PIPELINE_STAGE_LINE).total);
+  EXPECT_EQ(50u, Stats(PIPELINE_STAGE_RESPONSE).total);
+  EXPECT_EQ(3160u, Stats(PIPELINE_STAGE_TOTAL).total);
+
+  // 3000us is in [2048, 4096).
+  EXPECT_EQ(1u, Stats(PIPELINE_STAGE_LINE).histogram[7]);
+  // 10us is in the first bucket.
+  EXPECT_EQ(1u, Stats(PIPELINE_STAGE_DECODE).histogram[0]);
+
+  // A second response with the same token isn't recorded.
+  PipelineLatency_ResponseSent(5u);
+  EXPECT_EQ(1u, Stats(PIPELINE_STAGE_TOTAL).count);
+
+  PipelineLatency_ResetStats();
+  EXPECT_EQ(0u, Stats(PIPELINE_STAGE_TOTAL).count);
+}
+
+TEST_F(PipelineLatencyTest, localMessage) {
+  PipelineLatency_TransferReceived();
+  PipelineLatency_MessageReceived(1u);
+  AdvanceMicroSeconds(20u);
+  PipelineLatency_ResponseSent(1u);
+
+  EXPECT_EQ(1u, Stats(PIPELINE_STAGE_DECODE).count);
+  EXPECT_EQ(0u, Stats(PIPELINE_STAGE_QUEUE).count);
+  EXPECT_EQ(0u, Stats(PIPELINE_STAGE_LINE).count);
+  EXPECT_EQ(20u, Stats(PIPELINE_STAGE_RESPONSE).max);
+  EXPECT_EQ(20u, Stats(PIPELINE_STAGE_TOTAL).max);
+}
+
+TEST_F(PipelineLatencyTest, interleavedMessages) {
+  PipelineLatency_TransferReceived();
+  PipelineLatency_MessageReceived(1u);
+  PipelineLatency_MessageReceived(2u);
+
+  AdvanceMicroSeconds(100u);
+  PipelineLatency_TransceiverEvent(2, 0u);
+  PipelineLatency_ResponseSent(2u);
+  AdvanceMicroSeconds(100u);
+  PipelineLatency_ResponseSent(1u);
+
+  EXPECT_EQ(2u, Stats(PIPELINE_STAGE_TOTAL).count);
+  EXPECT_EQ(100u, Stats(PIPELINE_STAGE_TOTAL).min);
+  EXPECT_EQ(200u, Stats(PIPELINE_STAGE_TOTAL).max);
+  // No frame was sent for the event, so there are no queue or line times.
+  EXPECT_EQ(0u, Stats(PIPELINE_STAGE_LINE).count);
+
+  // Unsolicited responses and unknown events are ignored.
+  PipelineLatency_TransceiverEvent(-1, 0u);
+  PipelineLatency_ResponseSent(9u);
+  EXPECT_EQ(2u, Stats(PIPELINE_STAGE_TOTAL).count);
+}
+
+TEST_F(PipelineLatencyTest, tooManyMessages) {
+  PipelineLatency_TransferReceived();
+  for (unsigned int i = 0; i < PIPELINE_LATENCY_MAX_MESSAGES + 1u; i++) {
+    PipelineLatency_MessageReceived(i);
+  }
+
+  // The oldest message was forgotten.
+  PipelineLatency_ResponseSent(0u);
+  EXPECT_EQ(0u, Stats(PIPELINE_STAGE_TOTAL).count);
+  for (unsigned int i = 1; i < PIPELINE_LATENCY_MAX_MESSAGES + 1u; i++) {
+    PipelineLatency_ResponseSent(i);
+  }
+  EXPECT_EQ(PIPELINE_LATENCY_MAX_MESSAGES, Stats(PIPELINE_STAGE_TOTAL).count);
+}
@@ -26,6 +26,7 @@
 #include <ola/rdm/RDMEnums.h>
 #include <ola/rdm/UID.h>
 
+#include "metrics.h"
 #include "rdm_buffer.h"
 #include "rdm_handler.h"
 #include "utils.h"
@@ -71,6 +72,8 @@ class MockModel {
   MOCK_METHOD2(Request,
                int(const RDMHeader *header, const uint8_t *param_data));
   MOCK_METHOD0(Tasks, void());
+  MOCK_METHOD3(DMX, void(unsigned int offset, const uint8_t *data,
+                         unsigned int length));
 };
 
 MockModel *g_first_mock = nullptr;
@@ -108,6 +111,12 @@ void TasksFirst() {
   }
 }
 
+void DMXFirst(unsigned int offset, const uint8_t *data, unsigned int length) {
+  if (g_first_mock) {
+    g_first_mock->DMX(offset, data, length);
+  }
+}
+
 void ActivateSecond() {
   if (g_second_mock) {
     g_second_mock->Activate();
@@ -229,7 +238,10 @@ const ModelEntry RDMHandlerTest::FIRST_MODEL {
   DeactivateFirst,
   IoctlFirst,
   RequestFirst,
-  TasksFirst
+  TasksFirst,
+  DMXFirst,
+  nullptr,
+  0
 };
 
 const ModelEntry RDMHandlerTest::SECOND_MODEL {
@@ -238,7 +250,10 @@ const ModelEntry RDMHandlerTest::SECOND_MODEL {
   DeactivateSecond,
   IoctlSecond,
   RequestSecond,
-  TasksSecond
+  TasksSecond,
+  nullptr,
+  nullptr,
+  0
 };
 
 TEST_F(RDMHandlerTest, testDispatching) {
@@ -331,6 +346,37 @@ TEST_F(RDMHandlerTest, testSendResponse) {
                            nullptr);
 }
 
+TEST_F(RDMHandlerTest, testDMX) {
+  RDMHandlerSettings settings = {
+    .default_model = NULL_MODEL_ID,
+    .send_callback = nullptr
+  };
+  RDMHandler_Initialize(&settings);
+
+  const uint8_t dmx_data[] = {1, 2, 3};
+
+  // No active model
+  RDMHandler_HandleDMX(0, dmx_data, arraysize(dmx_data));
+
+  EXPECT_TRUE(RDMHandler_AddModel(&FIRST_MODEL));
+  EXPECT_TRUE(RDMHandler_AddModel(&SECOND_MODEL));
+
+  testing::InSequence seq;
+  EXPECT_CALL(m_first_model, Activate()).Times(1);
+  EXPECT_CALL(m_first_model, DMX(10, dmx_data, arraysize(dmx_data)))
+    .Times(1);
+
+  EXPECT_TRUE(RDMHandler_SetActiveModel(MODEL_ONE));
+  RDMHandler_HandleDMX(10, dmx_data, arraysize(dmx_data));
+
+  // The second model doesn't have a dmx_fn
+  EXPECT_CALL(m_first_model, Deactivate()).Times(1);
+  EXPECT_CALL(m_second_model, Activate()).Times(1);
+
+  EXPECT_TRUE(RDMHandler_SetActiveModel(MODEL_TWO));
+  RDMHandler_HandleDMX(10, dmx_data, arraysize(dmx_data));
+}
+
 TEST_F(RDMHandlerTest, testGetSetModelId) {
   RDMHandlerSettings settings = {
     .default_model = MODEL_ONE,
@@ -441,3 +487,78 @@ TEST_F(RDMHandlerTest, testGetModelList) {
 
   CallRDMHandler(get_request.get());
 }
+
+TEST_F(RDMHandlerTest, testGetDeviceMetrics) {
+  RDMHandlerSettings settings = {
+    .default_model = MODEL_ONE,
+    .send_callback = SendResponse
+  };
+  RDMHandler_Initialize(&settings);
+  Metrics_Initialize();
+  Metrics_Increment(METRIC_TX_FRAMES);
+  Metrics_Set(METRIC_UPTIME, 0x01020304);
+
+  EXPECT_CALL(m_first_model, Activate()).Times(1);
+  EXPECT_CALL(m_first_model, Ioctl(IOCTL_GET_UID, _, UID_LENGTH))
+    .WillRepeatedly(WithArgs<1>(CopyUID(TEST_UID)));
+  EXPECT_TRUE(RDMHandler_AddModel(&FIRST_MODEL));
+
+  unique_ptr<RDMRequest> get_request(new RDMGetRequest(
+      m_controller_uid, m_our_uid, 0, 0, 0, PID_DEVICE_METRICS,
+      nullptr, 0));
+
+  uint8_t metrics[METRIC_COUNT * sizeof(uint32_t)] = {
+    0x01, 0x02, 0x03, 0x04,  // uptime
+    0x00, 0x00, 0x00, 0x00,  // scheduler_load
+    0x00, 0x00, 0x00, 0x01,  // tx_frames
+  };
+  unique_ptr<RDMResponse> get_response(GetResponseFromData(
+        get_request.get(), metrics, arraysize(metrics)));
+
+  EXPECT_CALL(m_sender_mock, SendResponse(true, _, 1))
+      .With(testing::Args<1, 2>(IOVecResponseIs(get_response.get())));
+
+  CallRDMHandler(get_request.get());
+}
+
+TEST_F(RDMHandlerTest, testGetDeviceMetricDescription) {
+  RDMHandlerSettings settings = {
+    .default_model = MODEL_ONE,
+    .send_callback = SendResponse
+  };
+  RDMHandler_Initialize(&settings);
+
+  EXPECT_CALL(m_first_model, Activate()).Times(1);
+  EXPECT_CALL(m_first_model, Ioctl(IOCTL_GET_UID, _, UID_LENGTH))
+    .WillRepeatedly(WithArgs<1>(CopyUID(TEST_UID)));
+  EXPECT_TRUE(RDMHandler_AddModel(&FIRST_MODEL));
+
+  const uint8_t metric = METRIC_TX_FRAMES;
+  unique_ptr<RDMRequest> get_request(new RDMGetRequest(
+      m_controller_uid, m_our_uid, 0, 0, 0, PID_DEVICE_METRIC_DESCRIPTION,
+      &metric, sizeof(metric)));
+
+  const uint8_t description[] = {
+    METRIC_TX_FRAMES, METRIC_TYPE_COUNTER,
+    't', 'x', '_', 'f', 'r', 'a', 'm', 'e', 's'
+  };
+  unique_ptr<RDMResponse> get_response(GetResponseFromData(
+        get_request.get(), description, arraysize(description)));
+
+  EXPECT_CALL(m_sender_mock, SendResponse(true, _, 1))
+      .With(testing::Args<1, 2>(IOVecResponseIs(get_response.get())));
+  CallRDMHandler(get_request.get());
+
+  // Out of range
+  const uint8_t bad_metric = METRIC_COUNT;
+  get_request.reset(new RDMGetRequest(
+      m_controller_uid, m_our_uid, 0, 0, 0, PID_DEVICE_METRIC_DESCRIPTION,
+      &bad_metric, sizeof(bad_metric)));
+  unique_ptr<RDMResponse> nack_response(
+      ola::rdm::NackWithReason(get_request.get(),
+                               ola::rdm::NR_DATA_OUT_OF_RANGE));
+
+  EXPECT_CALL(m_sender_mock, SendResponse(true, _, 1))
+      .With(testing::Args<1, 2>(IOVecResponseIs(nack_response.get())));
+  CallRDMHandler(get_request.get());
+}
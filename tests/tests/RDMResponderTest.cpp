@@ -50,6 +50,7 @@ using ola::rdm::RDMSetRequest;
 using std::unique_ptr;
 using ::testing::StrictMock;
 using ::testing::Return;
+using ::testing::_;
 
 namespace {
 
@@ -95,6 +96,19 @@ int ClearSensors(const RDMHeader *header,
   return 0;
 }
 
+RDMResponder g_test_subdevices[2];
+
+unsigned int g_released_subdevices = 0;
+
+void SelectTestSubDevice(unsigned int slot) {
+  RDMResponder_SwitchResponder(&g_test_subdevices[slot]);
+}
+
+void ReleaseTestSubDevice(unsigned int slot) {
+  EXPECT_EQ(&g_test_subdevices[slot], g_responder);
+  g_released_subdevices++;
+}
+
 // Sensors
 enum { NUMBER_OF_SENSORS = 2 };
 
@@ -239,6 +253,7 @@ class RDMResponderTest : public testing::Test {
     }
 
     g_responder->def = def;
+    RDMResponder_InvalidateCache();
   }
 
   void InitResponder() {
@@ -400,8 +415,8 @@ TEST_F(RDMResponderTest, testBuildNack) {
 
 TEST_F(RDMResponderTest, testDispatch) {
   const PIDDescriptor pid_descriptors[] = {
-    {PID_IDENTIFY_DEVICE, GetIdentifyDevice, 0, (PIDCommandHandler) nullptr},
     {PID_RECORD_SENSORS, (PIDCommandHandler) nullptr, 0, ClearSensors},
+    {PID_IDENTIFY_DEVICE, GetIdentifyDevice, 0, (PIDCommandHandler) nullptr},
   };
   ResponderDefinition responder_def;
   InitDefinition(&responder_def);
@@ -503,8 +518,8 @@ TEST_F(RDMResponderTest, supportedParameters) {
     {PID_DEVICE_INFO, nullptr, 0, nullptr},
     {PID_SOFTWARE_VERSION_LABEL, nullptr, 0, nullptr},
     {PID_DMX_START_ADDRESS, nullptr, 0, nullptr},
-    {PID_IDENTIFY_DEVICE, nullptr, 0, nullptr},
-    {PID_RECORD_SENSORS, nullptr, 0, nullptr}
+    {PID_RECORD_SENSORS, nullptr, 0, nullptr},
+    {PID_IDENTIFY_DEVICE, nullptr, 0, nullptr}
   };
 
   ResponderDefinition responder_def;
@@ -812,6 +827,64 @@ TEST_F(RDMResponderTest, dmxStartAddress) {
   EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
 }
 
+TEST_F(RDMResponderTest, deviceInfo) {
+  ResponderDefinition responder_def;
+  InitDefinition(&responder_def);
+  responder_def.model_id = 0x0102;
+  responder_def.product_category = PRODUCT_CATEGORY_TEST;
+  responder_def.software_version = 0x01020304;
+
+  g_responder->current_personality = 1u;
+  g_responder->dmx_start_address = 10u;
+  g_responder->sub_device_count = 0u;
+  RDMResponder_InvalidateCache();
+
+  unique_ptr<RDMRequest> request = BuildGetRequest(PID_DEVICE_INFO);
+
+  const uint8_t expected_response[] = {
+    1, 0, 1, 2, 0x71, 0, 1, 2, 3, 4, 0, 2, 1, 2, 0, 10, 0, 0, 2
+  };
+
+  unique_ptr<RDMResponse> response(GetResponseFromData(
+        request.get(),
+        expected_response,
+        arraysize(expected_response)));
+
+  int size = InvokeHandler(RDMResponder_GetDeviceInfo, request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // A second GET is served from the cache.
+  size = InvokeHandler(RDMResponder_GetDeviceInfo, request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // Changing the start address & personality invalidates the cache.
+  uint8_t address_data[] = { 0, 20 };
+  unique_ptr<RDMRequest> set_request = BuildSetRequest(
+      PID_DMX_START_ADDRESS, address_data, arraysize(address_data));
+  InvokeHandler(RDMResponder_SetDMXStartAddress, set_request.get());
+
+  uint8_t new_personality = 2;
+  set_request = BuildSetRequest(
+      PID_DMX_PERSONALITY, &new_personality, sizeof(new_personality));
+  InvokeHandler(RDMResponder_SetDMXPersonality, set_request.get());
+
+  const uint8_t updated_response[] = {
+    1, 0, 1, 2, 0x71, 0, 1, 2, 3, 4, 0, 2, 2, 2, 0, 20, 0, 0, 2
+  };
+
+  response.reset(GetResponseFromData(
+        request.get(),
+        updated_response,
+        arraysize(updated_response)));
+
+  size = InvokeHandler(RDMResponder_GetDeviceInfo, request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+
+  // Restore the state the other tests expect.
+  g_responder->dmx_start_address = 10u;
+  RDMResponder_InvalidateCache();
+}
+
 TEST_F(RDMResponderTest, slotInfo) {
   unique_ptr<RDMRequest> request = BuildGetRequest(PID_SLOT_INFO);
 
@@ -1078,3 +1151,61 @@ TEST_F(RDMResponderTest, paramDescription) {
       &PIXEL_TYPE_DESCRIPTION);
   EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
 }
+
+TEST_F(RDMResponderTest, subDeviceRegistry) {
+  InitResponder();
+  EXPECT_EQ(0, RDMResponder_SubDeviceCount());
+
+  g_released_subdevices = 0;
+  RDMResponder_ResetSubDevices(SelectTestSubDevice, ReleaseTestSubDevice);
+  EXPECT_FALSE(RDMResponder_AddSubDevice(SUBDEVICE_ROOT));
+  EXPECT_TRUE(RDMResponder_AddSubDevice(1));
+  EXPECT_TRUE(RDMResponder_AddSubDevice(512));
+  EXPECT_FALSE(RDMResponder_AddSubDevice(512));
+  EXPECT_FALSE(RDMResponder_AddSubDevice(513));
+
+  EXPECT_EQ(2, RDMResponder_SubDeviceCount());
+  EXPECT_EQ(0, RDMResponder_SubDeviceSlot(1));
+  EXPECT_EQ(1, RDMResponder_SubDeviceSlot(512));
+  EXPECT_EQ(-1, RDMResponder_SubDeviceSlot(2));
+  EXPECT_EQ(-1, RDMResponder_SubDeviceSlot(SUBDEVICE_ALL));
+
+  const PIDDescriptor pid_descriptors[] = {
+    {PID_RECORD_SENSORS, (PIDCommandHandler) nullptr, 0, ClearSensors},
+  };
+  ResponderDefinition responder_def;
+  InitDefinition(&responder_def);
+  responder_def.descriptors = pid_descriptors;
+  responder_def.descriptor_count = arraysize(pid_descriptors);
+  g_test_subdevices[0].def = &responder_def;
+  g_test_subdevices[1].def = &responder_def;
+  RDMResponder *root = g_responder;
+
+  // A SET to all sub devices is dispatched to each of them.
+  uint8_t sensor_index = 0;
+  unique_ptr<RDMRequest> request(new RDMSetRequest(
+      m_controller_uid, m_our_uid, 0, 0, SUBDEVICE_ALL, PID_RECORD_SENSORS,
+      &sensor_index, sizeof(sensor_index)));
+
+  EXPECT_CALL(m_pid_handler, Call(PID_RECORD_SENSORS, false, _, _))
+    .Times(2)
+    .WillRepeatedly(Return(26));
+  EXPECT_EQ(26, InvokeHandler(RDMResponder_DispatchSubDevice, request.get()));
+  EXPECT_EQ(root, g_responder);
+  EXPECT_EQ(2u, g_released_subdevices);
+
+  // A sub device that doesn't exist.
+  request.reset(new RDMSetRequest(
+      m_controller_uid, m_our_uid, 0, 0, 2, PID_RECORD_SENSORS,
+      &sensor_index, sizeof(sensor_index)));
+
+  unique_ptr<RDMResponse> response(
+      ola::rdm::NackWithReason(request.get(),
+                               ola::rdm::NR_SUB_DEVICE_OUT_OF_RANGE));
+  int size = InvokeHandler(RDMResponder_DispatchSubDevice, request.get());
+  EXPECT_THAT(ArrayTuple(g_rdm_buffer, size), ResponseIs(response.get()));
+  EXPECT_EQ(2u, g_released_subdevices);
+
+  RDMResponder_ResetSubDevices(nullptr, nullptr);
+  EXPECT_EQ(0, RDMResponder_SubDeviceCount());
+}
@@ -0,0 +1,68 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * ResponderDefinitionTest.cpp
+ * Checks the ResponderDefinitions of all the models.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include "dimmer_model.h"
+#include "led_model.h"
+#include "moving_light.h"
+#include "network_model.h"
+#include "proxy_model.h"
+#include "rdm_model.h"
+#include "rdm_responder.h"
+#include "sensor_model.h"
+
+class ResponderDefinitionTest
+    : public ::testing::TestWithParam<const ModelEntry*> {
+};
+
+/*
+ * Check that the descriptors are sorted by PID, with no duplicates. This is
+ * required by RDMResponder_DispatchPID().
+ */
+TEST_P(ResponderDefinitionTest, DescriptorsAreSorted) {
+  const ModelEntry *model = GetParam();
+  ASSERT_NE(nullptr, model->definitions);
+  ASSERT_GT(model->definition_count, 0u)
+      << "Model 0x" << std::hex << model->model_id;
+
+  for (unsigned int i = 0; i < model->definition_count; i++) {
+    const ResponderDefinition *definition = model->definitions[i];
+    ASSERT_NE(nullptr, definition);
+    ASSERT_NE(nullptr, definition->descriptors);
+
+    for (unsigned int j = 1; j < definition->descriptor_count; j++) {
+      EXPECT_LT(definition->descriptors[j - 1].pid,
+                definition->descriptors[j].pid)
+          << "Model 0x" << std::hex << definition->model_id << ", PID 0x"
+          << definition->descriptors[j].pid << " is out of order";
+    }
+  }
+}
+
+INSTANTIATE_TEST_CASE_P(
+    AllModels,
+    ResponderDefinitionTest,
+    ::testing::Values(&DIMMER_MODEL_ENTRY,
+                      &LED_MODEL_ENTRY,
+                      &MOVING_LIGHT_MODEL_ENTRY,
+                      &NETWORK_MODEL_ENTRY,
+                      &PROXY_MODEL_ENTRY,
+                      &SENSOR_MODEL_ENTRY));
@@ -30,6 +30,7 @@
 #include "RDMHandlerMock.h"
 #include "SPIRGBMock.h"
 
+using ::testing::AnyNumber;
 using ::testing::IgnoreResult;
 using ::testing::Return;
 using ::testing::StrictMock;
@@ -41,6 +42,7 @@ class ResponderTest : public testing::Test {
   void SetUp() {
     RDMHandler_SetMock(&handler_mock);
     SPIRGB_SetMock(&spi_mock);
+    EXPECT_CALL(handler_mock, HandleDMX(_, _, _)).Times(AnyNumber());
     Responder_Initialize();
     ReceiverCounters_ResetCounters();
   }
@@ -57,6 +59,7 @@ class ResponderTest : public testing::Test {
     event.op = T_OP_RX;
     event.data = frame;
     event.timing = NULL;
+    event.timestamp = 0u;
 
     unsigned int i = 0;
     while (i < size) {
@@ -238,6 +241,7 @@ TEST_F(ResponderTest, nonRxOp) {
   event.data = NULL;
   event.length = 0;
   event.timing = NULL;
+  event.timestamp = 0u;
   event.result = T_RESULT_RX_CONTINUE_FRAME;
   Responder_Receive(&event);
 }
@@ -282,13 +286,32 @@ TEST_F(ResponderTest, dmxCounters) {
   EXPECT_EQ(45, ReceiverCounters_DMXMaximumSlotCount());
 }
 
+TEST_F(ResponderTest, dmxData) {
+  // One slot per event.
+  unsigned int i = 1;
+  for (; i < arraysize(DMX_FRAME); i++) {
+    EXPECT_CALL(handler_mock, HandleDMX(i - 1, &DMX_FRAME[i], 1)).Times(1);
+  }
+  SendFrame(DMX_FRAME, arraysize(DMX_FRAME));
+
+  // Multiple slots per event.
+  EXPECT_CALL(handler_mock, HandleDMX(0, &DMX_FRAME[1], 3)).Times(1);
+  EXPECT_CALL(handler_mock, HandleDMX(3, &DMX_FRAME[4], 4)).Times(1);
+  EXPECT_CALL(handler_mock, HandleDMX(7, &DMX_FRAME[8], 3)).Times(1);
+  SendFrame(DMX_FRAME, arraysize(DMX_FRAME), 4);
+
+  // Non-DMX frames aren't passed on.
+  EXPECT_CALL(handler_mock, HandleDMX(_, _, _)).Times(0);
+  SendFrame(ASC_FRAME, arraysize(ASC_FRAME), 4);
+}
+
 TEST_F(ResponderTest, SPIOutput) {
   SPIRGBConfiguration spi_config;
   spi_config.module_id = SPI_ID_1;
-  spi_config.baud_rate = 2000000;
-  spi_config.use_enhanced_buffering = false;
   SPIRGB_Init(&spi_config);
 
+  EXPECT_CALL(spi_mock, PixelCount())
+    .WillRepeatedly(Return(2));
   EXPECT_CALL(spi_mock, BeginUpdate())
     .Times(1);
   EXPECT_CALL(spi_mock, SetPixel(0, RED, 1)).Times(1);
@@ -302,3 +325,17 @@ TEST_F(ResponderTest, SPIOutput) {
 
   SendFrame(DMX_FRAME, arraysize(DMX_FRAME));
 }
+
+TEST_F(ResponderTest, SPIOutputOnLastPixel) {
+  EXPECT_CALL(spi_mock, PixelCount())
+    .WillRepeatedly(Return(2));
+  EXPECT_CALL(spi_mock, BeginUpdate())
+    .Times(1);
+  EXPECT_CALL(spi_mock, SetPixel(_, _, _)).Times(6);
+  EXPECT_CALL(spi_mock, CompleteUpdate())
+    .Times(1);
+
+  // The frame ends on the last pixel slot, the update completes without
+  // waiting for the frame timeout.
+  SendFrame(DMX_FRAME, 7);
+}
@@ -24,65 +24,75 @@
 #include "spi_rgb.h"
 #include "Array.h"
 #include "Matchers.h"
-#include "plib_spi_mock.h"
+#include "SPIMock.h"
 
+using ::testing::AnyNumber;
 using ::testing::ElementsAreArray;
+using ::testing::Each;
 using ::testing::Invoke;
+using ::testing::IsNull;
 using ::testing::Return;
 using ::testing::StrictMock;
-using ::testing::WithArgs;
 using ::testing::_;
 
 class SPIRGBTest : public testing::Test {
  public:
+  SPIRGBTest()
+      : m_complete_immediately(true),
+        m_output(NULL),
+        m_output_length(0),
+        m_callback(NULL) {
+    m_config.module_id = SPI_ID_1;
+  }
+
   void SetUp() {
-    PLIB_SPI_SetMock(&spi_mock);
+    SPI_SetMock(&spi_mock);
+    ON_CALL(spi_mock, QueueTransfer(_, _, _, _, _, _))
+      .WillByDefault(Invoke(this, &SPIRGBTest::QueueTransfer));
+    EXPECT_CALL(spi_mock, QueueTransfer(SPI_ID_1, _, _, IsNull(), 0, _))
+      .Times(AnyNumber());
   }
 
   void TearDown() {
-    PLIB_SPI_SetMock(NULL);
+    SPI_SetMock(NULL);
   }
 
-  void AppendByte(uint8_t byte) {
-    m_spi_data.push_back(byte);
+  /*
+   * The data is recorded once the transfer completes, which checks the frame
+   * isn't modified while it's being sent.
+   */
+  bool QueueTransfer(SPI_MODULE_ID, const uint8_t *output,
+                     unsigned int output_length, uint8_t*, unsigned int,
+                     SPI_Callback callback) {
+    m_output = output;
+    m_output_length = output_length;
+    m_callback = callback;
+    if (m_complete_immediately) {
+      CompleteTransfer();
+    }
+    return true;
+  }
+
+  void CompleteTransfer() {
+    ASSERT_NE(nullptr, m_callback);
+    m_spi_data.insert(m_spi_data.end(), m_output, m_output + m_output_length);
+    SPI_Callback callback = m_callback;
+    m_callback = NULL;
+    callback(SPI_COMPLETE_TRANSFER);
   }
 
  protected:
-  StrictMock<MockPeripheralSPI> spi_mock;
+  StrictMock<MockSPI> spi_mock;
+  SPIRGBConfiguration m_config;
   std::vector<uint8_t> m_spi_data;
+  bool m_complete_immediately;
+  const uint8_t *m_output;
+  unsigned int m_output_length;
+  SPI_Callback m_callback;
 };
 
-TEST_F(SPIRGBTest, testSimpleMode) {
-  SPIRGBConfiguration config;
-  config.module_id = SPI_ID_1;
-  config.baud_rate = 2000000;
-  config.use_enhanced_buffering = false;
-
-  EXPECT_CALL(spi_mock, BaudRateSet(SPI_ID_1, _, 2000000))
-    .Times(1);
-  EXPECT_CALL(spi_mock,
-              CommunicationWidthSelect(SPI_ID_1, SPI_COMMUNICATION_WIDTH_8BITS))
-    .Times(1);
-  EXPECT_CALL(spi_mock,
-              ClockPolaritySelect(SPI_ID_1, SPI_CLOCK_POLARITY_IDLE_HIGH))
-    .Times(1);
-  EXPECT_CALL(spi_mock, SlaveSelectDisable(SPI_ID_1))
-    .Times(1);
-  EXPECT_CALL(spi_mock, PinDisable(SPI_ID_1, SPI_PIN_SLAVE_SELECT))
-    .Times(1);
-  EXPECT_CALL(spi_mock, Enable(SPI_ID_1))
-    .Times(1);
-  EXPECT_CALL(spi_mock, MasterEnable(SPI_ID_1))
-    .Times(1);
-  EXPECT_CALL(spi_mock, IsBusy(SPI_ID_1))
-    .WillRepeatedly(Return(false));
-  EXPECT_CALL(spi_mock, BufferWrite(SPI_ID_1, _))
-    .WillRepeatedly(WithArgs<1>(Invoke(this, &SPIRGBTest::AppendByte)));
-
-  EXPECT_CALL(spi_mock, IsBusy(SPI_ID_1))
-    .WillRepeatedly(Return(false));
-
-  SPIRGB_Init(&config);
+TEST_F(SPIRGBTest, testUpdate) {
+  SPIRGB_Init(&m_config);
 
   SPIRGB_BeginUpdate();
   SPIRGB_CompleteUpdate();
@@ -111,63 +121,311 @@ TEST_F(SPIRGBTest, testSimpleMode) {
   EXPECT_THAT(m_spi_data, ElementsAreArray(expected2));
 }
 
-TEST_F(SPIRGBTest, testEnhancedMode) {
-  SPIRGBConfiguration config;
-  config.module_id = SPI_ID_1;
-  config.baud_rate = 4000000;
-  config.use_enhanced_buffering = true;
+TEST_F(SPIRGBTest, testFullStrip) {
+  SPIRGB_Init(&m_config);
+  EXPECT_EQ(2u, SPIRGB_PixelCount());
+
+  SPIRGB_SetPixelCount(SPIRGB_MAX_PIXELS + 1u);
+  EXPECT_EQ(SPIRGB_MAX_PIXELS, SPIRGB_PixelCount());
+
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(169, RED, 255);
+  SPIRGB_SetPixel(170, RED, 255);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  // 170 pixels, followed by one latch byte for every 32 pixels.
+  ASSERT_EQ(516u, m_spi_data.size());
+  std::vector<uint8_t> pixels(m_spi_data.begin(), m_spi_data.begin() + 507);
+  EXPECT_THAT(pixels, Each(0x80));
+  EXPECT_EQ(0x80, m_spi_data[507]);
+  EXPECT_EQ(0xff, m_spi_data[508]);
+  EXPECT_EQ(0x80, m_spi_data[509]);
+  const uint8_t latch[] = {0, 0, 0, 0, 0, 0};
+  EXPECT_THAT(std::vector<uint8_t>(m_spi_data.begin() + 510, m_spi_data.end()),
+              ElementsAreArray(latch));
+}
+
+TEST_F(SPIRGBTest, testQueueing) {
+  m_config.module_id = SPI_ID_2;
+  m_complete_immediately = false;
+  SPIRGB_Init(&m_config);
+  SPIRGB_SetPixelCount(64);
 
-  EXPECT_CALL(spi_mock, BaudRateSet(SPI_ID_1, _, 4000000))
-    .Times(1);
-  EXPECT_CALL(spi_mock,
-              CommunicationWidthSelect(SPI_ID_1, SPI_COMMUNICATION_WIDTH_8BITS))
-    .Times(1);
-  EXPECT_CALL(spi_mock,
-              ClockPolaritySelect(SPI_ID_1, SPI_CLOCK_POLARITY_IDLE_HIGH))
-    .Times(1);
-  EXPECT_CALL(spi_mock, FIFOEnable(SPI_ID_1))
-    .Times(1);
-  EXPECT_CALL(spi_mock, SlaveSelectDisable(SPI_ID_1))
-    .Times(1);
-  EXPECT_CALL(spi_mock, PinDisable(SPI_ID_1, SPI_PIN_SLAVE_SELECT))
-    .Times(1);
-  EXPECT_CALL(spi_mock, Enable(SPI_ID_1))
-    .Times(1);
-  EXPECT_CALL(spi_mock, MasterEnable(SPI_ID_1))
-    .Times(1);
-  EXPECT_CALL(spi_mock, IsBusy(SPI_ID_1))
-    .WillRepeatedly(Return(false));
-  EXPECT_CALL(spi_mock, BufferWrite(SPI_ID_1, _))
-    .WillRepeatedly(WithArgs<1>(Invoke(this, &SPIRGBTest::AppendByte)));
+  // Nothing is sent until the first update completes.
+  SPIRGB_Tasks();
 
-  EXPECT_CALL(spi_mock, TransmitBufferIsFull(SPI_ID_1))
-    .WillRepeatedly(Return(false));
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, GREEN, 128);
+  SPIRGB_SetPixel(63, BLUE, 255);
+  SPIRGB_CompleteUpdate();
 
-  SPIRGB_Init(&config);
+  // The SPI queue is full, so the frame is retried.
+  EXPECT_CALL(spi_mock, QueueTransfer(SPI_ID_2, _, 194, IsNull(), 0, _))
+    .WillOnce(Return(false))
+    .WillOnce(Invoke(this, &SPIRGBTest::QueueTransfer));
+  SPIRGB_Tasks();
+  EXPECT_EQ(nullptr, m_callback);
+  SPIRGB_Tasks();
+  ASSERT_NE(nullptr, m_callback);
+  const uint8_t *frame = m_output;
+
+  // The frame has been handed off, further calls are no-ops.
+  SPIRGB_Tasks();
+
+  // While the previous transfer is still running, the next frame waits. It's
+  // encoded into the other buffer.
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, GREEN, 0);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  // 64 pixels and 2 latch bytes.
+  CompleteTransfer();
+  ASSERT_EQ(194u, m_spi_data.size());
+  EXPECT_EQ(0xc0, m_spi_data[0]);
+  EXPECT_EQ(0x80, m_spi_data[1]);
+  EXPECT_EQ(0x80, m_spi_data[188]);
+  EXPECT_EQ(0x80, m_spi_data[190]);
+  EXPECT_EQ(0xff, m_spi_data[191]);
+  EXPECT_EQ(0, m_spi_data[192]);
+  EXPECT_EQ(0, m_spi_data[193]);
+  m_spi_data.clear();
+
+  EXPECT_CALL(spi_mock, QueueTransfer(SPI_ID_2, _, 194, IsNull(), 0, _))
+    .WillOnce(Invoke(this, &SPIRGBTest::QueueTransfer));
+  SPIRGB_Tasks();
+  EXPECT_NE(frame, m_output);
+
+  CompleteTransfer();
+  ASSERT_EQ(194u, m_spi_data.size());
+  EXPECT_EQ(0x80, m_spi_data[0]);
+  EXPECT_EQ(0xff, m_spi_data[191]);
+}
+
+TEST_F(SPIRGBTest, testDoubleBuffering) {
+  m_complete_immediately = false;
+  SPIRGB_Init(&m_config);
+
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, RED, 255);
+  SPIRGB_SetPixel(1, RED, 255);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
 
+  // Start the next update, this doesn't stop the current frame.
   SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, RED, 0);
+  SPIRGB_Tasks();
+  SPIRGB_SetPixel(1, RED, 0);
+  SPIRGB_Tasks();
   SPIRGB_CompleteUpdate();
   SPIRGB_Tasks();
 
+  CompleteTransfer();
+  SPIRGB_Tasks();
+  CompleteTransfer();
+
   const uint8_t expected[] = {
+    0x80, 0xff, 0x80, 0x80, 0xff, 0x80, 0,
     0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0
   };
   EXPECT_THAT(m_spi_data, ElementsAreArray(expected));
   m_spi_data.clear();
 
-  // Now set some pixels
-  SPIRGB_SetPixel(0, RED, 255);
-
-  // Now actually start the update
+  // A short frame leaves the remaining pixels unchanged.
+  m_complete_immediately = true;
   SPIRGB_BeginUpdate();
   SPIRGB_SetPixel(0, BLUE, 255);
-  SPIRGB_SetPixel(1, GREEN, 128);
-
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(1, GREEN, 255);
   SPIRGB_CompleteUpdate();
   SPIRGB_Tasks();
 
   const uint8_t expected2[] = {
-    0x80, 0x80, 0xff, 0xc0, 0x80, 0x80, 0
+    0x80, 0x80, 0xff, 0x80, 0x80, 0x80, 0,
+    0x80, 0x80, 0xff, 0xff, 0x80, 0x80, 0
   };
   EXPECT_THAT(m_spi_data, ElementsAreArray(expected2));
 }
+
+TEST_F(SPIRGBTest, testRepeatedComplete) {
+  SPIRGB_Init(&m_config);
+
+  EXPECT_CALL(spi_mock, QueueTransfer(SPI_ID_1, _, 7, IsNull(), 0, _))
+    .WillOnce(Invoke(this, &SPIRGBTest::QueueTransfer));
+
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, RED, 255);
+  SPIRGB_CompleteUpdate();
+  // The second call, e.g. from the RX timeout, doesn't queue another frame.
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+  SPIRGB_Tasks();
+
+  const uint8_t expected[] = {
+    0x80, 0xff, 0x80, 0x80, 0x80, 0x80, 0
+  };
+  EXPECT_THAT(m_spi_data, ElementsAreArray(expected));
+}
+
+TEST_F(SPIRGBTest, testPixelTypes) {
+  SPIRGB_Init(&m_config);
+
+  SPIRGB_SetPixelType(PIXEL_TYPE_WS2801);
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, RED, 255);
+  SPIRGB_SetPixel(0, GREEN, 128);
+  SPIRGB_SetPixel(1, RED, 1);
+  SPIRGB_SetPixel(1, GREEN, 2);
+  SPIRGB_SetPixel(1, BLUE, 3);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  const uint8_t ws2801[] = { 0xff, 0x80, 0, 1, 2, 3 };
+  EXPECT_THAT(m_spi_data, ElementsAreArray(ws2801));
+  m_spi_data.clear();
+
+  // Changing the type keeps the pixel values.
+  SPIRGB_SetPixelType(PIXEL_TYPE_P9813);
+  SPIRGB_BeginUpdate();
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  const uint8_t p9813[] = {
+    0, 0, 0, 0,
+    0xf4, 0, 0x80, 0xff,
+    0xff, 3, 2, 1,
+    0, 0, 0, 0
+  };
+  EXPECT_THAT(m_spi_data, ElementsAreArray(p9813));
+  m_spi_data.clear();
+
+  SPIRGB_SetPixelType(PIXEL_TYPE_APA102);
+  SPIRGB_BeginUpdate();
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  const uint8_t apa102[] = {
+    0, 0, 0, 0,
+    0xff, 0, 0x80, 0xff,
+    0xff, 3, 2, 1,
+    0
+  };
+  EXPECT_THAT(m_spi_data, ElementsAreArray(apa102));
+  m_spi_data.clear();
+
+  // The global brightness is sent in the header byte.
+  SPIRGB_SetBrightness(4);
+  SPIRGB_BeginUpdate();
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  const uint8_t dimmed_apa102[] = {
+    0, 0, 0, 0,
+    0xe4, 0, 0x80, 0xff,
+    0xe4, 3, 2, 1,
+    0
+  };
+  EXPECT_THAT(m_spi_data, ElementsAreArray(dimmed_apa102));
+  m_spi_data.clear();
+
+  SPIRGB_SetPixelType(PIXEL_TYPE_LPD8806);
+  SPIRGB_BeginUpdate();
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  const uint8_t lpd8806[] = { 0xc0, 0xff, 0x80, 0x81, 0x80, 0x81, 0 };
+  EXPECT_THAT(m_spi_data, ElementsAreArray(lpd8806));
+}
+
+TEST_F(SPIRGBTest, testPixelTypeChangeDuringTransfer) {
+  m_complete_immediately = false;
+  SPIRGB_Init(&m_config);
+
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, RED, 255);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+  ASSERT_NE(nullptr, m_callback);
+
+  // Change the type while the frame is being sent.
+  SPIRGB_SetPixelType(PIXEL_TYPE_APA102);
+  SPIRGB_BeginUpdate();
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  CompleteTransfer();
+  const uint8_t lpd8806[] = { 0x80, 0xff, 0x80, 0x80, 0x80, 0x80, 0 };
+  EXPECT_THAT(m_spi_data, ElementsAreArray(lpd8806));
+  m_spi_data.clear();
+
+  // Both frame buffers now use the new layout.
+  const uint8_t apa102[] = {
+    0, 0, 0, 0,
+    0xff, 0, 0, 0xff,
+    0xff, 0, 0, 0,
+    0
+  };
+  for (unsigned int i = 0; i < 2; i++) {
+    SPIRGB_Tasks();
+    CompleteTransfer();
+    EXPECT_THAT(m_spi_data, ElementsAreArray(apa102));
+    m_spi_data.clear();
+
+    SPIRGB_BeginUpdate();
+    SPIRGB_CompleteUpdate();
+  }
+}
+
+TEST_F(SPIRGBTest, testColorCorrection) {
+  SPIRGB_Init(&m_config);
+  SPIRGB_SetPixelType(PIXEL_TYPE_WS2801);
+  SPIRGB_SetPixelCount(1);
+  SPIRGB_SetWhiteBalance(255, 200, 255);
+
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, RED, 255);
+  SPIRGB_SetPixel(0, GREEN, 128);
+  SPIRGB_SetPixel(0, BLUE, 64);
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  const uint8_t balanced[] = { 255, 100, 64 };
+  EXPECT_THAT(m_spi_data, ElementsAreArray(balanced));
+  m_spi_data.clear();
+
+  EXPECT_FALSE(SPIRGB_SetGamma(23));
+  EXPECT_TRUE(SPIRGB_SetGamma(22));
+  SPIRGB_BeginUpdate();
+  SPIRGB_CompleteUpdate();
+  SPIRGB_Tasks();
+
+  const uint8_t gamma[] = { 255, 44, 12 };
+  EXPECT_THAT(m_spi_data, ElementsAreArray(gamma));
+  m_spi_data.clear();
+
+  // A level of 1 is half a step on a LPD8806, so dithering alternates
+  // between 0 and 1. Frames are sent continuously.
+  EXPECT_TRUE(SPIRGB_SetGamma(10));
+  SPIRGB_SetWhiteBalance(255, 255, 255);
+  SPIRGB_SetPixelType(PIXEL_TYPE_LPD8806);
+  SPIRGB_SetDithering(true);
+  SPIRGB_BeginUpdate();
+  SPIRGB_SetPixel(0, RED, 1);
+  SPIRGB_CompleteUpdate();
+
+  std::vector<uint8_t> red_levels;
+  for (unsigned int i = 0; i < 8; i++) {
+    SPIRGB_Tasks();
+    ASSERT_EQ(4u, m_spi_data.size());
+    red_levels.push_back(m_spi_data[1]);
+    m_spi_data.clear();
+  }
+  const uint8_t expected_red[] = {
+    0x80, 0x81, 0x80, 0x81, 0x80, 0x81, 0x80, 0x81
+  };
+  EXPECT_THAT(red_levels, ElementsAreArray(expected_red));
+}
@@ -28,17 +28,23 @@
 #include "constants.h"
 #include "dmx_spec.h"
 #include "setting_macros.h"
+#include "plib_dma_mock.h"
 #include "spi.h"
+#include "spi_rgb.h"
+#include "sys/kmem.h"
 
 #include "tests/sim/InterruptController.h"
+#include "tests/sim/PeripheralDMA.h"
 #include "tests/sim/PeripheralSPI.h"
 #include "tests/sim/Simulator.h"
 
+using ::testing::AnyNumber;
 using ::testing::ElementsAreArray;
 using ::testing::InSequence;;
 using ::testing::InvokeWithoutArgs;
 using ::testing::IsEmpty;;
-using ::testing::Return;
+using ::testing::NiceMock;
+using ::testing::SaveArg;
 using ::testing::StrictMock;
 using ::testing::_;
 using ola::NewCallback;
@@ -49,7 +55,9 @@ extern "C" {
 #endif
 
 // Declare the ISR symbols.
-void SPI_Event(void);
+void SPI2_Event(void);
+void SPI_DMA2Event(void);
+void SPI_DMA3Event(void);
 
 #ifdef __cplusplus
 }
@@ -74,7 +82,14 @@ class SPITest : public testing::Test {
   SPITest()
       : m_callback(ola::NewCallback(&SPI_Tasks)),
         m_simulator(kClockSpeed),
-        m_spi(&m_simulator, &m_interrupt_controller) {
+        m_spi(&m_simulator, &m_interrupt_controller),
+        m_dma(&m_interrupt_controller) {
+    m_config.module_id = SPI_ID_2;
+    m_config.baud_rate = kBaudRate;
+    m_config.use_enhanced_buffering = true;
+    m_config.use_dma = false;
+    m_config.tx_dma_channel = DMA_CHANNEL_2;
+    m_config.rx_dma_channel = DMA_CHANNEL_3;
   }
 
   void SetUp() {
@@ -84,17 +99,24 @@ class SPITest : public testing::Test {
     SYS_INT_SetMock(&m_interrupt_controller);
 
     m_interrupt_controller.RegisterISR(INT_SOURCE_SPI_2_RECEIVE,
-        NewCallback(&SPI_Event));
+        INT_VECTOR_SPI2, NewCallback(&SPI2_Event));
     m_interrupt_controller.RegisterISR(INT_SOURCE_SPI_2_TRANSMIT,
-        NewCallback(&SPI_Event));
+        INT_VECTOR_SPI2, NewCallback(&SPI2_Event));
+    m_interrupt_controller.RegisterISR(INT_SOURCE_DMA_2,
+        INT_VECTOR_DMA2, NewCallback(&SPI_DMA2Event));
+    m_interrupt_controller.RegisterISR(INT_SOURCE_DMA_3,
+        INT_VECTOR_DMA3, NewCallback(&SPI_DMA3Event));
+    m_dma.MapRegister(PLIB_SPI_BufferAddressGet(SPI_ID_2),
+                      m_spi.BufferRegister(SPI_ID_2));
 
     m_simulator.AddTask(m_callback.get());
 
-    SPI_Initialize();
+    SPI_Initialize(&m_config);
   }
 
   void TearDown() {
     g_event_handler = nullptr;
+    PLIB_DMA_SetMock(nullptr);
     PLIB_SPI_SetMock(nullptr);
     SYS_INT_SetMock(nullptr);
 
@@ -103,12 +125,15 @@ class SPITest : public testing::Test {
 
  protected:
   std::unique_ptr<ola::Callback0<void>> m_callback;
+  SPIConfiguration m_config;
 
   Simulator m_simulator;
   InterruptController m_interrupt_controller;
   PeripheralSPI m_spi;
+  PeripheralDMA m_dma;
 
   StrictMock<MockEventHandler> m_event_handler;
+  unsigned int m_stop_after;
 
   void AddInputBytes(const uint8_t *data, unsigned int size) {
     for (unsigned int i = 0; i < size; i++) {
@@ -116,6 +141,22 @@ class SPITest : public testing::Test {
     }
   }
 
+  // Run the simulator until size bytes have been sent.
+  void RunUntilSent(unsigned int size) {
+    std::unique_ptr<ola::Callback0<void>> stop_task(
+        NewCallback(this, &SPITest::StopAfterSent));
+    m_stop_after = size;
+    m_simulator.AddTask(stop_task.get());
+    m_simulator.Run();
+    m_simulator.RemoveTask(stop_task.get());
+  }
+
+  void StopAfterSent() {
+    if (m_spi.SentBytes(SPI_ID_2).size() >= m_stop_after) {
+      m_simulator.Stop();
+    }
+  }
+
   static const uint32_t kClockSpeed = 80000000;
   static const uint32_t kBaudRate = 250000;
 };
@@ -123,7 +164,7 @@ class SPITest : public testing::Test {
 TEST_F(SPITest, testOutput) {
   uint8_t output[] = {1, 2, 3};
   EXPECT_TRUE(SPI_QueueTransfer(
-      output, arraysize(output), nullptr, 0, &EventHandler));
+      SPI_ID_2, output, arraysize(output), nullptr, 0, &EventHandler));
 
   EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
   EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
@@ -139,7 +180,7 @@ TEST_F(SPITest, testInput) {
 
   uint8_t input[3];
   EXPECT_TRUE(SPI_QueueTransfer(
-      nullptr, 0, input, arraysize(input), &EventHandler));
+      SPI_ID_2, nullptr, 0, input, arraysize(input), &EventHandler));
 
   EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
   EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
@@ -157,7 +198,7 @@ TEST_F(SPITest, testInput) {
 
 TEST_F(SPITest, nullTransfer) {
   EXPECT_TRUE(SPI_QueueTransfer(
-      nullptr, 0, nullptr, 0, &EventHandler));
+      SPI_ID_2, nullptr, 0, nullptr, 0, &EventHandler));
 
   EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
     .WillOnce(InvokeWithoutArgs(&m_simulator, &Simulator::Stop));
@@ -167,6 +208,16 @@ TEST_F(SPITest, nullTransfer) {
   EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), IsEmpty());
 }
 
+TEST_F(SPITest, tooLong) {
+  uint8_t data[1];
+  EXPECT_FALSE(SPI_QueueTransfer(
+      SPI_ID_2, data, SPI_MAX_TRANSFER_LENGTH + 1u, nullptr, 0,
+      &EventHandler));
+  EXPECT_FALSE(SPI_QueueTransfer(
+      SPI_ID_2, nullptr, 0, data, SPI_MAX_TRANSFER_LENGTH + 1u,
+      &EventHandler));
+}
+
 TEST_F(SPITest, writeReadTransfer) {
   // larger than the enhanced buffer size.
   uint8_t tx_data[] = {1, 2, 3, 4};
@@ -178,7 +229,8 @@ TEST_F(SPITest, writeReadTransfer) {
 
   uint8_t input[11];
   EXPECT_TRUE(SPI_QueueTransfer(
-      tx_data, arraysize(tx_data), input, arraysize(input), &EventHandler));
+      SPI_ID_2, tx_data, arraysize(tx_data), input, arraysize(input),
+      &EventHandler));
 
   EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
   EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
@@ -199,7 +251,7 @@ TEST_F(SPITest, bigTransfer) {
   // larger than the enhanced buffer size.
   uint8_t output[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
   EXPECT_TRUE(SPI_QueueTransfer(
-      output, arraysize(output), nullptr, 0, &EventHandler));
+      SPI_ID_2, output, arraysize(output), nullptr, 0, &EventHandler));
 
   EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
   EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
@@ -209,32 +261,350 @@ TEST_F(SPITest, bigTransfer) {
   EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), ElementsAreArray(output));
 }
 
-TEST_F(SPITest, testDoubleTransfer) {
-  uint8_t output1[] = {1, 2, 3};
-  uint8_t output2[] = {4, 5, 6};
-  uint8_t output3[] = {7, 8, 9};
-  EXPECT_TRUE(SPI_QueueTransfer(
-      output1, arraysize(output1), nullptr, 0, &EventHandler));
-  EXPECT_TRUE(SPI_QueueTransfer(
-      output2, arraysize(output2), nullptr, 0, &EventHandler));
+TEST_F(SPITest, testQueuedTransfers) {
+  uint8_t output[SPI_QUEUE_SIZE + 1][2];
+  for (unsigned int i = 0; i < SPI_QUEUE_SIZE + 1; i++) {
+    output[i][0] = 2 * i;
+    output[i][1] = 2 * i + 1;
+  }
+
+  for (unsigned int i = 0; i < SPI_QUEUE_SIZE; i++) {
+    EXPECT_TRUE(SPI_QueueTransfer(
+        SPI_ID_2, output[i], arraysize(output[i]), nullptr, 0,
+        &EventHandler));
+  }
   EXPECT_FALSE(SPI_QueueTransfer(
-      output3, arraysize(output3), nullptr, 0, &EventHandler));
+      SPI_ID_2, output[SPI_QUEUE_SIZE], arraysize(output[SPI_QUEUE_SIZE]),
+      nullptr, 0, &EventHandler));
+
+  // The module hasn't been initialized.
+  EXPECT_FALSE(SPI_QueueTransfer(
+      SPI_ID_1, output[0], arraysize(output[0]), nullptr, 0, &EventHandler));
 
   InSequence seq;
+  for (unsigned int i = 0; i < SPI_QUEUE_SIZE; i++) {
+    EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
+    EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
+      .WillOnce(InvokeWithoutArgs(&m_simulator, &Simulator::Stop));
+  }
+
+  m_simulator.Run();
+
+  EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), ElementsAreArray(output[0]));
+
+  // Completing a transfer frees a slot.
+  EXPECT_TRUE(SPI_QueueTransfer(
+      SPI_ID_2, output[SPI_QUEUE_SIZE], arraysize(output[SPI_QUEUE_SIZE]),
+      nullptr, 0, nullptr));
+
+  // Now continue.
+  for (unsigned int i = 1; i < SPI_QUEUE_SIZE; i++) {
+    m_simulator.Run();
+  }
+  m_simulator.SetClockLimit(10000, false);
+  m_simulator.Run();
+
+  // The transfers are performed in the order they were queued.
+  vector<uint8_t> expected;
+  for (unsigned int i = 0; i < SPI_QUEUE_SIZE + 1; i++) {
+    expected.push_back(output[i][0]);
+    expected.push_back(output[i][1]);
+  }
+  EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), ElementsAreArray(expected));
+}
+
+TEST_F(SPITest, testDMAOutput) {
+  NiceMock<MockPeripheralDMA> dma_mock;
+  PLIB_DMA_SetMock(&dma_mock);
+
+  m_config.use_dma = true;
+  EXPECT_CALL(dma_mock, ChannelXStartIRQSet(DMA_ID_0, DMA_CHANNEL_2,
+                                            DMA_TRIGGER_SPI_2_TRANSMIT))
+    .Times(1);
+  EXPECT_CALL(dma_mock, ChannelXStartIRQSet(DMA_ID_0, DMA_CHANNEL_3,
+                                            DMA_TRIGGER_SPI_2_RECEIVE))
+    .Times(1);
+  EXPECT_CALL(dma_mock,
+              ChannelXINTSourceEnable(DMA_ID_0, DMA_CHANNEL_2,
+                                      DMA_INT_BLOCK_TRANSFER_COMPLETE))
+    .Times(1);
+  EXPECT_CALL(dma_mock,
+              ChannelXINTSourceEnable(DMA_ID_0, DMA_CHANNEL_3,
+                                      DMA_INT_BLOCK_TRANSFER_COMPLETE))
+    .Times(1);
+  SPI_Initialize(&m_config);
+
+  uint8_t output[] = {1, 2, 3};
+  EXPECT_TRUE(SPI_QueueTransfer(
+      SPI_ID_2, output, arraysize(output), nullptr, 0, &EventHandler));
+
+  EXPECT_CALL(dma_mock,
+              ChannelXSourceStartAddressSet(DMA_ID_0, DMA_CHANNEL_2,
+                                            KVA_TO_PA(output)))
+    .Times(1);
+  EXPECT_CALL(dma_mock, ChannelXSourceSizeSet(DMA_ID_0, DMA_CHANNEL_2, 3))
+    .Times(1);
+  EXPECT_CALL(
+      dma_mock,
+      ChannelXDestinationStartAddressSet(
+          DMA_ID_0, DMA_CHANNEL_2,
+          KVA_TO_PA(PLIB_SPI_BufferAddressGet(SPI_ID_2))))
+    .Times(1);
+  EXPECT_CALL(dma_mock, ChannelXEnable(DMA_ID_0, DMA_CHANNEL_2)).Times(1);
+
   EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
+  m_simulator.SetClockLimit(10, false);
+  m_simulator.Run();
+
+  // The DMA channel completes the block, and then the SPI module sends the
+  // last byte.
+  EXPECT_CALL(dma_mock,
+              ChannelXINTSourceFlagClear(DMA_ID_0, DMA_CHANNEL_2,
+                                         DMA_INT_BLOCK_TRANSFER_COMPLETE))
+    .Times(1);
+  m_interrupt_controller.RaiseInterrupt(INT_SOURCE_DMA_2);
   EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
     .WillOnce(InvokeWithoutArgs(&m_simulator, &Simulator::Stop));
+  m_interrupt_controller.RaiseInterrupt(INT_SOURCE_SPI_2_TRANSMIT);
+
+  m_simulator.SetClockLimit(1000000, true);
+  m_simulator.Run();
+}
+
+TEST_F(SPITest, testDMAInput) {
+  NiceMock<MockPeripheralDMA> dma_mock;
+  PLIB_DMA_SetMock(&dma_mock);
+
+  m_config.use_dma = true;
+  SPI_Initialize(&m_config);
+
+  uint8_t input[] = {1, 2, 3};
+  EXPECT_TRUE(SPI_QueueTransfer(
+      SPI_ID_2, nullptr, 0, input, arraysize(input), &EventHandler));
+
+  EXPECT_CALL(dma_mock, ChannelXSourceStartAddressSet(_, _, _))
+    .Times(AnyNumber());
+  EXPECT_CALL(dma_mock, ChannelXSourceSizeSet(_, _, _)).Times(AnyNumber());
+  EXPECT_CALL(dma_mock, ChannelXDestinationStartAddressSet(_, _, _))
+    .Times(AnyNumber());
+  EXPECT_CALL(dma_mock, ChannelXDestinationSizeSet(_, _, _))
+    .Times(AnyNumber());
+
+  // The input buffer is zeroed & then used as the source of the 0s to send.
+  EXPECT_CALL(dma_mock,
+              ChannelXDestinationStartAddressSet(DMA_ID_0, DMA_CHANNEL_3,
+                                                 KVA_TO_PA(input)))
+    .Times(1);
+  EXPECT_CALL(dma_mock,
+              ChannelXDestinationSizeSet(DMA_ID_0, DMA_CHANNEL_3, 3))
+    .Times(1);
+  EXPECT_CALL(dma_mock,
+              ChannelXSourceStartAddressSet(DMA_ID_0, DMA_CHANNEL_2,
+                                            KVA_TO_PA(input)))
+    .Times(1);
+  EXPECT_CALL(dma_mock, ChannelXSourceSizeSet(DMA_ID_0, DMA_CHANNEL_2, 3))
+    .Times(1);
+
   EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
+  m_simulator.SetClockLimit(10, false);
+  m_simulator.Run();
+
+  // The transfer completes once the RX channel has stored the last byte.
+  m_interrupt_controller.RaiseInterrupt(INT_SOURCE_DMA_2);
   EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
     .WillOnce(InvokeWithoutArgs(&m_simulator, &Simulator::Stop));
+  m_interrupt_controller.RaiseInterrupt(INT_SOURCE_DMA_3);
 
+  m_simulator.SetClockLimit(1000000, true);
   m_simulator.Run();
 
-  EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), ElementsAreArray(output1));
+  const uint8_t zeros[] = {0, 0, 0};
+  EXPECT_THAT(ArrayTuple(input, arraysize(input)),
+              DataIs(zeros, arraysize(zeros)));
+}
+
+TEST_F(SPITest, testSimulatedDMAOutput) {
+  PLIB_DMA_SetMock(&m_dma);
+  m_config.use_dma = true;
+  SPI_Initialize(&m_config);
+
+  // larger than the enhanced buffer size.
+  uint8_t output[20];
+  for (unsigned int i = 0; i < arraysize(output); i++) {
+    output[i] = i;
+  }
+  EXPECT_TRUE(SPI_QueueTransfer(
+      SPI_ID_2, output, arraysize(output), nullptr, 0, &EventHandler));
+
+  EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
+  EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
+    .WillOnce(InvokeWithoutArgs(&m_simulator, &Simulator::Stop));
 
-  // Now continue.
   m_simulator.Run();
+  EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), ElementsAreArray(output));
+  EXPECT_EQ(arraysize(output), m_dma.CellCount(DMA_CHANNEL_2));
+  EXPECT_EQ(1u, m_dma.BlockCount(DMA_CHANNEL_2));
+  // One interrupt at the end of the block, and one once the last byte is
+  // sent.
+  EXPECT_EQ(1u, m_interrupt_controller.InterruptCount(INT_SOURCE_DMA_2));
+  EXPECT_EQ(1u,
+            m_interrupt_controller.InterruptCount(INT_SOURCE_SPI_2_TRANSMIT));
+  EXPECT_EQ(2u, m_interrupt_controller.TotalInterruptCount());
+}
 
-  const uint8_t expected[] = {1, 2, 3, 4, 5, 6};
-  EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), ElementsAreArray(expected));
+TEST_F(SPITest, testSimulatedDMALongOutput) {
+  PLIB_DMA_SetMock(&m_dma);
+  m_config.use_dma = true;
+  SPI_Initialize(&m_config);
+
+  // More than two DMA blocks.
+  vector<uint8_t> output(600);
+  for (unsigned int i = 0; i < output.size(); i++) {
+    output[i] = i;
+  }
+  EXPECT_TRUE(SPI_QueueTransfer(
+      SPI_ID_2, output.data(), output.size(), nullptr, 0, &EventHandler));
+
+  EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
+  EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
+    .WillOnce(InvokeWithoutArgs(&m_simulator, &Simulator::Stop));
+
+  m_simulator.Run();
+  EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), ElementsAreArray(output));
+  EXPECT_EQ(output.size(), m_dma.CellCount(DMA_CHANNEL_2));
+  EXPECT_EQ(3u, m_dma.BlockCount(DMA_CHANNEL_2));
+  EXPECT_EQ(3u, m_interrupt_controller.InterruptCount(INT_SOURCE_DMA_2));
+}
+
+TEST_F(SPITest, testSimulatedDMAInput) {
+  PLIB_DMA_SetMock(&m_dma);
+  m_config.use_dma = true;
+  SPI_Initialize(&m_config);
+
+  uint8_t data[20];
+  for (unsigned int i = 0; i < arraysize(data); i++) {
+    data[i] = 100 + i;
+  }
+  AddInputBytes(data, arraysize(data));
+
+  uint8_t input[arraysize(data)];
+  EXPECT_TRUE(SPI_QueueTransfer(
+      SPI_ID_2, nullptr, 0, input, arraysize(input), &EventHandler));
+
+  EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
+  EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
+    .WillOnce(InvokeWithoutArgs(&m_simulator, &Simulator::Stop));
+
+  m_simulator.Run();
+
+  EXPECT_THAT(ArrayTuple(input, arraysize(input)),
+              DataIs(data, arraysize(data)));
+  const uint8_t zeros[arraysize(data)] = {};
+  EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), ElementsAreArray(zeros));
+  EXPECT_EQ(1u, m_dma.BlockCount(DMA_CHANNEL_2));
+  EXPECT_EQ(1u, m_dma.BlockCount(DMA_CHANNEL_3));
+  // The SPI interrupt isn't used.
+  EXPECT_EQ(2u, m_interrupt_controller.TotalInterruptCount());
+}
+
+TEST_F(SPITest, testSimulatedDMALongInput) {
+  PLIB_DMA_SetMock(&m_dma);
+  m_config.use_dma = true;
+  SPI_Initialize(&m_config);
+
+  vector<uint8_t> data(600);
+  for (unsigned int i = 0; i < data.size(); i++) {
+    data[i] = i * 7;
+  }
+  AddInputBytes(data.data(), data.size());
+
+  vector<uint8_t> input(data.size());
+  EXPECT_TRUE(SPI_QueueTransfer(
+      SPI_ID_2, nullptr, 0, input.data(), input.size(), &EventHandler));
+
+  EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(1);
+  EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
+    .WillOnce(InvokeWithoutArgs(&m_simulator, &Simulator::Stop));
+
+  m_simulator.Run();
+
+  EXPECT_EQ(data, input);
+  EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), ElementsAreArray(vector<uint8_t>(
+      data.size(), 0)));
+  EXPECT_EQ(3u, m_dma.BlockCount(DMA_CHANNEL_2));
+  EXPECT_EQ(3u, m_dma.BlockCount(DMA_CHANNEL_3));
+}
+
+TEST_F(SPITest, testSimulatedDMAPixelFrame) {
+  PLIB_DMA_SetMock(&m_dma);
+  m_config.use_dma = true;
+  SPI_Initialize(&m_config);
+
+  SPIRGBConfiguration rgb_config;
+  rgb_config.module_id = SPI_ID_2;
+  SPIRGB_Init(&rgb_config);
+  SPIRGB_SetPixelType(PIXEL_TYPE_WS2801);
+  SPIRGB_SetPixelCount(SPIRGB_MAX_PIXELS);
+
+  // A full WS2801 frame is 510 bytes, which is two DMA blocks.
+  vector<uint8_t> frame;
+  SPIRGB_BeginUpdate();
+  for (unsigned int i = 0; i < SPIRGB_MAX_PIXELS; i++) {
+    const uint8_t red = i;
+    const uint8_t green = i + 85;
+    const uint8_t blue = i + 170;
+    SPIRGB_SetPixel(i, RED, red);
+    SPIRGB_SetPixel(i, GREEN, green);
+    SPIRGB_SetPixel(i, BLUE, blue);
+    frame.push_back(red);
+    frame.push_back(green);
+    frame.push_back(blue);
+  }
+  SPIRGB_CompleteUpdate();
+
+  std::unique_ptr<ola::Callback0<void>> rgb_task(
+      NewCallback(&SPIRGB_Tasks));
+  m_simulator.AddTask(rgb_task.get());
+  RunUntilSent(frame.size());
+  m_simulator.RemoveTask(rgb_task.get());
+
+  EXPECT_THAT(m_spi.SentBytes(SPI_ID_2), ElementsAreArray(frame));
+  EXPECT_EQ(frame.size(), m_dma.CellCount(DMA_CHANNEL_2));
+  EXPECT_EQ(2u, m_dma.BlockCount(DMA_CHANNEL_2));
+}
+
+TEST_F(SPITest, interruptCounts) {
+  uint8_t output[64];
+  for (unsigned int i = 0; i < arraysize(output); i++) {
+    output[i] = i;
+  }
+
+  EXPECT_CALL(m_event_handler, Run(SPI_BEGIN_TRANSFER)).Times(2);
+  EXPECT_CALL(m_event_handler, Run(SPI_COMPLETE_TRANSFER))
+    .Times(2)
+    .WillRepeatedly(InvokeWithoutArgs(&m_simulator, &Simulator::Stop));
+
+  // Interrupt driven.
+  EXPECT_TRUE(SPI_QueueTransfer(
+      SPI_ID_2, output, arraysize(output), nullptr, 0, &EventHandler));
+  m_simulator.Run();
+  unsigned int isr_count = m_interrupt_controller.InterruptCount(
+      INT_SOURCE_SPI_2_TRANSMIT);
+  EXPECT_LT(0u, isr_count);
+  RecordProperty("isr_count", isr_count);
+  EXPECT_EQ(1u, m_interrupt_controller.MaxNestingDepth());
+
+  // DMA
+  PLIB_DMA_SetMock(&m_dma);
+  m_config.use_dma = true;
+  SPI_Initialize(&m_config);
+  m_interrupt_controller.ResetCounters();
+
+  EXPECT_TRUE(SPI_QueueTransfer(
+      SPI_ID_2, output, arraysize(output), nullptr, 0, &EventHandler));
+  m_simulator.Run();
+  // One interrupt for the DMA block and one for the last byte.
+  EXPECT_EQ(2u, m_interrupt_controller.TotalInterruptCount());
+  EXPECT_GT(isr_count, m_interrupt_controller.TotalInterruptCount());
+  EXPECT_EQ(arraysize(output), m_dma.CellCount(DMA_CHANNEL_2));
 }
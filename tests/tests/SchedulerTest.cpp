@@ -0,0 +1,203 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * SchedulerTest.cpp
+ * Tests for the Scheduler code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include "scheduler.h"
+#include "CoreTimerMock.h"
+
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+namespace {
+
+// Each task advances the core timer by a different amount.
+uint32_t g_core_timer = 0u;
+unsigned int g_first_count = 0u;
+unsigned int g_second_count = 0u;
+
+void FirstTask() {
+  g_first_count++;
+  g_core_timer += 100u;
+}
+
+void SecondTask() {
+  g_second_count++;
+  g_core_timer += 300u;
+}
+
+void WakingTask() {
+  g_second_count++;
+  // Simulate an ISR waking the task while it's running.
+  Scheduler_Wake(WakingTask);
+}
+
+void UnregisteredTask() {}
+
+}  // namespace
+
+class SchedulerTest : public testing::Test {
+ public:
+  void SetUp() {
+    CoreTimer_SetMock(&m_core_timer);
+    ON_CALL(m_core_timer, GetCount()).WillByDefault(Invoke([]() {
+      return g_core_timer;
+    }));
+
+    g_core_timer = 0u;
+    g_first_count = 0u;
+    g_second_count = 0u;
+    Scheduler_Initialize();
+  }
+
+  void TearDown() {
+    CoreTimer_SetMock(nullptr);
+  }
+
+  NiceMock<MockCoreTimer> m_core_timer;
+};
+
+TEST_F(SchedulerTest, polledTask) {
+  EXPECT_TRUE(Scheduler_AddTask(FirstTask, SCHEDULER_POLLED));
+  Scheduler_Run();
+  Scheduler_Run();
+  Scheduler_Run();
+  EXPECT_EQ(3u, g_first_count);
+
+  Scheduler_SetEnabled(FirstTask, false);
+  Scheduler_Run();
+  EXPECT_EQ(3u, g_first_count);
+
+  Scheduler_SetEnabled(FirstTask, true);
+  Scheduler_Run();
+  EXPECT_EQ(4u, g_first_count);
+}
+
+TEST_F(SchedulerTest, wakeableTask) {
+  EXPECT_TRUE(Scheduler_AddTask(FirstTask, SCHEDULER_POLLED));
+  EXPECT_TRUE(Scheduler_AddTask(SecondTask, SCHEDULER_WAKEABLE));
+
+  // Wakeable tasks run once after being added.
+  Scheduler_Run();
+  Scheduler_Run();
+  EXPECT_EQ(2u, g_first_count);
+  EXPECT_EQ(1u, g_second_count);
+
+  // Multiple wakes are coalesced.
+  Scheduler_Wake(SecondTask);
+  Scheduler_Wake(SecondTask);
+  Scheduler_Run();
+  Scheduler_Run();
+  EXPECT_EQ(4u, g_first_count);
+  EXPECT_EQ(2u, g_second_count);
+
+  // A disabled task remembers it was woken.
+  Scheduler_SetEnabled(SecondTask, false);
+  Scheduler_Wake(SecondTask);
+  Scheduler_Run();
+  EXPECT_EQ(2u, g_second_count);
+  Scheduler_SetEnabled(SecondTask, true);
+  Scheduler_Run();
+  EXPECT_EQ(3u, g_second_count);
+
+  // Unknown tasks are ignored.
+  Scheduler_Wake(UnregisteredTask);
+  Scheduler_SetEnabled(UnregisteredTask, false);
+  Scheduler_Run();
+  EXPECT_EQ(3u, g_second_count);
+}
+
+TEST_F(SchedulerTest, wakeWhileRunning) {
+  EXPECT_TRUE(Scheduler_AddTask(WakingTask, SCHEDULER_WAKEABLE));
+  Scheduler_Run();
+  Scheduler_Run();
+  Scheduler_Run();
+  EXPECT_EQ(3u, g_second_count);
+}
+
+TEST_F(SchedulerTest, maxTasks) {
+  for (unsigned int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+    EXPECT_TRUE(Scheduler_AddTask(FirstTask, SCHEDULER_POLLED));
+  }
+  EXPECT_FALSE(Scheduler_AddTask(SecondTask, SCHEDULER_POLLED));
+
+  Scheduler_Initialize();
+  EXPECT_TRUE(Scheduler_AddTask(SecondTask, SCHEDULER_POLLED));
+}
+
+TEST_F(SchedulerTest, accounting) {
+  Scheduler_TaskStats stats;
+  EXPECT_FALSE(Scheduler_GetTaskStats(FirstTask, &stats));
+  EXPECT_EQ(0u, Scheduler_SampleLoad());
+
+  EXPECT_TRUE(Scheduler_AddTask(FirstTask, SCHEDULER_POLLED));
+  EXPECT_TRUE(Scheduler_AddTask(SecondTask, SCHEDULER_WAKEABLE));
+  Scheduler_ResetStats();
+
+  for (unsigned int i = 0; i < 10; i++) {
+    Scheduler_Run();
+    // Time spent outside of the tasks.
+    g_core_timer += 200u;
+  }
+  Scheduler_Run();
+
+  EXPECT_TRUE(Scheduler_GetTaskStats(FirstTask, &stats));
+  EXPECT_EQ(11u, stats.calls);
+  EXPECT_EQ(1100u, stats.cycles);
+  EXPECT_EQ(100u, stats.max_cycles);
+
+  EXPECT_TRUE(Scheduler_GetTaskStats(SecondTask, &stats));
+  EXPECT_EQ(1u, stats.calls);
+  EXPECT_EQ(300u, stats.cycles);
+  EXPECT_EQ(300u, stats.max_cycles);
+
+  // Only the wakeable task counts, 300 busy cycles out of 3400.
+  EXPECT_EQ(88u, Scheduler_SampleLoad());
+
+  Scheduler_ResetStats();
+  EXPECT_TRUE(Scheduler_GetTaskStats(FirstTask, &stats));
+  EXPECT_EQ(0u, stats.calls);
+  EXPECT_EQ(0u, stats.cycles);
+  EXPECT_EQ(0u, stats.max_cycles);
+  EXPECT_EQ(0u, Scheduler_SampleLoad());
+}
+
+TEST_F(SchedulerTest, loadWindow) {
+  EXPECT_TRUE(Scheduler_AddTask(FirstTask, SCHEDULER_POLLED));
+  EXPECT_TRUE(Scheduler_AddTask(SecondTask, SCHEDULER_WAKEABLE));
+  Scheduler_ResetStats();
+
+  // The wakeable task runs once after being added.
+  Scheduler_Run();
+  g_core_timer += 600u;
+  // 300 busy cycles out of 1000.
+  EXPECT_EQ(300u, Scheduler_SampleLoad());
+
+  // Each sample only covers the time since the last one.
+  Scheduler_Run();
+  g_core_timer += 900u;
+  EXPECT_EQ(0u, Scheduler_SampleLoad());
+
+  Scheduler_Wake(SecondTask);
+  Scheduler_Run();
+  // 300 busy cycles out of 400.
+  EXPECT_EQ(750u, Scheduler_SampleLoad());
+  EXPECT_EQ(0u, Scheduler_SampleLoad());
+}
@@ -0,0 +1,556 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * SimulatedDiscoveryTest.cpp
+ * Run RDM discovery against a simulated bus of responders.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "Array.h"
+#include "CoreTimerMock.h"
+#include "coarse_timer.h"
+#include "constants.h"
+#include "rdm.h"
+#include "setting_macros.h"
+#include "transceiver.h"
+
+#include "tests/sim/InterruptController.h"
+#include "tests/sim/PeripheralInputCapture.h"
+#include "tests/sim/PeripheralTimer.h"
+#include "tests/sim/PeripheralUART.h"
+#include "tests/sim/RDMBus.h"
+#include "tests/sim/SignalGenerator.h"
+#include "tests/sim/Simulator.h"
+
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ola::NewCallback;
+using std::set;
+using std::vector;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Declare the ISR symbols.
+void InputCaptureEvent(void);
+void Transceiver_TimerEvent();
+void Transceiver_UARTEvent();
+uint8_t Transceiver_FreeBufferCount();
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * @brief Performs binary search discovery, the way the host would.
+ *
+ * The agent keeps a stack of UID ranges. Each range is probed with a
+ * DISC_UNIQUE_BRANCH, if there is no response the range is discarded, if a
+ * single responder replies it's muted and the range is probed again, and if
+ * the responses collide the range is split in two.
+ */
+class DiscoveryAgent {
+ public:
+  struct Stats {
+    unsigned int dub_requests;
+    unsigned int mute_requests;
+    unsigned int unmute_requests;
+    unsigned int collisions;
+  };
+
+  DiscoveryAgent(Simulator *simulator, uint64_t controller_uid)
+      : m_simulator(simulator),
+        m_controller_uid(controller_uid),
+        m_state(IDLE),
+        m_in_flight(false),
+        m_have_result(false),
+        m_result(T_RESULT_OK),
+        m_transaction_number(0),
+        m_token(0),
+        m_mute_uid(0),
+        m_stats() {
+  }
+
+  // Start discovery. A full discovery un-mutes all responders first, an
+  // incremental discovery only finds responders that aren't muted.
+  void Start(bool full) {
+    m_found.clear();
+    m_ranges.clear();
+    m_ranges.push_back(Range(0, kMaxUID));
+    if (full) {
+      m_state = UNMUTE;
+      m_stats.unmute_requests++;
+      BuildRequest(RDMBus::kBroadcastUID, PID_DISC_UN_MUTE, nullptr, 0);
+    } else {
+      SendNextDUB();
+    }
+  }
+
+  bool Complete() const { return m_state == IDLE; }
+  const set<uint64_t>& Found() const { return m_found; }
+  const Stats& GetStats() const { return m_stats; }
+
+  bool HandleEvent(const TransceiverEvent *event) {
+    if (event->op == T_OP_MODE_CHANGE) {
+      m_simulator->Stop();
+      return true;
+    }
+    if (event->op != T_OP_RDM_DUB && event->op != T_OP_RDM_BROADCAST &&
+        event->op != T_OP_RDM_WITH_RESPONSE) {
+      return true;
+    }
+    m_in_flight = false;
+    m_have_result = true;
+    m_result = event->result;
+    m_data.assign(event->data, event->data + event->length);
+    return true;
+  }
+
+  void Tasks() {
+    if (m_have_result) {
+      m_have_result = false;
+      ProcessResult();
+    }
+    if (!m_request.empty() && !m_in_flight) {
+      bool ok;
+      if (m_state == DUB) {
+        ok = Transceiver_QueueRDMDUB(m_token, m_request.data(),
+                                     m_request.size());
+      } else {
+        ok = Transceiver_QueueRDMRequest(m_token, m_request.data(),
+                                         m_request.size(), m_state == UNMUTE);
+      }
+      if (ok) {
+        m_in_flight = true;
+        m_request.clear();
+      }
+    }
+  }
+
+  static const uint64_t kMaxUID = 0xfffffffffffeull;
+
+ private:
+  enum State {
+    IDLE,
+    UNMUTE,
+    DUB,
+    MUTE,
+  };
+
+  typedef std::pair<uint64_t, uint64_t> Range;
+
+  Simulator *m_simulator;
+  const uint64_t m_controller_uid;
+  State m_state;
+  bool m_in_flight;
+  bool m_have_result;
+  TransceiverOperationResult m_result;
+  vector<uint8_t> m_data;
+  vector<uint8_t> m_request;
+  uint8_t m_transaction_number;
+  int16_t m_token;
+  uint64_t m_mute_uid;
+  vector<Range> m_ranges;
+  set<uint64_t> m_found;
+  Stats m_stats;
+
+  void ProcessResult() {
+    switch (m_state) {
+      case UNMUTE:
+        SendNextDUB();
+        break;
+      case DUB:
+        if (m_result != T_RESULT_RX_DATA || m_data.empty()) {
+          m_ranges.pop_back();
+        } else if (DecodeDUBResponse(&m_mute_uid) &&
+                   m_mute_uid >= m_ranges.back().first &&
+                   m_mute_uid <= m_ranges.back().second) {
+          m_state = MUTE;
+          m_stats.mute_requests++;
+          BuildRequest(m_mute_uid, PID_DISC_MUTE, nullptr, 0);
+          return;
+        } else {
+          SplitRange();
+        }
+        SendNextDUB();
+        break;
+      case MUTE:
+        if (m_result == T_RESULT_RX_DATA && IsValidMuteResponse()) {
+          m_found.insert(m_mute_uid);
+        } else {
+          // The collision happened to decode to a valid UID.
+          SplitRange();
+        }
+        SendNextDUB();
+        break;
+      case IDLE:
+        break;
+    }
+  }
+
+  void SendNextDUB() {
+    if (m_ranges.empty()) {
+      m_state = IDLE;
+      m_simulator->Stop();
+      return;
+    }
+
+    uint8_t param_data[2 * UID_LENGTH];
+    PackUID(m_ranges.back().first, param_data);
+    PackUID(m_ranges.back().second, param_data + UID_LENGTH);
+    m_state = DUB;
+    m_stats.dub_requests++;
+    BuildRequest(RDMBus::kBroadcastUID, PID_DISC_UNIQUE_BRANCH, param_data,
+                 arraysize(param_data));
+  }
+
+  void SplitRange() {
+    m_stats.collisions++;
+    Range range = m_ranges.back();
+    m_ranges.pop_back();
+    if (range.first == range.second) {
+      return;
+    }
+    uint64_t mid = range.first + (range.second - range.first) / 2;
+    m_ranges.push_back(Range(mid + 1, range.second));
+    m_ranges.push_back(Range(range.first, mid));
+  }
+
+  // The request excludes the start code, but the checksum includes it.
+  void BuildRequest(uint64_t destination, uint16_t pid,
+                    const uint8_t *param_data, uint8_t param_data_length) {
+    m_request.assign(RDM_PARAM_DATA_OFFSET - 1, 0);
+    m_request[0] = SUB_START_CODE;
+    m_request[1] = RDM_PARAM_DATA_OFFSET + param_data_length;
+    PackUID(destination, &m_request[2]);
+    PackUID(m_controller_uid, &m_request[8]);
+    m_request[14] = m_transaction_number++;
+    m_request[15] = 1;  // port ID
+    m_request[19] = DISCOVERY_COMMAND;
+    m_request[20] = pid >> 8;
+    m_request[21] = pid & 0xff;
+    m_request[22] = param_data_length;
+    m_request.insert(m_request.end(), param_data,
+                     param_data + param_data_length);
+
+    uint16_t checksum = RDM_START_CODE;
+    for (uint8_t byte : m_request) {
+      checksum += byte;
+    }
+    m_request.push_back(checksum >> 8);
+    m_request.push_back(checksum & 0xff);
+    m_token++;
+  }
+
+  bool DecodeDUBResponse(uint64_t *uid) const {
+    unsigned int offset = 0;
+    while (offset < m_data.size() && offset < 7 && m_data[offset] == 0xfe) {
+      offset++;
+    }
+    if (offset == m_data.size() || m_data[offset] != 0xaa ||
+        m_data.size() < offset + 17) {
+      return false;
+    }
+    const uint8_t *euid = &m_data[offset + 1];
+    uint16_t checksum = 0;
+    *uid = 0;
+    for (unsigned int i = 0; i < 2 * UID_LENGTH; i += 2) {
+      checksum += euid[i] + euid[i + 1];
+      *uid = (*uid << 8) + (euid[i] & euid[i + 1]);
+    }
+    uint16_t expected_checksum = ((euid[12] & euid[13]) << 8) +
+                                 (euid[14] & euid[15]);
+    return checksum == expected_checksum;
+  }
+
+  bool IsValidMuteResponse() const {
+    if (m_data.size() < RDM_PARAM_DATA_OFFSET + RDM_CHECKSUM_LENGTH ||
+        m_data[0] != RDM_START_CODE) {
+      return false;
+    }
+    unsigned int length = m_data[MESSAGE_LENGTH_OFFSET];
+    if (m_data.size() != length + RDM_CHECKSUM_LENGTH) {
+      return false;
+    }
+    uint16_t checksum = 0;
+    for (unsigned int i = 0; i < length; i++) {
+      checksum += m_data[i];
+    }
+    return m_data[20] == DISCOVERY_COMMAND_RESPONSE &&
+           checksum == (m_data[length] << 8) + m_data[length + 1];
+  }
+
+  static void PackUID(uint64_t uid, uint8_t *data) {
+    for (int i = UID_LENGTH - 1; i >= 0; i--) {
+      data[i] = uid & 0xff;
+      uid >>= 8;
+    }
+  }
+};
+
+const uint64_t DiscoveryAgent::kMaxUID;
+
+DiscoveryAgent *g_agent = nullptr;
+
+bool EventHandler(const TransceiverEvent *event) {
+  return g_agent ? g_agent->HandleEvent(event) : true;
+}
+
+class DiscoveryTest : public testing::Test {
+ public:
+  DiscoveryTest()
+      : m_tx_callback(NewCallback(this, &DiscoveryTest::GotByte)),
+        m_callback(NewCallback(&Transceiver_Tasks)),
+        m_agent_callback(NewCallback(this, &DiscoveryTest::AgentTasks)),
+        m_simulator(kClockSpeed),
+        m_timer(&m_simulator, &m_interrupt_controller),
+        m_ic(&m_simulator, &m_interrupt_controller),
+        m_uart(&m_simulator, &m_interrupt_controller, m_tx_callback.get()),
+        m_generator(&m_simulator, &m_ic, &m_uart, AS_IC_ID(2),
+                    AS_USART_ID(1), kClockSpeed, kBaudRate),
+        m_bus(&m_simulator, &m_generator, kClockSpeed, kBaudRate),
+        m_agent(&m_simulator, kControllerUID) {
+  }
+
+  void GotByte(USART_MODULE_ID uart_id, uint8_t byte) {
+    if (uart_id == AS_USART_ID(1)) {
+      m_bus.ReceiveByte(byte);
+    }
+  }
+
+  void AgentTasks() {
+    m_agent.Tasks();
+  }
+
+  void SetUp() {
+    g_agent = &m_agent;
+    PLIB_TMR_SetMock(&m_timer);
+    PLIB_IC_SetMock(&m_ic);
+    PLIB_USART_SetMock(&m_uart);
+    SYS_INT_SetMock(&m_interrupt_controller);
+
+    // The core timer runs at half the system clock.
+    CoreTimer_SetMock(&m_core_timer);
+    ON_CALL(m_core_timer, GetCount()).WillByDefault(Invoke([this]() {
+      return static_cast<uint32_t>(m_simulator.Clock() / 2);
+    }));
+    m_interrupt_controller.RegisterISR(INT_SOURCE_TIMER_3,
+        NewCallback(&Transceiver_TimerEvent));
+    m_interrupt_controller.RegisterISR(INT_SOURCE_INPUT_CAPTURE_2,
+        NewCallback(&InputCaptureEvent));
+    m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_ERROR,
+        NewCallback(&Transceiver_UARTEvent));
+    m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_TRANSMIT,
+        NewCallback(&Transceiver_UARTEvent));
+    m_interrupt_controller.RegisterISR(INT_SOURCE_USART_1_RECEIVE,
+        NewCallback(&Transceiver_UARTEvent));
+
+    m_simulator.AddTask(m_callback.get());
+    m_simulator.AddTask(m_agent_callback.get());
+    // Discovery only relies on the coarse timer, so there's no need to run
+    // the tasks every micro-second.
+    m_simulator.SetTaskInterval(100);
+
+    TransceiverHardwareSettings settings = {
+      .usart = AS_USART_ID(1),
+      .usart_vector = AS_USART_INTERRUPT_VECTOR(1),
+      .usart_tx_source = AS_USART_INTERRUPT_TX_SOURCE(1),
+      .usart_rx_source = AS_USART_INTERRUPT_RX_SOURCE(1),
+      .usart_error_source = AS_USART_INTERRUPT_ERROR_SOURCE(1),
+      .port = PORT_CHANNEL_F,
+      .break_bit = PORTS_BIT_POS_8,
+      .tx_enable_bit = PORTS_BIT_POS_1,
+      .rx_enable_bit = PORTS_BIT_POS_0,
+      .input_capture_module = AS_IC_ID(2),
+      .input_capture_vector = AS_IC_INTERRUPT_VECTOR(2),
+      .input_capture_source = AS_IC_INTERRUPT_SOURCE(2),
+      .timer_module_id = AS_TIMER_ID(3),
+      .timer_vector = AS_TIMER_INTERRUPT_VECTOR(3),
+      .timer_source = AS_TIMER_INTERRUPT_SOURCE(3),
+      .input_capture_timer = AS_IC_TMR_ID(3),
+    };
+    Transceiver_Initialize(&settings, &EventHandler, &EventHandler);
+
+    CoarseTimer_Settings timer_settings = {
+      .interrupt_source = INT_SOURCE_TIMER_CORE
+    };
+    CoarseTimer_Initialize(&timer_settings);
+
+    ASSERT_TRUE(Transceiver_SetMode(T_MODE_CONTROLLER, 0));
+    m_simulator.SetClockLimit(1000000, true);
+    m_simulator.Run();
+    ASSERT_EQ(T_MODE_CONTROLLER, Transceiver_GetMode());
+  }
+
+  void TearDown() {
+    g_agent = nullptr;
+    PLIB_TMR_SetMock(nullptr);
+    PLIB_IC_SetMock(nullptr);
+    PLIB_USART_SetMock(nullptr);
+    SYS_INT_SetMock(nullptr);
+    CoreTimer_SetMock(nullptr);
+
+    m_simulator.RemoveTask(m_callback.get());
+    m_simulator.RemoveTask(m_agent_callback.get());
+  }
+
+  /*
+   * @brief Run discovery to completion.
+   * @returns The duration of discovery in micro-seconds of line time.
+   */
+  uint64_t RunDiscovery(bool full, uint64_t limit) {
+    uint64_t start = m_simulator.Clock();
+    m_agent.Start(full);
+    m_simulator.SetClockLimit(limit, true);
+    m_simulator.Run();
+    EXPECT_TRUE(m_agent.Complete());
+    return (m_simulator.Clock() - start) / (kClockSpeed / 1000000);
+  }
+
+ protected:
+  std::unique_ptr<PeripheralUART::TXCallback> m_tx_callback;
+  std::unique_ptr<ola::Callback0<void>> m_callback;
+  std::unique_ptr<ola::Callback0<void>> m_agent_callback;
+
+  Simulator m_simulator;
+  InterruptController m_interrupt_controller;
+  NiceMock<MockCoreTimer> m_core_timer;
+  PeripheralTimer m_timer;
+  PeripheralInputCapture m_ic;
+  PeripheralUART m_uart;
+  SignalGenerator m_generator;
+  RDMBus m_bus;
+  DiscoveryAgent m_agent;
+
+  static const uint32_t kClockSpeed = 80000000;
+  static const uint32_t kBaudRate = 250000;
+  static const uint64_t kControllerUID = 0x7a7000000000ull;
+};
+
+const uint64_t DiscoveryTest::kControllerUID;
+
+TEST_F(DiscoveryTest, noResponders) {
+  RunDiscovery(true, 100000);
+
+  EXPECT_THAT(m_agent.Found(), ::testing::IsEmpty());
+  EXPECT_EQ(1u, m_agent.GetStats().dub_requests);
+  EXPECT_EQ(1u, m_bus.GetStats().dub_requests);
+  EXPECT_EQ(0u, m_bus.GetStats().dub_responses);
+}
+
+TEST_F(DiscoveryTest, collision) {
+  const uint64_t uid1 = 0x7a7000000001ull;
+  const uint64_t uid2 = 0x7a7000000002ull;
+  m_bus.AddResponder(uid1);
+  m_bus.AddResponder(uid2);
+
+  RunDiscovery(true, 2000000);
+
+  EXPECT_THAT(m_agent.Found(), ::testing::ElementsAre(uid1, uid2));
+  EXPECT_TRUE(m_bus.IsMuted(uid1));
+  EXPECT_TRUE(m_bus.IsMuted(uid2));
+  EXPECT_LE(1u, m_bus.GetStats().collisions);
+  EXPECT_EQ(0u, m_bus.GetStats().checksum_errors);
+  // Collisions can decode to a UID that doesn't exist, the mute for these
+  // goes unanswered.
+  EXPECT_EQ(m_agent.GetStats().mute_requests,
+            m_bus.GetStats().mute_requests);
+}
+
+TEST_F(DiscoveryTest, mixedTurnaround) {
+  // Responders with different turnaround times overlap by different amounts.
+  const uint64_t uid1 = 0x7a7000000001ull;
+  const uint64_t uid2 = 0x7a7000000002ull;
+  const uint64_t uid3 = 0x7a7000000003ull;
+  m_bus.AddResponder(uid1, 176);
+  m_bus.AddResponder(uid2, 500);
+  m_bus.AddResponder(uid3, 1500);
+
+  RunDiscovery(true, 2000000);
+
+  EXPECT_THAT(m_agent.Found(), ::testing::ElementsAre(uid1, uid2, uid3));
+  EXPECT_LE(1u, m_bus.GetStats().collisions);
+}
+
+TEST_F(DiscoveryTest, mutedRespondersStayQuiet) {
+  const uint64_t uid1 = 0x7a7000000001ull;
+  const uint64_t uid2 = 0x4a5000001234ull;
+  m_bus.AddResponder(uid1);
+  RunDiscovery(true, 1000000);
+  EXPECT_THAT(m_agent.Found(), ::testing::ElementsAre(uid1));
+
+  // A new device is attached, an incremental discovery should only find the
+  // new device.
+  m_bus.AddResponder(uid2);
+  m_bus.ResetStats();
+  RunDiscovery(false, 1000000);
+  EXPECT_THAT(m_agent.Found(), ::testing::ElementsAre(uid2));
+  EXPECT_EQ(0u, m_bus.GetStats().collisions);
+  EXPECT_EQ(0u, m_bus.GetStats().unmute_requests);
+
+  // A full discovery finds both.
+  RunDiscovery(true, 1000000);
+  EXPECT_THAT(m_agent.Found(), ::testing::ElementsAre(uid2, uid1));
+}
+
+/*
+ * Benchmark discovery with increasing numbers of responders. The line time &
+ * transaction counts are recorded as test properties.
+ */
+class DiscoveryBenchmark : public DiscoveryTest,
+                           public ::testing::WithParamInterface<unsigned int> {
+};
+
+TEST_P(DiscoveryBenchmark, discover) {
+  const unsigned int device_count = GetParam();
+
+  // Random UIDs from a handful of manufacturers.
+  std::mt19937_64 rng(device_count);
+  set<uint64_t> uids;
+  while (uids.size() < device_count) {
+    uint64_t uid = ((0x7a70ull + rng() % 4) << 32) + (rng() & 0xfffffffe);
+    if (uids.insert(uid).second) {
+      m_bus.AddResponder(uid);
+    }
+  }
+
+  // Allow 100ms per device.
+  uint64_t line_time = RunDiscovery(true, 1000000 + device_count * 100000);
+
+  EXPECT_EQ(uids, m_agent.Found());
+  for (uint64_t uid : uids) {
+    EXPECT_TRUE(m_bus.IsMuted(uid));
+  }
+  EXPECT_EQ(0u, m_bus.GetStats().checksum_errors);
+
+  const DiscoveryAgent::Stats &stats = m_agent.GetStats();
+  RecordProperty("devices", device_count);
+  RecordProperty("line_time_us", line_time);
+  RecordProperty("dub_requests", stats.dub_requests);
+  RecordProperty("mute_requests", stats.mute_requests);
+  RecordProperty("collisions", m_bus.GetStats().collisions);
+}
+
+INSTANTIATE_TEST_CASE_P(DeviceCounts, DiscoveryBenchmark,
+                        ::testing::Values(1, 10, 100, 1000));
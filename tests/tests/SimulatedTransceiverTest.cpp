@@ -28,9 +28,11 @@
 #include <vector>
 
 #include "Array.h"
+#include "CoreTimerMock.h"
 #include "coarse_timer.h"
 #include "constants.h"
 #include "dmx_spec.h"
+#include "metrics.h"
 #include "setting_macros.h"
 #include "transceiver.h"
 
@@ -49,10 +51,12 @@ using ::testing::ElementsAreArray;
 using ::testing::Ge;
 using ::testing::Gt;
 using ::testing::InSequence;
+using ::testing::Invoke;
 using ::testing::InvokeWithoutArgs;
 using ::testing::IsEmpty;
 using ::testing::Le;
 using ::testing::Lt;
+using ::testing::NiceMock;
 using ::testing::Return;
 using ::testing::SizeIs;
 using ::testing::StrictMock;
@@ -208,8 +212,11 @@ class TransceiverTest : public testing::Test {
     PLIB_USART_SetMock(&m_uart);
     SYS_INT_SetMock(&m_interrupt_controller);
 
-    m_interrupt_controller.RegisterISR(INT_SOURCE_TIMER_1,
-        NewCallback(&CoarseTimer_TimerEvent));
+    // The core timer runs at half the system clock.
+    CoreTimer_SetMock(&m_core_timer);
+    ON_CALL(m_core_timer, GetCount()).WillByDefault(Invoke([this]() {
+      return static_cast<uint32_t>(m_simulator.Clock() / 2);
+    }));
     m_interrupt_controller.RegisterISR(INT_SOURCE_TIMER_3,
         NewCallback(&Transceiver_TimerEvent));
     m_interrupt_controller.RegisterISR(INT_SOURCE_INPUT_CAPTURE_2,
@@ -223,12 +230,12 @@ class TransceiverTest : public testing::Test {
 
     m_simulator.AddTask(m_callback.get());
 
+    Metrics_Initialize();
     TransceiverHardwareSettings settings = DefaultSettings();
     Transceiver_Initialize(&settings, &EventHandler, &EventHandler);
 
     CoarseTimer_Settings timer_settings = {
-      .timer_id = AS_TIMER_ID(1),
-      .interrupt_source = AS_TIMER_INTERRUPT_SOURCE(1)
+      .interrupt_source = INT_SOURCE_TIMER_CORE
     };
     CoarseTimer_Initialize(&timer_settings);
   }
@@ -252,6 +259,7 @@ class TransceiverTest : public testing::Test {
     PLIB_IC_SetMock(nullptr);
     PLIB_USART_SetMock(nullptr);
     SYS_INT_SetMock(nullptr);
+    CoreTimer_SetMock(nullptr);
 
     m_simulator.RemoveTask(m_callback.get());
   }
@@ -288,6 +296,7 @@ class TransceiverTest : public testing::Test {
 
   Simulator m_simulator;
   InterruptController m_interrupt_controller;
+  NiceMock<MockCoreTimer> m_core_timer;
   PeripheralTimer m_timer;
   PeripheralInputCapture m_ic;
   PeripheralUART m_uart;
@@ -375,6 +384,8 @@ TEST_F(TransceiverTest, controllerTxDMX) {
   m_simulator.Run();
   EXPECT_THAT(m_tx_bytes,
               MatchesFrameWithSC(NULL_START_CODE, kDMX1, arraysize(kDMX1)));
+  EXPECT_EQ(1u, Metrics_Get(METRIC_TX_FRAMES));
+  EXPECT_EQ(0u, Metrics_Get(METRIC_RDM_RESPONSES_SENT));
 }
 
 TEST_F(TransceiverTest, controllerTxEmptyDMX) {
@@ -878,7 +889,7 @@ TEST_F(TransceiverTest, responderRxShortMark) {
   EXPECT_THAT(rx_data, ElementsAreArray(kDMX2, arraysize(kDMX2)));
 }
 
-// Interslot delay, this test can take a while to run.
+// Interslot delay, this simulates more than 3s of runtime.
 TEST_F(TransceiverTest, responderRxInterSlotDelay) {
   vector<uint8_t> rx_data;
 
@@ -895,6 +906,9 @@ TEST_F(TransceiverTest, responderRxInterSlotDelay) {
 
   // we need more than 1s of runtime
   m_simulator.SetClockLimit(3000000, true);
+  // The frame timeout is checked with the coarse timer, which has a 100us
+  // resolution, so there is no need to run the tasks more often than that.
+  m_simulator.SetTaskInterval(100);
   m_generator.SetStopOnComplete(true);
   m_generator.AddDelay(100);
   m_generator.AddBreak(176);
@@ -1127,6 +1141,8 @@ TEST_F(TransceiverTest, responderRDMRequest) {
   m_simulator.Run();
 
   EXPECT_THAT(m_tx_bytes, MatchesFrame(kRDMResponse, arraysize(kRDMResponse)));
+  EXPECT_EQ(0u, Metrics_Get(METRIC_TX_FRAMES));
+  EXPECT_EQ(1u, Metrics_Get(METRIC_RDM_RESPONSES_SENT));
 }
 
 TEST_F(TransceiverTest, responderRDMDUB) {
@@ -0,0 +1,172 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * TimerWheelTest.cpp
+ * Tests for the TimerWheel code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include "coarse_timer.h"
+#include "sys_int_mock.h"
+#include "timer_wheel.h"
+
+namespace {
+
+unsigned int g_first_count = 0u;
+unsigned int g_second_count = 0u;
+TimerWheel_Timer g_first_timer;
+TimerWheel_Timer g_second_timer;
+
+void FirstCallback() {
+  g_first_count++;
+}
+
+void SecondCallback() {
+  g_second_count++;
+}
+
+void CancelSecond() {
+  g_first_count++;
+  TimerWheel_Cancel(&g_second_timer);
+}
+
+}  // namespace
+
+class TimerWheelTest : public ::testing::TestWithParam<uint32_t> {
+ public:
+  void SetUp() {
+    SYS_INT_SetMock(&m_sys_int_mock);
+    CoarseTimer_Settings timer_settings = {
+      .interrupt_source = INT_SOURCE_TIMER_CORE
+    };
+    CoarseTimer_Initialize(&timer_settings);
+    m_now = GetParam();
+    CoarseTimer_SetCounter(m_now);
+    TimerWheel_Initialize();
+
+    g_first_count = 0u;
+    g_second_count = 0u;
+  }
+
+  void TearDown() {
+    SYS_INT_SetMock(NULL);
+  }
+
+  /*
+   * @brief Advance the time, running the tasks every 0.1ms.
+   */
+  void RunFor(unsigned int ticks) {
+    for (unsigned int i = 0; i < ticks; i++) {
+      m_now++;
+      CoarseTimer_SetCounter(m_now);
+      TimerWheel_Tasks();
+    }
+  }
+
+  testing::NiceMock<MockSysInt> m_sys_int_mock;
+  uint32_t m_now;
+};
+
+TEST_P(TimerWheelTest, oneShot) {
+  TimerWheel_Schedule(&g_first_timer, 50u, FirstCallback);
+  EXPECT_TRUE(TimerWheel_IsScheduled(&g_first_timer));
+
+  // Like CoarseTimer_HasElapsed(), more than 5ms must pass.
+  RunFor(50u);
+  EXPECT_EQ(0u, g_first_count);
+
+  // Within 1ms.
+  RunFor(10u);
+  EXPECT_EQ(1u, g_first_count);
+  EXPECT_FALSE(TimerWheel_IsScheduled(&g_first_timer));
+
+  RunFor(1000u);
+  EXPECT_EQ(1u, g_first_count);
+}
+
+TEST_P(TimerWheelTest, longDelay) {
+  // Longer than one revolution of the wheel.
+  TimerWheel_Schedule(&g_first_timer, 10000u, FirstCallback);
+  RunFor(10000u);
+  EXPECT_EQ(0u, g_first_count);
+  RunFor(10u);
+  EXPECT_EQ(1u, g_first_count);
+}
+
+TEST_P(TimerWheelTest, periodic) {
+  TimerWheel_SchedulePeriodic(&g_first_timer, 100u, FirstCallback);
+  TimerWheel_SchedulePeriodic(&g_second_timer, 3000u, SecondCallback);
+
+  RunFor(10000u);
+  EXPECT_EQ(99u, g_first_count);
+  EXPECT_EQ(3u, g_second_count);
+  RunFor(10u);
+  EXPECT_EQ(100u, g_first_count);
+  EXPECT_TRUE(TimerWheel_IsScheduled(&g_first_timer));
+
+  TimerWheel_Cancel(&g_first_timer);
+  EXPECT_FALSE(TimerWheel_IsScheduled(&g_first_timer));
+  RunFor(1000u);
+  EXPECT_EQ(100u, g_first_count);
+
+  // Cancelling twice is fine.
+  TimerWheel_Cancel(&g_first_timer);
+  TimerWheel_Cancel(&g_second_timer);
+}
+
+TEST_P(TimerWheelTest, catchUp) {
+  TimerWheel_SchedulePeriodic(&g_first_timer, 100u, FirstCallback);
+
+  // The main loop stalls for 1s, then the missed periods are run.
+  m_now += 10000u;
+  CoarseTimer_SetCounter(m_now);
+  TimerWheel_Tasks();
+  EXPECT_EQ(1u, g_first_count);
+
+  // The next period is measured from the end of the stall.
+  RunFor(99u);
+  EXPECT_EQ(1u, g_first_count);
+  RunFor(1u);
+  EXPECT_EQ(2u, g_first_count);
+}
+
+TEST_P(TimerWheelTest, reschedule) {
+  TimerWheel_Schedule(&g_first_timer, 50u, FirstCallback);
+  RunFor(40u);
+  TimerWheel_Schedule(&g_first_timer, 50u, FirstCallback);
+  RunFor(40u);
+  EXPECT_EQ(0u, g_first_count);
+  RunFor(20u);
+  EXPECT_EQ(1u, g_first_count);
+}
+
+TEST_P(TimerWheelTest, cancelFromCallback) {
+  // Both timers expire in the same slot.
+  TimerWheel_Schedule(&g_second_timer, 50u, SecondCallback);
+  TimerWheel_Schedule(&g_first_timer, 50u, CancelSecond);
+  RunFor(100u);
+  EXPECT_EQ(1u, g_first_count + g_second_count);
+
+  // Re-initializing cancels all timers.
+  TimerWheel_Schedule(&g_first_timer, 50u, FirstCallback);
+  TimerWheel_Initialize();
+  EXPECT_FALSE(TimerWheel_IsScheduled(&g_first_timer));
+}
+
+INSTANTIATE_TEST_CASE_P(InstantiationName,
+                        TimerWheelTest,
+                        ::testing::Values(0, 12345, 0xffffff00));
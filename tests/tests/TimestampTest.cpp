@@ -0,0 +1,97 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * TimestampTest.cpp
+ * Tests for the Timestamp code.
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include "timestamp.h"
+#include "CoreTimerMock.h"
+
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+class TimestampTest : public ::testing::TestWithParam<uint32_t> {
+ public:
+  void SetUp() {
+    CoreTimer_SetMock(&m_core_timer_mock);
+    ON_CALL(m_core_timer_mock, GetCount()).WillByDefault(Invoke([this]() {
+      return m_core_timer;
+    }));
+    m_core_timer = GetParam();
+    Timestamp_Initialize();
+  }
+
+  void TearDown() {
+    CoreTimer_SetMock(NULL);
+  }
+
+  NiceMock<MockCoreTimer> m_core_timer_mock;
+  uint32_t m_core_timer = 0u;
+};
+
+TEST_P(TimestampTest, matchesCoreTimer) {
+  Timestamp start = Timestamp_Now();
+  EXPECT_EQ(GetParam(), static_cast<uint32_t>(start));
+
+  m_core_timer += 40u;
+  EXPECT_EQ(40u, Timestamp_Now() - start);
+  EXPECT_EQ(m_core_timer, static_cast<uint32_t>(Timestamp_Now()));
+}
+
+TEST_P(TimestampTest, neverWraps) {
+  const Timestamp start = Timestamp_Now();
+
+  // Run for 10 minutes, updating every 2^30 ticks like the core timer ISR.
+  const uint32_t kUpdateInterval = 1u << 30;
+  Timestamp last = start;
+  for (unsigned int i = 0; i < 23u; i++) {
+    m_core_timer += kUpdateInterval / 2u;
+    Timestamp now = Timestamp_Now();
+    EXPECT_EQ(kUpdateInterval / 2u, now - last);
+    last = now;
+
+    m_core_timer += kUpdateInterval / 2u;
+    Timestamp_Update();
+    now = Timestamp_Now();
+    EXPECT_EQ(kUpdateInterval / 2u, now - last);
+    last = now;
+  }
+  EXPECT_EQ(23ull * kUpdateInterval, Timestamp_Now() - start);
+  EXPECT_EQ(617u, Timestamp_ToMicroSeconds(Timestamp_Now() - start) /
+                  1000000u);
+}
+
+INSTANTIATE_TEST_CASE_P(CoreTimerValues, TimestampTest,
+                        ::testing::Values(0u, 0x80000000u, 0xfffffff0u));
+
+TEST(TimestampConversionTest, conversions) {
+  EXPECT_EQ(40u, TIMESTAMP_TICKS_PER_MICROSECOND);
+
+  EXPECT_EQ(0u, Timestamp_ToMicroSeconds(39u));
+  EXPECT_EQ(1u, Timestamp_ToMicroSeconds(40u));
+  EXPECT_EQ(1000u, Timestamp_ToMicroSeconds(40000u));
+  EXPECT_EQ(0u, Timestamp_ToTenthsOfMicroSeconds(3u));
+  EXPECT_EQ(1u, Timestamp_ToTenthsOfMicroSeconds(4u));
+  EXPECT_EQ(1760u, Timestamp_ToTenthsOfMicroSeconds(7040u));
+
+  EXPECT_EQ(40u, Timestamp_FromMicroSeconds(1u));
+  EXPECT_EQ(4000000000ull, Timestamp_FromMicroSeconds(100000000u));
+  EXPECT_EQ(4u, Timestamp_FromTenthsOfMicroSeconds(1u));
+  EXPECT_EQ(7040u, Timestamp_FromTenthsOfMicroSeconds(1760u));
+}
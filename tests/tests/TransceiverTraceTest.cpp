@@ -0,0 +1,156 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ * TransceiverTraceTest.cpp
+ * Copyright (C) 2015 Simon Newton
+ */
+
+#include <gtest/gtest.h>
+
+#include "transceiver_trace.h"
+#include "CoreTimerMock.h"
+
+using ::testing::Invoke;
+using ::testing::NiceMock;
+
+class TransceiverTraceTest : public testing::Test {
+ public:
+  void SetUp() {
+    CoreTimer_SetMock(&m_core_timer_mock);
+    ON_CALL(m_core_timer_mock, GetCount()).WillByDefault(Invoke([this]() {
+      return m_core_timer;
+    }));
+    TransceiverTrace_Initialize();
+  }
+
+  void TearDown() {
+    CoreTimer_SetMock(NULL);
+  }
+
+  // Record n events, with data_index set to first, first + 1, ...
+  void Record(unsigned int first, unsigned int n) {
+    for (unsigned int i = first; i < first + n; i++) {
+      m_core_timer += 10u;
+      TransceiverTrace_Record(2u, 0u, 1, i);
+    }
+  }
+
+  NiceMock<MockCoreTimer> m_core_timer_mock;
+  uint32_t m_core_timer = 100u;
+};
+
+TEST_F(TransceiverTraceTest, empty) {
+  const TransceiverTraceEvent *events;
+  uint32_t dropped = 99u;
+  EXPECT_EQ(0u, TransceiverTrace_Peek(&events, &dropped));
+  EXPECT_EQ(0u, dropped);
+}
+
+TEST_F(TransceiverTraceTest, recordAndRead) {
+  TransceiverTrace_Record(2u, 3u, 4, 5u);
+  m_core_timer += 40u;
+  TransceiverTrace_Record(6u, TRANSCEIVER_TRACE_NO_OP, -1, 0u);
+
+  const TransceiverTraceEvent *events;
+  uint32_t dropped;
+  ASSERT_EQ(2u, TransceiverTrace_Peek(&events, &dropped));
+  EXPECT_EQ(0u, dropped);
+
+  EXPECT_EQ(100u, events[0].time);
+  EXPECT_EQ(2u, events[0].state);
+  EXPECT_EQ(3u, events[0].op);
+  EXPECT_EQ(4, events[0].token);
+  EXPECT_EQ(5u, events[0].data_index);
+
+  EXPECT_EQ(140u, events[1].time);
+  EXPECT_EQ(6u, events[1].state);
+  EXPECT_EQ(TRANSCEIVER_TRACE_NO_OP, events[1].op);
+  EXPECT_EQ(-1, events[1].token);
+
+  TransceiverTrace_Consume(1u);
+  ASSERT_EQ(1u, TransceiverTrace_Peek(&events, &dropped));
+  EXPECT_EQ(6u, events[0].state);
+
+  TransceiverTrace_Consume(1u);
+  EXPECT_EQ(0u, TransceiverTrace_Peek(&events, &dropped));
+}
+
+TEST_F(TransceiverTraceTest, recordFromISR) {
+  // Simulate an ISR recording an event while the main loop is recording one.
+  bool in_isr = false;
+  EXPECT_CALL(m_core_timer_mock, GetCount())
+    .WillRepeatedly(Invoke([this, &in_isr]() {
+      if (!in_isr) {
+        in_isr = true;
+        m_core_timer += 10u;
+        TransceiverTrace_Record(7u, 8u, 9, 10u);
+        m_core_timer -= 10u;
+      }
+      return m_core_timer;
+    }));
+  TransceiverTrace_Record(2u, 3u, 4, 5u);
+
+  const TransceiverTraceEvent *events;
+  uint32_t dropped;
+  ASSERT_EQ(2u, TransceiverTrace_Peek(&events, &dropped));
+  EXPECT_EQ(0u, dropped);
+
+  EXPECT_EQ(100u, events[0].time);
+  EXPECT_EQ(2u, events[0].state);
+  EXPECT_EQ(5u, events[0].data_index);
+
+  EXPECT_EQ(110u, events[1].time);
+  EXPECT_EQ(7u, events[1].state);
+  EXPECT_EQ(10u, events[1].data_index);
+}
+
+TEST_F(TransceiverTraceTest, wrap) {
+  const TransceiverTraceEvent *events;
+  uint32_t dropped;
+
+  // Read 100 events, leaving the read position near the end of the buffer.
+  Record(0u, 100u);
+  ASSERT_EQ(100u, TransceiverTrace_Peek(&events, &dropped));
+  TransceiverTrace_Consume(100u);
+
+  // The unread events wrap, so they're returned in two parts.
+  Record(100u, 50u);
+  ASSERT_EQ(TRANSCEIVER_TRACE_SIZE - 100u,
+            TransceiverTrace_Peek(&events, &dropped));
+  EXPECT_EQ(100u, events[0].data_index);
+  TransceiverTrace_Consume(TRANSCEIVER_TRACE_SIZE - 100u);
+
+  ASSERT_EQ(150u - TRANSCEIVER_TRACE_SIZE,
+            TransceiverTrace_Peek(&events, &dropped));
+  EXPECT_EQ(TRANSCEIVER_TRACE_SIZE, events[0].data_index);
+  EXPECT_EQ(0u, dropped);
+}
+
+TEST_F(TransceiverTraceTest, overflow) {
+  const TransceiverTraceEvent *events;
+  uint32_t dropped;
+
+  Record(0u, TRANSCEIVER_TRACE_SIZE + 10u);
+  // The oldest 10 events were overwritten.
+  ASSERT_EQ(TRANSCEIVER_TRACE_SIZE - 10u,
+            TransceiverTrace_Peek(&events, &dropped));
+  EXPECT_EQ(10u, dropped);
+  EXPECT_EQ(10u, events[0].data_index);
+  TransceiverTrace_Consume(TRANSCEIVER_TRACE_SIZE - 10u);
+
+  ASSERT_EQ(10u, TransceiverTrace_Peek(&events, &dropped));
+  EXPECT_EQ(0u, dropped);
+  EXPECT_EQ(TRANSCEIVER_TRACE_SIZE, events[0].data_index);
+}
@@ -18,6 +18,11 @@ user_manual_pid_gen_pid_gen_LDADD = $(OLA_LIBS) \
                                     firmware/src/librdmutil.la \
                                     firmware/src/libreceivercounters.la \
                                     firmware/src/libsensormodel.la \
+                                    firmware/src/libspi.la \
+                                    firmware/src/libspirgb.la \
+                                    firmware/src/libscheduler.la \
                                     firmware/src/libcoarsetimer.la \
+                                    firmware/src/libtimerwheel.la \
                                     tests/harmony/mocks/libharmonymock.la \
+                                    tests/mocks/libcoretimermock.la \
                                     $(GMOCK_LIBS) $(GTEST_LIBS)